@@ -0,0 +1,409 @@
+// Microbenchmarks for the hot paths of a tick. Inputs come from fixed seeds so
+// runs are comparable across commits.
+#include "ai/behavior/Pathfinder.h"
+#include "ai/memory/NPCMemory.h"
+#include "ai/neural/NativeModel.h"
+#include "ai/neural/NeuralBrain.h"
+#include "ai/social/SocialIntelligence.h"
+#include "data/DataLogger.h"
+#include "engine/JobSystem.h"
+#include "engine/Profiler.h"
+#include "entities/NPC.h"
+#include "serialization/Snapshot.h"
+#include "world/HierarchicalPathfinder.h"
+#include "world/World.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace pw {
+namespace {
+
+constexpr uint32_t SEED = 7;
+
+// World with every chunk generated up front, so lazy generation stays out of the timings
+std::unique_ptr<World> makeWorld(int width = WORLD_WIDTH, int height = WORLD_HEIGHT) {
+    auto world = std::make_unique<World>(SEED, width, height);
+    JobSystem jobs(0);
+    world->generateChunks(jobs);
+    return world;
+}
+
+Vec2 randomWalkable(const World& world, std::mt19937& rng) {
+    std::uniform_int_distribution<int> xDist(0, world.getWidth() - 1);
+    std::uniform_int_distribution<int> yDist(0, world.getHeight() - 1);
+    for (;;) {
+        int x = xDist(rng);
+        int y = yDist(rng);
+        if (world.isWalkable(x, y)) return Vec2(x + 0.5f, y + 0.5f);
+    }
+}
+
+// NPCs spread over the map, registered in the world's entity index
+NPCStore spawn(World& world, int count) {
+    std::mt19937 rng(SEED);
+    NPCStore npcs;
+    npcs.reserve(count);
+    EntityIndex& index = world.getEntityIndex();
+    index.clear();
+    for (int i = 0; i < count; i++) {
+        uint32_t slot = npcs.add(i, randomWalkable(world, rng));
+        index.add(npcs.id(slot), npcs.position(slot));
+    }
+    index.build();
+    return npcs;
+}
+
+std::string scratchDirectory(const char* name) {
+    auto path = std::filesystem::temp_directory_path() / "pw_bench" / name;
+    std::filesystem::create_directories(path);
+    return path.string();
+}
+
+void BM_FindPath(benchmark::State& state) {
+    auto world = makeWorld();
+    const float maxDistance = static_cast<float>(state.range(0));
+    
+    std::mt19937 rng(SEED);
+    std::vector<std::pair<Vec2, Vec2>> queries;
+    while (queries.size() < 64) {
+        Vec2 from = randomWalkable(*world, rng);
+        Vec2 to = randomWalkable(*world, rng);
+        if (from.distance(to) <= maxDistance) queries.emplace_back(from, to);
+    }
+    
+    size_t next = 0;
+    for (auto _ : state) {
+        const auto& query = queries[next++ % queries.size()];
+        benchmark::DoNotOptimize(Pathfinder::findPath(*world, query.first, query.second));
+    }
+}
+BENCHMARK(BM_FindPath)->Arg(16)->Arg(64);
+
+// Queries toward 20 goals within range(0) tiles, as NPCs heading for the same
+// bushes and caves make them; goal trees come from the cache after the first.
+// 256 reaches past the first search window (SEARCH_RADIUS clusters).
+void BM_FindPathHierarchical(benchmark::State& state) {
+    auto world = makeWorld();
+    world->indexNavigation();
+    const HierarchicalPathfinder& navigation = *world->getNavigation();
+    const float maxDistance = static_cast<float>(state.range(0));
+    
+    std::mt19937 rng(SEED);
+    std::vector<Vec2> goals;
+    while (goals.size() < 20) goals.push_back(randomWalkable(*world, rng));
+    std::vector<std::pair<Vec2, Vec2>> queries;
+    while (queries.size() < 256) {
+        Vec2 from = randomWalkable(*world, rng);
+        Vec2 to = goals[queries.size() % goals.size()];
+        if (from.distance(to) <= maxDistance) queries.emplace_back(from, to);
+    }
+    
+    // Paths must be walkable, step by step, from start to goal, and found
+    // wherever flat A* finds one
+    for (const auto& query : queries) {
+        auto path = navigation.findPath(query.first, query.second);
+        if (path.empty() && !Pathfinder::findPath(*world, query.first, query.second, WORLD_WIDTH * WORLD_HEIGHT).empty()) {
+            state.SkipWithError("hierarchical search missed a reachable goal");
+            return;
+        }
+        for (size_t i = 0; i < path.size(); i++) {
+            const bool step = i == 0 || (std::abs(path[i].x - path[i - 1].x) <= 1.0f &&
+                                         std::abs(path[i].y - path[i - 1].y) <= 1.0f);
+            if (!step || !world->isWalkable(static_cast<int>(path[i].x), static_cast<int>(path[i].y))) {
+                state.SkipWithError("hierarchical path is not a walkable tile path");
+                return;
+            }
+        }
+        if (!path.empty() && (path.back().x != std::floor(query.second.x) || path.back().y != std::floor(query.second.y))) {
+            state.SkipWithError("hierarchical path ends away from its goal");
+            return;
+        }
+    }
+    
+    size_t next = 0;
+    for (auto _ : state) {
+        const auto& query = queries[next++ % queries.size()];
+        benchmark::DoNotOptimize(navigation.findPath(query.first, query.second));
+    }
+    state.counters["clusters"] = static_cast<double>(navigation.builtClusters());
+}
+BENCHMARK(BM_FindPathHierarchical)->Arg(64)->Arg(128)->Arg(256);
+
+// range(0): NPCs, range(1): 1 rewrites the NPC's tile first, so its cached tile window is stale
+void BM_GatherPerception(benchmark::State& state) {
+    auto world = makeWorld();
+    NPCStore npcs = spawn(*world, static_cast<int>(state.range(0)));
+    const bool edited = state.range(1) != 0;
+    
+    size_t next = 0;
+    for (auto _ : state) {
+        const NPC npc = npcs[next++ % npcs.size()];
+        if (edited) {
+            const Vec2 position = npc.getPosition();
+            const int x = static_cast<int>(position.x);
+            const int y = static_cast<int>(position.y);
+            world->setTile(x, y, world->getTile(x, y));
+        }
+        benchmark::DoNotOptimize(npc.gatherPerception(*world, 0));
+    }
+}
+BENCHMARK(BM_GatherPerception)->ArgNames({"npcs", "edited"})
+    ->Args({15, 0})->Args({1000, 0})->Args({1000, 1});
+
+// Nearest berry bush within 50 tiles from random walkable tiles, as foraging
+// behavior trees ask; range(0): 1 answers from the world's resource field
+void BM_NearestTile(benchmark::State& state) {
+    auto world = makeWorld();
+    if (state.range(0)) {
+        world->indexResources();
+    }
+    std::mt19937 rng(SEED);
+    std::vector<Vec2> queries(1024);
+    for (Vec2& query : queries) query = randomWalkable(*world, rng);
+    
+    // A bush eaten bare must drop out of the answers, cached ones included
+    const int firstX = static_cast<int>(queries[0].x);
+    const int firstY = static_cast<int>(queries[0].y);
+    const Vec2 bush = world->nearestTile(firstX, firstY, TileType::BerryBush, 50.0f);
+    if (bush.x >= 0) {
+        while (world->consumeFood(static_cast<int>(bush.x), static_cast<int>(bush.y))) {}
+        const Vec2 after = world->nearestTile(firstX, firstY, TileType::BerryBush, 50.0f);
+        if (after.x == bush.x && after.y == bush.y) {
+            state.SkipWithError("depleted berry bush still returned");
+            return;
+        }
+    }
+    
+    size_t next = 0;
+    for (auto _ : state) {
+        const Vec2 query = queries[next++ % queries.size()];
+        benchmark::DoNotOptimize(world->nearestTile(static_cast<int>(query.x), static_cast<int>(query.y),
+                                                    TileType::BerryBush, 50.0f));
+    }
+}
+BENCHMARK(BM_NearestTile)->ArgName("indexed")->Arg(0)->Arg(1);
+
+// Needs, moods and movement over the component arrays, every NPC walking somewhere
+void BM_NPCUpdate(benchmark::State& state) {
+    auto world = makeWorld();
+    NPCStore npcs = spawn(*world, static_cast<int>(state.range(0)));
+    
+    std::mt19937 rng(SEED + 1);
+    std::vector<Action> actions(npcs.size());
+    for (Action& action : actions) {
+        action.type = ActionType::Move;
+        action.targetPosition = randomWalkable(*world, rng);
+    }
+    
+    WorldCommandBuffer commands;
+    for (auto _ : state) {
+        npcs.update(0, npcs.size(), FIXED_TIMESTEP, *world, actions.data(), commands);
+        commands.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(npcs.size()));
+}
+BENCHMARK(BM_NPCUpdate)->Arg(1000)->Arg(10000);
+
+// range(0): 1 decides through the model (skipped without one), 0 through the fallback
+void BM_NeuralDecide(benchmark::State& state) {
+    const bool withModel = state.range(0) != 0;
+    auto world = makeWorld();
+    NPCStore npcs = spawn(*world, 15);
+    Perception perception = npcs[0].gatherPerception(*world, 0);
+    
+    NeuralBrain brain(0, withModel ? "models/npc_brain.onnx" : "", SEED);
+    if (withModel && !brain.hasModel()) {
+        state.SkipWithError("no model (add models/npc_brain.pwnn, or models/npc_brain.onnx with ONNX Runtime)");
+        return;
+    }
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(brain.decide(perception, *world));
+    }
+}
+BENCHMARK(BM_NeuralDecide)->ArgName("model")->Arg(0)->Arg(1);
+
+// range(0) NPCs per call through a default-shape native model with random
+// weights; range(1) the WeightPrecision
+void BM_NativeInference(benchmark::State& state) {
+    const size_t rows = static_cast<size_t>(state.range(0));
+    NativeModel model;
+    model.initializeRandom(NativeModel::Shape{}, SEED, static_cast<WeightPrecision>(state.range(1)));
+    
+    CounterRng rng(SEED);
+    std::vector<float> perception(rows * InferenceScheduler::PERCEPTION_DIM);
+    std::vector<float> memory(rows * InferenceScheduler::MEMORY_CONTEXT_SIZE);
+    for (float& value : perception) value = rng.uniform();
+    for (float& value : memory) value = rng.uniform(-1.0f, 1.0f);
+    std::vector<float> output(rows * InferenceScheduler::OUTPUT_DIM);
+    
+    for (auto _ : state) {
+        model.run(perception.data(), memory.data(), rows, output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rows));
+    state.counters["weight_kb"] = static_cast<double>(model.weightBytes()) / 1024.0;
+}
+BENCHMARK(BM_NativeInference)->ArgNames({"npcs", "precision"})
+    ->Args({1, 0})->Args({64, 0})->Args({64, 1})->Args({64, 2});
+
+// range(0): 0 JSONL, 1 binary; written synchronously so the write is timed too
+void BM_LogDecision(benchmark::State& state) {
+    const LogFormat format = state.range(0) ? LogFormat::Binary : LogFormat::Jsonl;
+    auto world = makeWorld();
+    NPCStore npcs = spawn(*world, 15);
+    Perception perception = npcs[0].gatherPerception(*world, 0);
+    Action action;
+    action.type = ActionType::Forage;
+    Outcome outcome;
+    outcome.needsDelta.hunger = -0.1f;
+    outcome.action = action.type;
+    
+    LogQueueSettings synchronous;
+    synchronous.capacity = 0;
+    DataLogger logger(scratchDirectory("log_decision"), format, synchronous);
+    
+    Tick tick = 0;
+    for (auto _ : state) {
+        logger.logDecision(tick++, 0, perception, action, outcome);
+    }
+    logger.flush();
+}
+BENCHMARK(BM_LogDecision)->ArgName("binary")->Arg(0)->Arg(1);
+
+// range(0): map side in tiles, range(1): threads (0 = every core)
+void BM_GenerateTerrain(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    JobSystem jobs(static_cast<int>(state.range(1)));
+    
+    for (auto _ : state) {
+        World world(SEED, side, side);
+        world.generateChunks(jobs);
+        benchmark::DoNotOptimize(world.residentChunks());
+    }
+    state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_GenerateTerrain)
+    ->Args({256, 1})->Args({1024, 1})->Args({1024, 0})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+NPCMemory makeMemory() {
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> position(0.0f, 200.0f);
+    std::uniform_real_distribution<float> significance(0.1f, 1.0f);
+    NPCMemory memory;
+    for (size_t i = 0; i < NPCMemory::MAX_MEMORIES; i++) {
+        memory.addMemory(static_cast<MemoryType>(i % 4), Vec2(position(rng), position(rng)),
+                         static_cast<Tick>(i * 10), significance(rng));
+    }
+    memory.decay(NPCMemory::MAX_MEMORIES * 10);
+    return memory;
+}
+
+void BM_MemoryRecall(benchmark::State& state) {
+    NPCMemory memory = makeMemory();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(memory.recall(MemoryType::Food, 5));
+    }
+}
+BENCHMARK(BM_MemoryRecall);
+
+void BM_MemoryRecallNearby(benchmark::State& state) {
+    NPCMemory memory = makeMemory();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(memory.recallNearby(Vec2(100.0f, 100.0f), 20.0f, 5));
+    }
+}
+BENCHMARK(BM_MemoryRecallNearby);
+
+// Round trip of a memory that has replaced entries across many more grid
+// cells than it holds, as a long-lived NPC's does
+void BM_MemorySnapshot(benchmark::State& state) {
+    NPCMemory memory;
+    for (int i = 0; i < 4 * static_cast<int>(NPCMemory::MAX_MEMORIES); i++) {
+        memory.addMemory(MemoryType::Food, Vec2(i * 20.0f, 0.0f), static_cast<Tick>(i));
+    }
+    
+    for (auto _ : state) {
+        SnapshotWriter out(false);
+        memory.writeSnapshot(out);
+        SnapshotReader in;
+        in.view(out.data(), out.size());
+        NPCMemory restored;
+        if (!restored.readSnapshot(in) || restored.getAllMemories().size() != memory.getAllMemories().size()) {
+            state.SkipWithError("memory snapshot did not read back");
+            return;
+        }
+        benchmark::DoNotOptimize(restored);
+    }
+}
+BENCHMARK(BM_MemorySnapshot);
+
+// Frames with a zone that first records 150 frames in, as a subsystem that
+// only starts working after warm-up does; its percentiles must cover only
+// the frames it was recorded in
+void BM_ProfilerFrame(benchmark::State& state) {
+    Profiler& profiler = Profiler::instance();
+    if (!profiler.start("")) {
+        state.SkipWithError("profiler compiled out");
+        return;
+    }
+    for (int frame = 0; frame < 150; frame++) {
+        profiler.record("bench/early", 0, 1000000);
+        profiler.endFrame();
+    }
+    
+    for (auto _ : state) {
+        profiler.record("bench/early", 0, 1000000);
+        profiler.record("bench/late", 0, 2000000);
+        profiler.endFrame();
+    }
+    profiler.stop();
+    
+    bool reported = false;
+    for (const Profiler::ZoneStats& zone : profiler.stats()) {
+        if (zone.name == "bench/late") {
+            reported = std::abs(zone.p50Ms - 2.0) < 1e-3 && std::abs(zone.p99Ms - 2.0) < 1e-3;
+        }
+    }
+    if (!reported) {
+        state.SkipWithError("late zone's p50/p99 are not 2 ms");
+    }
+}
+// Fewer frames than Profiler::STATS_WINDOW, so every slot read must have been written
+BENCHMARK(BM_ProfilerFrame)->Iterations(60);
+
+// A population's meetings recorded into one shared store, then each NPC's
+// emergent group found from its row
+void BM_SocialInteractions(benchmark::State& state) {
+    static constexpr int PARTNERS = 32;
+    const int npcCount = static_cast<int>(state.range(0));
+    RelationshipStore store;
+    std::vector<std::unique_ptr<SocialIntelligence>> npcs;
+    for (int i = 0; i < npcCount; i++) {
+        npcs.push_back(std::make_unique<SocialIntelligence>(i, SEED, &store));
+    }
+    
+    std::mt19937 rng(SEED);
+    std::uniform_int_distribution<int> pick(0, npcCount - 1);
+    Tick tick = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < npcCount; i++) {
+            npcs[i]->recordInteraction(static_cast<EntityId>(pick(rng) % PARTNERS + i / PARTNERS * PARTNERS),
+                                       "neutral", 0.1f, tick);
+        }
+        for (const auto& npc : npcs) {
+            benchmark::DoNotOptimize(npc->findSimilarNpcs());
+        }
+        tick++;
+    }
+    state.SetItemsProcessed(state.iterations() * npcCount);
+}
+BENCHMARK(BM_SocialInteractions)->ArgName("npcs")->Arg(1000);
+
+} // namespace
+} // namespace pw
@@ -0,0 +1,70 @@
+// Whole-tick scaling: ticks per second of the headless simulation at growing
+// populations. Brain state persistence is off and logs go to a scratch
+// directory, so runs don't touch the working tree.
+#include "engine/AllocationCounter.h"
+#include "engine/Simulation.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+
+namespace pw {
+namespace {
+
+constexpr int WARMUP_TICKS = 10;
+
+// Allocation-counting builds warm up until NPC memories, tick buffers and the
+// resource field have grown to their working size, so allocs/tick reports the
+// steady state rather than the first ticks' growth
+constexpr int ALLOCATION_WARMUP_TICKS = 500;
+
+// range(0): NPCs, range(1): map side in tiles, range(2): threads (0 = every core)
+void BM_SimulationTick(benchmark::State& state) {
+    const int npcs = static_cast<int>(state.range(0));
+    const int side = static_cast<int>(state.range(1));
+    
+    auto logs = std::filesystem::temp_directory_path() / "pw_bench" / "simulation_tick";
+    std::filesystem::create_directories(logs);
+    
+    Simulation simulation;
+    simulation.setSeed(7);
+    simulation.setNPCCount(npcs);
+    simulation.setWorldSize(side, side);
+    simulation.setThreadCount(static_cast<int>(state.range(2)));
+    simulation.setLogFormat(LogFormat::Binary);
+    simulation.setLogDirectory(logs.string());
+    simulation.setPersistBrainStates(false);
+    simulation.init();
+    
+    // First ticks generate the chunks around the spawn points
+    const int warmup = AllocationCounter::enabled() ? ALLOCATION_WARMUP_TICKS : WARMUP_TICKS;
+    for (int i = 0; i < warmup; i++) {
+        simulation.step(FIXED_TIMESTEP);
+    }
+    
+    const uint64_t allocationsBefore = AllocationCounter::allocations();
+    for (auto _ : state) {
+        simulation.step(FIXED_TIMESTEP);
+    }
+    if (AllocationCounter::enabled()) {
+        state.counters["allocs/tick"] = static_cast<double>(AllocationCounter::allocations() - allocationsBefore) /
+                                        static_cast<double>(state.iterations());
+    }
+    
+    state.counters["ticks/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.counters["npcs"] = static_cast<double>(simulation.getNPCs().size());
+    simulation.finish();
+}
+BENCHMARK(BM_SimulationTick)
+    ->ArgNames({"npcs", "side", "threads"})
+    ->Args({15, 200, 1})
+    ->Args({1000, 1024, 1})
+    ->Args({1000, 1024, 0})
+    ->Args({10000, 2048, 0})
+    ->Iterations(100)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+} // namespace pw
+
+BENCHMARK_MAIN();
@@ -1,14 +1,18 @@
 #include "BehaviorTreeBrain.h"
 #include "world/World.h"
+#include "world/HierarchicalPathfinder.h"
+#include "engine/Profiler.h"
+#include "serialization/Snapshot.h"
 #include <cmath>
 
 namespace pw {
 
-BehaviorTreeBrain::BehaviorTreeBrain(EntityId ownerId)
-    : ownerId(ownerId), rng(std::random_device{}()) {
+BehaviorTreeBrain::BehaviorTreeBrain(EntityId ownerId, uint32_t seed)
+    : ownerId(ownerId), rng(CounterRng::streamKey(seed, ownerId, CounterRng::Brain)) {
 }
 
-Action BehaviorTreeBrain::decide(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::decide(const Perception& perception, const World& world) {
+    PW_PROFILE_ZONE("decide/behavior-tree");
     return decideBasedOnNeeds(perception, world);
 }
 
@@ -16,11 +20,32 @@ void BehaviorTreeBrain::onOutcome(const Outcome& outcome) {
     // Learn from outcome (future: used for learning systems)
 }
 
-Action BehaviorTreeBrain::decideBasedOnNeeds(const Perception& perception, World& world) {
+void BehaviorTreeBrain::writeSnapshot(SnapshotWriter& out) const {
+    npcMemory.writeSnapshot(out);
+    out.writeRng(rng);
+    out.write(currentAction);
+    out.writeVector(currentPath);
+    out.write(pathIndex);
+}
+
+bool BehaviorTreeBrain::readSnapshot(SnapshotReader& in) {
+    static constexpr size_t MAX_PATH = 1 << 20;
+    
+    if (!npcMemory.readSnapshot(in)) {
+        return false;
+    }
+    in.readRng(rng);
+    in.read(currentAction);
+    in.readVector(currentPath, MAX_PATH);
+    in.read(pathIndex);
+    return in.ok();
+}
+
+Action BehaviorTreeBrain::decideBasedOnNeeds(const Perception& perception, const World& world) {
     const Needs& needs = perception.internalNeeds;
     
     // Check weather - seek shelter if raining
-    if (perception.weather == "rain" || perception.weather == "storm") {
+    if (perception.weather == Weather::Rain || perception.weather == Weather::Storm) {
         if (needs.safety < 0.7f) { // Not urgent safety need
             return seekShelter(perception, world);
         }
@@ -45,17 +70,17 @@ Action BehaviorTreeBrain::decideBasedOnNeeds(const Perception& perception, World
     return explore(perception, world);
 }
 
-Action BehaviorTreeBrain::forageForFood(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::forageForFood(const Perception& perception, const World& world) {
     // Check memory for known food sources
-    auto foodMemories = memory.recall("food", 3);
+    auto foodMemories = npcMemory.recall(MemoryType::Food, 3);
     
     Vec2 target;
     bool foundTarget = false;
     
     // Try remembered locations first
-    for (const auto& mem : foodMemories) {
-        if (mem.location.distance(perception.position) < 100.0f) {
-            target = mem.location;
+    for (const MemoryEntry* mem : foodMemories) {
+        if (mem->location.distance(perception.position) < 100.0f) {
+            target = mem->location;
             foundTarget = true;
             break;
         }
@@ -66,7 +91,7 @@ Action BehaviorTreeBrain::forageForFood(const Perception& perception, World& wor
         target = findNearestTile(perception, world, TileType::BerryBush, 50.0f);
         if (target.x >= 0 && target.y >= 0) {
             foundTarget = true;
-            memory.addMemory("food", target, 0, 1.0f);
+            npcMemory.addMemory(MemoryType::Food, target, 0, 1.0f);
         }
     }
     
@@ -82,7 +107,7 @@ Action BehaviorTreeBrain::forageForFood(const Perception& perception, World& wor
             // Move to food
             Action action;
             action.type = ActionType::Move;
-            action.targetPosition = target;
+            action.targetPosition = nextWaypoint(perception, world, target);
             return action;
         }
     }
@@ -91,16 +116,16 @@ Action BehaviorTreeBrain::forageForFood(const Perception& perception, World& wor
     return explore(perception, world);
 }
 
-Action BehaviorTreeBrain::seekRest(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::seekRest(const Perception& perception, const World& world) {
     // Look for shelter or safe spot
-    auto shelterMemories = memory.recall("shelter", 3);
+    auto shelterMemories = npcMemory.recall(MemoryType::Shelter, 3);
     
     Vec2 target;
     bool foundTarget = false;
     
-    for (const auto& mem : shelterMemories) {
-        if (mem.location.distance(perception.position) < 100.0f) {
-            target = mem.location;
+    for (const MemoryEntry* mem : shelterMemories) {
+        if (mem->location.distance(perception.position) < 100.0f) {
+            target = mem->location;
             foundTarget = true;
             break;
         }
@@ -110,7 +135,7 @@ Action BehaviorTreeBrain::seekRest(const Perception& perception, World& world) {
         target = findNearestTile(perception, world, TileType::Cave, 50.0f);
         if (target.x >= 0 && target.y >= 0) {
             foundTarget = true;
-            memory.addMemory("shelter", target, 0, 1.0f);
+            npcMemory.addMemory(MemoryType::Shelter, target, 0, 1.0f);
         }
     }
     
@@ -123,7 +148,7 @@ Action BehaviorTreeBrain::seekRest(const Perception& perception, World& world) {
         } else {
             Action action;
             action.type = ActionType::Move;
-            action.targetPosition = target;
+            action.targetPosition = nextWaypoint(perception, world, target);
             return action;
         }
     }
@@ -134,7 +159,7 @@ Action BehaviorTreeBrain::seekRest(const Perception& perception, World& world) {
     return action;
 }
 
-Action BehaviorTreeBrain::socialize(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::socialize(const Perception& perception, const World& world) {
     // Find nearest NPC
     if (!perception.nearbyNPCs.empty()) {
         float minDist = 1000.0f;
@@ -164,7 +189,7 @@ Action BehaviorTreeBrain::socialize(const Perception& perception, World& world)
     return explore(perception, world);
 }
 
-Action BehaviorTreeBrain::explore(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::explore(const Perception& perception, const World& world) {
     Vec2 target = findRandomWalkableNearby(perception, world, 30.0f);
     
     Action action;
@@ -173,7 +198,7 @@ Action BehaviorTreeBrain::explore(const Perception& perception, World& world) {
     return action;
 }
 
-Action BehaviorTreeBrain::seekShelter(const Perception& perception, World& world) {
+Action BehaviorTreeBrain::seekShelter(const Perception& perception, const World& world) {
     Vec2 target = findNearestTile(perception, world, TileType::Cave, 50.0f);
     
     if (target.x < 0 || target.y < 0) {
@@ -183,7 +208,7 @@ Action BehaviorTreeBrain::seekShelter(const Perception& perception, World& world
     if (target.x >= 0 && target.y >= 0) {
         Action action;
         action.type = ActionType::SeekShelter;
-        action.targetPosition = target;
+        action.targetPosition = nextWaypoint(perception, world, target);
         return action;
     }
     
@@ -192,44 +217,45 @@ Action BehaviorTreeBrain::seekShelter(const Perception& perception, World& world
     return action;
 }
 
-Vec2 BehaviorTreeBrain::findNearestTile(const Perception& perception, World& world, TileType type, float maxDist) {
-    int centerX = static_cast<int>(perception.position.x);
-    int centerY = static_cast<int>(perception.position.y);
-    int searchRadius = static_cast<int>(maxDist);
-    
-    float minDist = maxDist * maxDist;
-    Vec2 nearest(-1, -1);
-    
-    for (int dy = -searchRadius; dy <= searchRadius; dy++) {
-        for (int dx = -searchRadius; dx <= searchRadius; dx++) {
-            int x = centerX + dx;
-            int y = centerY + dy;
-            
-            if (x < 0 || x >= world.getWidth() || y < 0 || y >= world.getHeight()) {
-                continue;
-            }
-            
-            const Tile& tile = world.getTile(x, y);
-            if (tile.type == type) {
-                float distSq = dx * dx + dy * dy;
-                if (distSq < minDist) {
-                    minDist = distSq;
-                    nearest = Vec2(static_cast<float>(x), static_cast<float>(y));
-                }
-            }
+Vec2 BehaviorTreeBrain::findNearestTile(const Perception& perception, const World& world, TileType type, float maxDist) {
+    // The world's resource field answers without scanning
+    return world.nearestTile(static_cast<int>(perception.position.x), static_cast<int>(perception.position.y),
+                             type, maxDist);
+}
+
+Vec2 BehaviorTreeBrain::nextWaypoint(const Perception& perception, const World& world, Vec2 target) {
+    const HierarchicalPathfinder* navigation = world.getNavigation();
+    if (!navigation) {
+        return target;
+    }
+    
+    // Keep following the current path while it still leads to target and the
+    // NPC hasn't strayed from it
+    const Vec2 goal(std::floor(target.x), std::floor(target.y));
+    const bool onPath = pathIndex >= 0 && pathIndex < static_cast<int>(currentPath.size()) &&
+                        currentPath.back().x == goal.x && currentPath.back().y == goal.y &&
+                        currentPath[pathIndex].distance(perception.position) <= 2.0f;
+    if (!onPath) {
+        currentPath = navigation->findPath(perception.position, target);
+        pathIndex = 0;
+        if (currentPath.empty()) {
+            // Unreachable: head straight for it
+            return target;
         }
     }
     
-    return nearest;
+    // Past every waypoint already reached
+    while (pathIndex + 1 < static_cast<int>(currentPath.size()) &&
+           currentPath[pathIndex].distance(perception.position) < 1.0f) {
+        pathIndex++;
+    }
+    return pathIndex + 1 < static_cast<int>(currentPath.size()) ? currentPath[pathIndex] : target;
 }
 
-Vec2 BehaviorTreeBrain::findRandomWalkableNearby(const Perception& perception, World& world, float radius) {
-    std::uniform_real_distribution<float> angleDist(0.0f, 6.28318f);
-    std::uniform_real_distribution<float> radiusDist(radius * 0.5f, radius);
-    
+Vec2 BehaviorTreeBrain::findRandomWalkableNearby(const Perception& perception, const World& world, float radius) {
     for (int attempt = 0; attempt < 10; attempt++) {
-        float angle = angleDist(rng);
-        float r = radiusDist(rng);
+        float angle = rng.uniform(0.0f, 6.28318f);
+        float r = rng.uniform(radius * 0.5f, radius);
         
         Vec2 target(
             perception.position.x + std::cos(angle) * r,
@@ -4,39 +4,47 @@
 #include "ai/memory/NPCMemory.h"
 #include "ai/behavior/Pathfinder.h"
 #include "world/Tile.h"
-#include <random>
+#include "engine/Random.h"
 
 namespace pw {
 
 class BehaviorTreeBrain : public IBrain {
 public:
-    BehaviorTreeBrain(EntityId ownerId);
+    // The brain's RNG is derived from seed and ownerId, so decisions are reproducible
+    BehaviorTreeBrain(EntityId ownerId, uint32_t seed = 0);
     
-    Action decide(const Perception& perception, World& world) override;
+    BrainKind kind() const override { return BrainKind::BehaviorTree; }
+    Action decide(const Perception& perception, const World& world) override;
     void onOutcome(const Outcome& outcome) override;
+    const NPCMemory* memory() const override { return &npcMemory; }
+    int decisionInterval() const override { return 10; }  // Plans hold for many ticks
     
-    NPCMemory& getMemory() { return memory; }
+    NPCMemory& getMemory() { return npcMemory; }
+    
+    void writeSnapshot(SnapshotWriter& out) const override;
+    bool readSnapshot(SnapshotReader& in) override;
 
 private:
     EntityId ownerId;
-    NPCMemory memory;
-    std::mt19937 rng;
+    NPCMemory npcMemory;
+    CounterRng rng;
     
     Action currentAction;
     std::vector<Vec2> currentPath;
     int pathIndex = 0;
     
     // Decision making
-    Action decideBasedOnNeeds(const Perception& perception, World& world);
-    Action forageForFood(const Perception& perception, World& world);
-    Action seekRest(const Perception& perception, World& world);
-    Action socialize(const Perception& perception, World& world);
-    Action explore(const Perception& perception, World& world);
-    Action seekShelter(const Perception& perception, World& world);
+    Action decideBasedOnNeeds(const Perception& perception, const World& world);
+    Action forageForFood(const Perception& perception, const World& world);
+    Action seekRest(const Perception& perception, const World& world);
+    Action socialize(const Perception& perception, const World& world);
+    Action explore(const Perception& perception, const World& world);
+    Action seekShelter(const Perception& perception, const World& world);
     
     // Utilities
-    Vec2 findNearestTile(const Perception& perception, World& world, TileType type, float maxDist = 50.0f);
-    Vec2 findRandomWalkableNearby(const Perception& perception, World& world, float radius = 20.0f);
+    Vec2 nextWaypoint(const Perception& perception, const World& world, Vec2 target);
+    Vec2 findNearestTile(const Perception& perception, const World& world, TileType type, float maxDist = 50.0f);
+    Vec2 findRandomWalkableNearby(const Perception& perception, const World& world, float radius = 20.0f);
 };
 
 } // namespace pw
@@ -1,112 +1,147 @@
 #include "Pathfinder.h"
 #include "world/World.h"
-#include <queue>
-#include <unordered_set>
-#include <unordered_map>
+#include "engine/Profiler.h"
 #include <cmath>
 #include <algorithm>
 
 namespace pw {
 
-struct NodeCompare {
-    bool operator()(const Pathfinder::Node* a, const Pathfinder::Node* b) const {
-        return a->f > b->f;
+namespace {
+
+// Min-heap on f
+struct OpenCompare {
+    template <typename Entry>
+    bool operator()(const Entry& a, const Entry& b) const {
+        return a.f > b.f;
     }
 };
 
+} // namespace
+
+void PathfindingContext::begin(int newWidth, int newHeight) {
+    size_t tiles = static_cast<size_t>(newWidth) * newHeight;
+    if (newWidth != width || newHeight != height || gScore.size() != tiles) {
+        width = newWidth;
+        height = newHeight;
+        gScore.assign(tiles, 0.0f);
+        parent.assign(tiles, -1);
+        seenGeneration.assign(tiles, 0);
+        closedGeneration.assign(tiles, 0);
+        generation = 0;
+    }
+    
+    generation++;
+    if (generation == 0) {
+        // Wrapped around: old stamps could look current again
+        std::fill(seenGeneration.begin(), seenGeneration.end(), 0);
+        std::fill(closedGeneration.begin(), closedGeneration.end(), 0);
+        generation = 1;
+    }
+    
+    open.clear();
+}
+
+PathfindingContext& Pathfinder::threadContext() {
+    static thread_local PathfindingContext context;
+    return context;
+}
+
 float Pathfinder::heuristic(int x1, int y1, int x2, int y2) {
     return std::abs(x1 - x2) + std::abs(y1 - y2);
 }
 
 std::vector<Vec2> Pathfinder::findPath(const World& world, Vec2 start, Vec2 goal, int maxSteps) {
+    return findPath(threadContext(), world, start, goal, maxSteps);
+}
+
+std::vector<Vec2> Pathfinder::findPath(PathfindingContext& ctx, const World& world,
+                                       Vec2 start, Vec2 goal, int maxSteps) {
+    PW_PROFILE_ZONE("pathfinding/astar");
     int startX = static_cast<int>(start.x);
     int startY = static_cast<int>(start.y);
     int goalX = static_cast<int>(goal.x);
     int goalY = static_cast<int>(goal.y);
     
+    const int width = world.getWidth();
+    const int height = world.getHeight();
+    
     // Check if goal is walkable
     if (!world.isWalkable(goalX, goalY)) {
         return {};
     }
+    if (startX < 0 || startX >= width || startY < 0 || startY >= height) {
+        return {};
+    }
     
-    std::priority_queue<Node*, std::vector<Node*>, NodeCompare> openSet;
-    std::unordered_map<int, std::unique_ptr<Node>> allNodes;
-    std::unordered_set<int> closedSet;
-    
-    auto getKey = [](int x, int y) { return y * 10000 + x; };
+    ctx.begin(width, height);
+    const uint32_t gen = ctx.generation;
     
-    auto startNode = std::make_unique<Node>(startX, startY);
-    startNode->g = 0;
-    startNode->h = heuristic(startX, startY, goalX, goalY);
-    startNode->f = startNode->h;
+    const int32_t startTile = startY * width + startX;
+    const int32_t goalTile = goalY * width + goalX;
     
-    Node* startPtr = startNode.get();
-    allNodes[getKey(startX, startY)] = std::move(startNode);
-    openSet.push(startPtr);
+    ctx.gScore[startTile] = 0.0f;
+    ctx.parent[startTile] = -1;
+    ctx.seenGeneration[startTile] = gen;
+    ctx.open.push_back({heuristic(startX, startY, goalX, goalY), startTile});
     
     int steps = 0;
     constexpr int dx[] = {0, 1, 0, -1, 1, 1, -1, -1};
     constexpr int dy[] = {-1, 0, 1, 0, -1, 1, 1, -1};
     
-    while (!openSet.empty() && steps < maxSteps) {
+    while (!ctx.open.empty() && steps < maxSteps) {
         steps++;
         
-        Node* current = openSet.top();
-        openSet.pop();
+        std::pop_heap(ctx.open.begin(), ctx.open.end(), OpenCompare{});
+        const int32_t current = ctx.open.back().tile;
+        ctx.open.pop_back();
         
-        int currentKey = getKey(current->x, current->y);
-        if (closedSet.count(currentKey)) {
+        // Stale duplicate of an already expanded tile
+        if (ctx.closedGeneration[current] == gen) {
             continue;
         }
-        closedSet.insert(currentKey);
+        ctx.closedGeneration[current] = gen;
         
         // Goal reached
-        if (current->x == goalX && current->y == goalY) {
+        if (current == goalTile) {
             std::vector<Vec2> path;
-            Node* node = current;
-            while (node != nullptr) {
-                path.push_back(Vec2(static_cast<float>(node->x), static_cast<float>(node->y)));
-                node = node->parent;
+            for (int32_t tile = current; tile != -1; tile = ctx.parent[tile]) {
+                path.push_back(Vec2(static_cast<float>(tile % width), static_cast<float>(tile / width)));
             }
             std::reverse(path.begin(), path.end());
             return path;
         }
         
+        const int cx = current % width;
+        const int cy = current / width;
+        const float currentG = ctx.gScore[current];
+        
         // Check neighbors
         for (int i = 0; i < 8; i++) {
-            int nx = current->x + dx[i];
-            int ny = current->y + dy[i];
-            int neighborKey = getKey(nx, ny);
+            int nx = cx + dx[i];
+            int ny = cy + dy[i];
             
-            if (closedSet.count(neighborKey)) {
+            // isWalkable() is false outside the world
+            if (!world.isWalkable(nx, ny)) {
                 continue;
             }
             
-            if (!world.isWalkable(nx, ny)) {
+            const int32_t neighbor = ny * width + nx;
+            if (ctx.closedGeneration[neighbor] == gen) {
                 continue;
             }
             
             float moveCost = (i < 4) ? 1.0f : 1.414f; // Diagonal cost
-            float newG = current->g + moveCost;
+            float newG = currentG + moveCost;
             
-            Node* neighbor = nullptr;
-            auto it = allNodes.find(neighborKey);
-            if (it == allNodes.end()) {
-                auto newNode = std::make_unique<Node>(nx, ny);
-                neighbor = newNode.get();
-                allNodes[neighborKey] = std::move(newNode);
-            } else {
-                neighbor = it->second.get();
-                if (newG >= neighbor->g && neighbor->g > 0) {
-                    continue;
-                }
+            if (ctx.seenGeneration[neighbor] == gen && newG >= ctx.gScore[neighbor]) {
+                continue;
             }
             
-            neighbor->g = newG;
-            neighbor->h = heuristic(nx, ny, goalX, goalY);
-            neighbor->f = neighbor->g + neighbor->h;
-            neighbor->parent = current;
-            openSet.push(neighbor);
+            ctx.seenGeneration[neighbor] = gen;
+            ctx.gScore[neighbor] = newG;
+            ctx.parent[neighbor] = current;
+            ctx.open.push_back({newG + heuristic(nx, ny, goalX, goalY), neighbor});
+            std::push_heap(ctx.open.begin(), ctx.open.end(), OpenCompare{});
         }
     }
     
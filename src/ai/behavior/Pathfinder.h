@@ -1,24 +1,51 @@
 #pragma once
 
 #include "engine/Math.h"
+#include <cstdint>
 #include <vector>
 
 namespace pw {
 
 class World;
 
-class Pathfinder {
+// Reusable A* search state: dense per-tile arrays stamped with a search
+// generation, so starting a new search never has to clear them. Not shared
+// between threads; Pathfinder keeps one per thread.
+class PathfindingContext {
 public:
-    struct Node {
-        int x, y;
-        float g, h, f;
-        Node* parent = nullptr;
-        
-        Node(int x_, int y_) : x(x_), y(y_), g(0), h(0), f(0) {}
+    // Size the arrays for the world and start a new search generation
+    void begin(int width, int height);
+    
+    size_t tileCount() const { return gScore.size(); }
+
+private:
+    friend class Pathfinder;
+    
+    struct OpenEntry {
+        float f;
+        int32_t tile;
     };
     
+    int width = 0;
+    int height = 0;
+    uint32_t generation = 0;
+    
+    std::vector<float> gScore;
+    std::vector<int32_t> parent;
+    std::vector<uint32_t> seenGeneration;    // gScore/parent valid for this search
+    std::vector<uint32_t> closedGeneration;  // Tile expanded in this search
+    std::vector<OpenEntry> open;             // Binary heap, may hold stale entries
+};
+
+class Pathfinder {
+public:
+    // Uses the calling thread's context; safe to call from several threads
     static std::vector<Vec2> findPath(const World& world, Vec2 start, Vec2 goal, int maxSteps = 1000);
+    static std::vector<Vec2> findPath(PathfindingContext& context, const World& world,
+                                      Vec2 start, Vec2 goal, int maxSteps = 1000);
     
+    static PathfindingContext& threadContext();
+
 private:
     static float heuristic(int x1, int y1, int x2, int y2);
 };
@@ -5,13 +5,13 @@ namespace pw {
 
 void Needs::update(float dt) {
     // Needs naturally increase over time
-    hunger = std::min(1.0f, hunger + dt * 0.05f);
-    energy = std::min(1.0f, energy + dt * 0.03f);
-    social = std::min(1.0f, social + dt * 0.02f);
-    curiosity = std::min(1.0f, curiosity + dt * 0.01f);
+    hunger = std::min(1.0f, hunger + dt * HUNGER_RATE);
+    energy = std::min(1.0f, energy + dt * ENERGY_RATE);
+    social = std::min(1.0f, social + dt * SOCIAL_RATE);
+    curiosity = std::min(1.0f, curiosity + dt * CURIOSITY_RATE);
     
     // Safety naturally decreases (becomes safer)
-    safety = std::max(0.0f, safety - dt * 0.1f);
+    safety = std::max(0.0f, safety + dt * SAFETY_RATE);
 }
 
 float Needs::getMostUrgent() const {
@@ -45,7 +45,7 @@ std::string Needs::getMostUrgentName() const {
     return name;
 }
 
-std::string Action::toString() const {
+const char* actionTypeName(ActionType type) {
     switch (type) {
         case ActionType::Idle: return "idle";
         case ActionType::Move: return "move";
@@ -60,4 +60,26 @@ std::string Action::toString() const {
     }
 }
 
+std::string Action::toString() const {
+    return actionTypeName(type);
+}
+
+Outcome Outcome::of(const Action& action, const Needs& before, const Needs& after, bool ate) {
+    Outcome outcome;
+    outcome.needsDelta.hunger = after.hunger - before.hunger;
+    outcome.needsDelta.energy = after.energy - before.energy;
+    outcome.needsDelta.social = after.social - before.social;
+    outcome.needsDelta.curiosity = after.curiosity - before.curiosity;
+    outcome.needsDelta.safety = after.safety - before.safety;
+    outcome.action = action.type;
+    
+    // Socializing is an event in itself; eating only once the berry was taken
+    if (ate) {
+        outcome.event = OutcomeEvent::Food;
+    } else if (action.type == ActionType::Socialize) {
+        outcome.event = OutcomeEvent::Social;
+    }
+    return outcome;
+}
+
 } // namespace pw
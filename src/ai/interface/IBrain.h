@@ -2,14 +2,23 @@
 
 #include "engine/Types.h"
 #include "engine/Math.h"
+#include "engine/FixedVector.h"
+#include "world/Tile.h"
+#include "world/Weather.h"
+#include "ai/memory/NPCMemory.h"
+#include <array>
+#include <bitset>
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
 
 namespace pw {
 
 class World;
+class InferenceScheduler;
+class SnapshotReader;
+class SnapshotWriter;
+class SocialIntelligence;
 
 // NPC Needs system
 struct Needs {
@@ -19,20 +28,55 @@ struct Needs {
     float curiosity = 0.5f;  // 0.0 = content, 1.0 = need exploration
     float safety = 0.9f;     // 0.0 = safe, 1.0 = threatened (starts high, decreases over time)
     
+    // Change per second; NPCStore applies the same rates to its need arrays
+    static constexpr float HUNGER_RATE = 0.05f;
+    static constexpr float ENERGY_RATE = 0.03f;
+    static constexpr float SOCIAL_RATE = 0.02f;
+    static constexpr float CURIOSITY_RATE = 0.01f;
+    static constexpr float SAFETY_RATE = -0.1f;
+    
     void update(float dt);
     float getMostUrgent() const;
     std::string getMostUrgentName() const;
 };
 
-// Perception data for logging
+struct PerceivedNPC {
+    EntityId id = 0;
+    Vec2 position;
+};
+
+// Perception data for brains and logging. Fixed layout with no heap members:
+// a tile grid centred on the NPC, a bounded neighbour list and enum-coded
+// weather and memories. DataLogger owns the conversion to strings.
 struct Perception {
+    static constexpr int VIEW_RADIUS = 5;
+    static constexpr int VIEW_SIZE = VIEW_RADIUS * 2 + 1;
+    static constexpr size_t VIEW_TILES = VIEW_SIZE * VIEW_SIZE;
+    static constexpr size_t MAX_NEARBY_NPCS = 16;
+    static constexpr size_t MAX_MEMORY_RECALLS = 16;
+    
     Vec2 position;
-    std::vector<std::pair<Vec2, std::string>> nearbyTiles;
-    std::vector<std::pair<EntityId, Vec2>> nearbyNPCs;
+    Vec2 worldSize = Vec2(static_cast<float>(WORLD_WIDTH), static_cast<float>(WORLD_HEIGHT));  // For normalizing positions
+    
+    // Row-major VIEW_SIZE x VIEW_SIZE grid; cell 0 is world tile (viewOriginX, viewOriginY)
+    int viewOriginX = 0;
+    int viewOriginY = 0;
+    std::array<TileType, VIEW_TILES> nearbyTiles{};
+    std::bitset<VIEW_TILES> tileInWorld;  // Cells outside the map are not perceived
+    
+    FixedVector<PerceivedNPC, MAX_NEARBY_NPCS> nearbyNPCs;
     Needs internalNeeds;
-    std::vector<std::string> memoryRecalls;
-    std::string weather;
+    FixedVector<MemoryType, MAX_MEMORY_RECALLS> memoryRecalls;
+    Weather weather = Weather::Clear;
     float timeOfDay = 0.0f;
+    Tick tick = 0;  // Simulation tick it was gathered on
+    
+    bool hasTile(size_t index) const { return tileInWorld[index]; }
+    
+    Vec2 tilePosition(size_t index) const {
+        return Vec2(static_cast<float>(viewOriginX + static_cast<int>(index) % VIEW_SIZE),
+                    static_cast<float>(viewOriginY + static_cast<int>(index) / VIEW_SIZE));
+    }
 };
 
 // Action types
@@ -56,18 +100,93 @@ struct Action {
     std::string toString() const;
 };
 
-// Outcome after action
+// Lower-case name used in logs ("build_shelter")
+const char* actionTypeName(ActionType type);
+
+// What a decision led to, as far as brains react to it
+enum class OutcomeEvent : uint8_t {
+    None,
+    Food,   // The NPC ate: its ConsumeFood command took a berry
+    Social  // The NPC socialized
+};
+
+// Outcome after action: plain values, built once per decision with no allocation
 struct Outcome {
-    std::map<std::string, float> needsDeltas;
-    std::string event;
+    Needs needsDelta{0.0f, 0.0f, 0.0f, 0.0f, 0.0f};  // Needs after the action minus before
+    ActionType action = ActionType::Idle;            // Logged as the outcome's "event"
+    OutcomeEvent event = OutcomeEvent::None;
+    
+    // ate: the engine resolved the action's ConsumeFood command in the NPC's favour
+    static Outcome of(const Action& action, const Needs& before, const Needs& after, bool ate);
+};
+
+// Something the engine observed during a tick, queued for the brains involved
+// and the event log (see Simulation::dispatchEvents). Plain values, so a
+// tick's events fill a reused buffer.
+struct EngineEvent {
+    enum class Type : uint8_t {
+        NpcMet  // npc and other came within meeting distance; value is the distance
+    };
+    
+    Type type = Type::NpcMet;
+    Tick tick = 0;
+    EntityId npc = 0;
+    EntityId other = 0;
+    uint32_t npcIndex = 0;    // Slots in the NPCStore
+    uint32_t otherIndex = 0;
+    float value = 0.0f;
+};
+
+using EngineEventQueue = std::vector<EngineEvent>;
+
+// Brain implementations, so callers can group or count brains without RTTI
+enum class BrainKind : uint8_t {
+    BehaviorTree,
+    Neural
 };
 
 // Brain interface - allows swapping AI implementations
 class IBrain {
 public:
     virtual ~IBrain() = default;
-    virtual Action decide(const Perception& perception, World& world) = 0;
+    virtual BrainKind kind() const = 0;
+    virtual Action decide(const Perception& perception, const World& world) = 0;
     virtual void onOutcome(const Outcome& outcome) = 0;
+    
+    // An engine event this brain's NPC took part in, as npc or other
+    virtual void onEvent(const EngineEvent& event) { (void)event; }
+    
+    // Optional capabilities; nullptr when the brain has none. The objects live
+    // as long as the brain, so callers may keep the pointers.
+    virtual const NPCMemory* memory() const { return nullptr; }
+    virtual SocialIntelligence* social() { return nullptr; }
+    
+    // Ticks between fresh decisions under AI level of detail; the engine
+    // reuses the last action in between (see DecisionScheduler)
+    virtual int decisionInterval() const { return 1; }
+    
+    // Two-phase decision for batched inference. prepareInput() queues the
+    // brain's model inputs on the scheduler and returns false if the brain has
+    // nothing to batch (the engine then calls decide() instead). applyOutput()
+    // is called after the scheduler ran, on the same tick or (with pipelined
+    // inference) a few ticks later, and turns the output row into an Action.
+    virtual bool prepareInput(const Perception& perception, const World& world,
+                              InferenceScheduler& scheduler) {
+        (void)perception;
+        (void)world;
+        (void)scheduler;
+        return false;
+    }
+    virtual Action applyOutput(const Perception& perception, const InferenceScheduler& scheduler) {
+        (void)perception;
+        (void)scheduler;
+        return Action{};
+    }
+    
+    // Everything that affects future decisions, for simulation snapshots.
+    // Brains without state can keep the defaults.
+    virtual void writeSnapshot(SnapshotWriter& out) const { (void)out; }
+    virtual bool readSnapshot(SnapshotReader& in) { (void)in; return true; }
 };
 
 } // namespace pw
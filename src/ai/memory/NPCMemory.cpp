@@ -1,76 +1,226 @@
 #include "NPCMemory.h"
+#include "serialization/Snapshot.h"
 #include <algorithm>
+#include <cstdint>
+#include <cmath>
 
 namespace pw {
 
-void NPCMemory::addMemory(const std::string& type, Vec2 location, Tick currentTick, float significance) {
-    memories.push_back(MemoryEntry(type, location, currentTick, significance));
-    
-    // Keep only most significant memories if we exceed max
-    if (memories.size() > MAX_MEMORIES) {
-        std::sort(memories.begin(), memories.end(),
-            [](const MemoryEntry& a, const MemoryEntry& b) {
-                return a.significance > b.significance;
-            });
-        memories.resize(MAX_MEMORIES);
+const char* memoryTypeName(MemoryType type) {
+    switch (type) {
+        case MemoryType::Food: return "food";
+        case MemoryType::Danger: return "danger";
+        case MemoryType::Npc: return "npc";
+        case MemoryType::Shelter: return "shelter";
+        default: return "unknown";
     }
 }
 
-std::vector<MemoryEntry> NPCMemory::recall(const std::string& type, int maxResults) const {
-    std::vector<MemoryEntry> result;
+bool parseMemoryType(const std::string& name, MemoryType& type) {
+    if (name == "food") type = MemoryType::Food;
+    else if (name == "danger") type = MemoryType::Danger;
+    else if (name == "npc") type = MemoryType::Npc;
+    else if (name == "shelter") type = MemoryType::Shelter;
+    else return false;
+    return true;
+}
+
+uint64_t NPCMemory::cellKey(int cx, int cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cy)) << 32) | static_cast<uint32_t>(cx);
+}
+
+int NPCMemory::cellCoord(float value) {
+    return static_cast<int>(std::floor(value / CELL_SIZE));
+}
+
+double NPCMemory::rankOf(const MemoryEntry& mem) {
+    return std::log(std::max(mem.significance, 1e-30f)) + static_cast<double>(DECAY_RATE) * mem.timestamp;
+}
+
+float NPCMemory::currentSignificance(const MemoryEntry& mem) const {
+    if (clock <= mem.timestamp) {
+        return mem.significance;
+    }
+    float age = static_cast<float>(clock - mem.timestamp);
+    return std::max(MIN_SIGNIFICANCE, mem.significance * std::exp(-DECAY_RATE * age));
+}
+
+void NPCMemory::addMemory(MemoryType type, Vec2 location, Tick currentTick, float significance) {
+    uint32_t slot = static_cast<uint32_t>(memories.size());
+    MemoryEntry entry(type, location, currentTick, significance);
+    double rank = rankOf(entry);
     
-    for (const auto& mem : memories) {
-        if (mem.type == type) {
-            result.push_back(mem);
+    if (memories.size() >= MAX_MEMORIES) {
+        // Full: the least significant memory is the last entry of some bucket.
+        // It makes room unless the new memory is weaker still.
+        uint32_t weakest = UINT32_MAX;
+        for (const auto& bucket : buckets) {
+            if (!bucket.empty() && (weakest == UINT32_MAX || ranks[bucket.back()] < ranks[weakest])) {
+                weakest = bucket.back();
+            }
+        }
+        if (weakest == UINT32_MAX || rank < ranks[weakest]) {
+            return;
         }
+        unindex(weakest);
+        slot = weakest;
+        memories[slot] = entry;
+        ranks[slot] = rank;
+    } else {
+        memories.push_back(entry);
+        ranks.push_back(rank);
     }
     
-    // Sort by significance
-    std::sort(result.begin(), result.end(),
-        [](const MemoryEntry& a, const MemoryEntry& b) {
-            return a.significance > b.significance;
-        });
+    index(slot);
+}
+
+MemoryRecall NPCMemory::recall(MemoryType type, int maxResults) const {
+    MemoryRecall result;
+    const auto& bucket = buckets[static_cast<size_t>(type)];
+    size_t count = std::min(bucket.size(), static_cast<size_t>(std::max(0, maxResults)));
     
-    if (result.size() > static_cast<size_t>(maxResults)) {
-        result.resize(maxResults);
+    for (size_t i = 0; i < count; ++i) {
+        if (!result.push_back(&memories[bucket[i]])) break;
     }
     
     return result;
 }
 
-std::vector<MemoryEntry> NPCMemory::recallNearby(Vec2 position, float radius, int maxResults) const {
-    std::vector<MemoryEntry> result;
+MemoryRecall NPCMemory::recallNearby(Vec2 position, float radius, int maxResults) const {
+    // Bounded top-k: best[] stays sorted by distance, nearest first
+    const size_t limit = std::min(MAX_RECALL, static_cast<size_t>(std::max(0, maxResults)));
+    std::array<std::pair<float, uint32_t>, MAX_RECALL> best;
+    size_t found = 0;
     
-    for (const auto& mem : memories) {
-        if (mem.location.distance(position) <= radius) {
-            result.push_back(mem);
+    auto consider = [&](uint32_t slot) {
+        float dist = memories[slot].location.distance(position);
+        if (dist > radius) return;
+        if (found == limit && (limit == 0 || dist >= best[found - 1].first)) return;
+        
+        size_t i = found < limit ? found++ : found - 1;
+        while (i > 0 && best[i - 1].first > dist) {
+            best[i] = best[i - 1];
+            --i;
         }
-    }
+        best[i] = {dist, slot};
+    };
     
-    // Sort by distance
-    std::sort(result.begin(), result.end(),
-        [position](const MemoryEntry& a, const MemoryEntry& b) {
-            return a.location.distance(position) < b.location.distance(position);
-        });
+    int minX = cellCoord(position.x - radius);
+    int maxX = cellCoord(position.x + radius);
+    int minY = cellCoord(position.y - radius);
+    int maxY = cellCoord(position.y + radius);
     
-    if (result.size() > static_cast<size_t>(maxResults)) {
-        result.resize(maxResults);
+    // Huge radii cover more cells than are occupied; walk the occupied ones instead
+    double span = (static_cast<double>(maxX) - minX + 1) * (static_cast<double>(maxY) - minY + 1);
+    if (span > static_cast<double>(cells.size())) {
+        for (const auto& [key, slots] : cells) {
+            for (uint32_t slot : slots) consider(slot);
+        }
+    } else {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            for (int cx = minX; cx <= maxX; ++cx) {
+                auto it = cells.find(cellKey(cx, cy));
+                if (it == cells.end()) continue;
+                for (uint32_t slot : it->second) consider(slot);
+            }
+        }
     }
     
+    MemoryRecall result;
+    for (size_t i = 0; i < found; ++i) {
+        result.push_back(&memories[best[i].second]);
+    }
     return result;
 }
 
 void NPCMemory::decay(Tick currentTick) {
-    // Decay significance over time
-    for (auto& mem : memories) {
-        Tick age = currentTick - mem.timestamp;
-        float decayRate = 0.001f;
-        mem.significance *= (1.0f - decayRate * age);
-        
-        if (mem.significance < 0.01f) {
-            mem.significance = 0.01f;
-        }
+    // Entries are decayed when read (currentSignificance)
+    clock = std::max(clock, currentTick);
+}
+
+void NPCMemory::writeSnapshot(SnapshotWriter& out) const {
+    out.writeVector(memories);
+    out.writeVector(ranks);
+    for (const auto& bucket : buckets) {
+        out.writeVector(bucket);
+    }
+    out.write(static_cast<uint64_t>(cells.size()));
+    for (const auto& [key, slots] : cells) {
+        out.write(key);
+        out.writeVector(slots);
+    }
+    out.write(clock);
+}
+
+bool NPCMemory::readSnapshot(SnapshotReader& in) {
+    in.readVector(memories, MAX_MEMORIES);
+    in.readVector(ranks, MAX_MEMORIES);
+    for (auto& bucket : buckets) {
+        in.readVector(bucket, MAX_MEMORIES);
+    }
+    
+    // Every cell holds at least one memory
+    cells.clear();
+    uint64_t cellCount = 0;
+    if (!in.read(cellCount) || cellCount > memories.size()) {
+        return false;
+    }
+    for (uint64_t i = 0; i < cellCount; i++) {
+        uint64_t key = 0;
+        in.read(key);
+        in.readVector(cells[key], MAX_MEMORIES);
+    }
+    in.read(clock);
+    
+    if (!in.ok() || ranks.size() != memories.size()) {
+        return false;
+    }
+    
+    // Slots must point at entries, or recall would read out of bounds
+    auto validSlots = [this](const std::vector<uint32_t>& slots) {
+        return std::all_of(slots.begin(), slots.end(), [this](uint32_t slot) { return slot < memories.size(); });
+    };
+    for (const auto& bucket : buckets) {
+        if (!validSlots(bucket)) return false;
+    }
+    for (const auto& [key, slots] : cells) {
+        if (!validSlots(slots)) return false;
     }
+    return true;
+}
+
+void NPCMemory::index(uint32_t slot) {
+    insertIntoBucket(slot);
+    
+    const Vec2& location = memories[slot].location;
+    cells[cellKey(cellCoord(location.x), cellCoord(location.y))].push_back(slot);
+}
+
+void NPCMemory::unindex(uint32_t slot) {
+    const MemoryEntry& mem = memories[slot];
+    
+    auto& bucket = buckets[static_cast<size_t>(mem.type)];
+    bucket.erase(std::find(bucket.begin(), bucket.end(), slot));
+    
+    auto cell = cells.find(cellKey(cellCoord(mem.location.x), cellCoord(mem.location.y)));
+    auto& slots = cell->second;
+    *std::find(slots.begin(), slots.end(), slot) = slots.back();
+    slots.pop_back();
+    if (slots.empty()) {
+        cells.erase(cell);
+    }
+}
+
+void NPCMemory::insertIntoBucket(uint32_t slot) {
+    auto& bucket = buckets[static_cast<size_t>(memories[slot].type)];
+    double rank = ranks[slot];
+    
+    // After existing memories of equal significance
+    auto position = std::upper_bound(bucket.begin(), bucket.end(), rank,
+        [this](double value, uint32_t other) {
+            return value > ranks[other];
+        });
+    bucket.insert(position, slot);
 }
 
 } // namespace pw
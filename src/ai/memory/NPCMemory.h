@@ -2,35 +2,91 @@
 
 #include "engine/Math.h"
 #include "engine/Types.h"
-#include <vector>
-#include <map>
+#include "engine/FixedVector.h"
+#include <array>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace pw {
 
+class SnapshotReader;
+class SnapshotWriter;
+
+enum class MemoryType : uint8_t {
+    Food,
+    Danger,
+    Npc,
+    Shelter
+};
+
+const char* memoryTypeName(MemoryType type);
+bool parseMemoryType(const std::string& name, MemoryType& type);
+
 struct MemoryEntry {
-    std::string type; // "food", "danger", "npc", "shelter"
+    MemoryType type = MemoryType::Food;
     Vec2 location;
-    Tick timestamp;
-    float significance = 1.0f;
+    Tick timestamp = 0;
+    float significance = 1.0f;  // As of timestamp; see NPCMemory::currentSignificance()
     
     MemoryEntry() = default;
-    MemoryEntry(const std::string& t, Vec2 loc, Tick ts, float sig = 1.0f)
+    MemoryEntry(MemoryType t, Vec2 loc, Tick ts, float sig = 1.0f)
         : type(t), location(loc), timestamp(ts), significance(sig) {}
 };
 
+// Recall results point into NPCMemory and stay valid until it is next modified
+static constexpr size_t MAX_RECALL = 16;
+using MemoryRecall = FixedVector<const MemoryEntry*, MAX_RECALL>;
+
+// Bounded episodic memory. Entries live in one dense array, indexed by a
+// per-type bucket sorted by significance and a uniform grid over locations,
+// so recall cost depends on the results and local density, not MAX_MEMORIES.
+//
+// Significance decays exponentially with age and is computed on read, so
+// decay() never touches the entries. Exponential decay keeps the order of any
+// two memories fixed over time, which is what lets the buckets stay sorted.
 class NPCMemory {
 public:
-    void addMemory(const std::string& type, Vec2 location, Tick currentTick, float significance = 1.0f);
-    std::vector<MemoryEntry> recall(const std::string& type, int maxResults = 5) const;
-    std::vector<MemoryEntry> recallNearby(Vec2 position, float radius, int maxResults = 5) const;
+    static constexpr size_t MAX_MEMORIES = 100;
+    static constexpr int CELL_SIZE = 16;  // Grid cell edge in tiles
+    static constexpr float DECAY_RATE = 0.001f;       // Per tick of age
+    static constexpr float MIN_SIGNIFICANCE = 0.01f;
+    
+    void addMemory(MemoryType type, Vec2 location, Tick currentTick, float significance = 1.0f);
+    
+    // Most significant memories of a type, best first
+    MemoryRecall recall(MemoryType type, int maxResults = 5) const;
+    // Memories within radius of position, nearest first
+    MemoryRecall recallNearby(Vec2 position, float radius, int maxResults = 5) const;
+    
+    // Advances the decay clock; O(1)
     void decay(Tick currentTick);
     
+    // Significance of mem as of the decay clock
+    float currentSignificance(const MemoryEntry& mem) const;
+    
     const std::vector<MemoryEntry>& getAllMemories() const { return memories; }
+    
+    // Entries and index order, so recall results match after a restore
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
 
 private:
+    static constexpr size_t TYPE_COUNT = static_cast<size_t>(MemoryType::Shelter) + 1;
+    
     std::vector<MemoryEntry> memories;
-    static constexpr int MAX_MEMORIES = 100;
+    std::vector<double> ranks;  // Time-invariant decay order: ln(significance) + DECAY_RATE * timestamp
+    std::array<std::vector<uint32_t>, TYPE_COUNT> buckets;      // Slots, most significant first
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;  // Slots by grid cell
+    Tick clock = 0;
+    
+    static double rankOf(const MemoryEntry& mem);
+    static uint64_t cellKey(int cx, int cy);
+    static int cellCoord(float value);
+    
+    void index(uint32_t slot);
+    void unindex(uint32_t slot);
+    void insertIntoBucket(uint32_t slot);
 };
 
 } // namespace pw
@@ -0,0 +1,152 @@
+#include "ai/neural/EpisodicBuffer.h"
+#include "serialization/Snapshot.h"
+#include <algorithm>
+#include <cmath>
+
+namespace pw {
+
+static_assert(EpisodicBuffer::CAPACITY <= 256, "heap stores slots as uint8_t");
+static_assert(simd::paddedSize(EpisodicBuffer::EMBEDDING_DIM) == EpisodicBuffer::EMBEDDING_DIM,
+              "embedding rows must stay vector-aligned");
+static_assert(EpisodicBuffer::TYPE_ONE_HOT + static_cast<size_t>(MemoryType::Shelter) <
+              EpisodicBuffer::EMBEDDING_DIM, "memory type one-hot must fit in the embedding");
+
+EpisodicBuffer::EpisodicBuffer() {
+    clear();
+}
+
+void EpisodicBuffer::clear() {
+    embeddings.fill(0.0f);
+    count = 0;
+}
+
+bool EpisodicBuffer::add(MemoryType type, Vec2 location, Tick timestamp, float significance) {
+    if (count < CAPACITY) {
+        size_t slot = count++;
+        write(slot, type, location, timestamp, significance);
+        heap[slot] = static_cast<uint8_t>(slot);
+        heapPosition[slot] = static_cast<uint8_t>(slot);
+        siftUp(slot);
+        return true;
+    }
+    
+    // Replace the least significant memory
+    size_t weakest = heap[0];
+    if (significance <= significances[weakest]) {
+        return false;
+    }
+    write(weakest, type, location, timestamp, significance);
+    siftDown(0);
+    return true;
+}
+
+void EpisodicBuffer::setSignificance(size_t slot, float value) {
+    float old = significances[slot];
+    significances[slot] = value;
+    embeddings[slot * EMBEDDING_DIM + SIGNIFICANCE] = value;
+    
+    if (value < old) {
+        siftUp(heapPosition[slot]);
+    } else {
+        siftDown(heapPosition[slot]);
+    }
+}
+
+void EpisodicBuffer::decay(size_t slot, Tick now, float rate) {
+    if (now <= decayedUntil[slot]) return;
+    const float ticks = static_cast<float>(now - decayedUntil[slot]);
+    decayedUntil[slot] = now;
+    setSignificance(slot, significances[slot] * std::exp(-rate * ticks));
+}
+
+void EpisodicBuffer::write(size_t slot, MemoryType type, Vec2 location, Tick timestamp, float significance) {
+    types[slot] = type;
+    locations[slot] = location;
+    timestamps[slot] = timestamp;
+    decayedUntil[slot] = timestamp;
+    significances[slot] = significance;
+    
+    float* row = &embeddings[slot * EMBEDDING_DIM];
+    std::fill(row, row + EMBEDDING_DIM, 0.0f);
+    row[POSITION_X] = location.x / extent.x;
+    row[POSITION_Y] = location.y / extent.y;
+    row[SIGNIFICANCE] = significance;
+    row[TYPE_ONE_HOT + static_cast<size_t>(type)] = 1.0f;
+}
+
+void EpisodicBuffer::writeSnapshot(SnapshotWriter& out) const {
+    out.write(static_cast<uint64_t>(count));
+    out.write(extent);
+    out.write(embeddings);
+    out.write(significances);
+    out.write(timestamps);
+    out.write(decayedUntil);
+    out.write(locations);
+    out.write(types);
+    out.write(heap);
+    out.write(heapPosition);
+}
+
+bool EpisodicBuffer::readSnapshot(SnapshotReader& in) {
+    uint64_t stored = 0;
+    if (!in.read(stored) || stored > CAPACITY) {
+        clear();
+        return false;
+    }
+    count = static_cast<size_t>(stored);
+    in.read(extent);
+    in.read(embeddings);
+    in.read(significances);
+    in.read(timestamps);
+    in.read(decayedUntil);
+    in.read(locations);
+    in.read(types);
+    in.read(heap);
+    in.read(heapPosition);
+    
+    for (size_t i = 0; in.ok() && i < count; i++) {
+        if (heap[i] >= count || heapPosition[heap[i]] != i) {
+            clear();
+            return false;
+        }
+    }
+    if (!in.ok()) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool EpisodicBuffer::heapLess(size_t a, size_t b) const {
+    return significances[heap[a]] < significances[heap[b]];
+}
+
+void EpisodicBuffer::heapSwap(size_t a, size_t b) {
+    std::swap(heap[a], heap[b]);
+    heapPosition[heap[a]] = static_cast<uint8_t>(a);
+    heapPosition[heap[b]] = static_cast<uint8_t>(b);
+}
+
+void EpisodicBuffer::siftUp(size_t position) {
+    while (position > 0) {
+        size_t parent = (position - 1) / 2;
+        if (!heapLess(position, parent)) break;
+        heapSwap(position, parent);
+        position = parent;
+    }
+}
+
+void EpisodicBuffer::siftDown(size_t position) {
+    for (;;) {
+        size_t smallest = position;
+        size_t left = position * 2 + 1;
+        size_t right = left + 1;
+        if (left < count && heapLess(left, smallest)) smallest = left;
+        if (right < count && heapLess(right, smallest)) smallest = right;
+        if (smallest == position) break;
+        heapSwap(position, smallest);
+        position = smallest;
+    }
+}
+
+} // namespace pw
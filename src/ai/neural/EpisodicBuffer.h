@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ai/memory/NPCMemory.h"
+#include "ai/neural/InferenceScheduler.h"
+#include "engine/Math.h"
+#include "engine/SimdMath.h"
+#include "engine/Types.h"
+#include <array>
+#include <cstdint>
+
+namespace pw {
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// Fixed-capacity episodic memory for NeuralBrain, stored as structure-of-arrays.
+// Each memory owns one row of a [CAPACITY][EMBEDDING_DIM] matrix that is kept in
+// the model's memory-input layout, so context() can be handed to inference
+// as-is; unused rows stay zero. When full, a new memory replaces the least
+// significant one (tracked with a min-heap) if it is more significant.
+class EpisodicBuffer {
+public:
+    static constexpr size_t CAPACITY = InferenceScheduler::MEMORY_SEQ_LEN;
+    static constexpr size_t EMBEDDING_DIM = InferenceScheduler::MEMORY_DIM;
+    
+    // Embedding row layout
+    static constexpr size_t POSITION_X = 0;
+    static constexpr size_t POSITION_Y = 1;
+    static constexpr size_t SIGNIFICANCE = 2;
+    static constexpr size_t ATTENTION = 3;
+    static constexpr size_t TYPE_ONE_HOT = 4;  // One slot per MemoryType
+    
+    EpisodicBuffer();
+    
+    void clear();
+    
+    // Returns false if the buffer is full of more significant memories
+    bool add(MemoryType type, Vec2 location, Tick timestamp, float significance);
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    
+    // [CAPACITY][EMBEDDING_DIM] model input
+    const float* context() const { return embeddings.data(); }
+    const float* embedding(size_t slot) const { return &embeddings[slot * EMBEDDING_DIM]; }
+    
+    MemoryType type(size_t slot) const { return types[slot]; }
+    Vec2 location(size_t slot) const { return locations[slot]; }
+    Tick timestamp(size_t slot) const { return timestamps[slot]; }
+    float significance(size_t slot) const { return significances[slot]; }
+    float attention(size_t slot) const { return embeddings[slot * EMBEDDING_DIM + ATTENTION]; }
+    
+    // Significance changes must go through here to keep eviction order valid
+    void setSignificance(size_t slot, float value);
+    
+    // Scale significance by exp(-rate) per tick since the memory was added or
+    // last decayed, so the result doesn't depend on how often this is called
+    void decay(size_t slot, Tick now, float rate);
+    void setAttention(size_t slot, float value) { embeddings[slot * EMBEDDING_DIM + ATTENTION] = value; }
+    
+    // World size that positions are normalized by; applies to memories added afterwards
+    void setExtent(Vec2 worldSize) { extent = worldSize; }
+    
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
+
+private:
+    alignas(simd::ALIGNMENT) std::array<float, CAPACITY * EMBEDDING_DIM> embeddings;
+    std::array<float, CAPACITY> significances;
+    std::array<Tick, CAPACITY> timestamps;
+    std::array<Tick, CAPACITY> decayedUntil;
+    std::array<Vec2, CAPACITY> locations;
+    std::array<MemoryType, CAPACITY> types;
+    
+    // Min-heap of slots on significance, and each slot's position in it
+    std::array<uint8_t, CAPACITY> heap;
+    std::array<uint8_t, CAPACITY> heapPosition;
+    size_t count = 0;
+    Vec2 extent = Vec2(static_cast<float>(WORLD_WIDTH), static_cast<float>(WORLD_HEIGHT));
+    
+    void write(size_t slot, MemoryType type, Vec2 location, Tick timestamp, float significance);
+    bool heapLess(size_t a, size_t b) const;
+    void heapSwap(size_t a, size_t b);
+    void siftUp(size_t position);
+    void siftDown(size_t position);
+};
+
+} // namespace pw
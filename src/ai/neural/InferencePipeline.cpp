@@ -0,0 +1,86 @@
+#include "ai/neural/InferencePipeline.h"
+#include "engine/Profiler.h"
+#include <chrono>
+
+namespace pw {
+
+InferencePipeline::~InferencePipeline() {
+    if (!thread.joinable()) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void InferencePipeline::start(int latency) {
+    if (latency < 1 || thread.joinable()) return;
+    
+    latencyTicks = latency;
+    slots.resize(static_cast<size_t>(latency) + 1);
+    for (Slot& s : slots) {
+        s.scheduler = std::make_unique<InferenceScheduler>();
+    }
+    thread = std::thread(&InferencePipeline::run, this);
+}
+
+void InferencePipeline::launch(Tick tick) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t index = static_cast<size_t>(tick % slots.size());
+        slots[index].sequence = ++launched;
+        queue.push_back(index);
+    }
+    wake.notify_one();
+}
+
+void InferencePipeline::wait(Tick tick) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t sequence = slots[tick % slots.size()].sequence;
+    if (completed >= sequence) return;
+    
+    PW_PROFILE_ZONE("inference/stall");
+    const auto start = std::chrono::steady_clock::now();
+    finished.wait(lock, [&] { return completed >= sequence; });
+    totals.stalls++;
+    totals.stallMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void InferencePipeline::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return completed >= launched; });
+}
+
+InferencePipelineStats InferencePipeline::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totals;
+}
+
+void InferencePipeline::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;  // Stopping with nothing left to run
+        
+        const size_t index = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        
+        // Single-threaded: the job system's workers belong to the simulation
+        const auto start = std::chrono::steady_clock::now();
+        slots[index].scheduler->run(nullptr);
+        const double elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        lock.lock();
+        completed++;
+        totals.batches++;
+        totals.inferenceMs += elapsed;
+        finished.notify_all();
+    }
+}
+
+} // namespace pw
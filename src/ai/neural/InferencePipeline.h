@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ai/neural/InferenceScheduler.h"
+#include "engine/Types.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pw {
+
+struct InferencePipelineStats {
+    uint64_t batches = 0;    // Ticks' requests run on the inference thread
+    double inferenceMs = 0;  // Time the inference thread spent running them
+    uint64_t stalls = 0;     // wait() calls that had to block
+    double stallMs = 0;      // Time the simulation thread spent blocked
+};
+
+// Runs each tick's batched inference on a dedicated thread while the
+// simulation carries on, for results read latency ticks later. Requests
+// submitted on tick t go to slot(t); launch(t) hands them over and wait(t)
+// returns once they have run, so slot(t) is safe to read until it is reused
+// at tick t + latency + 1. One thread launches and waits.
+class InferencePipeline {
+public:
+    InferencePipeline() = default;
+    ~InferencePipeline();  // Finishes launched work and joins the inference thread
+    
+    InferencePipeline(const InferencePipeline&) = delete;
+    InferencePipeline& operator=(const InferencePipeline&) = delete;
+    
+    // Starts the inference thread; latency < 1 leaves the pipeline off
+    void start(int latency);
+    bool enabled() const { return latencyTicks > 0; }
+    Tick latency() const { return static_cast<Tick>(latencyTicks); }
+    
+    // Scheduler collecting tick's requests
+    InferenceScheduler& slot(Tick tick) { return *slots[tick % slots.size()].scheduler; }
+    const InferenceScheduler& slot(Tick tick) const { return *slots[tick % slots.size()].scheduler; }
+    
+    void launch(Tick tick);
+    void wait(Tick tick);
+    void drain();  // wait() for everything launched
+    
+    InferencePipelineStats stats() const;
+
+private:
+    struct Slot {
+        std::unique_ptr<InferenceScheduler> scheduler;
+        uint64_t sequence = 0;  // launch() count when last launched; guarded by mutex
+    };
+    
+    int latencyTicks = 0;
+    std::vector<Slot> slots;  // latency + 1, so a slot is never read and filled on one tick
+    
+    mutable std::mutex mutex;
+    std::condition_variable wake;      // Inference thread waits for work
+    std::condition_variable finished;  // wait() waits for the inference thread
+    std::deque<size_t> queue;          // Launched slots, oldest first; guarded by mutex
+    uint64_t launched = 0;             // Guarded by mutex
+    uint64_t completed = 0;            // Guarded by mutex
+    bool stopping = false;             // Guarded by mutex
+    InferencePipelineStats totals;     // Guarded by mutex
+    
+    std::thread thread;
+    
+    void run();
+};
+
+} // namespace pw
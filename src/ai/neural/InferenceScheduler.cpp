@@ -0,0 +1,163 @@
+#include "ai/neural/InferenceScheduler.h"
+#include "ai/neural/ModelRegistry.h"
+#include "engine/JobSystem.h"
+#include "engine/Profiler.h"
+#include <cstdint>
+#include <iostream>
+
+namespace pw {
+
+InferenceScheduler::InferenceScheduler()
+#ifdef HAS_ONNX_RUNTIME
+    : memoryInfo(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault))
+#endif
+{
+}
+
+void InferenceScheduler::beginTick() {
+    for (size_t i = 0; i < activeBatches; ++i) {
+        Batch& batch = batches[i];
+        batch.rows = 0;
+        batch.perception.clear();
+        batch.memory.clear();
+        batch.output.clear();
+        batch.outputStride = 0;
+    }
+    activeBatches = 0;
+}
+
+InferenceTicket InferenceScheduler::submit(SharedModel* model, const float* perception,
+                                           const float* memory) {
+    InferenceTicket ticket;
+    if (!model) return ticket;
+    
+    std::lock_guard<std::mutex> lock(submitMutex);
+    
+    // Find the batch for this model
+    size_t batchIndex = 0;
+    while (batchIndex < activeBatches && batches[batchIndex].model != model) {
+        batchIndex++;
+    }
+    if (batchIndex == activeBatches) {
+        if (activeBatches == batches.size()) {
+            batches.emplace_back();
+        }
+        batches[batchIndex].model = model;
+        activeBatches++;
+    }
+    
+    Batch& batch = batches[batchIndex];
+    batch.perception.insert(batch.perception.end(), perception, perception + PERCEPTION_DIM);
+    batch.memory.insert(batch.memory.end(), memory, memory + MEMORY_CONTEXT_SIZE);
+    
+    ticket.batch = static_cast<int>(batchIndex);
+    ticket.row = static_cast<int>(batch.rows++);
+    return ticket;
+}
+
+#ifdef HAS_ONNX_RUNTIME
+void InferenceScheduler::runBatch(Batch& batch) {
+    try {
+        // Perception: (batch=N, perception_dim=20)
+        std::vector<int64_t> perceptionShape = {
+            static_cast<int64_t>(batch.rows),
+            static_cast<int64_t>(PERCEPTION_DIM)
+        };
+        
+        // Memory: (batch=N, seq_len=50, embedding_dim=32)
+        std::vector<int64_t> memoryShape = {
+            static_cast<int64_t>(batch.rows),
+            static_cast<int64_t>(MEMORY_SEQ_LEN),
+            static_cast<int64_t>(MEMORY_DIM)
+        };
+        
+        Ort::Value perceptionTensor = Ort::Value::CreateTensor<float>(
+            memoryInfo, batch.perception.data(), batch.perception.size(),
+            perceptionShape.data(), perceptionShape.size());
+        
+        Ort::Value memoryTensor = Ort::Value::CreateTensor<float>(
+            memoryInfo, batch.memory.data(), batch.memory.size(),
+            memoryShape.data(), memoryShape.size());
+        
+        const char* inputNames[] = {"perception", "memory"};
+        const char* outputNames[] = {"output"};
+        Ort::Value inputTensors[] = {std::move(perceptionTensor), std::move(memoryTensor)};
+        
+        std::shared_ptr<Ort::Session> session = batch.model->getSession();
+        auto outputTensors = session->Run(
+            Ort::RunOptions{nullptr}, inputNames, inputTensors, 2, outputNames, 1);
+        
+        const float* outputData = outputTensors[0].GetTensorMutableData<float>();
+        auto outputShape = outputTensors[0].GetTensorTypeAndShapeInfo().GetShape();
+        size_t outputSize = 1;
+        for (auto dim : outputShape) outputSize *= dim;
+        
+        batch.output.assign(outputData, outputData + outputSize);
+        batch.outputStride = outputSize / batch.rows;
+    
+    } catch (const Ort::Exception& e) {
+        std::cerr << "Batched inference error: " << e.what() << std::endl;
+        batch.output.clear();
+        batch.outputStride = 0;
+    }
+}
+#endif
+
+void InferenceScheduler::runNative(Batch& batch, const NativeModel& native, JobSystem* jobs) {
+    batch.output.resize(batch.rows * OUTPUT_DIM);
+    batch.outputStride = OUTPUT_DIM;
+    auto runRows = [&](size_t begin, size_t end, int) {
+        native.run(batch.perception.data() + begin * PERCEPTION_DIM,
+                   batch.memory.data() + begin * MEMORY_CONTEXT_SIZE, end - begin,
+                   batch.output.data() + begin * OUTPUT_DIM);
+    };
+    
+    // Rows are independent, so the split does not change the results
+    if (jobs && batch.rows > NATIVE_GRAIN) {
+        jobs->parallelFor(batch.rows, NATIVE_GRAIN, runRows);
+    } else {
+        runRows(0, batch.rows, 0);
+    }
+}
+
+void InferenceScheduler::run(JobSystem* jobs) {
+    PW_PROFILE_ZONE("inference/batched");
+    for (size_t i = 0; i < activeBatches; ++i) {
+        Batch& batch = batches[i];
+        if (batch.rows == 0) continue;
+        
+        if (std::shared_ptr<const NativeModel> native = batch.model->getNative()) {
+            runNative(batch, *native, jobs);
+        }
+#ifdef HAS_ONNX_RUNTIME
+        else {
+            runBatch(batch);
+        }
+#endif
+    }
+}
+
+const float* InferenceScheduler::output(const InferenceTicket& ticket, size_t& outputSize) const {
+    outputSize = 0;
+    if (!ticket.valid() || static_cast<size_t>(ticket.batch) >= activeBatches) {
+        return nullptr;
+    }
+    
+    const Batch& batch = batches[ticket.batch];
+    if (batch.outputStride == 0 || static_cast<size_t>(ticket.row) >= batch.rows) {
+        return nullptr;
+    }
+    
+    outputSize = batch.outputStride;
+    return batch.output.data() + ticket.row * batch.outputStride;
+}
+
+size_t InferenceScheduler::pendingRows() const {
+    size_t rows = 0;
+    for (size_t i = 0; i < activeBatches; ++i) {
+        rows += batches[i].rows;
+    }
+    return rows;
+}
+
+} // namespace pw
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#ifdef HAS_ONNX_RUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace pw {
+
+class JobSystem;
+class NativeModel;
+class SharedModel;
+
+// Handle to one queued row of a batched inference call
+struct InferenceTicket {
+    int batch = -1;
+    int row = -1;
+    
+    bool valid() const { return batch >= 0 && row >= 0; }
+};
+
+// Tick-level inference scheduler: brains submit their model inputs during the
+// prepare phase, run() issues a single session call per model for the whole
+// batch, and brains read their output row back during the apply phase.
+class InferenceScheduler {
+public:
+    // Model input/output contract (see tools/model_architecture.py)
+    static constexpr size_t PERCEPTION_DIM = 20;
+    static constexpr size_t MEMORY_SEQ_LEN = 50;
+    static constexpr size_t MEMORY_DIM = 32;
+    static constexpr size_t MEMORY_CONTEXT_SIZE = MEMORY_SEQ_LEN * MEMORY_DIM;
+    static constexpr size_t ACTION_DIM = 9;
+    static constexpr size_t OUTPUT_DIM = 12;  // 9 actions + 3 emotions
+    
+    InferenceScheduler();
+    
+    // Drop last tick's rows (buffers keep their capacity)
+    void beginTick();
+
+    // Queue one row for the given model. Inputs are copied into the batch.
+    // Safe to call from several threads; row order within a batch is unspecified.
+    InferenceTicket submit(SharedModel* model, const float* perception, const float* memory);
+
+    // Run every pending batch. Native models split theirs across jobs, if given.
+    void run(JobSystem* jobs = nullptr);
+    
+    // Output row for a ticket; returns nullptr (and size 0) if unavailable
+    const float* output(const InferenceTicket& ticket, size_t& outputSize) const;
+    
+    size_t pendingRows() const;
+    size_t batchCount() const { return activeBatches; }
+
+private:
+    struct Batch {
+        SharedModel* model = nullptr;
+        size_t rows = 0;
+        std::vector<float> perception;  // [rows, PERCEPTION_DIM]
+        std::vector<float> memory;      // [rows, MEMORY_SEQ_LEN, MEMORY_DIM]
+        std::vector<float> output;      // [rows, outputStride]
+        size_t outputStride = 0;
+    };
+    
+    // NPCs per job when a native model's batch is split
+    static constexpr size_t NATIVE_GRAIN = 64;
+    
+    std::vector<Batch> batches;
+    size_t activeBatches = 0;
+    std::mutex submitMutex;
+
+    void runNative(Batch& batch, const NativeModel& native, JobSystem* jobs);
+
+#ifdef HAS_ONNX_RUNTIME
+    Ort::MemoryInfo memoryInfo{nullptr};
+    
+    void runBatch(Batch& batch);
+#endif
+};
+
+} // namespace pw
@@ -0,0 +1,218 @@
+#include "ai/neural/ModelRegistry.h"
+#include <iostream>
+
+namespace pw {
+
+bool parseInferenceBackend(const std::string& name, InferenceBackend& backend) {
+    if (name == "auto") {
+        backend = InferenceBackend::Auto;
+    } else if (name == "onnx") {
+        backend = InferenceBackend::OnnxRuntime;
+    } else if (name == "native") {
+        backend = InferenceBackend::Native;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseGraphOptimization(const std::string& name, GraphOptimization& level) {
+    if (name == "disabled") {
+        level = GraphOptimization::Disabled;
+    } else if (name == "basic") {
+        level = GraphOptimization::Basic;
+    } else if (name == "extended") {
+        level = GraphOptimization::Extended;
+    } else if (name == "all") {
+        level = GraphOptimization::All;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+void ModelRegistry::configure(const InferenceSettings& newSettings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = newSettings;
+    failedLoads.clear();
+}
+
+InferenceSettings ModelRegistry::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+std::shared_ptr<SharedModel> ModelRegistry::acquire(const std::string& modelPath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    auto it = models.find(modelPath);
+    if (it != models.end()) {
+        return it->second;
+    }
+    
+    if (modelPath.empty()) {
+        return nullptr;
+    }
+    
+    // Skip (quietly) a file that already failed and hasn't changed since
+    const std::string file = resolve(modelPath);
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(file, error);
+    if (error) {
+        modified = std::filesystem::file_time_type::min();
+    }
+    auto failed = failedLoads.find(modelPath);
+    if (failed != failedLoads.end() && failed->second == modified) {
+        return nullptr;
+    }
+    
+    auto model = load(modelPath, file, modified);
+    if (model) {
+        models.emplace(modelPath, model);
+        failedLoads.erase(modelPath);
+    } else {
+        failedLoads[modelPath] = modified;
+    }
+    return model;
+}
+
+size_t ModelRegistry::reloadChanged() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t reloaded = 0;
+    
+    for (auto& [path, model] : models) {
+        std::error_code error;
+        const auto modified = std::filesystem::last_write_time(model->file, error);
+        if (error || modified == model->modifiedTime) continue;
+        model->modifiedTime = modified;
+        
+        if (!loadEngine(*model, model->file)) {
+            std::cerr << "Warning: Could not reload " << model->file << ", keeping version "
+                      << model->getVersion() << std::endl;
+            continue;
+        }
+        const uint32_t version = model->version.fetch_add(1, std::memory_order_acq_rel) + 1;
+        std::cout << "Reloaded model " << model->file << " (version " << version << ")" << std::endl;
+        reloaded++;
+    }
+    return reloaded;
+}
+
+size_t ModelRegistry::loadedModelCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return models.size();
+}
+
+void ModelRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    models.clear();
+    failedLoads.clear();
+}
+
+std::shared_ptr<SharedModel> ModelRegistry::load(const std::string& modelPath, const std::string& file,
+                                                 std::filesystem::file_time_type modified) {
+    auto model = std::make_shared<SharedModel>(modelPath);
+    model->file = file;
+    model->modifiedTime = modified;
+    
+    // acquire() skips a failed file until it changes, so these print once per version
+    if (modified == std::filesystem::file_time_type::min()) {
+        std::cerr << "Warning: No model at " << model->file
+                  << ", NeuralBrain will use fallback behavior" << std::endl;
+        return nullptr;
+    }
+    if (!loadEngine(*model, model->file)) {
+        std::cerr << "Warning: Could not load model " << model->file
+                  << ", NeuralBrain will use fallback behavior" << std::endl;
+        return nullptr;
+    }
+    return model;
+}
+
+std::string ModelRegistry::resolve(const std::string& modelPath) const {
+    std::filesystem::path nativePath(modelPath);
+    nativePath.replace_extension(".pwnn");
+    
+    switch (settings.backend) {
+        case InferenceBackend::Native:
+            return nativePath.string();
+        case InferenceBackend::OnnxRuntime:
+            return modelPath;
+        case InferenceBackend::Auto:
+            break;
+    }
+    std::error_code error;
+#ifdef HAS_ONNX_RUNTIME
+    return std::filesystem::exists(nativePath, error) ? nativePath.string() : modelPath;
+#else
+    // Nothing else could run the model
+    (void)error;
+    return nativePath.string();
+#endif
+}
+
+bool ModelRegistry::loadEngine(SharedModel& model, const std::string& file) {
+    if (std::filesystem::path(file).extension() == ".pwnn") {
+        auto native = std::make_shared<NativeModel>();
+        if (!native->load(file, settings.weightPrecision)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(model.engineMutex);
+        model.native = std::move(native);
+        return true;
+    }
+    
+#ifdef HAS_ONNX_RUNTIME
+    std::shared_ptr<Ort::Session> session = createSession(file);
+    if (!session) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(model.engineMutex);
+    model.session = std::move(session);
+    return true;
+#else
+    std::cerr << "Warning: " << file << " needs ONNX Runtime, which this build does not have" << std::endl;
+    return false;
+#endif
+}
+
+#ifdef HAS_ONNX_RUNTIME
+std::shared_ptr<Ort::Session> ModelRegistry::createSession(const std::string& modelPath) {
+    try {
+        if (!env) {
+            env = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "NeuralBrain");
+        }
+        
+        Ort::SessionOptions options;
+        options.SetIntraOpNumThreads(settings.intraOpThreads);
+        options.SetInterOpNumThreads(settings.interOpThreads);
+        
+        switch (settings.graphOptimization) {
+            case GraphOptimization::Disabled:
+                options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+                break;
+            case GraphOptimization::Basic:
+                options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
+                break;
+            case GraphOptimization::Extended:
+                options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+                break;
+            case GraphOptimization::All:
+                options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+                break;
+        }
+        
+        return std::make_shared<Ort::Session>(*env, modelPath.c_str(), options);
+    } catch (const Ort::Exception& e) {
+        std::cerr << "ONNX Runtime error: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+#endif
+
+} // namespace pw
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "ai/neural/NativeModel.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#ifdef HAS_ONNX_RUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace pw {
+
+enum class GraphOptimization {
+    Disabled,
+    Basic,
+    Extended,
+    All
+};
+
+// Which engine runs a model. Native is NativeModel on a .pwnn weights file
+// (for an .onnx path, the file beside it with that extension); Auto uses it
+// when that file exists and ONNX Runtime otherwise.
+enum class InferenceBackend {
+    Auto,
+    OnnxRuntime,
+    Native
+};
+
+// Reads "auto", "onnx" or "native"
+bool parseInferenceBackend(const std::string& name, InferenceBackend& backend);
+
+// Reads "disabled", "basic", "extended" or "all"
+bool parseGraphOptimization(const std::string& name, GraphOptimization& level);
+
+// Session settings applied to every model the registry loads
+struct InferenceSettings {
+    InferenceBackend backend = InferenceBackend::Auto;
+    WeightPrecision weightPrecision = WeightPrecision::Float32;  // Native models only
+    
+    // ONNX Runtime sessions only; 0 threads lets ONNX Runtime pick
+    int intraOpThreads = 1;
+    int interOpThreads = 1;
+    GraphOptimization graphOptimization = GraphOptimization::Basic;
+};
+
+// One loaded model, shared by every brain that uses the same model path
+class SharedModel {
+public:
+    explicit SharedModel(const std::string& path) : path(path) {}
+    
+    const std::string& getPath() const { return path; }
+    
+    // File the model was read from: the path itself, or its .pwnn sibling
+    const std::string& getFile() const { return file; }
+    
+    // 1 for the first load, bumped each time ModelRegistry::reloadChanged()
+    // swaps in a new version
+    uint32_t getVersion() const { return version.load(std::memory_order_acquire); }
+    
+    // Hold the returned engine for the whole call: a reload only drops the
+    // model's reference, so an engine in use is never destroyed under it.
+    // Exactly one of the two is set.
+    std::shared_ptr<const NativeModel> getNative() const {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        return native;
+    }
+#ifdef HAS_ONNX_RUNTIME
+    std::shared_ptr<Ort::Session> getSession() const {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        return session;
+    }
+#endif
+
+private:
+    friend class ModelRegistry;
+    
+    std::string path;
+    std::string file;
+    std::atomic<uint32_t> version{1};
+    std::filesystem::file_time_type modifiedTime{};  // Of the file last loaded (or tried)
+    mutable std::mutex engineMutex;
+    std::shared_ptr<const NativeModel> native;
+#ifdef HAS_ONNX_RUNTIME
+    std::shared_ptr<Ort::Session> session;
+#endif
+};
+
+// Process-wide model registry: one ONNX Runtime environment per process and
+// one engine per model path. Brains only hold a handle to the shared model.
+class ModelRegistry {
+public:
+    static ModelRegistry& instance();
+    
+    // Settings only affect models loaded after the call; paths that failed
+    // to load are tried again with them
+    void configure(const InferenceSettings& settings);
+    InferenceSettings getSettings() const;
+    
+    // Load (or reuse) the model at modelPath. Returns nullptr if it cannot be
+    // loaded. Failures are not cached: the file is tried again (and warned
+    // about again) once it appears or changes.
+    std::shared_ptr<SharedModel> acquire(const std::string& modelPath);
+    
+    // Reload, in place, every loaded model whose file has changed since it was
+    // read, so brains pick up a retrained model on their next inference without
+    // a restart. A file that fails to load leaves the old session running, and
+    // is tried again when it next changes. Writers should replace the file
+    // atomically (write a temporary, then rename). Returns models reloaded.
+    size_t reloadChanged();
+    
+    size_t loadedModelCount() const;
+    
+    // Drop the registry's references (brains keep theirs alive)
+    void clear();
+
+private:
+    ModelRegistry() = default;
+    
+    mutable std::mutex mutex;
+    InferenceSettings settings;
+    std::map<std::string, std::shared_ptr<SharedModel>> models;
+    
+    // Paths that failed to load, with the write time of the file tried
+    // (file_time_type::min() if it was missing)
+    std::map<std::string, std::filesystem::file_time_type> failedLoads;
+
+#ifdef HAS_ONNX_RUNTIME
+    std::unique_ptr<Ort::Env> env;
+#endif
+
+    std::shared_ptr<SharedModel> load(const std::string& modelPath, const std::string& file,
+                                      std::filesystem::file_time_type modified);
+    
+    // The file settings.backend reads for modelPath
+    std::string resolve(const std::string& modelPath) const;
+    
+    // Loads file into model's engine slot; false (with a warning) on failure
+    bool loadEngine(SharedModel& model, const std::string& file);
+#ifdef HAS_ONNX_RUNTIME
+    std::shared_ptr<Ort::Session> createSession(const std::string& modelPath);
+#endif
+};
+
+} // namespace pw
@@ -0,0 +1,454 @@
+#include "ai/neural/NativeModel.h"
+#include "ai/neural/InferenceScheduler.h"
+#include "engine/Random.h"
+#include "serialization/Snapshot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace pw {
+
+namespace {
+
+constexpr size_t MAX_DIM = 4096;  // Sanity bound on every dimension in a file
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7FFFFFFFu;
+    
+    if (magnitude >= 0x7F800000u) {  // Inf or NaN
+        return static_cast<uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477FF000u) {  // Rounds past the largest half
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (magnitude < 0x38800000u) {  // Subnormal half (or zero)
+        if (magnitude < 0x33000000u) return static_cast<uint16_t>(sign);
+        const uint32_t exponent = magnitude >> 23;
+        const uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1u))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+    
+    // Normal: rebias the exponent and round the mantissa to nearest even
+    uint32_t half = ((magnitude - 0x38000000u) >> 13);
+    const uint32_t remainder = magnitude & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+void relu(float* values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        values[i] = std::max(values[i], 0.0f);
+    }
+}
+
+bool readTensor(SnapshotReader& in, std::vector<float>& values, size_t expected) {
+    return in.readVector(values, expected) && values.size() == expected;
+}
+
+} // namespace
+
+bool parseWeightPrecision(const std::string& name, WeightPrecision& precision) {
+    if (name == "fp32") {
+        precision = WeightPrecision::Float32;
+    } else if (name == "fp16") {
+        precision = WeightPrecision::Float16;
+    } else if (name == "int8") {
+        precision = WeightPrecision::Int8;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* weightPrecisionName(WeightPrecision precision) {
+    switch (precision) {
+        case WeightPrecision::Float16: return "fp16";
+        case WeightPrecision::Int8: return "int8";
+        case WeightPrecision::Float32: break;
+    }
+    return "fp32";
+}
+
+// Per-thread activations of one chunk, reused across calls
+struct NativeModel::Workspace {
+    simd::AlignedFloats weights;         // An fp16 matrix expanded to fp32
+    std::vector<int16_t> activations;    // Input rows quantized for an int8 matrix
+    std::vector<float> activationScales;
+    std::vector<int32_t> products;
+    std::vector<float> hidden;
+    std::vector<float> query;
+    std::vector<float> memory;
+    std::vector<float> queries;
+    std::vector<float> keyValues;
+    std::vector<float> attended;
+    std::vector<float> projected;
+    std::vector<float> scores;
+};
+
+void NativeModel::Linear::assign(size_t inputCount, size_t outputCount, const std::vector<float>& values,
+                                 std::vector<float> biasValues, WeightPrecision storage) {
+    inputs = inputCount;
+    outputs = outputCount;
+    precision = storage;
+    bias = std::move(biasValues);
+    weights.clear();
+    halves.clear();
+    quantized.clear();
+    scales.clear();
+    
+    switch (precision) {
+        case WeightPrecision::Float32:
+            weights.assign(values.begin(), values.end());
+            break;
+        case WeightPrecision::Float16:
+            halves.resize(values.size());
+            for (size_t i = 0; i < values.size(); i++) {
+                halves[i] = floatToHalf(values[i]);
+            }
+            break;
+        case WeightPrecision::Int8:
+            quantized.resize(values.size());
+            scales.resize(outputs);
+            for (size_t o = 0; o < outputs; o++) {
+                const float* row = values.data() + o * inputs;
+                float largest = 0.0f;
+                for (size_t i = 0; i < inputs; i++) largest = std::max(largest, std::fabs(row[i]));
+                const float scale = largest > 0.0f ? largest / 127.0f : 1.0f;
+                scales[o] = scale;
+                for (size_t i = 0; i < inputs; i++) {
+                    quantized[o * inputs + i] = static_cast<int8_t>(std::lround(row[i] / scale));
+                }
+            }
+            break;
+    }
+}
+
+size_t NativeModel::Linear::bytes() const {
+    return weights.size() * sizeof(float) + halves.size() * sizeof(uint16_t) + quantized.size()
+        + (scales.size() + bias.size()) * sizeof(float);
+}
+
+void NativeModel::Linear::apply(const float* input, size_t rows, float* out, Workspace& workspace) const {
+    if (precision == WeightPrecision::Int8) {
+        applyQuantized(input, rows, out, workspace);
+        return;
+    }
+    
+    const float* matrix = weights.data();
+    if (precision == WeightPrecision::Float16) {
+        // Expanded once per call and then reused by every row of the chunk
+        workspace.weights.resize(inputs * outputs);
+        simd::halvesToFloats(halves.data(), halves.size(), workspace.weights.data());
+        matrix = workspace.weights.data();
+    }
+    
+    simd::multiplyTransposed(input, rows, inputs, matrix, outputs, inputs, inputs, out, outputs);
+    for (size_t r = 0; r < rows; r++) {
+        float* row = out + r * outputs;
+        for (size_t o = 0; o < outputs; o++) row[o] += bias[o];
+    }
+}
+
+void NativeModel::Linear::applyQuantized(const float* input, size_t rows, float* out,
+                                         Workspace& workspace) const {
+    // Each input row gets its own symmetric scale, so the products sum in
+    // int32 and are rescaled once per output
+    workspace.activations.resize(rows * inputs);
+    workspace.activationScales.resize(rows);
+    workspace.products.resize(rows * outputs);
+    for (size_t r = 0; r < rows; r++) {
+        workspace.activationScales[r] =
+            simd::quantize(input + r * inputs, inputs, workspace.activations.data() + r * inputs);
+    }
+    
+    simd::multiplyTransposed(workspace.activations.data(), rows, inputs, quantized.data(), outputs, inputs,
+                             inputs, workspace.products.data(), outputs);
+    for (size_t r = 0; r < rows; r++) {
+        const int32_t* products = workspace.products.data() + r * outputs;
+        const float rowScale = workspace.activationScales[r];
+        float* row = out + r * outputs;
+        for (size_t o = 0; o < outputs; o++) {
+            row[o] = static_cast<float>(products[o]) * rowScale * scales[o] + bias[o];
+        }
+    }
+}
+
+void NativeModel::LayerNorm::apply(float* rows, size_t count) const {
+    const size_t n = gamma.size();
+    for (size_t r = 0; r < count; r++) {
+        float* row = rows + r * n;
+        float mean = 0.0f;
+        for (size_t i = 0; i < n; i++) mean += row[i];
+        mean /= static_cast<float>(n);
+        float variance = 0.0f;
+        for (size_t i = 0; i < n; i++) variance += (row[i] - mean) * (row[i] - mean);
+        variance /= static_cast<float>(n);
+        const float inverse = 1.0f / std::sqrt(variance + 1e-5f);  // PyTorch's default epsilon
+        for (size_t i = 0; i < n; i++) row[i] = (row[i] - mean) * inverse * gamma[i] + beta[i];
+    }
+}
+
+bool NativeModel::load(const std::string& path, WeightPrecision storage) {
+    SnapshotReader in;
+    if (!in.map(path)) {
+        return false;
+    }
+    
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    Shape fileShape;
+    in.read(magic);
+    in.read(version);
+    in.read(fileShape);
+    if (!in.ok() || magic != MAGIC || version != VERSION) {
+        std::cerr << "Warning: " << path << " is not a version " << VERSION << " native model" << std::endl;
+        return false;
+    }
+    
+    const Shape& s = fileShape;
+    if (s.perceptionDim != InferenceScheduler::PERCEPTION_DIM || s.memoryLength != InferenceScheduler::MEMORY_SEQ_LEN
+        || s.memoryDim != InferenceScheduler::MEMORY_DIM || s.heads == 0 || s.modelDim % s.heads != 0
+        || s.modelDim < 2 || s.modelDim > MAX_DIM || s.layers > 64) {
+        std::cerr << "Warning: " << path << " has a " << s.perceptionDim << "/" << s.memoryLength << "x"
+                  << s.memoryDim << " input; expected " << InferenceScheduler::PERCEPTION_DIM << "/"
+                  << InferenceScheduler::MEMORY_SEQ_LEN << "x" << InferenceScheduler::MEMORY_DIM
+                  << " with model dim divisible by heads" << std::endl;
+        return false;
+    }
+    
+    const size_t d = s.modelDim;
+    std::vector<float> weight;
+    std::vector<float> bias;
+    // Each returns false if a tensor is missing or shorter than the header says
+    auto linear = [&](Linear& layer, size_t inputs, size_t outputs) {
+        if (!readTensor(in, weight, inputs * outputs) || !readTensor(in, bias, outputs)) {
+            return false;
+        }
+        layer.assign(inputs, outputs, weight, bias, storage);
+        return true;
+    };
+    auto layerNorm = [&](LayerNorm& norm) {
+        return readTensor(in, norm.gamma, d) && readTensor(in, norm.beta, d);
+    };
+    
+    NativeModel model;
+    model.shape = s;
+    model.precision = storage;
+    bool complete = linear(model.perceptionIn, s.perceptionDim, d)
+        && linear(model.perceptionOut, d, d)
+        && linear(model.memoryIn, s.memoryDim, d)
+        && readTensor(in, model.positions, s.memoryLength * d);
+    
+    model.blocks.resize(s.layers);
+    for (Block& block : model.blocks) {
+        if (!complete) break;
+        // PyTorch packs the query, key and value projections into one matrix
+        std::vector<float> projection;
+        std::vector<float> projectionBias;
+        if (!readTensor(in, projection, 3 * d * d) || !readTensor(in, projectionBias, 3 * d)) {
+            complete = false;
+            break;
+        }
+        block.query.assign(d, d, std::vector<float>(projection.begin(), projection.begin() + d * d),
+                           std::vector<float>(projectionBias.begin(), projectionBias.begin() + d), storage);
+        block.keyValue.assign(d, 2 * d, std::vector<float>(projection.begin() + d * d, projection.end()),
+                              std::vector<float>(projectionBias.begin() + d, projectionBias.end()), storage);
+        complete = linear(block.output, d, d)
+            && layerNorm(block.norm1)
+            && linear(block.ffnIn, d, 4 * d)
+            && linear(block.ffnOut, 4 * d, d)
+            && layerNorm(block.norm2);
+    }
+    
+    complete = complete
+        && linear(model.actionIn, d, d)
+        && linear(model.actionOut, d, InferenceScheduler::ACTION_DIM)
+        && linear(model.emotionIn, d, d / 2)
+        && linear(model.emotionOut, d / 2, InferenceScheduler::OUTPUT_DIM - InferenceScheduler::ACTION_DIM);
+    
+    if (!complete || !in.ok()) {
+        std::cerr << "Warning: Native model " << path << " is truncated or does not match its header" << std::endl;
+        return false;
+    }
+    *this = std::move(model);
+    return true;
+}
+
+void NativeModel::initializeRandom(const Shape& newShape, uint64_t seed, WeightPrecision storage) {
+    shape = newShape;
+    precision = storage;
+    CounterRng rng(CounterRng::streamKey(seed, 0, CounterRng::Brain));
+    
+    // PyTorch's default Linear initialization range
+    auto linear = [&](Linear& layer, size_t inputs, size_t outputs) {
+        const float bound = 1.0f / std::sqrt(static_cast<float>(inputs));
+        std::vector<float> weight(inputs * outputs);
+        std::vector<float> bias(outputs);
+        for (float& w : weight) w = rng.uniform(-bound, bound);
+        for (float& b : bias) b = rng.uniform(-bound, bound);
+        layer.assign(inputs, outputs, weight, std::move(bias), storage);
+    };
+    const size_t d = shape.modelDim;
+    auto layerNorm = [&](LayerNorm& norm) {
+        norm.gamma.assign(d, 1.0f);
+        norm.beta.assign(d, 0.0f);
+    };
+    
+    linear(perceptionIn, shape.perceptionDim, d);
+    linear(perceptionOut, d, d);
+    linear(memoryIn, shape.memoryDim, d);
+    
+    // Sinusoidal encoding, as PositionalEncoding builds it
+    positions.assign(shape.memoryLength * d, 0.0f);
+    for (size_t p = 0; p < shape.memoryLength; p++) {
+        for (size_t i = 0; i + 1 < d; i += 2) {
+            const float angle = p * std::exp(-std::log(10000.0f) * i / d);
+            positions[p * d + i] = std::sin(angle);
+            positions[p * d + i + 1] = std::cos(angle);
+        }
+    }
+    
+    blocks.assign(shape.layers, Block{});
+    for (Block& block : blocks) {
+        linear(block.query, d, d);
+        linear(block.keyValue, d, 2 * d);
+        linear(block.output, d, d);
+        layerNorm(block.norm1);
+        linear(block.ffnIn, d, 4 * d);
+        linear(block.ffnOut, 4 * d, d);
+        layerNorm(block.norm2);
+    }
+    
+    linear(actionIn, d, d);
+    linear(actionOut, d, InferenceScheduler::ACTION_DIM);
+    linear(emotionIn, d, d / 2);
+    linear(emotionOut, d / 2, InferenceScheduler::OUTPUT_DIM - InferenceScheduler::ACTION_DIM);
+}
+
+size_t NativeModel::weightBytes() const {
+    size_t bytes = perceptionIn.bytes() + perceptionOut.bytes() + memoryIn.bytes() + positions.size() * sizeof(float)
+        + actionIn.bytes() + actionOut.bytes() + emotionIn.bytes() + emotionOut.bytes();
+    for (const Block& block : blocks) {
+        bytes += block.query.bytes() + block.keyValue.bytes() + block.output.bytes() + block.ffnIn.bytes()
+            + block.ffnOut.bytes() + (block.norm1.gamma.size() + block.norm2.gamma.size()) * 2 * sizeof(float);
+    }
+    return bytes;
+}
+
+void NativeModel::run(const float* perception, const float* memory, size_t rows, float* output) const {
+    thread_local Workspace workspace;
+    const size_t memoryStride = static_cast<size_t>(shape.memoryLength) * shape.memoryDim;
+    for (size_t r = 0; r < rows; r += CHUNK) {
+        const size_t count = std::min(CHUNK, rows - r);
+        runChunk(perception + r * shape.perceptionDim, memory + r * memoryStride, count,
+                 output + r * InferenceScheduler::OUTPUT_DIM, workspace);
+    }
+}
+
+void NativeModel::runChunk(const float* perception, const float* memory, size_t rows, float* output,
+                           Workspace& workspace) const {
+    const size_t d = shape.modelDim;
+    const size_t length = shape.memoryLength;
+    const size_t memoryRows = rows * length;
+    
+    // Perception encoder: the attention query
+    workspace.hidden.resize(rows * 4 * d);
+    workspace.query.resize(rows * d);
+    perceptionIn.apply(perception, rows, workspace.hidden.data(), workspace);
+    relu(workspace.hidden.data(), rows * d);
+    perceptionOut.apply(workspace.hidden.data(), rows, workspace.query.data(), workspace);
+    
+    // Memory encoder plus positions: keys and values for every block
+    workspace.memory.resize(memoryRows * d);
+    memoryIn.apply(memory, memoryRows, workspace.memory.data(), workspace);
+    relu(workspace.memory.data(), memoryRows * d);
+    for (size_t m = 0; m < memoryRows; m++) {
+        float* row = workspace.memory.data() + m * d;
+        const float* position = positions.data() + (m % length) * d;
+        for (size_t i = 0; i < d; i++) row[i] += position[i];
+    }
+    
+    workspace.queries.resize(rows * d);
+    workspace.keyValues.resize(memoryRows * 2 * d);
+    workspace.attended.resize(rows * d);
+    workspace.projected.resize(rows * d);
+    float* query = workspace.query.data();
+    for (const Block& block : blocks) {
+        block.query.apply(query, rows, workspace.queries.data(), workspace);
+        block.keyValue.apply(workspace.memory.data(), memoryRows, workspace.keyValues.data(), workspace);
+        attend(workspace.queries.data(), workspace.keyValues.data(), rows, workspace.attended.data(), workspace);
+        block.output.apply(workspace.attended.data(), rows, workspace.projected.data(), workspace);
+        for (size_t i = 0; i < rows * d; i++) query[i] += workspace.projected[i];
+        block.norm1.apply(query, rows);
+        
+        block.ffnIn.apply(query, rows, workspace.hidden.data(), workspace);
+        relu(workspace.hidden.data(), rows * 4 * d);
+        block.ffnOut.apply(workspace.hidden.data(), rows, workspace.projected.data(), workspace);
+        for (size_t i = 0; i < rows * d; i++) query[i] += workspace.projected[i];
+        block.norm2.apply(query, rows);
+    }
+    
+    // Heads, written straight into the output rows
+    constexpr size_t ACTIONS = InferenceScheduler::ACTION_DIM;
+    constexpr size_t STRIDE = InferenceScheduler::OUTPUT_DIM;
+    constexpr size_t EMOTIONS = STRIDE - ACTIONS;
+    float* logits = workspace.projected.data();
+    actionIn.apply(query, rows, workspace.hidden.data(), workspace);
+    relu(workspace.hidden.data(), rows * d);
+    actionOut.apply(workspace.hidden.data(), rows, logits, workspace);
+    for (size_t r = 0; r < rows; r++) {
+        float* row = output + r * STRIDE;
+        std::copy(logits + r * ACTIONS, logits + (r + 1) * ACTIONS, row);
+        simd::softmax(row, ACTIONS);
+    }
+    
+    float* emotions = workspace.projected.data();
+    emotionIn.apply(query, rows, workspace.hidden.data(), workspace);
+    relu(workspace.hidden.data(), rows * (d / 2));
+    emotionOut.apply(workspace.hidden.data(), rows, emotions, workspace);
+    for (size_t r = 0; r < rows; r++) {
+        for (size_t e = 0; e < EMOTIONS; e++) {
+            output[r * STRIDE + ACTIONS + e] = std::tanh(emotions[r * EMOTIONS + e]);
+        }
+    }
+}
+
+void NativeModel::attend(const float* queries, const float* keyValues, size_t rows, float* out,
+                         Workspace& workspace) const {
+    // Multi-head attention of each NPC's single query over its own memories
+    const size_t d = shape.modelDim;
+    const size_t length = shape.memoryLength;
+    const size_t headDim = d / shape.heads;
+    const float scale = 1.0f / std::sqrt(static_cast<float>(headDim));
+    workspace.scores.resize(length);
+    float* scores = workspace.scores.data();
+    
+    for (size_t r = 0; r < rows; r++) {
+        const float* memories = keyValues + r * length * 2 * d;
+        for (size_t h = 0; h < shape.heads; h++) {
+            const size_t offset = h * headDim;
+            simd::dotBatch(memories + offset, length, 2 * d, queries + r * d + offset, headDim, scores);
+            for (size_t s = 0; s < length; s++) scores[s] *= scale;
+            simd::softmax(scores, length);
+            
+            float* head = out + r * d + offset;
+            std::fill(head, head + headDim, 0.0f);
+            for (size_t s = 0; s < length; s++) {
+                const float* value = memories + s * 2 * d + d + offset;
+                const float weight = scores[s];
+                for (size_t i = 0; i < headDim; i++) head[i] += weight * value[i];
+            }
+        }
+    }
+}
+
+} // namespace pw
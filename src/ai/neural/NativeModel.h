@@ -0,0 +1,132 @@
+#pragma once
+
+#include "engine/SimdMath.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pw {
+
+// How NativeModel stores its weight matrices. fp16 halves the weights' memory
+// and is expanded to fp32 a matrix at a time as it is used. int8 (symmetric,
+// one scale per output row) quarters it and runs as an integer product: each
+// input row is quantized to int8 range with its own scale, summed in int32,
+// then rescaled.
+enum class WeightPrecision {
+    Float32,
+    Float16,
+    Int8
+};
+
+// Reads "fp32", "fp16" or "int8"
+bool parseWeightPrecision(const std::string& name, WeightPrecision& precision);
+const char* weightPrecisionName(WeightPrecision precision);
+
+// Built-in CPU implementation of NPCBrainModel (tools/model_architecture.py):
+// perception MLP, memory encoder, memory attention blocks and the action and
+// emotion heads, in eval mode. For a model this small, ONNX Runtime's per-call
+// overhead outweighs the arithmetic, and builds without it still get neural
+// brains. Weights come from a .pwnn file written by tools/export_native_model.py:
+//
+//   header   {magic, version, perception dim, memory length, memory dim,
+//             model dim, heads, layers} as uint32
+//   tensors  in the exporter's fixed order, each a uint64 count then floats
+class NativeModel {
+public:
+    static constexpr uint32_t MAGIC = 0x4D4E5750;  // "PWNM"
+    static constexpr uint32_t VERSION = 1;
+    
+    struct Shape {
+        uint32_t perceptionDim = 20;
+        uint32_t memoryLength = 50;
+        uint32_t memoryDim = 32;
+        uint32_t modelDim = 128;
+        uint32_t heads = 4;
+        uint32_t layers = 2;
+    };
+    
+    // False, with a warning, if the file is unreadable or its input shape
+    // differs from the InferenceScheduler contract
+    bool load(const std::string& path, WeightPrecision precision);
+    
+    // Random weights of the given shape, for benchmarks
+    void initializeRandom(const Shape& shape, uint64_t seed, WeightPrecision precision);
+    
+    const Shape& getShape() const { return shape; }
+    WeightPrecision getPrecision() const { return precision; }
+    size_t weightBytes() const;
+    
+    // Forward pass for rows NPCs: perception [rows, perception dim] and memory
+    // [rows, memory length, memory dim] in; output [rows, OUTPUT_DIM] out,
+    // holding 9 action probabilities (softmax of the logits) then valence,
+    // arousal and dominance. Rows are independent, so results do not depend
+    // on how a batch is split. Safe to call from several threads.
+    void run(const float* perception, const float* memory, size_t rows, float* output) const;
+
+private:
+    struct Workspace;
+    
+    // Dense layer with weights in PyTorch's [outputs, inputs] layout
+    struct Linear {
+        size_t inputs = 0;
+        size_t outputs = 0;
+        WeightPrecision precision = WeightPrecision::Float32;
+        simd::AlignedFloats weights;    // Float32
+        std::vector<uint16_t> halves;   // Float16
+        std::vector<int8_t> quantized;  // Int8
+        std::vector<float> scales;      // Int8, per output row
+        std::vector<float> bias;
+        
+        void assign(size_t inputs, size_t outputs, const std::vector<float>& weights,
+                    std::vector<float> bias, WeightPrecision precision);
+        size_t bytes() const;
+        
+        // out[r * outputs + o] = bias[o] + input row r . weight row o
+        void apply(const float* input, size_t rows, float* out, Workspace& workspace) const;
+        // Int8: the input rows are quantized too and multiplied in integers
+        void applyQuantized(const float* input, size_t rows, float* out, Workspace& workspace) const;
+    };
+    
+    struct LayerNorm {
+        std::vector<float> gamma;
+        std::vector<float> beta;
+        
+        void apply(float* rows, size_t count) const;
+    };
+    
+    // MemoryAttentionBlock; the attention's input projection is split into the
+    // query part and the key/value part, which run over different inputs
+    struct Block {
+        Linear query;
+        Linear keyValue;  // [2 * model dim, model dim]: keys then values
+        Linear output;
+        LayerNorm norm1;
+        Linear ffnIn;
+        Linear ffnOut;
+        LayerNorm norm2;
+    };
+    
+    // NPCs per pass through the layers, so the memory activations of a pass
+    // (CHUNK * memory length rows) stay cache-sized
+    static constexpr size_t CHUNK = 16;
+    
+    Shape shape;
+    WeightPrecision precision = WeightPrecision::Float32;
+    Linear perceptionIn;
+    Linear perceptionOut;
+    Linear memoryIn;
+    std::vector<float> positions;  // [memory length, model dim], added to encoded memories
+    std::vector<Block> blocks;
+    Linear actionIn;
+    Linear actionOut;
+    Linear emotionIn;
+    Linear emotionOut;
+    
+    void runChunk(const float* perception, const float* memory, size_t rows, float* output,
+                  Workspace& workspace) const;
+    void attend(const float* queries, const float* keyValues, size_t rows, float* out,
+                Workspace& workspace) const;
+};
+
+} // namespace pw
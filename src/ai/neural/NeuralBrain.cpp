@@ -1,15 +1,27 @@
 #include "ai/neural/NeuralBrain.h"
 #include "world/World.h"
 #include "world/Tile.h"
+#include "engine/SimdMath.h"
+#include "engine/Profiler.h"
+#include "serialization/Snapshot.h"
 #include <nlohmann/json.hpp>
 #include <algorithm>
-#include <random>
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <fstream>
 
 namespace pw {
 
+namespace {
+
+// Rewards and emotions have always accumulated the deltas in this order
+std::array<float, 5> deltasInNameOrder(const Needs& d) {
+    return {d.curiosity, d.energy, d.hunger, d.safety, d.social};
+}
+
+} // namespace
+
 // EmotionalState implementation
 void EmotionalState::clamp() {
     valence = std::max(-1.0f, std::min(1.0f, valence));
@@ -25,84 +37,107 @@ float EmotionalState::distance(const EmotionalState& other) const {
 }
 
 // NeuralBrain implementation
-NeuralBrain::NeuralBrain(EntityId ownerId, const std::string& modelPath)
+NeuralBrain::NeuralBrain(EntityId ownerId, const std::string& modelPath, uint32_t seed,
+                         RelationshipStore* relationships)
     : ownerId(ownerId)
-    , socialIntelligence(ownerId)
+    , socialIntelligence(ownerId, seed, relationships)
 #ifdef HAS_ONNX_RUNTIME
     , memoryInfo(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault))
 #endif
+    , rng(CounterRng::streamKey(seed, ownerId, CounterRng::Brain))
 {
     lastActionProbs.resize(9, 0.0f);  // 9 action types
     
-#ifdef HAS_ONNX_RUNTIME
+    // The registry warns (once per version of the file) if the model cannot be loaded
     modelLoaded = loadModel(modelPath);
-    if (!modelLoaded) {
-        std::cerr << "Warning: NeuralBrain " << ownerId << " failed to load model: " 
-                  << modelPath << std::endl;
-    }
-#else
-    std::cerr << "Warning: ONNX Runtime not available, NeuralBrain will use fallback behavior" 
-              << std::endl;
-#endif
 }
 
 NeuralBrain::~NeuralBrain() = default;
 
 bool NeuralBrain::loadModel(const std::string& modelPath) {
-#ifdef HAS_ONNX_RUNTIME
-    try {
-        ortEnv = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "NeuralBrain");
-        ortSessionOptions = std::make_unique<Ort::SessionOptions>();
-        ortSessionOptions->SetIntraOpNumThreads(1);
-        ortSessionOptions->SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_BASIC);
-        
-        // Try to load the model
-        ortSession = std::make_unique<Ort::Session>(*ortEnv, modelPath.c_str(), *ortSessionOptions);
-        
-        return true;
-    } catch (const Ort::Exception& e) {
-        std::cerr << "ONNX Runtime error: " << e.what() << std::endl;
-        return false;
-    }
-#else
-    (void)modelPath;
-    return false;
-#endif
+    model = ModelRegistry::instance().acquire(modelPath);
+    return model != nullptr;
 }
 
-Action NeuralBrain::decide(const Perception& perception, World& world) {
+Action NeuralBrain::decide(const Perception& perception, const World& world) {
+    PW_PROFILE_ZONE("decide/neural");
     (void)world;  // May be used for advanced queries
     
-    // Update memory buffer with current perception
-    updateMemoryBuffer(perception, 0);  // TODO: pass actual tick
-    
-    // Convert perception to vector
-    std::vector<float> perceptionVec = perceptionToVector(perception);
-    std::vector<float> memoryContext = getMemoryContext();
+    encodeInputs(perception, lastPerceptionVec, lastMemoryContext);
     
     // Run inference or fallback
-    std::vector<float> actionProbs;
-    std::vector<float> emotionOutput(3, 0.0f);
+    std::vector<float> output;
+    if (modelLoaded) {
+        output = runInference(lastPerceptionVec, lastMemoryContext.data());
+    }
+    
+    return actionFromOutput(perception, output.data(), output.size());
+}
+
+bool NeuralBrain::prepareInput(const Perception& perception, const World& world,
+                               InferenceScheduler& scheduler) {
+    PW_PROFILE_ZONE("decide/neural");
+    (void)world;
+    pendingTicket = InferenceTicket{};
+    
+    if (!modelLoaded || !model) {
+        return false;
+    }
+    
+    encodeInputs(perception, pendingPerceptionVec, pendingMemoryContext);
+    pendingTicket = scheduler.submit(model.get(), pendingPerceptionVec.data(),
+                                     pendingMemoryContext.data());
+    return pendingTicket.valid();
+}
+
+Action NeuralBrain::applyOutput(const Perception& perception, const InferenceScheduler& scheduler) {
+    PW_PROFILE_ZONE("decide/neural");
+    size_t outputSize = 0;
+    const float* output = scheduler.output(pendingTicket, outputSize);
+    pendingTicket = InferenceTicket{};
+    
+    // The decision now made is the one the queued input describes
+    lastPerceptionVec.swap(pendingPerceptionVec);
+    lastMemoryContext.swap(pendingMemoryContext);
+    return actionFromOutput(perception, output, outputSize);
+}
+
+void NeuralBrain::encodeInputs(const Perception& perception, std::vector<float>& perceptionVec,
+                               std::vector<float>& memoryContext) {
+    // Update memory buffer with current perception
+    memoryBuffer.setExtent(perception.worldSize);
+    decayMemories(perception.tick);
+    updateMemoryBuffer(perception, perception.tick);
+    
+    // Cached for experience replay as well as for the model input
+    perceptionToVector(perception, perceptionVec);
+    
+    // Attention over the buffer lands in each row's ATTENTION input, and
+    // brings back decayed memories the scene strongly resembles
+    triggerProustianRecall(perceptionVec);
+    memoryContext.assign(memoryBuffer.context(),
+                         memoryBuffer.context() + InferenceScheduler::MEMORY_CONTEXT_SIZE);
+}
+
+Action NeuralBrain::actionFromOutput(const Perception& perception, const float* output,
+                                     size_t outputSize) {
+    // Worked on in place; assign() reuses its capacity, so deciding does not allocate
+    std::vector<float>& actionProbs = lastActionProbs;
     
-#ifdef HAS_ONNX_RUNTIME
     if (modelLoaded) {
-        auto output = runInference(perceptionVec, memoryContext);
-        if (output.size() >= 12) {  // 9 actions + 3 emotions
-            actionProbs.assign(output.begin(), output.begin() + 9);
-            emotionOutput.assign(output.begin() + 9, output.begin() + 12);
+        if (output && outputSize >= InferenceScheduler::OUTPUT_DIM) {  // 9 actions + 3 emotions
+            actionProbs.assign(output, output + 9);
             
             // Update emotional state
-            emotionalState.valence = emotionOutput[0];
-            emotionalState.arousal = emotionOutput[1];
-            emotionalState.dominance = emotionOutput[2];
+            emotionalState.valence = output[9];
+            emotionalState.arousal = output[10];
+            emotionalState.dominance = output[11];
             emotionalState.clamp();
         } else {
             // Fallback to uniform distribution
             actionProbs.assign(9, 1.0f / 9.0f);
         }
-    } else
-#endif
-    {
+    } else {
         // Fallback: simple heuristic based on needs
         actionProbs.assign(9, 0.05f);
         
@@ -136,14 +171,8 @@ Action NeuralBrain::decide(const Perception& perception, World& world) {
     for (float p : actionProbs) sum += p;
     for (float& p : actionProbs) p /= sum;
     
-    lastActionProbs = actionProbs;
-    
     // Select action from distribution
     Action selectedAction = actionFromProbabilities(actionProbs, perception);
-    
-    // Cache for experience replay
-    lastPerceptionVec = perceptionVec;
-    lastMemoryContext = memoryContext;
     lastActionIndex = static_cast<int>(selectedAction.type);
     
     return selectedAction;
@@ -152,6 +181,7 @@ Action NeuralBrain::decide(const Perception& perception, World& world) {
 void NeuralBrain::onOutcome(const Outcome& outcome) {
     // Compute reward signal
     float reward = computeReward(outcome);
+    lastReward = reward;
     
     // Store for online learning
     if (replayBuffer.size() < MAX_REPLAY_BUFFER && lastActionIndex >= 0 
@@ -170,7 +200,7 @@ void NeuralBrain::onOutcome(const Outcome& outcome) {
     }
     
     // Update emotional state based on outcome
-    for (const auto& [need, delta] : outcome.needsDeltas) {
+    for (float delta : deltasInNameOrder(outcome.needsDelta)) {
         if (delta < 0) {  // Need satisfied
             emotionalState.valence += 0.1f;
             emotionalState.arousal -= 0.05f;
@@ -180,28 +210,33 @@ void NeuralBrain::onOutcome(const Outcome& outcome) {
         }
     }
     
-    if (!outcome.event.empty()) {
-        if (outcome.event.find("danger") != std::string::npos ||
-            outcome.event.find("attacked") != std::string::npos) {
-            emotionalState.valence -= 0.3f;
-            emotionalState.arousal += 0.4f;
-            emotionalState.dominance -= 0.2f;
-        } else if (outcome.event.find("food") != std::string::npos ||
-                   outcome.event.find("social") != std::string::npos) {
+    switch (outcome.event) {
+        case OutcomeEvent::Food:
+        case OutcomeEvent::Social:
             emotionalState.valence += 0.2f;
-        }
+            break;
+        case OutcomeEvent::None:
+            break;
     }
     
     emotionalState.clamp();
 }
 
-std::vector<float> NeuralBrain::perceptionToVector(const Perception& perception) const {
-    std::vector<float> vec;
-    vec.reserve(20);  // Approximate size
+void NeuralBrain::onEvent(const EngineEvent& event) {
+    static constexpr float MEETING_VALENCE = 0.1f;
+    
+    if (event.type == EngineEvent::Type::NpcMet) {
+        const EntityId other = event.npc == ownerId ? event.other : event.npc;
+        socialIntelligence.recordInteraction(other, "neutral", MEETING_VALENCE, event.tick);
+    }
+}
+
+void NeuralBrain::perceptionToVector(const Perception& perception, std::vector<float>& vec) const {
+    vec.clear();  // Keeps capacity, so steady-state calls do not allocate
     
     // Position (2)
-    vec.push_back(perception.position.x / static_cast<float>(WORLD_WIDTH));
-    vec.push_back(perception.position.y / static_cast<float>(WORLD_HEIGHT));
+    vec.push_back(perception.position.x / perception.worldSize.x);
+    vec.push_back(perception.position.y / perception.worldSize.y);
     
     // Needs (5)
     vec.push_back(perception.internalNeeds.hunger);
@@ -212,14 +247,16 @@ std::vector<float> NeuralBrain::perceptionToVector(const Perception& perception)
     
     // Time and weather (2)
     vec.push_back(perception.timeOfDay);
-    vec.push_back(perception.weather == "rain" ? 1.0f : 0.0f);
+    vec.push_back(perception.weather == Weather::Rain ? 1.0f : 0.0f);
     
     // Nearby tiles (one-hot encoded, simplified to counts)
     int waterCount = 0, foodCount = 0, shelterCount = 0;
-    for (const auto& [pos, type] : perception.nearbyTiles) {
-        if (type == "Water") waterCount++;
-        else if (type == "BerryBush" || type == "Tree") foodCount++;
-        else if (type == "Cave" || type == "Shelter") shelterCount++;
+    for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+        if (!perception.hasTile(i)) continue;
+        TileType type = perception.nearbyTiles[i];
+        if (type == TileType::Water) waterCount++;
+        else if (type == TileType::BerryBush || type == TileType::Tree) foodCount++;
+        else if (type == TileType::Cave || type == TileType::Shelter) shelterCount++;
     }
     vec.push_back(std::min(1.0f, waterCount / 5.0f));
     vec.push_back(std::min(1.0f, foodCount / 5.0f));
@@ -234,53 +271,12 @@ std::vector<float> NeuralBrain::perceptionToVector(const Perception& perception)
     vec.push_back(emotionalState.dominance);
     
     // Pad to fixed size if needed
-    while (vec.size() < 20) {
-        vec.push_back(0.0f);
-    }
-    
-    return vec;
-}
-
-std::vector<float> NeuralBrain::getMemoryContext() const {
-    std::vector<float> context;
-    context.reserve(MAX_MEMORY_BUFFER * MEMORY_EMBEDDING_DIM);
-    
-    // Simplified: encode recent memories
-    for (size_t i = 0; i < std::min(memoryBuffer.size(), MAX_MEMORY_BUFFER); ++i) {
-        const auto& mem = memoryBuffer[i];
-        
-        // Simple embedding: position + significance + type encoding
-        std::vector<float> embedding(MEMORY_EMBEDDING_DIM, 0.0f);
-        embedding[0] = mem.memory.location.x / static_cast<float>(WORLD_WIDTH);
-        embedding[1] = mem.memory.location.y / static_cast<float>(WORLD_HEIGHT);
-        embedding[2] = mem.memory.significance;
-        embedding[3] = mem.attentionWeight;
-        
-        // Type encoding (one-hot-ish)
-        if (mem.memory.type == "food") embedding[4] = 1.0f;
-        else if (mem.memory.type == "danger") embedding[5] = 1.0f;
-        else if (mem.memory.type == "npc") embedding[6] = 1.0f;
-        else if (mem.memory.type == "shelter") embedding[7] = 1.0f;
-        
-        context.insert(context.end(), embedding.begin(), embedding.end());
-    }
-    
-    // Pad if needed
-    while (context.size() < MAX_MEMORY_BUFFER * MEMORY_EMBEDDING_DIM) {
-        context.push_back(0.0f);
-    }
-    
-    return context;
+    vec.resize(std::max<size_t>(vec.size(), InferenceScheduler::PERCEPTION_DIM), 0.0f);
 }
 
 Action NeuralBrain::actionFromProbabilities(const std::vector<float>& probs, 
                                             const Perception& perception) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::discrete_distribution<> dist(probs.begin(), probs.end());
-    
-    int actionIdx = dist(gen);
-    ActionType actionType = static_cast<ActionType>(actionIdx);
+    ActionType actionType = static_cast<ActionType>(sampleCategorical(probs, rng));
     
     Action action;
     action.type = actionType;
@@ -291,16 +287,17 @@ Action NeuralBrain::actionFromProbabilities(const std::vector<float>& probs,
         case ActionType::Explore:
             // Random nearby position
             action.targetPosition = perception.position + Vec2{
-                static_cast<float>((gen() % 40) - 20),
-                static_cast<float>((gen() % 40) - 20)
+                static_cast<float>(static_cast<int>(rng.below(40)) - 20),
+                static_cast<float>(static_cast<int>(rng.below(40)) - 20)
             };
             break;
         case ActionType::Forage:
         case ActionType::Eat:
             // Move towards food if seen
-            for (const auto& [pos, type] : perception.nearbyTiles) {
-                if (type == "BerryBush" || type == "Tree") {
-                    action.targetPosition = pos;
+            for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+                TileType type = perception.nearbyTiles[i];
+                if (perception.hasTile(i) && (type == TileType::BerryBush || type == TileType::Tree)) {
+                    action.targetPosition = perception.tilePosition(i);
                     break;
                 }
             }
@@ -308,15 +305,16 @@ Action NeuralBrain::actionFromProbabilities(const std::vector<float>& probs,
         case ActionType::Socialize:
             // Move towards nearest NPC
             if (!perception.nearbyNPCs.empty()) {
-                action.targetEntity = perception.nearbyNPCs[0].first;
-                action.targetPosition = perception.nearbyNPCs[0].second;
+                action.targetEntity = perception.nearbyNPCs[0].id;
+                action.targetPosition = perception.nearbyNPCs[0].position;
             }
             break;
         case ActionType::SeekShelter:
             // Move towards shelter
-            for (const auto& [pos, type] : perception.nearbyTiles) {
-                if (type == "Cave" || type == "Shelter") {
-                    action.targetPosition = pos;
+            for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+                TileType type = perception.nearbyTiles[i];
+                if (perception.hasTile(i) && (type == TileType::Cave || type == TileType::Shelter)) {
+                    action.targetPosition = perception.tilePosition(i);
                     break;
                 }
             }
@@ -330,85 +328,57 @@ Action NeuralBrain::actionFromProbabilities(const std::vector<float>& probs,
 }
 
 void NeuralBrain::updateMemoryBuffer(const Perception& perception, Tick currentTick) {
-    // Add significant perceptions to memory buffer
+    // Add significant perceptions to memory buffer; once it is full they only
+    // displace less significant memories
     
     // Add food sightings
-    for (const auto& [pos, type] : perception.nearbyTiles) {
-        if (type == "BerryBush" || type == "Tree") {
-            float significance = perception.internalNeeds.hunger * 1.5f;
-            MemoryEntry mem("food", pos, currentTick, significance);
-            
-            // Create embedding (simplified)
-            std::vector<float> embedding(MEMORY_EMBEDDING_DIM, 0.0f);
-            embedding[0] = pos.x / static_cast<float>(WORLD_WIDTH);
-            embedding[1] = pos.y / static_cast<float>(WORLD_HEIGHT);
-            embedding[2] = significance;
-            
-            memoryBuffer.emplace_back(mem, embedding);
+    float foodSignificance = perception.internalNeeds.hunger * 1.5f;
+    for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+        TileType type = perception.nearbyTiles[i];
+        if (perception.hasTile(i) && (type == TileType::BerryBush || type == TileType::Tree)) {
+            memoryBuffer.add(MemoryType::Food, perception.tilePosition(i), currentTick, foodSignificance);
         }
     }
     
     // Add NPC encounters
+    float npcSignificance = perception.internalNeeds.social * 1.2f;
     for (const auto& [npcId, pos] : perception.nearbyNPCs) {
-        float significance = perception.internalNeeds.social * 1.2f;
-        MemoryEntry mem("npc", pos, currentTick, significance);
-        
-        std::vector<float> embedding(MEMORY_EMBEDDING_DIM, 0.0f);
-        embedding[0] = pos.x / static_cast<float>(WORLD_WIDTH);
-        embedding[1] = pos.y / static_cast<float>(WORLD_HEIGHT);
-        embedding[2] = significance;
-        embedding[6] = 1.0f;  // NPC type marker
-        
-        memoryBuffer.emplace_back(mem, embedding);
-    }
-    
-    // Maintain buffer size
-    if (memoryBuffer.size() > MAX_MEMORY_BUFFER) {
-        // Remove lowest significance memories
-        std::sort(memoryBuffer.begin(), memoryBuffer.end(),
-                  [](const EpisodicMemory& a, const EpisodicMemory& b) {
-                      return a.memory.significance < b.memory.significance;
-                  });
-        memoryBuffer.erase(memoryBuffer.begin(), 
-                          memoryBuffer.begin() + (memoryBuffer.size() - MAX_MEMORY_BUFFER));
+        (void)npcId;
+        memoryBuffer.add(MemoryType::Npc, pos, currentTick, npcSignificance);
     }
 }
 
 void NeuralBrain::computeMemoryAttention(const std::vector<float>& queryVec) {
-    // Simplified attention: dot product similarity
-    for (auto& mem : memoryBuffer) {
-        float similarity = 0.0f;
-        size_t minSize = std::min(queryVec.size(), mem.embedding.size());
-        for (size_t i = 0; i < minSize; ++i) {
-            similarity += queryVec[i] * mem.embedding[i];
-        }
-        mem.attentionWeight = std::max(0.0f, similarity);
-    }
+    // Simplified attention: dot product similarity against every row at once
+    const size_t count = memoryBuffer.size();
+    const size_t dims = std::min(queryVec.size(), MEMORY_EMBEDDING_DIM);
+    alignas(simd::ALIGNMENT) std::array<float, MAX_MEMORY_BUFFER> weights;
     
-    // Softmax normalization
-    float maxWeight = -1e9f;
-    for (const auto& mem : memoryBuffer) {
-        maxWeight = std::max(maxWeight, mem.attentionWeight);
+    simd::dotBatch(memoryBuffer.context(), count, MEMORY_EMBEDDING_DIM, queryVec.data(), dims,
+                   weights.data());
+    for (size_t slot = 0; slot < count; ++slot) {
+        weights[slot] = std::max(0.0f, weights[slot]);
     }
     
-    float sumExp = 0.0f;
-    for (auto& mem : memoryBuffer) {
-        mem.attentionWeight = std::exp(mem.attentionWeight - maxWeight);
-        sumExp += mem.attentionWeight;
-    }
+    // Softmax normalization
+    simd::softmax(weights.data(), count);
     
-    if (sumExp > 0.0f) {
-        for (auto& mem : memoryBuffer) {
-            mem.attentionWeight /= sumExp;
-        }
+    for (size_t slot = 0; slot < count; ++slot) {
+        memoryBuffer.setAttention(slot, weights[slot]);
     }
 }
 
 void NeuralBrain::decayMemories(Tick currentTick) {
-    for (auto& mem : memoryBuffer) {
-        Tick age = currentTick - mem.memory.timestamp;
-        float decayFactor = 1.0f - (age / 10000.0f);  // Decay over 10000 ticks
-        mem.memory.significance *= std::max(0.1f, decayFactor);
+    // Amortized: each call decays one slice of the buffer, resuming where the
+    // last call stopped. A visited memory catches up on every tick since it was
+    // last decayed, so the rate doesn't depend on how often NPCs decide.
+    const size_t count = memoryBuffer.size();
+    if (count == 0) return;
+    
+    const size_t slice = std::min(count, MEMORY_DECAY_SLICE);
+    for (size_t i = 0; i < slice; ++i) {
+        decayCursor = (decayCursor + 1) % count;
+        memoryBuffer.decay(decayCursor, currentTick, MEMORY_DECAY_RATE);
     }
 }
 
@@ -416,11 +386,12 @@ void NeuralBrain::triggerProustianRecall(const std::vector<float>& currentPercep
     // Check if current perception triggers a strong match with old memory
     computeMemoryAttention(currentPerception);
     
-    for (auto& mem : memoryBuffer) {
+    for (size_t slot = 0; slot < memoryBuffer.size(); ++slot) {
         // If an old, decayed memory gets high attention, boost its significance
-        if (mem.attentionWeight > 0.3f && mem.memory.significance < 0.3f) {
+        float significance = memoryBuffer.significance(slot);
+        if (memoryBuffer.attention(slot) > 0.3f && significance < 0.3f) {
             // Flashback! This memory resurfaces
-            mem.memory.significance = std::min(1.0f, mem.memory.significance + 0.5f);
+            memoryBuffer.setSignificance(slot, std::min(1.0f, significance + 0.5f));
             
             // Emotional impact
             emotionalState.arousal += 0.2f;
@@ -430,12 +401,20 @@ void NeuralBrain::triggerProustianRecall(const std::vector<float>& currentPercep
 }
 
 std::vector<float> NeuralBrain::runInference(const std::vector<float>& perceptionVec,
-                                             const std::vector<float>& memoryContext) {
-#ifdef HAS_ONNX_RUNTIME
-    if (!modelLoaded || !ortSession) {
+                                             const float* memoryContext) {
+    PW_PROFILE_ZONE("inference");
+    if (!modelLoaded || !model) {
         return std::vector<float>(12, 0.0f);  // Return zeros
     }
     
+    if (std::shared_ptr<const NativeModel> native = model->getNative()) {
+        std::vector<float> output(InferenceScheduler::OUTPUT_DIM);
+        native->run(perceptionVec.data(), memoryContext, 1, output.data());
+        return output;
+    }
+    
+#ifdef HAS_ONNX_RUNTIME
+    
     try {
         // Prepare input tensors with correct shapes
         // Perception: (batch=1, perception_dim=20)
@@ -454,7 +433,7 @@ std::vector<float> NeuralBrain::runInference(const std::vector<float>& perceptio
             perceptionShape.data(), perceptionShape.size());
             
         Ort::Value memoryTensor = Ort::Value::CreateTensor<float>(
-            memoryInfo, const_cast<float*>(memoryContext.data()), memoryContext.size(),
+            memoryInfo, const_cast<float*>(memoryContext), InferenceScheduler::MEMORY_CONTEXT_SIZE,
             memoryShape.data(), memoryShape.size());
         
         // Input names
@@ -463,7 +442,8 @@ std::vector<float> NeuralBrain::runInference(const std::vector<float>& perceptio
         Ort::Value inputTensors[] = {std::move(perceptionTensor), std::move(memoryTensor)};
         
         // Run inference
-        auto outputTensors = ortSession->Run(
+        std::shared_ptr<Ort::Session> session = model->getSession();
+        auto outputTensors = session->Run(
             Ort::RunOptions{nullptr}, inputNames, inputTensors, 2, outputNames, 1);
         
         // Extract output
@@ -479,8 +459,6 @@ std::vector<float> NeuralBrain::runInference(const std::vector<float>& perceptio
         return std::vector<float>(12, 0.0f);
     }
 #else
-    (void)perceptionVec;
-    (void)memoryContext;
     return std::vector<float>(12, 0.0f);
 #endif
 }
@@ -488,7 +466,7 @@ std::vector<float> NeuralBrain::runInference(const std::vector<float>& perceptio
 float NeuralBrain::computeReward(const Outcome& outcome) const {
     float reward = 0.0f;
     
-    for (const auto& [need, delta] : outcome.needsDeltas) {
+    for (float delta : deltasInNameOrder(outcome.needsDelta)) {
         if (delta < 0) {  // Need satisfied
             reward += -delta;  // Positive reward
         } else {  // Need increased
@@ -496,14 +474,10 @@ float NeuralBrain::computeReward(const Outcome& outcome) const {
         }
     }
     
-    if (!outcome.event.empty()) {
-        if (outcome.event.find("danger") != std::string::npos) {
-            reward -= 2.0f;
-        } else if (outcome.event.find("food") != std::string::npos) {
-            reward += 1.0f;
-        } else if (outcome.event.find("social") != std::string::npos) {
-            reward += 0.5f;
-        }
+    switch (outcome.event) {
+        case OutcomeEvent::Food: reward += 1.0f; break;
+        case OutcomeEvent::Social: reward += 0.5f; break;
+        default: break;
     }
     
     return reward;
@@ -513,10 +487,11 @@ void NeuralBrain::updateFromExperience(const Perception& perception, const Actio
                                        const Outcome& outcome, float reward) {
     // Store in replay buffer
     ExperienceReplay exp;
-    exp.perceptionVec = perceptionToVector(perception);
+    perceptionToVector(perception, exp.perceptionVec);
     exp.actionIndex = static_cast<int>(action.type);
     exp.reward = reward;
-    exp.memoryContext = getMemoryContext();
+    exp.memoryContext.assign(memoryBuffer.context(),
+                             memoryBuffer.context() + InferenceScheduler::MEMORY_CONTEXT_SIZE);
     
     if (replayBuffer.size() >= MAX_REPLAY_BUFFER) {
         // Remove oldest experience
@@ -569,28 +544,30 @@ void NeuralBrain::saveState(const std::string& filepath) const {
     
     // Save memory buffer
     nlohmann::json memoriesJson = nlohmann::json::array();
-    for (const auto& mem : memoryBuffer) {
+    for (size_t slot = 0; slot < memoryBuffer.size(); ++slot) {
+        Vec2 location = memoryBuffer.location(slot);
+        const float* embedding = memoryBuffer.embedding(slot);
         nlohmann::json memJson;
-        memJson["type"] = mem.memory.type;
-        memJson["location"] = {{"x", mem.memory.location.x}, {"y", mem.memory.location.y}};
-        memJson["timestamp"] = mem.memory.timestamp;
-        memJson["significance"] = mem.memory.significance;
-        memJson["attention_weight"] = mem.attentionWeight;
-        memJson["embedding"] = mem.embedding;
+        memJson["type"] = memoryTypeName(memoryBuffer.type(slot));
+        memJson["location"] = {{"x", location.x}, {"y", location.y}};
+        memJson["timestamp"] = memoryBuffer.timestamp(slot);
+        memJson["significance"] = memoryBuffer.significance(slot);
+        memJson["attention_weight"] = memoryBuffer.attention(slot);
+        memJson["embedding"] = std::vector<float>(embedding, embedding + MEMORY_EMBEDDING_DIM);
         memoriesJson.push_back(memJson);
     }
     state["memory_buffer"] = memoriesJson;
     
     // Save social relationships
     nlohmann::json socialJson = nlohmann::json::object();
-    for (const auto& [id, rel] : socialIntelligence.getAllRelationships()) {
+    for (const RelationshipEmbedding& rel : socialIntelligence.getAllRelationships()) {
         nlohmann::json relJson;
         relJson["npc_id"] = rel.npcId;
         relJson["trust"] = rel.trust;
         relJson["affinity"] = rel.affinity;
         relJson["last_interaction"] = rel.lastInteraction;
         relJson["embedding"] = rel.embedding;
-        socialJson[std::to_string(id)] = relJson;
+        socialJson[std::to_string(rel.npcId)] = relJson;
     }
     state["social_relationships"] = socialJson;
     
@@ -628,7 +605,9 @@ void NeuralBrain::loadState(const std::string& filepath) {
         memoryBuffer.clear();
         for (const auto& memJson : state["memory_buffer"]) {
             MemoryEntry mem;
-            mem.type = memJson.value("type", "");
+            if (!parseMemoryType(memJson.value("type", ""), mem.type)) {
+                continue;
+            }
             if (memJson.contains("location")) {
                 mem.location.x = memJson["location"].value("x", 0.0f);
                 mem.location.y = memJson["location"].value("y", 0.0f);
@@ -636,17 +615,12 @@ void NeuralBrain::loadState(const std::string& filepath) {
             mem.timestamp = memJson.value("timestamp", static_cast<Tick>(0));
             mem.significance = memJson.value("significance", 0.0f);
             
-            std::vector<float> embedding(MEMORY_EMBEDDING_DIM, 0.0f);
-            if (memJson.contains("embedding")) {
-                const auto& embJson = memJson["embedding"];
-                for (size_t i = 0; i < std::min(embJson.size(), static_cast<size_t>(MEMORY_EMBEDDING_DIM)); ++i) {
-                    embedding[i] = embJson[i].get<float>();
-                }
+            // The embedding row is rebuilt from the fields above
+            size_t slot = memoryBuffer.size();
+            if (memoryBuffer.add(mem.type, mem.location, mem.timestamp, mem.significance) &&
+                slot < memoryBuffer.size()) {
+                memoryBuffer.setAttention(slot, memJson.value("attention_weight", 0.0f));
             }
-            
-            EpisodicMemory epMem(mem, embedding);
-            epMem.attentionWeight = memJson.value("attention_weight", 0.0f);
-            memoryBuffer.push_back(std::move(epMem));
         }
     }
     
@@ -654,9 +628,14 @@ void NeuralBrain::loadState(const std::string& filepath) {
     if (state.contains("social_relationships")) {
         for (const auto& [idStr, relJson] : state["social_relationships"].items()) {
             try {
-                EntityId npcId = static_cast<EntityId>(std::stoul(idStr));
-                socialIntelligence.recordInteraction(npcId, "neutral", 0.0f, 
-                                                      relJson.value("last_interaction", static_cast<Tick>(0)));
+                RelationshipEmbedding rel(static_cast<EntityId>(std::stoul(idStr)));
+                rel.lastInteraction = relJson.value("last_interaction", static_cast<Tick>(0));
+                if (relJson.contains("embedding") && relJson["embedding"].size() == rel.embedding.size()) {
+                    for (size_t i = 0; i < rel.embedding.size(); ++i) {
+                        rel.embedding[i] = relJson["embedding"][i].get<float>();
+                    }
+                }
+                socialIntelligence.restoreRelationship(rel);
             } catch (const std::exception&) {
                 // Skip malformed entries
             }
@@ -664,4 +643,100 @@ void NeuralBrain::loadState(const std::string& filepath) {
     }
 }
 
+void NeuralBrain::writeState(SnapshotWriter& out) const {
+    out.write(emotionalState);
+    memoryBuffer.writeSnapshot(out);
+    
+    // Settled, so pending decay is not lost
+    const std::vector<RelationshipEmbedding> relationships = socialIntelligence.getAllRelationships();
+    out.write(static_cast<uint32_t>(relationships.size()));
+    for (const RelationshipEmbedding& rel : relationships) {
+        out.write(rel.npcId);
+        out.write(rel.embedding);
+        out.write(rel.lastInteraction);
+    }
+}
+
+bool NeuralBrain::readState(SnapshotReader& in) {
+    static constexpr uint32_t MAX_RELATIONSHIPS = 1u << 20;
+    
+    in.read(emotionalState);
+    emotionalState.clamp();
+    if (!memoryBuffer.readSnapshot(in)) {
+        return false;
+    }
+    
+    uint32_t relationshipCount = 0;
+    if (!in.read(relationshipCount) || relationshipCount > MAX_RELATIONSHIPS) {
+        return false;
+    }
+    for (uint32_t i = 0; i < relationshipCount; i++) {
+        EntityId npcId = 0;
+        if (!in.read(npcId)) return false;
+        
+        RelationshipEmbedding rel(npcId);
+        in.read(rel.embedding);
+        in.read(rel.lastInteraction);
+        if (!in.ok()) return false;
+        socialIntelligence.restoreRelationship(rel);
+    }
+    return true;
+}
+
+void NeuralBrain::writeSnapshot(SnapshotWriter& out) const {
+    out.write(emotionalState);
+    npcMemory.writeSnapshot(out);
+    socialIntelligence.writeSnapshot(out);
+    memoryBuffer.writeSnapshot(out);
+    out.write(static_cast<uint64_t>(decayCursor));
+    out.writeVector(lastActionProbs);
+    out.writeRng(rng);
+    out.write(learningRate);
+    
+    // Replay entries in full, unlike saveState(): the mapping makes them cheap
+    out.write(static_cast<uint64_t>(replayBuffer.size()));
+    for (const auto& experience : replayBuffer) {
+        out.writeVector(experience.perceptionVec);
+        out.write(experience.actionIndex);
+        out.write(experience.reward);
+        out.writeVector(experience.memoryContext);
+    }
+    out.writeVector(lastPerceptionVec);
+    out.writeVector(lastMemoryContext);
+    out.write(lastActionIndex);
+}
+
+bool NeuralBrain::readSnapshot(SnapshotReader& in) {
+    static constexpr size_t MAX_VECTOR = 1 << 16;
+    
+    in.read(emotionalState);
+    if (!npcMemory.readSnapshot(in) || !socialIntelligence.readSnapshot(in) ||
+        !memoryBuffer.readSnapshot(in)) {
+        return false;
+    }
+    
+    uint64_t cursor = 0;
+    in.read(cursor);
+    decayCursor = static_cast<size_t>(cursor);
+    in.readVector(lastActionProbs, MAX_VECTOR);
+    in.readRng(rng);
+    in.read(learningRate);
+    
+    uint64_t replayCount = 0;
+    if (!in.read(replayCount) || replayCount > MAX_REPLAY_BUFFER) {
+        return false;
+    }
+    replayBuffer.resize(static_cast<size_t>(replayCount));
+    for (auto& experience : replayBuffer) {
+        in.readVector(experience.perceptionVec, MAX_VECTOR);
+        in.read(experience.actionIndex);
+        in.read(experience.reward);
+        in.readVector(experience.memoryContext, InferenceScheduler::MEMORY_CONTEXT_SIZE);
+    }
+    in.readVector(lastPerceptionVec, MAX_VECTOR);
+    in.readVector(lastMemoryContext, InferenceScheduler::MEMORY_CONTEXT_SIZE);
+    in.read(lastActionIndex);
+    return in.ok();
+}
+
 } // namespace pw
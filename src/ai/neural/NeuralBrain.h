@@ -2,7 +2,11 @@
 
 #include "ai/interface/IBrain.h"
 #include "ai/memory/NPCMemory.h"
+#include "ai/neural/EpisodicBuffer.h"
 #include "ai/social/SocialIntelligence.h"
+#include "ai/neural/InferenceScheduler.h"
+#include "ai/neural/ModelRegistry.h"
+#include "engine/Random.h"
 #include <vector>
 #include <string>
 #include <memory>
@@ -23,32 +27,47 @@ struct EmotionalState {
     float distance(const EmotionalState& other) const;
 };
 
-// Memory buffer entry with embedding
-struct EpisodicMemory {
-    MemoryEntry memory;
-    std::vector<float> embedding;  // Neural representation
-    float attentionWeight = 0.0f;  // Last attention weight from transformer
-    
-    EpisodicMemory() = default;
-    EpisodicMemory(const MemoryEntry& mem, const std::vector<float>& emb)
-        : memory(mem), embedding(emb) {}
-};
-
 class NeuralBrain : public IBrain {
 public:
-    NeuralBrain(EntityId ownerId, const std::string& modelPath = "models/npc_brain.onnx");
+    // Action sampling is seeded from seed and ownerId, so decisions are reproducible.
+    // Relationships are kept in relationships, if given, which must outlive the brain.
+    NeuralBrain(EntityId ownerId, const std::string& modelPath = "models/npc_brain.onnx",
+                uint32_t seed = 0, RelationshipStore* relationships = nullptr);
     ~NeuralBrain();
     
-    Action decide(const Perception& perception, World& world) override;
+    BrainKind kind() const override { return BrainKind::Neural; }
+    Action decide(const Perception& perception, const World& world) override;
     void onOutcome(const Outcome& outcome) override;
+    void onEvent(const EngineEvent& event) override;  // Meetings become social interactions
+    const NPCMemory* memory() const override { return &npcMemory; }
+    SocialIntelligence* social() override { return &socialIntelligence; }
+    int decisionInterval() const override { return 6; }  // 10 Hz
+    
+    // Batched inference phases (see InferenceScheduler)
+    bool prepareInput(const Perception& perception, const World& world,
+                      InferenceScheduler& scheduler) override;
+    Action applyOutput(const Perception& perception, const InferenceScheduler& scheduler) override;
+    
+    // False when decisions come from the fallback heuristics
+    bool hasModel() const { return modelLoaded; }
     
     // Access internal state for debugging
     const EmotionalState& getEmotionalState() const { return emotionalState; }
-    const std::vector<EpisodicMemory>& getMemoryBuffer() const { return memoryBuffer; }
+    const EpisodicBuffer& getMemoryBuffer() const { return memoryBuffer; }
     const std::vector<float>& getLastActionProbs() const { return lastActionProbs; }
     
+    // The last decision as a training sample: the model input it was made
+    // from, the action index and the reward onOutcome() computed for it
+    // (-1 and 0 before the first decision)
+    const std::vector<float>& getLastPerceptionVector() const { return lastPerceptionVec; }
+    int getLastActionIndex() const { return lastActionIndex; }
+    float getLastReward() const { return lastReward; }
+    
+    // Version of the shared model deciding for this brain; 0 while the fallback heuristics decide
+    uint32_t getModelVersion() const { return modelLoaded && model ? model->getVersion() : 0; }
+    
     // Memory management
-    NPCMemory& getMemory() { return memory; }
+    NPCMemory& getMemory() { return npcMemory; }
     
     // Social intelligence
     SocialIntelligence& getSocialIntelligence() { return socialIntelligence; }
@@ -58,32 +77,50 @@ public:
     void updateFromExperience(const Perception& perception, const Action& action, 
                               const Outcome& outcome, float reward);
     
-    // Serialization (JSON-based)
+    // State kept between runs: emotional state, episodic buffer and
+    // relationships. writeState/readState are the packed binary form used by
+    // BrainStateFile; saveState/loadState are the JSON form, kept for debugging.
+    void writeState(SnapshotWriter& out) const;
+    bool readState(SnapshotReader& in);
     void saveState(const std::string& filepath) const;
     void loadState(const std::string& filepath);
+    
+    void writeSnapshot(SnapshotWriter& out) const override;
+    bool readSnapshot(SnapshotReader& in) override;
 
 private:
-#ifdef HAS_ONNX_RUNTIME
-    std::unique_ptr<Ort::Env> ortEnv;
-    std::unique_ptr<Ort::Session> ortSession;
-    std::unique_ptr<Ort::SessionOptions> ortSessionOptions;
-    Ort::MemoryInfo memoryInfo{nullptr};
-#endif
-    
     EntityId ownerId;
-    NPCMemory memory;
+    NPCMemory npcMemory;
     SocialIntelligence socialIntelligence;
     bool modelLoaded = false;
     
+    // Shared with every brain using the same model path (see ModelRegistry)
+    std::shared_ptr<SharedModel> model;
+#ifdef HAS_ONNX_RUNTIME
+    Ort::MemoryInfo memoryInfo{nullptr};
+#endif
+    
     // Neural state
     EmotionalState emotionalState;
-    std::vector<EpisodicMemory> memoryBuffer;
-    static constexpr size_t MAX_MEMORY_BUFFER = 50;
-    static constexpr size_t MEMORY_EMBEDDING_DIM = 32;
+    EpisodicBuffer memoryBuffer;  // Also the model's memory input
+    static constexpr size_t MAX_MEMORY_BUFFER = EpisodicBuffer::CAPACITY;
+    static constexpr size_t MEMORY_EMBEDDING_DIM = EpisodicBuffer::EMBEDDING_DIM;
+    static constexpr size_t MEMORY_DECAY_SLICE = 8;  // Memories decayed per decayMemories() call
+    static constexpr float MEMORY_DECAY_RATE = 2.3e-4f;  // Per tick: a tenfold fall over 10000 ticks
+    size_t decayCursor = 0;
     
     // Inference output cache
     std::vector<float> lastActionProbs;
     
+    // Row queued on a scheduler and the input it was made from, until
+    // applyOutput() reads it back (the same tick, or later when pipelined)
+    InferenceTicket pendingTicket;
+    std::vector<float> pendingPerceptionVec;
+    std::vector<float> pendingMemoryContext;
+    
+    // Per-brain so NPCs can decide on different threads
+    CounterRng rng;
+    
     // Online learning
     struct ExperienceReplay {
         std::vector<float> perceptionVec;
@@ -95,14 +132,18 @@ private:
     static constexpr size_t MAX_REPLAY_BUFFER = 100;
     float learningRate = 0.001f;
     
-    // Cached last perception/action for experience replay
+    // Cached last perception/action for experience replay, with the memory
+    // context the decision saw (memoryBuffer moves on while one is pipelined)
     std::vector<float> lastPerceptionVec;
     std::vector<float> lastMemoryContext;
     int lastActionIndex = -1;
+    float lastReward = 0.0f;
     
     // Helper methods
-    std::vector<float> perceptionToVector(const Perception& perception) const;
-    std::vector<float> getMemoryContext() const;
+    void encodeInputs(const Perception& perception, std::vector<float>& perceptionVec,
+                      std::vector<float>& memoryContext);
+    Action actionFromOutput(const Perception& perception, const float* output, size_t outputSize);
+    void perceptionToVector(const Perception& perception, std::vector<float>& vec) const;
     Action actionFromProbabilities(const std::vector<float>& probs, const Perception& perception);
     void updateMemoryBuffer(const Perception& perception, Tick currentTick);
     void computeMemoryAttention(const std::vector<float>& queryVec);
@@ -111,8 +152,7 @@ private:
     
     // ONNX inference
     bool loadModel(const std::string& modelPath);
-    std::vector<float> runInference(const std::vector<float>& perceptionVec, 
-                                     const std::vector<float>& memoryContext);
+    std::vector<float> runInference(const std::vector<float>& perceptionVec, const float* memoryContext);
     
     // Online learning (simplified Hebbian-style update)
     void applyOnlineUpdate(const ExperienceReplay& experience);
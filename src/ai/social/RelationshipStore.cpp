@@ -0,0 +1,173 @@
+#include "ai/social/RelationshipStore.h"
+#include <algorithm>
+#include <cmath>
+
+namespace pw {
+
+static_assert(simd::paddedSize(RelationshipEmbedding::EMBEDDING_DIM) == RelationshipEmbedding::EMBEDDING_DIM,
+              "relationship embeddings must fill whole SIMD rows");
+
+// RelationshipEmbedding implementation
+RelationshipEmbedding::RelationshipEmbedding(EntityId id)
+    : npcId(id) {
+}
+
+RelationshipEmbedding::RelationshipEmbedding(EntityId id, CounterRng& rng)
+    : npcId(id) {
+    // Initialize with small random values
+    for (float& val : embedding) {
+        val = rng.normal(0.0f, 0.1f);
+    }
+    
+    updateDerivedMetrics();
+}
+
+void RelationshipEmbedding::updateDerivedMetrics() {
+    // Derive trust and affinity from embedding dimensions
+    // Use first few dimensions for interpretable metrics
+    if (embedding.size() >= 2) {
+        trust = std::tanh(embedding[0]);  // Maps to [-1, 1]
+        affinity = std::tanh(embedding[1]);
+    }
+}
+
+float RelationshipEmbedding::similarity(const RelationshipEmbedding& a,
+                                       const RelationshipEmbedding& b) {
+    // Cosine similarity
+    return simd::cosine(a.embedding.data(), b.embedding.data(), EMBEDDING_DIM);
+}
+
+// RelationshipStore implementation
+size_t RelationshipStore::home(uint64_t key) const {
+    // Fibonacci hashing: the high bits of the product are well mixed
+    const uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(hash >> 32) & (table.size() - 1);
+}
+
+uint32_t RelationshipStore::find(uint32_t row, EntityId other) const {
+    if (row == NONE || table.empty()) return NONE;
+    
+    const uint64_t key = keyOf(row, other);
+    for (size_t i = home(key);; i = (i + 1) & (table.size() - 1)) {
+        if (table[i].key == key) return table[i].slot;
+        if (table[i].key == EMPTY) return NONE;
+    }
+}
+
+uint32_t RelationshipStore::put(uint32_t& row, const RelationshipEmbedding& rel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (row == NONE) {
+        if (!freeRows.empty()) {
+            row = freeRows.back();
+            freeRows.pop_back();
+        } else {
+            row = static_cast<uint32_t>(rows.size());
+            rows.emplace_back();
+        }
+    }
+    
+    uint32_t slot = find(row, rel.npcId);
+    if (slot == NONE) {
+        if ((relationshipCount + 1) * 2 > table.size()) {
+            grow();
+        }
+        
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slotFields.size());
+            slotFields.emplace_back();
+            embeddings.resize(embeddings.size() + DIM);
+        }
+        
+        const uint64_t key = keyOf(row, rel.npcId);
+        size_t i = home(key);
+        while (table[i].key != EMPTY) i = (i + 1) & (table.size() - 1);
+        table[i].key = key;
+        table[i].slot = slot;
+        relationshipCount++;
+        
+        // Rows stay in id order, as the std::map they replace iterated
+        std::vector<uint32_t>& members = rows[row];
+        auto at = std::lower_bound(members.begin(), members.end(), rel.npcId,
+                                   [&](uint32_t s, EntityId id) { return slotFields[s].npcId < id; });
+        members.insert(at, slot);
+    }
+    
+    std::copy(rel.embedding.begin(), rel.embedding.end(), embedding(slot));
+    Fields& f = slotFields[slot];
+    f.npcId = rel.npcId;
+    f.trust = rel.trust;
+    f.affinity = rel.affinity;
+    f.lastInteraction = rel.lastInteraction;
+    f.decayedUntil = rel.decayedUntil;
+    return slot;
+}
+
+void RelationshipStore::release(uint32_t row) {
+    if (row == NONE) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    for (uint32_t slot : rows[row]) {
+        erase(keyOf(row, slotFields[slot].npcId));
+        freeSlots.push_back(slot);
+    }
+    relationshipCount -= rows[row].size();
+    rows[row].clear();  // Keeps its capacity for the next owner
+    freeRows.push_back(row);
+}
+
+const std::vector<uint32_t>& RelationshipStore::slots(uint32_t row) const {
+    static const std::vector<uint32_t> none;
+    return row == NONE ? none : rows[row];
+}
+
+void RelationshipStore::updateDerivedMetrics(uint32_t slot) {
+    const float* values = embedding(slot);
+    slotFields[slot].trust = std::tanh(values[0]);
+    slotFields[slot].affinity = std::tanh(values[1]);
+}
+
+RelationshipEmbedding RelationshipStore::get(uint32_t slot) const {
+    const Fields& f = slotFields[slot];
+    RelationshipEmbedding rel(f.npcId);
+    const float* values = embedding(slot);
+    std::copy(values, values + DIM, rel.embedding.begin());
+    rel.trust = f.trust;
+    rel.affinity = f.affinity;
+    rel.lastInteraction = f.lastInteraction;
+    rel.decayedUntil = f.decayedUntil;
+    return rel;
+}
+
+void RelationshipStore::grow() {
+    std::vector<Entry> old(std::max<size_t>(64, table.size() * 2));
+    old.swap(table);
+    for (const Entry& entry : old) {
+        if (entry.key == EMPTY) continue;
+        size_t i = home(entry.key);
+        while (table[i].key != EMPTY) i = (i + 1) & (table.size() - 1);
+        table[i] = entry;
+    }
+}
+
+void RelationshipStore::erase(uint64_t key) {
+    const size_t mask = table.size() - 1;
+    size_t hole = home(key);
+    while (table[hole].key != key) hole = (hole + 1) & mask;
+    
+    // Backward-shift deletion: pull later entries of the run into the hole
+    // unless that would move them before their home, so lookups need no tombstones
+    for (size_t i = (hole + 1) & mask; table[i].key != EMPTY; i = (i + 1) & mask) {
+        const size_t want = home(table[i].key);
+        if (((i - want) & mask) >= ((i - hole) & mask)) {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole] = Entry();
+}
+
+} // namespace pw
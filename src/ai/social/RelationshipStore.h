@@ -0,0 +1,115 @@
+#pragma once
+
+#include "engine/Types.h"
+#include "engine/SimdMath.h"
+#include "engine/Random.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace pw {
+
+// Relationship embedding - learned representation of NPC-to-NPC relationship.
+// RelationshipStore keeps these split into flat arrays; this is the form they
+// are passed in and copied out as.
+struct RelationshipEmbedding {
+    static constexpr size_t EMBEDDING_DIM = 16;  // A whole number of SIMD rows
+    
+    EntityId npcId;
+    alignas(simd::ALIGNMENT) std::array<float, EMBEDDING_DIM> embedding{};  // Learned embedding vector
+    float trust = 0.0f;            // Derived from embedding
+    float affinity = 0.0f;         // Derived from embedding
+    Tick lastInteraction = 0;
+    Tick decayedUntil = 0;         // Decay has been applied up to this tick
+    
+    // A zero embedding, for relationships about to be restored
+    explicit RelationshipEmbedding(EntityId id);
+    // A new relationship: small random values drawn from rng
+    RelationshipEmbedding(EntityId id, CounterRng& rng);
+    
+    // Compute derived metrics from embedding
+    void updateDerivedMetrics();
+    
+    // Measure similarity between two embeddings
+    static float similarity(const RelationshipEmbedding& a, const RelationshipEmbedding& b);
+};
+
+// Every relationship of a population in flat arrays rather than a std::map of
+// separately allocated nodes per brain: an open-addressing table from (row,
+// other NPC) to a slot, the slots' embeddings in one aligned pool of
+// EMBEDDING_DIM-float rows and their other fields beside it. Each
+// SocialIntelligence is one row, whose slots are kept sorted by the other NPC's
+// id. Freed slots and rows are reused, so a settled population stops allocating.
+//
+// Adding relationships and acquiring or releasing rows lock, since brains are
+// built, restored and destroyed in parallel. Reading and updating slots does
+// not: do it only while nothing is being added, as in the serial event
+// dispatch or while saving.
+class RelationshipStore {
+public:
+    static constexpr size_t DIM = RelationshipEmbedding::EMBEDDING_DIM;
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    // Per slot, everything but the embedding
+    struct Fields {
+        EntityId npcId = 0;
+        float trust = 0.0f;
+        float affinity = 0.0f;
+        Tick lastInteraction = 0;
+        Tick decayedUntil = 0;
+    };
+    
+    RelationshipStore() = default;
+    RelationshipStore(const RelationshipStore&) = delete;
+    RelationshipStore& operator=(const RelationshipStore&) = delete;
+    
+    // Slot of row's relationship with other, or NONE
+    uint32_t find(uint32_t row, EntityId other) const;
+    
+    // Stores rel as row's relationship with rel.npcId, replacing any there,
+    // and returns its slot. A row of NONE is first given a new row.
+    uint32_t put(uint32_t& row, const RelationshipEmbedding& rel);
+    
+    // Drops the row and its relationships, for reuse
+    void release(uint32_t row);
+    
+    // The row's slots in id order (none for NONE)
+    const std::vector<uint32_t>& slots(uint32_t row) const;
+    
+    float* embedding(uint32_t slot) { return &embeddings[slot * DIM]; }
+    const float* embedding(uint32_t slot) const { return &embeddings[slot * DIM]; }
+    Fields& fields(uint32_t slot) { return slotFields[slot]; }
+    const Fields& fields(uint32_t slot) const { return slotFields[slot]; }
+    
+    // Trust and affinity from the embedding, as RelationshipEmbedding::updateDerivedMetrics()
+    void updateDerivedMetrics(uint32_t slot);
+    
+    RelationshipEmbedding get(uint32_t slot) const;
+    
+    size_t size() const { return relationshipCount; }  // Relationships held
+
+private:
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+    
+    struct Entry {
+        uint64_t key = EMPTY;  // Row in the high half, other NPC's id in the low
+        uint32_t slot = NONE;
+    };
+    
+    std::vector<Entry> table;  // Linear probing, power-of-two size, at most half full
+    simd::AlignedFloats embeddings;
+    std::vector<Fields> slotFields;
+    std::vector<std::vector<uint32_t>> rows;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> freeRows;
+    size_t relationshipCount = 0;
+    std::mutex mutex;
+    
+    static uint64_t keyOf(uint32_t row, EntityId other) { return (static_cast<uint64_t>(row) << 32) | other; }
+    size_t home(uint64_t key) const;
+    void grow();
+    void erase(uint64_t key);
+};
+
+} // namespace pw
@@ -1,105 +1,102 @@
 #include "ai/social/SocialIntelligence.h"
+#include "serialization/Snapshot.h"
 #include <algorithm>
 #include <cmath>
-#include <random>
 
 namespace pw {
 
-// RelationshipEmbedding implementation
-RelationshipEmbedding::RelationshipEmbedding(EntityId id) 
-    : npcId(id) {
-    // Initialize with small random values
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::normal_distribution<float> dist(0.0f, 0.1f);
-    
-    embedding.resize(EMBEDDING_DIM);
-    for (float& val : embedding) {
-        val = dist(gen);
-    }
-    
-    updateDerivedMetrics();
-}
-
-void RelationshipEmbedding::updateDerivedMetrics() {
-    // Derive trust and affinity from embedding dimensions
-    // Use first few dimensions for interpretable metrics
-    if (embedding.size() >= 2) {
-        trust = std::tanh(embedding[0]);  // Maps to [-1, 1]
-        affinity = std::tanh(embedding[1]);
-    }
-}
-
-float RelationshipEmbedding::similarity(const RelationshipEmbedding& a, 
-                                       const RelationshipEmbedding& b) {
-    // Cosine similarity
-    float dotProduct = 0.0f;
-    float normA = 0.0f;
-    float normB = 0.0f;
-    
-    size_t minSize = std::min(a.embedding.size(), b.embedding.size());
-    for (size_t i = 0; i < minSize; ++i) {
-        dotProduct += a.embedding[i] * b.embedding[i];
-        normA += a.embedding[i] * a.embedding[i];
-        normB += b.embedding[i] * b.embedding[i];
+// SocialIntelligence implementation
+SocialIntelligence::SocialIntelligence(EntityId ownerId, uint32_t seed, RelationshipStore* store) 
+    : ownerId(ownerId), rng(CounterRng::streamKey(seed, ownerId, CounterRng::Social)), store(store) {
+    if (!store) {
+        ownStore = std::make_unique<RelationshipStore>();
+        this->store = ownStore.get();
     }
-    
-    normA = std::sqrt(normA);
-    normB = std::sqrt(normB);
-    
-    if (normA < 1e-6f || normB < 1e-6f) return 0.0f;
-    
-    return dotProduct / (normA * normB);
 }
 
-// SocialIntelligence implementation
-SocialIntelligence::SocialIntelligence(EntityId ownerId) 
-    : ownerId(ownerId) {
+SocialIntelligence::~SocialIntelligence() {
+    store->release(row);
 }
 
 void SocialIntelligence::recordInteraction(EntityId otherNpc, 
                                            const std::string& interactionType,
                                            float valence, Tick currentTick) {
     // Get or create relationship
-    auto it = relationships.find(otherNpc);
-    if (it == relationships.end()) {
-        relationships.emplace(otherNpc, RelationshipEmbedding(otherNpc));
-        it = relationships.find(otherNpc);
+    uint32_t slot = store->find(row, otherNpc);
+    if (slot == RelationshipStore::NONE) {
+        RelationshipEmbedding rel(otherNpc, rng);
+        rel.decayedUntil = decayClock;  // Nothing to catch up on
+        slot = store->put(row, rel);
     }
     
     // Update the relationship
-    updateEmbedding(it->second, interactionType, valence);
-    it->second.lastInteraction = currentTick;
+    settle(slot);
+    updateEmbedding(slot, interactionType, valence);
+    store->fields(slot).lastInteraction = currentTick;
+}
+
+void SocialIntelligence::restoreRelationship(const RelationshipEmbedding& saved) {
+    // Stored in one locked step: brain states are restored in parallel
+    RelationshipEmbedding rel = saved;
+    rel.decayedUntil = decayClock;
+    rel.updateDerivedMetrics();
+    store->put(row, rel);
 }
 
-const RelationshipEmbedding* SocialIntelligence::getRelationship(EntityId npcId) const {
-    auto it = relationships.find(npcId);
-    if (it != relationships.end()) {
-        return &it->second;
+bool SocialIntelligence::getRelationship(EntityId npcId, RelationshipEmbedding& out) const {
+    const uint32_t slot = store->find(row, npcId);
+    if (slot == RelationshipStore::NONE) return false;
+    
+    settle(slot);
+    out = store->get(slot);
+    return true;
+}
+
+std::vector<RelationshipEmbedding> SocialIntelligence::getAllRelationships() const {
+    settleAll();
+    std::vector<RelationshipEmbedding> all;
+    all.reserve(relationshipCount());
+    for (uint32_t slot : store->slots(row)) {
+        all.push_back(store->get(slot));
     }
-    return nullptr;
+    return all;
 }
 
 std::vector<EntityId> SocialIntelligence::findSimilarNpcs(float threshold) const {
     std::vector<EntityId> similar;
-    
-    // Compare all pairs of relationships
-    std::vector<std::pair<EntityId, const RelationshipEmbedding*>> rels;
-    for (const auto& [id, rel] : relationships) {
-        rels.push_back({id, &rel});
+    settleAll();
+    const std::vector<uint32_t>& slots = store->slots(row);
+    const size_t count = slots.size();
+    const size_t dim = RelationshipStore::DIM;
+    
+    // Unit-length rows gathered from the pool, so one A * A^T gives every
+    // pairwise cosine similarity
+    std::vector<EntityId> ids;
+    ids.reserve(count);
+    simd::AlignedFloats rows(count * dim);
+    for (uint32_t slot : slots) {
+        float* unit = &rows[ids.size() * dim];
+        std::copy(store->embedding(slot), store->embedding(slot) + dim, unit);
+        simd::normalize(unit, dim);
+        ids.push_back(store->fields(slot).npcId);
     }
     
-    // Find NPCs with similar relationship patterns
-    for (size_t i = 0; i < rels.size(); ++i) {
-        for (size_t j = i + 1; j < rels.size(); ++j) {
-            float sim = RelationshipEmbedding::similarity(*rels[i].second, *rels[j].second);
-            if (sim >= threshold) {
-                if (std::find(similar.begin(), similar.end(), rels[i].first) == similar.end()) {
-                    similar.push_back(rels[i].first);
-                }
-                if (std::find(similar.begin(), similar.end(), rels[j].first) == similar.end()) {
-                    similar.push_back(rels[j].first);
-                }
+    std::vector<float> similarity(count * count);
+    simd::gram(rows.data(), count, dim, dim, similarity.data());
+    
+    // Find NPCs with similar relationship patterns, in pair order
+    std::vector<uint8_t> added(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = i + 1; j < count; ++j) {
+            if (similarity[i * count + j] < threshold) continue;
+            
+            if (!added[i]) {
+                added[i] = 1;
+                similar.push_back(ids[i]);
+            }
+            if (!added[j]) {
+                added[j] = 1;
+                similar.push_back(ids[j]);
             }
         }
     }
@@ -110,11 +107,13 @@ std::vector<EntityId> SocialIntelligence::findSimilarNpcs(float threshold) const
 EntityId SocialIntelligence::getClosestAlly() const {
     EntityId bestId = 0;
     float bestAffinity = -1.0f;
+    settleAll();
     
-    for (const auto& [id, rel] : relationships) {
+    for (uint32_t slot : store->slots(row)) {
+        const RelationshipStore::Fields& rel = store->fields(slot);
         if (rel.affinity > bestAffinity) {
             bestAffinity = rel.affinity;
-            bestId = id;
+            bestId = rel.npcId;
         }
     }
     
@@ -124,11 +123,13 @@ EntityId SocialIntelligence::getClosestAlly() const {
 EntityId SocialIntelligence::getStrongestRival() const {
     EntityId worstId = 0;
     float worstAffinity = 1.0f;
+    settleAll();
     
-    for (const auto& [id, rel] : relationships) {
+    for (uint32_t slot : store->slots(row)) {
+        const RelationshipStore::Fields& rel = store->fields(slot);
         if (rel.affinity < worstAffinity) {
             worstAffinity = rel.affinity;
-            worstId = id;
+            worstId = rel.npcId;
         }
     }
     
@@ -136,23 +137,40 @@ EntityId SocialIntelligence::getStrongestRival() const {
 }
 
 void SocialIntelligence::decayRelationships(Tick currentTick) {
-    for (auto& [id, rel] : relationships) {
-        Tick timeSinceInteraction = currentTick - rel.lastInteraction;
-        
-        // Decay towards neutral (0) over time
-        if (timeSinceInteraction > 1000) {  // After 1000 ticks
-            float decayRate = 0.001f;
-            for (float& val : rel.embedding) {
-                val *= (1.0f - decayRate);
-            }
-            rel.updateDerivedMetrics();
-        }
+    decayClock = std::max(decayClock, currentTick);
+}
+
+void SocialIntelligence::settle(uint32_t slot) const {
+    RelationshipStore::Fields& rel = store->fields(slot);
+    
+    // Decay steps fall on multiples of DECAY_INTERVAL in (start, decayClock]
+    Tick start = std::max(rel.decayedUntil, rel.lastInteraction + DECAY_IDLE_TICKS);
+    rel.decayedUntil = std::max(rel.decayedUntil, decayClock);
+    if (decayClock <= start) return;
+    
+    Tick steps = decayClock / DECAY_INTERVAL - start / DECAY_INTERVAL;
+    if (steps == 0) return;
+    
+    // Decay towards neutral (0) over time
+    float factor = std::pow(1.0f - DECAY_RATE, static_cast<float>(steps));
+    float* embedding = store->embedding(slot);
+    for (size_t i = 0; i < RelationshipStore::DIM; i++) {
+        embedding[i] *= factor;
     }
+    store->updateDerivedMetrics(slot);
 }
 
-void SocialIntelligence::updateEmbedding(RelationshipEmbedding& rel,
+void SocialIntelligence::settleAll() const {
+    for (uint32_t slot : store->slots(row)) {
+        settle(slot);
+    }
+}
+
+void SocialIntelligence::updateEmbedding(uint32_t slot,
                                         const std::string& interactionType,
                                         float valence) {
+    float* embedding = store->embedding(slot);
+    
     // Learning rate
     float alpha = 0.1f;
     
@@ -161,33 +179,69 @@ void SocialIntelligence::updateEmbedding(RelationshipEmbedding& rel,
     
     if (interactionType == "cooperative" || interactionType == "share_food") {
         // Positive interactions increase trust and affinity dimensions
-        rel.embedding[0] += alpha * valence * 0.5f;  // Trust
-        rel.embedding[1] += alpha * valence * 0.3f;  // Affinity
+        embedding[0] += alpha * valence * 0.5f;  // Trust
+        embedding[1] += alpha * valence * 0.3f;  // Affinity
     } else if (interactionType == "competitive" || interactionType == "conflict") {
         // Negative interactions decrease trust and affinity
-        rel.embedding[0] -= alpha * std::abs(valence) * 0.4f;
-        rel.embedding[1] -= alpha * std::abs(valence) * 0.6f;
+        embedding[0] -= alpha * std::abs(valence) * 0.4f;
+        embedding[1] -= alpha * std::abs(valence) * 0.6f;
     } else if (interactionType == "neutral" || interactionType == "observe") {
         // Neutral interactions slightly increase familiarity
-        rel.embedding[2] += alpha * 0.1f;  // Familiarity dimension
+        embedding[2] += alpha * 0.1f;  // Familiarity dimension
     }
     
     // Add some noise to other dimensions (exploration)
-    // Use a local random generator per call to avoid thread-safety issues
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::normal_distribution<float> noise(0.0f, 0.01f);
-    
-    for (size_t i = 3; i < rel.embedding.size(); ++i) {
-        rel.embedding[i] += noise(gen);
+    for (size_t i = 3; i < RelationshipStore::DIM; ++i) {
+        embedding[i] += rng.normal(0.0f, 0.01f);
     }
     
     // Clamp values to reasonable range
-    for (float& val : rel.embedding) {
-        val = std::max(-2.0f, std::min(2.0f, val));
+    for (size_t i = 0; i < RelationshipStore::DIM; ++i) {
+        embedding[i] = std::max(-2.0f, std::min(2.0f, embedding[i]));
     }
     
-    rel.updateDerivedMetrics();
+    store->updateDerivedMetrics(slot);
+}
+
+void SocialIntelligence::writeSnapshot(SnapshotWriter& out) const {
+    out.write(decayClock);
+    out.writeRng(rng);
+    out.write(static_cast<uint64_t>(relationshipCount()));
+    for (uint32_t slot : store->slots(row)) {
+        const RelationshipStore::Fields& rel = store->fields(slot);
+        out.write(rel.npcId);
+        out.writeBytes(store->embedding(slot), RelationshipStore::DIM * sizeof(float));
+        out.write(rel.trust);
+        out.write(rel.affinity);
+        out.write(rel.lastInteraction);
+        out.write(rel.decayedUntil);
+    }
+}
+
+bool SocialIntelligence::readSnapshot(SnapshotReader& in) {
+    static constexpr uint64_t MAX_RELATIONSHIPS = 1u << 20;
+    
+    store->release(row);
+    row = RelationshipStore::NONE;
+    uint64_t count = 0;
+    in.read(decayClock);
+    in.readRng(rng);
+    if (!in.read(count) || count > MAX_RELATIONSHIPS) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        EntityId npcId = 0;
+        if (!in.read(npcId)) return false;
+        
+        RelationshipEmbedding rel(npcId);
+        in.read(rel.embedding);
+        in.read(rel.trust);
+        in.read(rel.affinity);
+        in.read(rel.lastInteraction);
+        in.read(rel.decayedUntil);
+        store->put(row, rel);
+    }
+    return in.ok();
 }
 
 } // namespace pw
@@ -1,47 +1,37 @@
 #pragma once
 
+#include "ai/social/RelationshipStore.h"
 #include "engine/Types.h"
-#include "engine/Math.h"
-#include <map>
+#include "engine/Random.h"
+#include <memory>
 #include <vector>
 #include <string>
 
 namespace pw {
 
-// Relationship embedding - learned representation of NPC-to-NPC relationship
-struct RelationshipEmbedding {
-    EntityId npcId;
-    std::vector<float> embedding;  // Learned embedding vector
-    float trust = 0.0f;            // Derived from embedding
-    float affinity = 0.0f;         // Derived from embedding
-    Tick lastInteraction = 0;
-    
-    static constexpr size_t EMBEDDING_DIM = 16;
-    
-    RelationshipEmbedding(EntityId id);
-    
-    // Compute derived metrics from embedding
-    void updateDerivedMetrics();
-    
-    // Measure similarity between two embeddings
-    static float similarity(const RelationshipEmbedding& a, const RelationshipEmbedding& b);
-};
+class SnapshotReader;
+class SnapshotWriter;
 
+// One NPC's relationships: a row of a RelationshipStore shared by the
+// population, or of a store of its own when given none
 class SocialIntelligence {
 public:
-    SocialIntelligence(EntityId ownerId);
+    // Embedding noise comes from a stream derived from seed and ownerId
+    SocialIntelligence(EntityId ownerId, uint32_t seed = 0, RelationshipStore* store = nullptr);
+    ~SocialIntelligence();
+    SocialIntelligence(const SocialIntelligence&) = delete;
+    SocialIntelligence& operator=(const SocialIntelligence&) = delete;
     
     // Update relationship based on interaction outcome
     void recordInteraction(EntityId otherNpc, const std::string& interactionType, 
                           float valence, Tick currentTick);
     
-    // Get relationship with specific NPC
-    const RelationshipEmbedding* getRelationship(EntityId npcId) const;
+    // Copies out the relationship with a specific NPC; false if there is none
+    bool getRelationship(EntityId npcId, RelationshipEmbedding& out) const;
     
-    // Get all relationships
-    const std::map<EntityId, RelationshipEmbedding>& getAllRelationships() const { 
-        return relationships; 
-    }
+    // Copies of all relationships, in id order
+    std::vector<RelationshipEmbedding> getAllRelationships() const;
+    size_t relationshipCount() const { return store->slots(row).size(); }
     
     // Find NPCs with similar relationships (emergent groups)
     std::vector<EntityId> findSimilarNpcs(float threshold = 0.7f) const;
@@ -50,16 +40,37 @@ public:
     EntityId getClosestAlly() const;
     EntityId getStrongestRival() const;
     
-    // Decay relationships over time
+    // Decay relationships over time. Only advances the decay clock; each
+    // relationship catches up on the decay it missed when it is next read.
     void decayRelationships(Tick currentTick);
+    
+    // Relationships idle for longer than DECAY_IDLE_TICKS shrink by DECAY_RATE
+    // on every decay step, i.e. every tick that is a multiple of DECAY_INTERVAL
+    static constexpr Tick DECAY_INTERVAL = 100;
+    static constexpr Tick DECAY_IDLE_TICKS = 1000;
+    static constexpr float DECAY_RATE = 0.001f;
+    
+    // Adds (or replaces) a saved relationship as-is; it decays from now on
+    void restoreRelationship(const RelationshipEmbedding& saved);
+    
+    // Relationships as stored, with any decay still pending
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
 
 private:
     EntityId ownerId;
-    std::map<EntityId, RelationshipEmbedding> relationships;
+    CounterRng rng;
+    std::unique_ptr<RelationshipStore> ownStore;  // Only when not given one
+    RelationshipStore* store;  // Const reads still settle pending decay through it
+    uint32_t row = RelationshipStore::NONE;  // Until the first relationship
+    Tick decayClock = 0;
+    
+    // Applies the decay steps a slot missed up to decayClock
+    void settle(uint32_t slot) const;
+    void settleAll() const;  // The whole row in one pass over the pool
     
     // Update embedding based on interaction
-    void updateEmbedding(RelationshipEmbedding& rel, const std::string& interactionType, 
-                        float valence);
+    void updateEmbedding(uint32_t slot, const std::string& interactionType, float valence);
 };
 
 } // namespace pw
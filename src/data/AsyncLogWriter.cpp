@@ -0,0 +1,153 @@
+#include "AsyncLogWriter.h"
+#include <algorithm>
+#include <chrono>
+
+namespace pw {
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity, BackpressurePolicy policy, WriteFn write, FlushFn flush,
+                               size_t slotBytes)
+    : slots(std::max<size_t>(1, capacity))
+    , policy(policy)
+    , writeFn(std::move(write))
+    , flushFn(std::move(flush)) {
+    for (Slot& s : slots) {
+        s.bytes.reserve(slotBytes);
+    }
+    thread = std::thread(&AsyncLogWriter::run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+bool AsyncLogWriter::parsePolicy(const std::string& name, BackpressurePolicy& result) {
+    if (name == "block") {
+        result = BackpressurePolicy::Block;
+        return true;
+    }
+    if (name == "drop") {
+        result = BackpressurePolicy::Drop;
+        return true;
+    }
+    if (name == "sample") {
+        result = BackpressurePolicy::Sample;
+        return true;
+    }
+    return false;
+}
+
+bool AsyncLogWriter::push(uint8_t channel, std::string_view record) {
+    const size_t capacity = slots.size();
+    const uint64_t slot = tail.load(std::memory_order_relaxed);
+    size_t depth = static_cast<size_t>(slot - head.load(std::memory_order_acquire));
+    pushCount++;
+    
+    if (policy == BackpressurePolicy::Sample && depth >= capacity / 2 &&
+        pushCount % SAMPLE_INTERVAL != 0) {
+        sampledOut.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    if (depth >= capacity) {
+        if (policy != BackpressurePolicy::Block) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        
+        // Wait for the I/O thread to free a slot
+        while (depth >= capacity) {
+            notifyConsumer();
+            std::this_thread::yield();
+            depth = static_cast<size_t>(slot - head.load(std::memory_order_acquire));
+        }
+    }
+    
+    Slot& target = slots[slot % capacity];
+    target.channel = channel;
+    target.bytes.assign(record.data(), record.size());
+    tail.store(slot + 1);  // seq_cst pairs with the sleeping flag in notifyConsumer()
+    
+    if (depth + 1 > maxDepth.load(std::memory_order_relaxed)) {
+        maxDepth.store(depth + 1, std::memory_order_relaxed);
+    }
+    
+    notifyConsumer();
+    return true;
+}
+
+void AsyncLogWriter::notifyConsumer() {
+    if (sleeping.load()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_one();
+    }
+}
+
+void AsyncLogWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t target = tail.load(std::memory_order_relaxed);
+    flushTarget = std::max(flushTarget, target);
+    wake.notify_one();
+    flushed.wait(lock, [&] { return flushedUpTo >= target; });
+}
+
+LogQueueStats AsyncLogWriter::stats() const {
+    LogQueueStats result;
+    const uint64_t consumed = head.load(std::memory_order_acquire);
+    result.capacity = slots.size();
+    result.depth = static_cast<size_t>(tail.load(std::memory_order_acquire) - consumed);
+    result.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    result.written = consumed;
+    result.dropped = dropped.load(std::memory_order_relaxed);
+    result.sampledOut = sampledOut.load(std::memory_order_relaxed);
+    return result;
+}
+
+void AsyncLogWriter::run() {
+    const size_t capacity = slots.size();
+    
+    for (;;) {
+        // Drain everything published so far
+        uint64_t next = head.load(std::memory_order_relaxed);
+        const uint64_t end = tail.load(std::memory_order_acquire);
+        for (; next != end; next++) {
+            const Slot& slot = slots[next % capacity];
+            writeFn(slot.channel, slot.bytes);
+            head.store(next + 1, std::memory_order_release);
+        }
+        
+        std::unique_lock<std::mutex> lock(mutex);
+        if (flushTarget > flushedUpTo && next >= flushTarget) {
+            const uint64_t target = flushTarget;
+            lock.unlock();
+            flushFn();
+            lock.lock();
+            flushedUpTo = target;
+            flushed.notify_all();
+            continue;
+        }
+        
+        const bool hasWork = tail.load(std::memory_order_acquire) != next;
+        if (stopping && !hasWork) {
+            lock.unlock();
+            flushFn();
+            return;
+        }
+        if (hasWork || flushTarget > flushedUpTo) {
+            continue;
+        }
+        
+        // Sleep until push()/flush() wakes us; the timeout is only a safety net
+        sleeping.store(true);
+        wake.wait_for(lock, std::chrono::milliseconds(50), [&] {
+            return stopping || flushTarget > flushedUpTo || tail.load() != next;
+        });
+        sleeping.store(false);
+    }
+}
+
+} // namespace pw
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace pw {
+
+// What push() does when the I/O thread falls behind
+enum class BackpressurePolicy {
+    Block,   // Wait for a free slot; nothing is lost
+    Drop,    // Discard records while the queue is full
+    Sample   // Past half full keep every SAMPLE_INTERVAL-th record, drop when full
+};
+
+struct LogQueueStats {
+    size_t capacity = 0;
+    size_t depth = 0;        // Records waiting right now
+    size_t maxDepth = 0;     // High-water mark
+    uint64_t written = 0;    // Records handed to the sink
+    uint64_t dropped = 0;    // Lost because the queue was full
+    uint64_t sampledOut = 0; // Skipped by the Sample policy
+};
+
+// Hands serialized records to a dedicated I/O thread through a bounded
+// single-producer/single-consumer ring. push() never touches the disk; the
+// sink runs on the I/O thread only. One thread may push at a time.
+class AsyncLogWriter {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 8192;
+    static constexpr uint64_t SAMPLE_INTERVAL = 4;
+    
+    using WriteFn = std::function<void(uint8_t channel, const std::string& record)>;
+    using FlushFn = std::function<void()>;
+    
+    // Every slot starts with slotBytes of capacity, so shorter records never
+    // allocate; longer ones grow the slot once
+    AsyncLogWriter(size_t capacity, BackpressurePolicy policy, WriteFn write, FlushFn flush,
+                   size_t slotBytes = 0);
+    ~AsyncLogWriter();  // Drains the queue, flushes and joins the I/O thread
+    
+    AsyncLogWriter(const AsyncLogWriter&) = delete;
+    AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+    
+    // Copies record into the ring; false if the policy discarded it
+    bool push(uint8_t channel, std::string_view record);
+    
+    // Returns once everything pushed so far is written and the sink flushed
+    void flush();
+    
+    BackpressurePolicy getPolicy() const { return policy; }
+    LogQueueStats stats() const;
+    
+    static bool parsePolicy(const std::string& name, BackpressurePolicy& policy);
+
+private:
+    struct Slot {
+        uint8_t channel = 0;
+        std::string bytes;  // Keeps its capacity between uses
+    };
+    
+    std::vector<Slot> slots;
+    BackpressurePolicy policy;
+    WriteFn writeFn;
+    FlushFn flushFn;
+    
+    // Monotonic counters; slot index is counter % capacity
+    alignas(64) std::atomic<uint64_t> head{0};  // Next slot to consume
+    alignas(64) std::atomic<uint64_t> tail{0};  // Next slot to fill
+    uint64_t pushCount = 0;                     // Producer only, drives sampling
+    
+    std::atomic<size_t> maxDepth{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> sampledOut{0};
+    
+    // Sleeping and flush handshakes only; records never take the lock
+    std::mutex mutex;
+    std::condition_variable wake;     // I/O thread waits for work
+    std::condition_variable flushed;  // flush() waits for the I/O thread
+    std::atomic<bool> sleeping{false};
+    uint64_t flushTarget = 0;         // Guarded by mutex
+    uint64_t flushedUpTo = 0;         // Guarded by mutex
+    bool stopping = false;            // Guarded by mutex
+    
+    std::thread thread;
+    
+    void run();
+    void notifyConsumer();
+};
+
+} // namespace pw
@@ -0,0 +1,59 @@
+#include "BinaryLogWriter.h"
+#include <iostream>
+
+namespace pw {
+
+BinaryLogWriter::BinaryLogWriter(size_t blockSize) : blockSize(blockSize) {
+    block.reserve(blockSize);
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    close();
+}
+
+bool BinaryLogWriter::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Warning: Could not open binary log " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void BinaryLogWriter::close() {
+    if (!file) return;
+    
+    flush();
+    std::fclose(file);
+    file = nullptr;
+}
+
+void BinaryLogWriter::write(const void* data, size_t size) {
+    if (!file) return;
+    
+    if (block.size() + size > blockSize) {
+        flush();
+    }
+    
+    // Oversized writes skip the block
+    if (size >= blockSize) {
+        std::fwrite(data, 1, size, file);
+    } else {
+        const char* bytes = static_cast<const char*>(data);
+        block.insert(block.end(), bytes, bytes + size);
+    }
+    written += size;
+}
+
+void BinaryLogWriter::flush() {
+    if (!file) return;
+    
+    if (!block.empty()) {
+        std::fwrite(block.data(), 1, block.size(), file);
+        block.clear();
+    }
+    std::fflush(file);
+}
+
+} // namespace pw
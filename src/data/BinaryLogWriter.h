@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace pw {
+
+// Append-only file writer that collects records in a large in-memory block and
+// hands them to the OS one block at a time
+class BinaryLogWriter {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;  // 1 MiB
+    
+    explicit BinaryLogWriter(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~BinaryLogWriter();
+    
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+    
+    bool open(const std::string& path);
+    bool isOpen() const { return file != nullptr; }
+    void close();
+    
+    void write(const void* data, size_t size);
+    void flush();
+    
+    size_t bytesWritten() const { return written; }
+
+private:
+    std::FILE* file = nullptr;
+    std::vector<char> block;
+    size_t blockSize;
+    size_t written = 0;
+};
+
+} // namespace pw
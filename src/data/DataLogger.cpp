@@ -1,11 +1,20 @@
 #include "DataLogger.h"
+#include "DecisionRecord.h"
+#include "engine/Profiler.h"
+#include "engine/Random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 namespace pw {
 
-DataLogger::DataLogger(const std::string& outputDir) : outputDir(outputDir) {
+DataLogger::DataLogger(const std::string& outputDir, LogFormat format, const LogQueueSettings& queueSettings,
+                       const LogFilterSettings& filter)
+    : outputDir(outputDir), format(format), filter(filter) {
     // Create output directory
     #ifdef _WIN32
         _mkdir(outputDir.c_str());
@@ -14,10 +23,21 @@ DataLogger::DataLogger(const std::string& outputDir) : outputDir(outputDir) {
     #endif
     
     // Open log files
-    decisionsFile.open(outputDir + "/decisions.jsonl");
+    if (format == LogFormat::Binary) {
+        if (binaryDecisions.open(outputDir + "/decisions.bin")) {
+            BinaryLogHeader header;
+            header.recordSize = sizeof(DecisionRecord);
+            binaryDecisions.write(&header, sizeof(header));
+        }
+    } else {
+        // Large stream buffer so lines go to the OS in big blocks
+        decisionsBuffer.resize(BinaryLogWriter::DEFAULT_BLOCK_SIZE);
+        decisionsFile.rdbuf()->pubsetbuf(decisionsBuffer.data(), decisionsBuffer.size());
+        decisionsFile.open(outputDir + "/decisions.jsonl");
+    }
     eventsFile.open(outputDir + "/events.jsonl");
     
-    if (!decisionsFile.is_open() || !eventsFile.is_open()) {
+    if (!decisionsOpen() || !eventsFile.is_open()) {
         std::cerr << "Warning: Could not open data log files" << std::endl;
     }
     
@@ -27,53 +47,212 @@ DataLogger::DataLogger(const std::string& outputDir) : outputDir(outputDir) {
         {"timestamp", std::time(nullptr)}
     };
     if (decisionsFile.is_open()) {
-        decisionsFile << schemaInfo.dump() << std::endl;
+        decisionsFile << schemaInfo.dump() << '\n';
     }
     if (eventsFile.is_open()) {
-        eventsFile << schemaInfo.dump() << std::endl;
+        eventsFile << schemaInfo.dump() << '\n';
+    }
+    
+    if (queueSettings.capacity > 0) {
+        // Binary records (and events) fit a preallocated slot; JSON lines vary,
+        // so their slots grow to size during the first pass over the ring
+        queue = std::make_unique<AsyncLogWriter>(
+            queueSettings.capacity, queueSettings.policy,
+            [this](uint8_t channel, const std::string& record) { writeRecord(channel, record); },
+            [this]() { flushFiles(); },
+            format == LogFormat::Binary ? sizeof(DecisionRecord) : 0);
     }
 }
 
 DataLogger::~DataLogger() {
-    flush();
+    // Drains and flushes the queue before the files close
+    queue.reset();
+    flushFiles();
     decisionsFile.close();
     eventsFile.close();
+    binaryDecisions.close();
+}
+
+bool DataLogger::parseLogFormat(const std::string& name, LogFormat& result) {
+    if (name == "jsonl") {
+        result = LogFormat::Jsonl;
+        return true;
+    }
+    if (name == "binary") {
+        result = LogFormat::Binary;
+        return true;
+    }
+    return false;
+}
+
+bool DataLogger::decisionsOpen() const {
+    return format == LogFormat::Binary ? binaryDecisions.isOpen() : decisionsFile.is_open();
 }
 
 void DataLogger::logDecision(Tick tick, EntityId npcId, const Perception& perception,
                               const Action& decision, const Outcome& outcome) {
-    if (!decisionsFile.is_open()) return;
-    
-    json entry = {
-        {"tick", tick},
-        {"npc_id", std::string("npc_") + std::to_string(npcId)},
-        {"perception", perceptionToJson(perception)},
-        {"decision", actionToJson(decision)},
-        {"outcome", outcomeToJson(outcome)}
-    };
+    if (!decisionsOpen()) return;
+    
+    formatDecision(tick, npcId, perception, decision, outcome, scratchRecord);
+    writeDecision(scratchRecord);
+}
+
+void DataLogger::formatDecision(Tick tick, EntityId npcId, const Perception& perception,
+                                const Action& decision, const Outcome& outcome,
+                                std::pmr::string& record) const {
+    PW_PROFILE_ZONE("DataLogger::format");
+    if (format == LogFormat::Binary) {
+        DecisionRecord binary = makeDecisionRecord(tick, npcId, perception, decision, outcome);
+        record.assign(reinterpret_cast<const char*>(&binary), sizeof(binary));
+        return;
+    }
+    
+    char npcName[16];
+    std::snprintf(npcName, sizeof(npcName), "npc_%u", npcId);
     
-    decisionsFile << entry.dump() << std::endl;
+    record.clear();
+    JsonWriter out(record);
+    out.beginObject();
+    out.key("decision");
+    writeAction(out, decision);
+    out.field("npc_id", npcName);
+    out.key("outcome");
+    writeOutcome(out, outcome);
+    out.key("perception");
+    writePerception(out, perception);
+    out.field("tick", tick);
+    out.endObject();
+}
+
+void DataLogger::writeDecision(std::string_view record) {
+    if (!decisionsOpen()) return;
+    
+    if (queue) {
+        queue->push(DECISIONS, record);
+    } else {
+        writeRecord(DECISIONS, record);
+    }
+}
+
+void DataLogger::writeRecord(uint8_t channel, std::string_view record) {
+    PW_PROFILE_ZONE("DataLogger::write");
+    if (channel == EVENTS) {
+        eventsFile << record << '\n';
+        return;
+    }
+    
+    if (format == LogFormat::Binary) {
+        binaryDecisions.write(record.data(), record.size());
+    } else {
+        decisionsFile << record << '\n';
+    }
     logCount++;
     
     // Periodic flush
-    if (logCount % 100 == 0) {
-        flush();
+    if (logCount % FLUSH_INTERVAL == 0) {
+        flushFiles();
     }
 }
 
 void DataLogger::logEvent(Tick tick, const std::string& eventType, const json& eventData) {
+    PW_PROFILE_ZONE("DataLogger::event");
     if (!eventsFile.is_open()) return;
     
-    json entry = {
-        {"tick", tick},
-        {"event_type", eventType},
-        {"data", eventData}
-    };
+    scratchRecord.clear();
+    JsonWriter out(scratchRecord);
+    out.beginObject();
+    out.key("data").raw(eventData.dump());
+    out.field("event_type", std::string_view(eventType));
+    out.field("tick", tick);
+    out.endObject();
+    writeEvent();
+}
+
+void DataLogger::logEvent(const EngineEvent& event) {
+    PW_PROFILE_ZONE("DataLogger::event");
+    if (!eventsFile.is_open()) return;
     
-    eventsFile << entry.dump() << std::endl;
+    scratchRecord.clear();
+    JsonWriter out(scratchRecord);
+    out.beginObject();
+    const char* name = "";
+    out.key("data").beginObject();
+    switch (event.type) {
+        case EngineEvent::Type::NpcMet:
+            name = "npc_met";
+            out.field("distance", event.value);
+            out.field("npc1", event.npc);
+            out.field("npc2", event.other);
+            break;
+    }
+    out.endObject();
+    out.field("event_type", name);
+    out.field("tick", event.tick);
+    out.endObject();
+    writeEvent();
+}
+
+void DataLogger::writeEvent() {
+    if (queue) {
+        queue->push(EVENTS, scratchRecord);
+    } else {
+        writeRecord(EVENTS, scratchRecord);
+    }
+}
+
+bool DataLogger::wantsDecision(Tick tick, EntityId npcId, ActionType previous, const Action& decision,
+                               const Outcome& outcome) const {
+    if (filter.decisionSampling > 1) {
+        // A hash rather than a counter, so the sample holds up under AI level of detail
+        const uint64_t draw = CounterRng::streamKey(tick, npcId, CounterRng::Logging);
+        if (draw % static_cast<uint64_t>(filter.decisionSampling) != 0) return false;
+    }
+    
+    if (!filter.actionChanges && filter.minNeedDelta <= 0.0f) return true;
+    if (filter.actionChanges && decision.type != previous) return true;
+    if (filter.minNeedDelta > 0.0f) {
+        const Needs& d = outcome.needsDelta;
+        for (float delta : {d.hunger, d.energy, d.social, d.curiosity, d.safety}) {
+            if (std::abs(delta) >= filter.minNeedDelta) return true;
+        }
+    }
+    return false;
+}
+
+bool DataLogger::wantsMeeting(Tick tick, EntityId a, EntityId b) {
+    if (filter.meetingCooldown == 0) return true;
+    
+    // Forget pairs whose cooldown ran out, so the table holds only recent meetings
+    if (tick >= meetingsPrunedAt + filter.meetingCooldown) {
+        for (auto it = meetingsLogged.begin(); it != meetingsLogged.end();) {
+            it = tick >= it->second + filter.meetingCooldown ? meetingsLogged.erase(it) : std::next(it);
+        }
+        meetingsPrunedAt = tick;
+    }
+    
+    const uint64_t pair = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+    auto [it, inserted] = meetingsLogged.try_emplace(pair, tick);
+    if (!inserted) {
+        if (tick < it->second + filter.meetingCooldown) return false;
+        it->second = tick;
+    }
+    return true;
 }
 
 void DataLogger::flush() {
+    if (queue) {
+        queue->flush();
+    } else {
+        flushFiles();
+    }
+}
+
+LogQueueStats DataLogger::queueStats() const {
+    return queue ? queue->stats() : LogQueueStats{};
+}
+
+void DataLogger::flushFiles() {
+    binaryDecisions.flush();
     if (decisionsFile.is_open()) {
         decisionsFile.flush();
     }
@@ -82,57 +261,89 @@ void DataLogger::flush() {
     }
 }
 
-json DataLogger::perceptionToJson(const Perception& p) const {
-    json tiles = json::array();
-    for (const auto& [pos, type] : p.nearbyTiles) {
-        tiles.push_back({
-            {"position", {pos.x, pos.y}},
-            {"type", type}
-        });
+const char* DataLogger::tileTypeName(TileType type) {
+    // Simplified categories used by the training data schema
+    switch (type) {
+        case TileType::BerryBush: return "food";
+        case TileType::Cave: return "shelter";
+        default: return "grass";
+    }
+}
+
+const char* DataLogger::weatherName(Weather weather) {
+    switch (weather) {
+        case Weather::Rain: return "rain";
+        case Weather::Storm: return "storm";
+        default: return "clear";
+    }
+}
+
+void DataLogger::writePerception(JsonWriter& out, const Perception& p) {
+    out.beginObject();
+    out.key("internal_needs");
+    writeNeeds(out, p.internalNeeds);
+    
+    out.key("memory_recalls").beginArray();
+    for (MemoryType type : p.memoryRecalls) {
+        out.value(memoryTypeName(type));
     }
+    out.endArray();
     
-    json npcs = json::array();
+    out.key("nearby_npcs").beginArray();
     for (const auto& [id, pos] : p.nearbyNPCs) {
-        npcs.push_back({
-            {"id", id},
-            {"position", {pos.x, pos.y}}
-        });
-    }
-    
-    return {
-        {"position", {p.position.x, p.position.y}},
-        {"nearby_tiles", tiles},
-        {"nearby_npcs", npcs},
-        {"internal_needs", needsToJson(p.internalNeeds)},
-        {"memory_recalls", p.memoryRecalls},
-        {"weather", p.weather},
-        {"time_of_day", p.timeOfDay}
-    };
+        out.beginObject().field("id", id);
+        out.key("position");
+        writePosition(out, pos);
+        out.endObject();
+    }
+    out.endArray();
+    
+    out.key("nearby_tiles").beginArray();
+    for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+        if (!p.hasTile(i)) continue;
+        out.beginObject().key("position");
+        writePosition(out, p.tilePosition(i));
+        out.field("type", tileTypeName(p.nearbyTiles[i]));
+        out.endObject();
+    }
+    out.endArray();
+    
+    out.key("position");
+    writePosition(out, p.position);
+    out.field("time_of_day", p.timeOfDay);
+    out.field("weather", weatherName(p.weather));
+    out.endObject();
 }
 
-json DataLogger::actionToJson(const Action& a) const {
-    return {
-        {"type", a.toString()},
-        {"target_position", {a.targetPosition.x, a.targetPosition.y}},
-        {"target_entity", a.targetEntity}
-    };
+void DataLogger::writeAction(JsonWriter& out, const Action& a) {
+    out.beginObject();
+    out.field("target_entity", a.targetEntity);
+    out.key("target_position");
+    writePosition(out, a.targetPosition);
+    out.field("type", actionTypeName(a.type));
+    out.endObject();
 }
 
-json DataLogger::outcomeToJson(const Outcome& o) const {
-    return {
-        {"needs_delta", o.needsDeltas},
-        {"event", o.event}
-    };
+void DataLogger::writeOutcome(JsonWriter& out, const Outcome& o) {
+    out.beginObject();
+    out.field("event", actionTypeName(o.action));
+    out.key("needs_delta");
+    writeNeeds(out, o.needsDelta);
+    out.endObject();
 }
 
-json DataLogger::needsToJson(const Needs& n) const {
-    return {
-        {"hunger", n.hunger},
-        {"energy", n.energy},
-        {"social", n.social},
-        {"curiosity", n.curiosity},
-        {"safety", n.safety}
-    };
+void DataLogger::writeNeeds(JsonWriter& out, const Needs& n) {
+    out.beginObject();
+    out.field("curiosity", n.curiosity);
+    out.field("energy", n.energy);
+    out.field("hunger", n.hunger);
+    out.field("safety", n.safety);
+    out.field("social", n.social);
+    out.endObject();
+}
+
+void DataLogger::writePosition(JsonWriter& out, Vec2 position) {
+    out.beginArray().value(position.x).value(position.y).endArray();
 }
 
 } // namespace pw
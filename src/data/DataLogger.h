@@ -3,39 +3,124 @@
 #include "ai/interface/IBrain.h"
 #include "entities/NPC.h"
 #include "engine/Types.h"
+#include "data/AsyncLogWriter.h"
+#include "data/BinaryLogWriter.h"
+#include "data/JsonWriter.h"
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace pw {
 
 using json = nlohmann::json;
 
+// Decision log encoding. Events are always written as JSONL.
+enum class LogFormat {
+    Jsonl,   // decisions.jsonl, one JSON object per line
+    Binary   // decisions.bin, fixed-size records (see DecisionRecord.h)
+};
+
+// Background I/O for the log files
+struct LogQueueSettings {
+    size_t capacity = AsyncLogWriter::DEFAULT_CAPACITY;  // Records; 0 writes on the caller thread
+    BackpressurePolicy policy = BackpressurePolicy::Block;
+};
+
+// Which decisions and events are worth logging, checked before anything is
+// formatted. The defaults log everything.
+struct LogFilterSettings {
+    int decisionSampling = 1;    // Log about 1 in N of each NPC's decisions
+    bool actionChanges = false;  // Of those, only decisions that switch action type...
+    float minNeedDelta = 0.0f;   // ...or (if > 0) that moved a need by at least this much
+    Tick meetingCooldown = 0;    // Ticks before the same pair's npc_met is logged again
+    
+    bool filtersDecisions() const { return decisionSampling > 1 || actionChanges || minNeedDelta > 0.0f; }
+};
+
 class DataLogger {
 public:
-    DataLogger(const std::string& outputDir = "data_logs");
+    DataLogger(const std::string& outputDir = "data_logs", LogFormat format = LogFormat::Jsonl,
+               const LogQueueSettings& queue = {}, const LogFilterSettings& filter = {});
     ~DataLogger();
     
     void logDecision(Tick tick, EntityId npcId, const Perception& perception,
                      const Action& decision, const Outcome& outcome);
     
+    // logDecision() in two steps: formatting is thread-safe, so records can be
+    // built in parallel and then written in a fixed order. record is replaced
+    // by the encoded bytes in this logger's format; JSON is written as text
+    // straight into it, so its allocator (e.g. a FrameArena) is all the
+    // memory formatting uses.
+    void formatDecision(Tick tick, EntityId npcId, const Perception& perception,
+                        const Action& decision, const Outcome& outcome, std::pmr::string& record) const;
+    void writeDecision(std::string_view record);
+    
     void logEvent(Tick tick, const std::string& eventType, const json& eventData);
+    void logEvent(const EngineEvent& event);  // As "npc_met" etc. with its fields as data
+    
+    // Filter checks. wantsDecision() is thread-safe and depends only on its
+    // arguments (sampling hashes id and tick), so a seeded run keeps the same
+    // records for any thread count; previous is the action type the NPC had
+    // before this decision. wantsMeeting() notes the pair when it returns
+    // true, so call it from one thread only.
+    bool wantsDecision(Tick tick, EntityId npcId, ActionType previous, const Action& decision,
+                       const Outcome& outcome) const;
+    bool wantsMeeting(Tick tick, EntityId a, EntityId b);
+    const LogFilterSettings& getFilter() const { return filter; }
     
+    // Blocks until everything logged so far has reached the files
     void flush();
     
+    bool isAsync() const { return queue != nullptr; }
+    LogQueueStats queueStats() const;
+    
     static constexpr const char* SCHEMA_VERSION = "1.0.0";
+    static constexpr size_t FLUSH_INTERVAL = 10000;  // Decisions between explicit flushes
+    
+    LogFormat getFormat() const { return format; }
+    static bool parseLogFormat(const std::string& name, LogFormat& format);
+    
+    // String names used in the log schema
+    static const char* tileTypeName(TileType type);
+    static const char* weatherName(Weather weather);
 
 private:
     std::string outputDir;
+    LogFormat format;
     std::ofstream decisionsFile;
     std::ofstream eventsFile;
-    int logCount = 0;
+    BinaryLogWriter binaryDecisions;
+    std::vector<char> decisionsBuffer;  // Backing store for decisionsFile
+    size_t logCount = 0;
+    
+    LogFilterSettings filter;
+    std::unordered_map<uint64_t, Tick> meetingsLogged;  // Pair -> tick it was last logged
+    Tick meetingsPrunedAt = 0;
+    std::pmr::string scratchRecord;  // Reused by logDecision() and logEvent()
+    
+    // Declared last so the I/O thread is stopped before the files close
+    std::unique_ptr<AsyncLogWriter> queue;
+    
+    enum Channel : uint8_t { DECISIONS, EVENTS };
+    
+    bool decisionsOpen() const;
+    
+    // File access; run on the I/O thread when the queue is enabled
+    void writeRecord(uint8_t channel, std::string_view record);
+    void flushFiles();
+    void writeEvent();  // scratchRecord to the events file
     
-    json perceptionToJson(const Perception& p) const;
-    json actionToJson(const Action& a) const;
-    json outcomeToJson(const Outcome& o) const;
-    json needsToJson(const Needs& n) const;
+    // JSONL schema; keys in sorted order, as json objects print them
+    static void writePerception(JsonWriter& out, const Perception& p);
+    static void writeAction(JsonWriter& out, const Action& a);
+    static void writeOutcome(JsonWriter& out, const Outcome& o);
+    static void writeNeeds(JsonWriter& out, const Needs& n);
+    static void writePosition(JsonWriter& out, Vec2 position);
 };
 
 } // namespace pw
@@ -0,0 +1,57 @@
+#include "DecisionRecord.h"
+
+namespace pw {
+
+DecisionRecord makeDecisionRecord(Tick tick, EntityId npcId, const Perception& perception,
+                                  const Action& decision, const Outcome& outcome) {
+    DecisionRecord r;
+    r.tick = tick;
+    r.npcId = npcId;
+    r.positionX = perception.position.x;
+    r.positionY = perception.position.y;
+    
+    const Needs& n = perception.internalNeeds;
+    r.needs[0] = n.hunger;
+    r.needs[1] = n.energy;
+    r.needs[2] = n.social;
+    r.needs[3] = n.curiosity;
+    r.needs[4] = n.safety;
+    
+    r.timeOfDay = perception.timeOfDay;
+    r.viewOriginX = perception.viewOriginX;
+    r.viewOriginY = perception.viewOriginY;
+    r.targetX = decision.targetPosition.x;
+    r.targetY = decision.targetPosition.y;
+    r.targetEntity = decision.targetEntity;
+    
+    const Needs& d = outcome.needsDelta;
+    r.needsDelta[0] = d.hunger;
+    r.needsDelta[1] = d.energy;
+    r.needsDelta[2] = d.social;
+    r.needsDelta[3] = d.curiosity;
+    r.needsDelta[4] = d.safety;
+    
+    r.weather = static_cast<uint8_t>(perception.weather);
+    r.actionType = static_cast<uint8_t>(decision.type);
+    
+    for (size_t i = 0; i < Perception::VIEW_TILES; ++i) {
+        r.tiles[i] = perception.hasTile(i) ? static_cast<uint8_t>(perception.nearbyTiles[i])
+                                           : DecisionRecord::NO_TILE;
+    }
+    
+    r.memoryRecallCount = static_cast<uint8_t>(perception.memoryRecalls.size());
+    for (size_t i = 0; i < perception.memoryRecalls.size(); ++i) {
+        r.memoryRecalls[i] = static_cast<uint8_t>(perception.memoryRecalls[i]);
+    }
+    
+    r.nearbyNpcCount = static_cast<uint8_t>(perception.nearbyNPCs.size());
+    for (size_t i = 0; i < perception.nearbyNPCs.size(); ++i) {
+        r.nearbyNpcIds[i] = perception.nearbyNPCs[i].id;
+        r.nearbyNpcPositions[i][0] = perception.nearbyNPCs[i].position.x;
+        r.nearbyNpcPositions[i][1] = perception.nearbyNPCs[i].position.y;
+    }
+    
+    return r;
+}
+
+} // namespace pw
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ai/interface/IBrain.h"
+#include "engine/Types.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace pw {
+
+// Binary decision log (decisions.bin): a BinaryLogHeader followed by fixed-size
+// DecisionRecords in host byte order (little-endian on every supported target),
+// with no padding between fields. Mirrored by
+// RECORD_DTYPE in tools/export_training_data.py - bump BINARY_SCHEMA_VERSION
+// and update both when the layout changes.
+constexpr uint32_t BINARY_LOG_MAGIC = 0x4C445750;  // "PWDL"
+constexpr uint32_t BINARY_SCHEMA_VERSION = 1;
+
+struct BinaryLogHeader {
+    uint32_t magic = BINARY_LOG_MAGIC;
+    uint32_t schemaVersion = BINARY_SCHEMA_VERSION;
+    uint32_t recordSize = 0;
+    uint32_t reserved = 0;
+};
+
+struct DecisionRecord {
+    static constexpr uint8_t NO_TILE = 0xFF;  // View cell outside the world
+    
+    uint64_t tick = 0;
+    uint32_t npcId = 0;
+    float positionX = 0.0f;
+    float positionY = 0.0f;
+    float needs[5] = {};        // hunger, energy, social, curiosity, safety
+    float timeOfDay = 0.0f;
+    int32_t viewOriginX = 0;
+    int32_t viewOriginY = 0;
+    float targetX = 0.0f;
+    float targetY = 0.0f;
+    uint32_t targetEntity = 0;
+    float needsDelta[5] = {};   // Same order as needs
+    uint8_t weather = 0;        // Weather
+    uint8_t actionType = 0;     // ActionType
+    uint8_t nearbyNpcCount = 0;
+    uint8_t memoryRecallCount = 0;
+    uint8_t tiles[Perception::VIEW_TILES] = {};  // TileType, row-major from the view origin
+    uint8_t memoryRecalls[Perception::MAX_MEMORY_RECALLS] = {};  // MemoryType
+    uint8_t reserved[7] = {};
+    uint32_t nearbyNpcIds[Perception::MAX_NEARBY_NPCS] = {};
+    float nearbyNpcPositions[Perception::MAX_NEARBY_NPCS][2] = {};
+};
+
+static_assert(sizeof(BinaryLogHeader) == 16, "binary log header layout changed");
+static_assert(offsetof(DecisionRecord, weather) == 84, "decision record layout changed");
+static_assert(offsetof(DecisionRecord, nearbyNpcIds) == 232, "decision record layout changed");
+static_assert(sizeof(DecisionRecord) == 424, "decision record layout changed");
+
+DecisionRecord makeDecisionRecord(Tick tick, EntityId npcId, const Perception& perception,
+                                  const Action& decision, const Outcome& outcome);
+
+} // namespace pw
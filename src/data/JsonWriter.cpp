@@ -0,0 +1,112 @@
+#include "JsonWriter.h"
+#include <nlohmann/json.hpp>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace pw {
+
+void JsonWriter::separate() {
+    if (!first) out += ',';
+    first = false;
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    out += '{';
+    first = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    first = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    out += '[';
+    first = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    first = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    separate();
+    escaped(name);
+    out += ':';
+    first = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    return value(std::string_view(text));
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    escaped(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    separate();
+    if (!std::isfinite(number)) {
+        out += "null";
+        return *this;
+    }
+    
+    // The shortest round-trip formatting dump() itself uses
+    std::array<char, 64> buffer;
+    char* end = nlohmann::detail::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+    out.append(buffer.data(), static_cast<size_t>(end - buffer.data()));
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(uint64_t number) {
+    separate();
+    std::array<char, 24> buffer;
+    auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+    out.append(buffer.data(), static_cast<size_t>(result.ptr - buffer.data()));
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+    separate();
+    out.append(json.data(), json.size());
+    return *this;
+}
+
+void JsonWriter::escaped(std::string_view text) {
+    // dump()'s escapes with ensure_ascii off: UTF-8 passes through
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) <= 0x1F) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                    out += code;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace pw
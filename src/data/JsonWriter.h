@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace pw {
+
+// Appends compact JSON text to a string without building a json tree, whose
+// every node and destructor would touch the heap. Output matches
+// nlohmann::json::dump() byte for byte for the same values, numbers included;
+// objects keep the order keys are written in, so list them sorted to match
+// the std::map order dump() prints.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::pmr::string& out) : out(out) {}
+    
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const char* name);
+    
+    JsonWriter& value(const char* text);
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(double number);  // Floats print as json's doubles; non-finite as null
+    JsonWriter& value(uint64_t number);
+    JsonWriter& value(uint32_t number) { return value(static_cast<uint64_t>(number)); }
+    
+    // Already serialized JSON as the next value
+    JsonWriter& raw(std::string_view json);
+    
+    template <typename T>
+    JsonWriter& field(const char* name, T v) { return key(name).value(v); }
+
+private:
+    std::pmr::string& out;
+    bool first = true;  // Next value opens its container or follows a key: no comma
+    
+    void separate();
+    void escaped(std::string_view text);
+};
+
+} // namespace pw
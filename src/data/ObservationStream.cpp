@@ -0,0 +1,88 @@
+#include "ObservationStream.h"
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace pw {
+
+ObservationStream::~ObservationStream() {
+    close();
+}
+
+bool ObservationStream::open(const std::string& path, size_t ringCapacity) {
+    close();
+    if (ringCapacity == 0 || ringCapacity > UINT32_MAX) {
+        std::cerr << "Warning: Observation stream capacity must be 1 to " << UINT32_MAX << std::endl;
+        return false;
+    }
+
+#ifndef _WIN32
+    ::unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not create observation stream " << path << std::endl;
+        return false;
+    }
+    
+    const size_t size = sizeof(ObservationStreamHeader) + ringCapacity * sizeof(ObservationRecord);
+    void* mapped = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Warning: Could not map observation stream " << path << std::endl;
+        ::unlink(path.c_str());
+        return false;
+    }
+    
+    mapping = mapped;
+    mappingSize = size;
+    capacity = ringCapacity;
+    writeIndex = 0;
+    
+    // New files read as zeros, so until the header is complete the magic does not match
+    header = new (mapping) ObservationStreamHeader();
+    header->magic = 0;
+    header->recordSize = sizeof(ObservationRecord);
+    header->capacity = static_cast<uint32_t>(capacity);
+    header->perceptionDim = InferenceScheduler::PERCEPTION_DIM;
+    records = reinterpret_cast<ObservationRecord*>(static_cast<uint8_t*>(mapping) + sizeof(ObservationStreamHeader));
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = OBSERVATION_STREAM_MAGIC;
+    return true;
+#else
+    (void)path;
+    std::cerr << "Warning: Observation streams are not supported on this platform" << std::endl;
+    return false;
+#endif
+}
+
+void ObservationStream::close() {
+#ifndef _WIN32
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    records = nullptr;
+    capacity = 0;
+}
+
+void ObservationStream::publish(const ObservationRecord& record) {
+    if (!header) return;
+    
+    std::memcpy(&records[writeIndex % capacity], &record, sizeof(ObservationRecord));
+    writeIndex++;
+    header->writeIndex.store(writeIndex, std::memory_order_release);
+}
+
+} // namespace pw
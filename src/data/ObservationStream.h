@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ai/neural/InferenceScheduler.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pw {
+
+// Online training stream: a ring of fixed-size ObservationRecords in a shared
+// file mapping (put it under /dev/shm to keep it off disk) that a trainer maps
+// as numpy arrays while the simulation runs. Host byte order, no padding
+// between fields. Mirrored by tools/observation_stream.py - bump
+// OBSERVATION_SCHEMA_VERSION and update both when the layout changes.
+//
+// The writer fills slot n % capacity and then stores writeIndex = n + 1 with
+// release ordering. A reader copies the records it has not seen, then re-reads
+// writeIndex: a record n is intact only if n + capacity > writeIndex, since
+// slot n % capacity is reused by record n + capacity. The simulation never
+// waits for readers; slow ones lose the oldest records.
+constexpr uint32_t OBSERVATION_STREAM_MAGIC = 0x534F5750;  // "PWOS"
+constexpr uint32_t OBSERVATION_SCHEMA_VERSION = 1;
+
+struct ObservationStreamHeader {
+    uint32_t magic = OBSERVATION_STREAM_MAGIC;
+    uint32_t schemaVersion = OBSERVATION_SCHEMA_VERSION;
+    uint32_t recordSize = 0;
+    uint32_t capacity = 0;       // Records in the ring
+    uint32_t perceptionDim = 0;
+    uint32_t reserved[11] = {};
+    std::atomic<uint64_t> writeIndex{0};  // Records published so far, on its own cache line
+    uint8_t padding[56] = {};
+};
+
+// One neural decision: the model input it came from, the action sampled and
+// the reward (NeuralBrain::computeReward) its outcome earned. The episodic
+// memory input is left out; at 1600 floats it would be 90% of the record.
+struct ObservationRecord {
+    uint64_t tick = 0;
+    uint32_t npcId = 0;
+    uint32_t actionIndex = 0;   // ActionType
+    float reward = 0.0f;
+    uint32_t modelVersion = 0;  // SharedModel::getVersion() that chose the action; 0 = fallback heuristics
+    float perception[InferenceScheduler::PERCEPTION_DIM] = {};
+    float actionProbs[InferenceScheduler::ACTION_DIM] = {};  // Distribution the action was sampled from
+    uint32_t reserved = 0;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "observation stream index must be lock-free");
+static_assert(offsetof(ObservationStreamHeader, writeIndex) == 64, "observation stream header layout changed");
+static_assert(sizeof(ObservationStreamHeader) == 128, "observation stream header layout changed");
+static_assert(offsetof(ObservationRecord, perception) == 24, "observation record layout changed");
+static_assert(offsetof(ObservationRecord, actionProbs) == 104, "observation record layout changed");
+static_assert(sizeof(ObservationRecord) == 144, "observation record layout changed");
+
+// Single-writer end of the ring. Records are copied straight into the mapping.
+class ObservationStream {
+public:
+    ObservationStream() = default;
+    ~ObservationStream();
+    
+    ObservationStream(const ObservationStream&) = delete;
+    ObservationStream& operator=(const ObservationStream&) = delete;
+    
+    // Create the ring at path with room for capacity records. An existing file
+    // is unlinked first, so readers still mapping it are not cut off.
+    bool open(const std::string& path, size_t capacity);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+    
+    void publish(const ObservationRecord& record);
+    uint64_t published() const { return writeIndex; }
+
+private:
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    ObservationStreamHeader* header = nullptr;
+    ObservationRecord* records = nullptr;
+    size_t capacity = 0;
+    uint64_t writeIndex = 0;
+};
+
+} // namespace pw
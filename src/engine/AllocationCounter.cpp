@@ -0,0 +1,41 @@
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace pw {
+
+namespace {
+std::atomic<uint64_t> allocationCount{0};
+}
+
+uint64_t AllocationCounter::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+} // namespace pw
+
+#if PW_COUNT_ALLOCATIONS
+
+// Only the two base forms are replaced: the standard library's array and
+// nothrow forms call these, and its operator delete frees what they return
+void* operator new(std::size_t size) {
+    pw::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    pw::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    const std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+#ifdef _WIN32
+    if (void* pointer = _aligned_malloc(rounded, align)) return pointer;
+#else
+    if (void* pointer = std::aligned_alloc(align, rounded)) return pointer;
+#endif
+    throw std::bad_alloc();
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts general-heap allocations, to check that steady-state ticks make
+// none. Build with PW_COUNT_ALLOCATIONS=1 (CMake: -DPW_ENABLE_ALLOCATION_COUNTER=ON)
+// and the global operator new is replaced by one that counts every call from
+// any thread; otherwise nothing is replaced and the count stays 0.
+#ifndef PW_COUNT_ALLOCATIONS
+#define PW_COUNT_ALLOCATIONS 0
+#endif
+
+namespace pw {
+
+namespace AllocationCounter {
+
+constexpr bool enabled() { return PW_COUNT_ALLOCATIONS != 0; }
+
+// operator new calls since the process started
+uint64_t allocations();
+
+} // namespace AllocationCounter
+
+} // namespace pw
@@ -0,0 +1,55 @@
+#include "DecisionScheduler.h"
+#include "entities/NPC.h"
+#include "world/World.h"
+
+namespace pw {
+
+bool DecisionScheduler::shouldDecide(Tick tick, NPCStore& npcs, size_t index,
+                                     const World& world) const {
+    if (!settings.enabled) return true;
+    
+    Tick interval = static_cast<Tick>(npcs.decisionInterval(index));
+    if (hasViewAnchor && npcs.position(index).distance(viewAnchor) > settings.farDistance) {
+        interval *= static_cast<Tick>(settings.farScale);
+    }
+    
+    const uint8_t current = triggers(npcs, index, world);
+    if (interval <= 1 || (tick + npcs.id(index)) % interval == 0 ||
+        current != npcs.triggersAtDecision(index)) {
+        npcs.setTriggersAtDecision(index, current);
+        return true;
+    }
+    return false;
+}
+
+uint8_t DecisionScheduler::triggers(const NPCStore& npcs, size_t index, const World& world) const {
+    const Needs needs = npcs.needs(index);
+    const float threshold = settings.urgentNeed;
+    return static_cast<uint8_t>((actionDone(npcs, index, world) ? ACTION_DONE : 0) |
+                                (needs.hunger >= threshold ? 1 : 0) |
+                                (needs.energy >= threshold ? 2 : 0) |
+                                (needs.social >= threshold ? 4 : 0) |
+                                (needs.curiosity >= threshold ? 8 : 0) |
+                                (needs.safety >= threshold ? 16 : 0));
+}
+
+bool DecisionScheduler::actionDone(const NPCStore& npcs, size_t index, const World& world) const {
+    const Action& action = npcs.currentAction(index);
+    const Vec2 position = npcs.position(index);
+    switch (action.type) {
+        case ActionType::Move:
+        case ActionType::Explore:
+        case ActionType::SeekShelter:
+            return position.x == action.targetPosition.x && position.y == action.targetPosition.y;
+        
+        case ActionType::Eat: {
+            Tile tile = world.getTile(static_cast<int>(position.x), static_cast<int>(position.y));
+            return !tile.hasFood || tile.foodAmount <= 0;
+        }
+        
+        default:
+            return false;
+    }
+}
+
+} // namespace pw
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Types.h"
+#include "Math.h"
+#include <cstdint>
+
+namespace pw {
+
+class NPCStore;
+class World;
+struct Needs;
+
+// AI level of detail: which NPCs pick a new action this tick. With it off
+// every NPC decides every tick. With it on an NPC decides every
+// IBrain::decisionInterval() ticks (scaled up far from the view anchor),
+// staggered by id so the same share of NPCs decides each tick, and keeps
+// its last action in between. It decides early when, since its last
+// decision, its action became finished (target reached, food gone) or a need
+// crossed urgentNeed either way. Both are edges, so an NPC whose brain keeps
+// choosing a finished action isn't re-run every tick.
+//
+// Everything shouldDecide() reads is simulation state (the crossing
+// bookkeeping lives in NPCStore and snapshots), so a seeded run makes the
+// same decisions for any thread count and after a resume.
+class DecisionScheduler {
+public:
+    struct Settings {
+        bool enabled = false;
+        float farDistance = 96.0f;  // Tiles from the view anchor
+        int farScale = 4;           // Interval multiplier beyond farDistance
+        float urgentNeed = 0.8f;    // Need level whose crossing triggers a decision
+    };
+    
+    void setSettings(const Settings& newSettings) { settings = newSettings; }
+    const Settings& getSettings() const { return settings; }
+    
+    // Set the view anchor (e.g. the camera) for distance scaling; headless runs have none
+    void setViewAnchor(Vec2 position) { viewAnchor = position; hasViewAnchor = true; }
+    
+    // Records the NPC's triggers when it returns true. Safe to call for
+    // different NPCs from several threads.
+    bool shouldDecide(Tick tick, NPCStore& npcs, size_t index, const World& world) const;
+
+private:
+    static constexpr uint8_t ACTION_DONE = 1 << 5;
+    
+    // One bit per need at or above urgentNeed, plus ACTION_DONE
+    uint8_t triggers(const NPCStore& npcs, size_t index, const World& world) const;
+    bool actionDone(const NPCStore& npcs, size_t index, const World& world) const;
+    
+    Settings settings;
+    Vec2 viewAnchor;
+    bool hasViewAnchor = false;
+};
+
+} // namespace pw
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace pw {
+
+// Fixed-capacity vector with inline storage. push_back() on a full vector is
+// rejected (returns false) instead of allocating.
+template <typename T, size_t N>
+class FixedVector {
+public:
+    static constexpr size_t capacity() { return N; }
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == N; }
+    void clear() { count = 0; }
+    
+    bool push_back(const T& value) {
+        if (count >= N) return false;
+        items[count++] = value;
+        return true;
+    }
+    
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+    
+    T& front() { return items[0]; }
+    const T& front() const { return items[0]; }
+    
+    T* data() { return items.data(); }
+    const T* data() const { return items.data(); }
+    
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + count; }
+    const T* begin() const { return items.data(); }
+    const T* end() const { return items.data() + count; }
+
+private:
+    std::array<T, N> items{};
+    size_t count = 0;
+};
+
+} // namespace pw
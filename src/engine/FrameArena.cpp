@@ -0,0 +1,55 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace pw {
+
+void FrameArena::reset() {
+    // A tick that spilled into more blocks gets them as one from now on
+    if (blocks.size() > 1) {
+        const size_t total = bytesReserved();
+        blocks.clear();
+        addBlock(total);
+    }
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+size_t FrameArena::bytesReserved() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
+
+size_t FrameArena::bytesUsed() const {
+    return used;
+}
+
+void FrameArena::addBlock(size_t size) {
+    Block block;
+    block.size = size;
+    block.data.reset(new std::byte[size]);
+    blocks.push_back(std::move(block));
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    // Fill blocks in order, skipping one too small for this request; a new block always fits it
+    for (;; current++, offset = 0) {
+        if (current == blocks.size()) {
+            addBlock(std::max(BLOCK_SIZE, bytes + alignment));
+        }
+        
+        std::byte* data = blocks[current].data.get();
+        const uintptr_t base = reinterpret_cast<uintptr_t>(data);
+        const uintptr_t aligned = (base + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        const size_t start = static_cast<size_t>(aligned - base);
+        if (start + bytes <= blocks[current].size) {
+            offset = start + bytes;
+            used += bytes;
+            return data + start;
+        }
+    }
+}
+
+} // namespace pw
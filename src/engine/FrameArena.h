@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace pw {
+
+// Bump allocator for data that lives no longer than a tick, such as the log
+// records the NPC update formats. deallocate() does nothing; reset() releases
+// everything at once and keeps the memory, merged into one block once a tick
+// has outgrown the first, so a steady tick allocates nothing from the heap.
+//
+// Not thread-safe: Simulation keeps one per JobSystem worker and resets them
+// at the end of each update().
+class FrameArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    
+    // Object in the arena that is never destroyed: for types whose memory all
+    // comes from this arena, e.g. std::pmr containers given it
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    
+    void reset();
+    
+    size_t bytesReserved() const;  // Heap memory held
+    size_t bytesUsed() const;      // Handed out since the last reset()
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+    
+    std::vector<Block> blocks;
+    size_t current = 0;  // Block being filled
+    size_t offset = 0;   // Bytes used in it
+    size_t used = 0;
+    
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    
+    void addBlock(size_t size);
+};
+
+} // namespace pw
@@ -1,83 +1,29 @@
 #include "GameEngine.h"
-#include "ai/behavior/BehaviorTreeBrain.h"
-#include "ai/neural/NeuralBrain.h"
-#include "ai/social/SocialIntelligence.h"
 #include <SDL2/SDL.h>
 #include <iostream>
-#include <sstream>
-#include <sys/stat.h>
-#include <sys/types.h>
 
 namespace pw {
 
-GameEngine::GameEngine() : rng(std::random_device{}()) {}
+GameEngine::GameEngine() : effectsRng(std::random_device{}()) {}
 
 GameEngine::~GameEngine() = default;
 
-void GameEngine::init() {
-    // Create world
-    world = std::make_unique<World>(42);
-    
-    // Spawn NPCs
-    std::uniform_real_distribution<float> xDist(10.0f, WORLD_WIDTH - 10.0f);
-    std::uniform_real_distribution<float> yDist(10.0f, WORLD_HEIGHT - 10.0f);
-    
-    int neuralCount = 0;
-    int behaviorTreeCount = 0;
-    
-    for (int i = 0; i < 15; i++) {
-        Vec2 pos(xDist(rng), yDist(rng));
-        
-        // Find walkable position
-        for (int attempt = 0; attempt < 20; attempt++) {
-            if (world->isWalkable(static_cast<int>(pos.x), static_cast<int>(pos.y))) {
-                break;
-            }
-            pos = Vec2(xDist(rng), yDist(rng));
-        }
-        
-        npcs.emplace_back(i, pos);
-        
-        // Alternate between neural and behavior tree brains (50/50 split)
-        // Note: Neural brain model path is relative to executable working directory
-        // Default: "models/npc_brain.onnx"
-        // TODO: Make model path configurable via command line or config file
-        if (i % 2 == 0) {
-            // Neural brain
-            auto neuralBrain = std::make_unique<NeuralBrain>(i, "models/npc_brain.onnx");
-            npcs.back().setBrain(std::move(neuralBrain));
-            neuralCount++;
-        } else {
-            // Behavior tree brain (default)
-            behaviorTreeCount++;
-        }
-    }
-    
-    // Initialize data logger
-    dataLogger = std::make_unique<DataLogger>();
-    
-    std::cout << "Game initialized with " << npcs.size() << " NPCs:" << std::endl;
-    std::cout << "  - " << neuralCount << " Neural Brains" << std::endl;
-    std::cout << "  - " << behaviorTreeCount << " Behavior Tree Brains" << std::endl;
-    
-    // Load any previously saved NPC states
-    loadNPCStates();
-}
-
 void GameEngine::run() {
-    init();
+    simulation.init();
+    const World& world = simulation.getWorld();
     
     // Create window and rendering systems
     window = std::make_unique<Window>("Pixel World Simulator", 1280, 720);
     window->setVirtualResolution(VIRTUAL_WIDTH, VIRTUAL_HEIGHT);
     
     renderer = std::make_unique<Renderer>(window->getRenderer());
+    tileMap = std::make_unique<TileMapRenderer>(*renderer);
     camera = std::make_unique<Camera>(VIRTUAL_WIDTH, VIRTUAL_HEIGHT);
     debugOverlay = std::make_unique<DebugOverlay>(*renderer);
     input = std::make_unique<InputManager>();
     
     // Center camera on world
-    camera->setPosition(Vec2(WORLD_WIDTH / 2.0f, WORLD_HEIGHT / 2.0f));
+    camera->setPosition(Vec2(world.getWidth() / 2.0f, world.getHeight() / 2.0f));
     camera->setZoom(2.0f);
     
     Uint64 lastTime = SDL_GetPerformanceCounter();
@@ -106,36 +52,19 @@ void GameEngine::run() {
         
         // Fixed timestep update
         accumulator += dt;
+        const Vec2 cameraPosition = camera->getPosition();
+        simulation.setViewAnchor(Vec2(cameraPosition.x / TILE_SIZE, cameraPosition.y / TILE_SIZE));
         while (accumulator >= FIXED_TIMESTEP) {
-            update(FIXED_TIMESTEP);
+            simulation.step(FIXED_TIMESTEP);
             accumulator -= FIXED_TIMESTEP;
-            currentTick++;
         }
         
         // Render
-        render();
+        render();  // Its zones count toward the next step()'s frame
     }
     
-    dataLogger->flush();
-    saveNPCStates();
-    std::cout << "Simulation ended at tick " << currentTick << std::endl;
-}
-
-void GameEngine::runHeadless(int ticks) {
-    init();
-    
-    for (int i = 0; i < ticks; i++) {
-        update(FIXED_TIMESTEP);
-        currentTick++;
-        
-        if (i % 1000 == 0) {
-            std::cout << "Tick: " << currentTick << std::endl;
-        }
-    }
-    
-    dataLogger->flush();
-    saveNPCStates();
-    std::cout << "Headless simulation completed: " << currentTick << " ticks" << std::endl;
+    simulation.finish();
+    std::cout << "Simulation ended at tick " << simulation.getTick() << std::endl;
 }
 
 void GameEngine::handleInput() {
@@ -164,83 +93,12 @@ void GameEngine::handleInput() {
     }
     
     // Cycle through NPCs for debug
+    const auto& npcs = simulation.getNPCs();
     if (input->isActionJustPressed(InputAction::CycleNPC) && !npcs.empty()) {
         selectedNPCIndex = (selectedNPCIndex + 1) % npcs.size();
     }
 }
 
-void GameEngine::update(float dt) {
-    // Update world
-    world->update(dt);
-    
-    // Update NPCs
-    for (auto& npc : npcs) {
-        // Gather perception
-        Perception perception = npc.gatherPerception(*world, npcs);
-        
-        // Store old needs for delta calculation
-        Needs oldNeeds = npc.getNeeds();
-        
-        // Get decision from brain
-        Action action = npc.getBrain()->decide(perception, *world);
-        
-        // Update NPC
-        npc.update(dt, *world, currentTick);
-        
-        // Calculate outcome
-        Outcome outcome;
-        Needs newNeeds = npc.getNeeds();
-        outcome.needsDeltas["hunger"] = newNeeds.hunger - oldNeeds.hunger;
-        outcome.needsDeltas["energy"] = newNeeds.energy - oldNeeds.energy;
-        outcome.needsDeltas["social"] = newNeeds.social - oldNeeds.social;
-        outcome.needsDeltas["curiosity"] = newNeeds.curiosity - oldNeeds.curiosity;
-        outcome.needsDeltas["safety"] = newNeeds.safety - oldNeeds.safety;
-        outcome.event = action.toString();
-        
-        // Log decision
-        dataLogger->logDecision(currentTick, npc.getId(), perception, action, outcome);
-        
-        // Notify brain of outcome
-        npc.getBrain()->onOutcome(outcome);
-    }
-    
-    // Log events (NPCs meeting, etc.)
-    for (size_t i = 0; i < npcs.size(); i++) {
-        for (size_t j = i + 1; j < npcs.size(); j++) {
-            float dist = npcs[i].getPosition().distance(npcs[j].getPosition());
-            if (dist < 2.0f) {
-                json eventData = {
-                    {"npc1", npcs[i].getId()},
-                    {"npc2", npcs[j].getId()},
-                    {"distance", dist}
-                };
-                dataLogger->logEvent(currentTick, "npc_met", eventData);
-                
-                // Record social interactions for neural NPCs
-                static constexpr float DEFAULT_MEETING_VALENCE = 0.1f;
-                if (auto* nb1 = dynamic_cast<NeuralBrain*>(npcs[i].getBrain())) {
-                    nb1->getSocialIntelligence().recordInteraction(
-                        npcs[j].getId(), "neutral", DEFAULT_MEETING_VALENCE, currentTick);
-                }
-                if (auto* nb2 = dynamic_cast<NeuralBrain*>(npcs[j].getBrain())) {
-                    nb2->getSocialIntelligence().recordInteraction(
-                        npcs[i].getId(), "neutral", DEFAULT_MEETING_VALENCE, currentTick);
-                }
-            }
-        }
-    }
-    
-    // Periodic social relationship decay
-    static constexpr Tick SOCIAL_DECAY_INTERVAL = 100;
-    if (currentTick % SOCIAL_DECAY_INTERVAL == 0) {
-        for (auto& npc : npcs) {
-            if (auto* nb = dynamic_cast<NeuralBrain*>(npc.getBrain())) {
-                nb->getSocialIntelligence().decayRelationships(currentTick);
-            }
-        }
-    }
-}
-
 void GameEngine::render() {
     window->applyVirtualScale();
     window->clear(Color(0, 0, 0));
@@ -253,111 +111,90 @@ void GameEngine::render() {
         renderDebugOverlay();
     }
     
-    window->present();
+    {
+        PW_PROFILE_ZONE("render/present");
+        renderer->flush();  // Queued sprites and overlay bars
+        window->present();
+    }
 }
 
 void GameEngine::renderWorld() {
-    Vec2 camPos = camera->getPosition();
-    float zoom = camera->getZoom();
-    
-    int startX = std::max(0, static_cast<int>(camPos.x - VIRTUAL_WIDTH / (2.0f * zoom * TILE_SIZE)));
-    int endX = std::min(WORLD_WIDTH, static_cast<int>(camPos.x + VIRTUAL_WIDTH / (2.0f * zoom * TILE_SIZE)) + 1);
-    int startY = std::max(0, static_cast<int>(camPos.y - VIRTUAL_HEIGHT / (2.0f * zoom * TILE_SIZE)));
-    int endY = std::min(WORLD_HEIGHT, static_cast<int>(camPos.y + VIRTUAL_HEIGHT / (2.0f * zoom * TILE_SIZE)) + 1);
-    
-    Color tint = world->getDayNightTint();
-    
-    for (int y = startY; y < endY; y++) {
-        for (int x = startX; x < endX; x++) {
-            const Tile& tile = world->getTile(x, y);
-            Color color = tile.getColor().withTint(tint, 0.3f);
-            
-            Vec2 screenPos = camera->worldToScreen(Vec2(x * TILE_SIZE, y * TILE_SIZE));
-            int size = static_cast<int>(TILE_SIZE * zoom);
-            
-            Rect rect(
-                static_cast<int>(screenPos.x),
-                static_cast<int>(screenPos.y),
-                size,
-                size
-            );
-            
-            renderer->drawRect(rect, color, true);
-        }
-    }
+    PW_PROFILE_ZONE("render/world");
+    tileMap->render(simulation.getWorld(), *camera);
 }
 
 void GameEngine::renderNPCs() {
-    Color tint = world->getDayNightTint();
+    PW_PROFILE_ZONE("render/npcs");
+    Color tint = simulation.getWorld().getDayNightTint();
     
-    for (const auto& npc : npcs) {
-        Vec2 worldPos = npc.getPosition();
+    const NPCStore& npcs = simulation.getNPCs();
+    for (size_t i = 0; i < npcs.size(); i++) {
+        Vec2 worldPos = npcs.position(i);
         Vec2 screenPos = camera->worldToScreen(Vec2(worldPos.x * TILE_SIZE, worldPos.y * TILE_SIZE));
         
-        int radius = static_cast<int>(4 * camera->getZoom());
-        Color color = npc.getColor().withTint(tint, 0.2f);
+        float radius = 4 * camera->getZoom();
+        Color color = npcs.color(i).withTint(tint, 0.2f);
         
-        renderer->drawCircle(
-            static_cast<int>(screenPos.x),
-            static_cast<int>(screenPos.y),
-            radius,
-            color,
-            true
-        );
+        renderer->queueCircle(screenPos.x, screenPos.y, radius, color);
     }
 }
 
 void GameEngine::renderWeather() {
-    if (world->getWeather() == Weather::Rain || world->getWeather() == Weather::Storm) {
+    PW_PROFILE_ZONE("render/weather");
+    const Weather weather = simulation.getWorld().getWeather();
+    if (weather == Weather::Rain || weather == Weather::Storm) {
         // Simple rain effect - draw falling lines
         std::uniform_real_distribution<float> xDist(0, VIRTUAL_WIDTH);
         std::uniform_real_distribution<float> yDist(0, VIRTUAL_HEIGHT);
         
         Color rainColor(150, 150, 200, 100);
-        int rainDrops = (world->getWeather() == Weather::Storm) ? 100 : 50;
+        int rainDrops = (weather == Weather::Storm) ? 100 : 50;
         
         for (int i = 0; i < rainDrops; i++) {
-            int x = static_cast<int>(xDist(rng));
-            int y = static_cast<int>(yDist(rng));
-            renderer->drawLine(x, y, x + 2, y + 5, rainColor);
+            int x = static_cast<int>(xDist(effectsRng));
+            int y = static_cast<int>(yDist(effectsRng));
+            renderer->queueLine(x, y, x + 2, y + 5, rainColor);
         }
     }
 }
 
 void GameEngine::renderDebugOverlay() {
+    PW_PROFILE_ZONE("render/debug");
+    const auto& npcs = simulation.getNPCs();
     // Draw simple debug info at top-left
     Color textBg(0, 0, 0, 180);
     
     // Background for text
-    renderer->drawRect(Rect(0, 0, 200, 80), textBg, true);
+    renderer->queueRect(Rect(0, 0, 200, 80), textBg);
     
     // Would normally draw text here, but we don't have a font system
     // Instead, draw colored bars representing aggregate NPC needs
     
     float avgHunger = 0, avgEnergy = 0, avgSocial = 0;
-    for (const auto& npc : npcs) {
-        avgHunger += npc.getNeeds().hunger;
-        avgEnergy += npc.getNeeds().energy;
-        avgSocial += npc.getNeeds().social;
+    for (size_t i = 0; i < npcs.size(); i++) {
+        const Needs needs = npcs.needs(i);
+        avgHunger += needs.hunger;
+        avgEnergy += needs.energy;
+        avgSocial += needs.social;
     }
     avgHunger /= npcs.size();
     avgEnergy /= npcs.size();
     avgSocial /= npcs.size();
     
     // Hunger bar (red)
-    renderer->drawRect(Rect(10, 10, static_cast<int>(avgHunger * 100), 5), Color(255, 0, 0), true);
+    renderer->queueRect(Rect(10, 10, static_cast<int>(avgHunger * 100), 5), Color(255, 0, 0));
     // Energy bar (yellow)
-    renderer->drawRect(Rect(10, 20, static_cast<int>(avgEnergy * 100), 5), Color(255, 255, 0), true);
+    renderer->queueRect(Rect(10, 20, static_cast<int>(avgEnergy * 100), 5), Color(255, 255, 0));
     // Social bar (blue)
-    renderer->drawRect(Rect(10, 30, static_cast<int>(avgSocial * 100), 5), Color(0, 150, 255), true);
+    renderer->queueRect(Rect(10, 30, static_cast<int>(avgSocial * 100), 5), Color(0, 150, 255));
     
     // Time of day indicator
-    int todX = static_cast<int>(world->getTimeOfDay() * 180) + 10;
-    renderer->drawRect(Rect(todX, 45, 5, 10), Color(255, 255, 0), true);
+    int todX = static_cast<int>(simulation.getWorld().getTimeOfDay() * 180) + 10;
+    renderer->queueRect(Rect(todX, 45, 5, 10), Color(255, 255, 0));
     
     // Render detailed NPC debug panel for selected NPC
     if (!npcs.empty() && selectedNPCIndex < static_cast<int>(npcs.size())) {
-        const NPC& selectedNPC = npcs[selectedNPCIndex];
+        const NPC selectedNPC = npcs[selectedNPCIndex];
         
         // Highlight selected NPC
         Vec2 screenPos = camera->worldToScreen(selectedNPC.getPosition());
@@ -369,31 +206,10 @@ void GameEngine::renderDebugOverlay() {
             debugOverlay->renderNPCDebug(selectedNPC, VIRTUAL_WIDTH - 410, 10);
         }
     }
-}
-
-void GameEngine::saveNPCStates() {
-    for (auto& npc : npcs) {
-        if (auto* neuralBrain = dynamic_cast<NeuralBrain*>(npc.getBrain())) {
-            std::string filepath = "npc_states/npc_" + std::to_string(npc.getId()) + "_state.json";
-            
-            // Create directory
-            #ifdef _WIN32
-                _mkdir("npc_states");
-            #else
-                mkdir("npc_states", 0755);
-            #endif
-            
-            neuralBrain->saveState(filepath);
-        }
-    }
-}
-
-void GameEngine::loadNPCStates() {
-    for (auto& npc : npcs) {
-        if (auto* neuralBrain = dynamic_cast<NeuralBrain*>(npc.getBrain())) {
-            std::string filepath = "npc_states/npc_" + std::to_string(npc.getId()) + "_state.json";
-            neuralBrain->loadState(filepath);
-        }
+    
+    // Rolling subsystem timings, bottom-left
+    if (debugOverlay && Profiler::instance().enabled()) {
+        debugOverlay->renderProfile(Profiler::instance().stats(), 10, VIRTUAL_HEIGHT - 100, 60);
     }
 }
 
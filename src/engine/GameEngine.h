@@ -1,31 +1,31 @@
 #pragma once
 
 #include "Types.h"
-#include "world/World.h"
-#include "entities/NPC.h"
-#include "data/DataLogger.h"
+#include "Simulation.h"
 #include "platform/Window.h"
 #include "rendering/Renderer.h"
+#include "rendering/TileMapRenderer.h"
 #include "rendering/Camera.h"
 #include "rendering/DebugOverlay.h"
 #include "input/InputManager.h"
-#include <vector>
 #include <memory>
 #include <random>
 
 namespace pw {
 
+// Visual client: runs a Simulation at a fixed timestep and draws it with SDL
 class GameEngine {
 public:
     GameEngine();
     ~GameEngine();
     
+    // Configure before run() / runHeadless()
+    Simulation& getSimulation() { return simulation; }
+    
     void run();
-    void runHeadless(int ticks);
+    void runHeadless(int ticks) { simulation.runHeadless(ticks); }
 
 private:
-    void init();
-    void update(float dt);
     void render();
     void handleInput();
     
@@ -34,27 +34,21 @@ private:
     void renderWeather();
     void renderDebugOverlay();
     
-    // NPC state persistence
-    void saveNPCStates();
-    void loadNPCStates();
+    Simulation simulation;
     
     std::unique_ptr<Window> window;
     std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<TileMapRenderer> tileMap;  // Per-chunk textures; released before the window
     std::unique_ptr<Camera> camera;
     std::unique_ptr<DebugOverlay> debugOverlay;
     std::unique_ptr<InputManager> input;
     
-    std::unique_ptr<World> world;
-    std::vector<NPC> npcs;
-    std::unique_ptr<DataLogger> dataLogger;
-    
-    Tick currentTick = 0;
     float accumulator = 0.0f;
     bool showDebug = false;
     int selectedNPCIndex = 0;
     bool running = true;
     
-    std::mt19937 rng;
+    std::mt19937 effectsRng;  // Rain; kept apart from the simulation's RNGs
 };
 
 } // namespace pw
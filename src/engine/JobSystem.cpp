@@ -0,0 +1,138 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace pw {
+
+JobSystem::JobSystem(int requestedThreads) {
+    threadCount = requestedThreads < 1 ? hardwareThreads() : requestedThreads;
+    
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    
+    // Worker 0 is the thread that calls parallelFor
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int JobSystem::hardwareThreads() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+size_t JobSystem::grainFor(size_t count, size_t minGrain) const {
+    size_t target = count / (static_cast<size_t>(threadCount) * 4);
+    return std::max(minGrain, target);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const RangeFn& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+    
+    if (workers.empty() || count <= grain) {
+        fn(0, count, 0);
+        return;
+    }
+    
+    size_t chunkCount = (count + grain - 1) / grain;
+    
+    // Publish the job before any chunk becomes visible to a worker
+    currentFn = &fn;
+    remainingChunks.store(chunkCount);
+    
+    for (size_t c = 0; c < chunkCount; c++) {
+        Chunk chunk;
+        chunk.begin = c * grain;
+        chunk.end = std::min(count, chunk.begin + grain);
+        
+        WorkerQueue& queue = *queues[c % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back(chunk);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        jobGeneration++;
+    }
+    wakeCondition.notify_all();
+    
+    runChunks(0);
+    
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [this] { return remainingChunks.load() == 0; });
+    currentFn = nullptr;
+}
+
+void JobSystem::workerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCondition.wait(lock, [&] { return stopping || jobGeneration != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = jobGeneration;
+        }
+        
+        runChunks(worker);
+    }
+}
+
+void JobSystem::runChunks(int worker) {
+    Chunk chunk;
+    while (popOrSteal(worker, chunk)) {
+        (*currentFn)(chunk.begin, chunk.end, worker);
+        
+        if (remainingChunks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            doneCondition.notify_all();
+        }
+    }
+}
+
+bool JobSystem::popOrSteal(int worker, Chunk& chunk) {
+    // Own queue first (front), then steal from the back of the others
+    {
+        WorkerQueue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.head < own.chunks.size()) {
+            chunk = own.chunks[own.head++];
+            if (own.head == own.chunks.size()) {
+                own.chunks.clear();
+                own.head = 0;
+            }
+            return true;
+        }
+    }
+    
+    for (int offset = 1; offset < threadCount; offset++) {
+        WorkerQueue& victim = *queues[(worker + offset) % threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.head < victim.chunks.size()) {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            if (victim.head == victim.chunks.size()) {
+                victim.chunks.clear();
+                victim.head = 0;
+            }
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+} // namespace pw
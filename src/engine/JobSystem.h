@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pw {
+
+// Fixed-size work-stealing thread pool. parallelFor() splits a range into
+// chunks that are dealt round-robin to per-worker queues; idle workers steal
+// from the back of other queues. The calling thread takes part as worker 0.
+class JobSystem {
+public:
+    // Range callback: process [begin, end) on the given worker (0..threadCount-1).
+    // Refers to the caller's callable instead of copying it, so handing a
+    // lambda to parallelFor() never allocates.
+    class RangeFn {
+    public:
+        template <typename Fn>
+        RangeFn(const Fn& fn)
+            : target(&fn)
+            , invoke([](const void* f, size_t begin, size_t end, int worker) {
+                  (*static_cast<const Fn*>(f))(begin, end, worker);
+              }) {}
+        
+        void operator()(size_t begin, size_t end, int worker) const { invoke(target, begin, end, worker); }
+    
+    private:
+        const void* target;
+        void (*invoke)(const void*, size_t, size_t, int);
+    };
+    
+    // threadCount includes the calling thread; values < 1 use all hardware threads
+    explicit JobSystem(int threadCount = 1);
+    ~JobSystem();
+    
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    
+    int getThreadCount() const { return threadCount; }
+    
+    // Run fn over [0, count) in chunks of at most grain items and wait for all of them.
+    // Not re-entrant: fn must not call parallelFor on the same JobSystem.
+    void parallelFor(size_t count, size_t grain, const RangeFn& fn);
+    
+    // Chunk size that gives each worker a few chunks to balance load
+    size_t grainFor(size_t count, size_t minGrain = 16) const;
+    
+    static int hardwareThreads();
+
+private:
+    struct Chunk {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    
+    // Owner pops from the front (head), thieves from the back; emptied
+    // queues keep their capacity, so dealing chunks does not allocate
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Chunk> chunks;
+        size_t head = 0;
+    };
+    
+    int threadCount = 1;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    
+    const RangeFn* currentFn = nullptr;
+    std::atomic<size_t> remainingChunks{0};
+    
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    uint64_t jobGeneration = 0;
+    bool stopping = false;
+    
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    
+    void workerLoop(int worker);
+    void runChunks(int worker);
+    bool popOrSteal(int worker, Chunk& chunk);
+};
+
+} // namespace pw
@@ -0,0 +1,99 @@
+#include "MultiWorldRunner.h"
+#include "Simulation.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+namespace pw {
+
+MultiWorldRunner::MultiWorldRunner(int worlds, int concurrent)
+    : worlds(std::max(0, worlds)), concurrent(concurrent) {}
+
+std::string MultiWorldRunner::shardName(int world) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "world_%03d", world);
+    return name;
+}
+
+bool MultiWorldRunner::run(int ticks, const Configure& configure) {
+    const int cores = JobSystem::hardwareThreads();
+    const int parallel = std::max(1, std::min(worlds, concurrent < 1 ? cores : concurrent));
+    const int threadsPerWorld = std::max(1, cores / parallel);
+    std::cout << "Running " << worlds << " worlds for " << ticks << " ticks, " << parallel
+              << " at a time with " << threadsPerWorld << " update threads each" << std::endl;
+    
+    std::mutex outputMutex;
+    std::atomic<bool> allRan{true};
+    std::atomic<uint64_t> npcTicks{0};
+    const auto start = std::chrono::steady_clock::now();
+    
+    // One world per chunk, so idle workers steal whole worlds
+    JobSystem pool(parallel);
+    pool.parallelFor(static_cast<size_t>(worlds), 1, [&](size_t begin, size_t end, int) {
+        for (size_t k = begin; k < end; k++) {
+            const int world = static_cast<int>(k);
+            const auto worldStart = std::chrono::steady_clock::now();
+            
+            Simulation simulation;
+            if (!configure(simulation, world)) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Warning: Could not configure world " << world << ", skipping it" << std::endl;
+                allRan = false;
+                continue;
+            }
+            simulation.setSeed(simulation.getSeed() + static_cast<uint32_t>(world));
+            simulation.setWorldSeed(simulation.getWorldSeed() + static_cast<uint32_t>(world));
+            
+            const std::string shard = simulation.getLogDirectory() + "/" + shardName(world);
+            std::error_code error;
+            std::filesystem::create_directories(shard, error);
+            if (error) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Warning: Could not create log shard " << shard << ": " << error.message()
+                          << ", skipping world " << world << std::endl;
+                allRan = false;
+                continue;
+            }
+            simulation.setLogDirectory(shard);
+            
+            // Page files are named by chunk only, so worlds must not share a directory
+            if (!simulation.getChunkPageDirectory().empty()) {
+                simulation.setChunkPageDirectory(simulation.getChunkPageDirectory() + "/" + shardName(world));
+            }
+            simulation.setThreadCount(threadsPerWorld);
+            simulation.setPersistBrainStates(false);
+            simulation.setLoadSnapshot("");
+            simulation.setSaveSnapshot("");
+            simulation.setProfilePath("");
+            simulation.setObservationStream("");
+            simulation.setVerbose(false);
+            
+            simulation.init();
+            for (int i = 0; i < ticks; i++) {
+                simulation.step(FIXED_TIMESTEP);
+            }
+            simulation.finish();
+            
+            const size_t npcs = simulation.getNPCs().size();
+            npcTicks += static_cast<uint64_t>(npcs) * static_cast<uint64_t>(ticks);
+            const double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - worldStart).count();
+            
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "World " << world << " (seed " << simulation.getSeed() << "): " << npcs
+                      << " NPCs, " << ticks << " ticks in " << seconds << " s -> " << shard << std::endl;
+        }
+    });
+    
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << worlds << " worlds in " << seconds << " s, "
+              << static_cast<uint64_t>(npcTicks.load() / std::max(seconds, 1e-9)) << " NPC ticks/s" << std::endl;
+    return allRan;
+}
+
+} // namespace pw
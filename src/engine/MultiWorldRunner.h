@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace pw {
+
+class Simulation;
+
+// Runs many independent headless simulations in one process, for generating
+// training data. World k gets seed + k and world seed + k, and logs to its
+// own shard, <log directory>/world_<k>; evicted chunks are paged to
+// <page directory>/world_<k> likewise. Up to `concurrent` worlds run at once
+// on a JobSystem, and each world's NPC update gets an even share of the
+// remaining cores. Models come from the process-wide ModelRegistry, so each
+// file is loaded once for every world.
+//
+// Worlds are built one at a time as earlier ones finish, so memory depends on
+// `concurrent`, not on the world count. Brain state persistence, snapshots,
+// profiling and the observation stream are process-wide files, so they are
+// off inside worlds.
+class MultiWorldRunner {
+public:
+    // Called for each world before the runner applies its shard settings;
+    // returning false skips the world
+    using Configure = std::function<bool(Simulation& simulation, int world)>;
+    
+    // concurrent < 1 runs one world per hardware thread
+    MultiWorldRunner(int worlds, int concurrent = 0);
+    
+    // Runs every world for ticks ticks; returns false if a world's
+    // configuration failed or its log shard could not be created
+    bool run(int ticks, const Configure& configure);
+    
+    static std::string shardName(int world);
+
+private:
+    int worlds;
+    int concurrent;
+};
+
+} // namespace pw
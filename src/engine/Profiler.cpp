@@ -0,0 +1,216 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+
+namespace pw {
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Profiler::start(const std::string& tracePath) {
+#if !PW_PROFILER
+    std::cerr << "Warning: Profiling zones were compiled out (PW_ENABLE_PROFILER=OFF)" << std::endl;
+    (void)tracePath;
+    return false;
+#else
+    if (!tracePath.empty()) {
+        trace.open(tracePath, std::ios::trunc);
+        if (!trace) {
+            std::cerr << "Warning: Could not write profile trace " << tracePath << std::endl;
+            return false;
+        }
+        trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        firstTraceEvent = true;
+    }
+    threadRing();  // The main thread is track 0
+    originNs = now();
+    active.store(true, std::memory_order_relaxed);
+    return true;
+#endif
+}
+
+void Profiler::stop() {
+    if (!enabled()) return;
+    endFrame();
+    active.store(false, std::memory_order_relaxed);
+    
+    if (trace.is_open()) {
+        // Name the tracks after the threads that recorded
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const auto& ring : rings) {
+            trace << (firstTraceEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                  << ring->threadId << ",\"args\":{\"name\":\""
+                  << (ring->threadId == 0 ? "main" : "thread " + std::to_string(ring->threadId)) << "\"}}";
+            firstTraceEvent = false;
+        }
+        trace << "\n]}\n";
+        trace.close();
+    }
+}
+
+Profiler::ThreadRing& Profiler::threadRing() {
+    thread_local ThreadRing* ring = nullptr;
+    if (!ring) {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(std::make_unique<ThreadRing>());
+        ring = rings.back().get();
+        ring->events.reset(new Event[ringCapacity]);
+        ring->capacity = ringCapacity;
+        ring->threadId = static_cast<int>(rings.size()) - 1;
+    }
+    return *ring;
+}
+
+void Profiler::record(const char* name, int64_t startNs, int64_t endNs) {
+    ThreadRing& ring = threadRing();
+    const size_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ring.capacity) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring.events[head % ring.capacity] = Event{name, startNs, endNs};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+size_t Profiler::zoneIndex(const char* name) {
+    // Equal literals in different translation units may not share a pointer
+    auto found = zoneByPointer.find(name);
+    if (found != zoneByPointer.end()) {
+        return found->second;
+    }
+    size_t index = 0;
+    while (index < zones.size() && zones[index].name != name) {
+        index++;
+    }
+    if (index == zones.size()) {
+        zones.emplace_back();
+        zones.back().name = name;
+    }
+    zoneByPointer.emplace(name, index);
+    return index;
+}
+
+void Profiler::writeTraceEvent(const Event& event, int threadId) {
+    char line[192];
+    std::snprintf(line, sizeof(line),
+                  "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                  firstTraceEvent ? "" : ",", event.name, threadId,
+                  (event.startNs - originNs) / 1000.0, (event.endNs - event.startNs) / 1000.0);
+    trace << line;
+    firstTraceEvent = false;
+}
+
+void Profiler::drain(ThreadRing& ring) {
+    const size_t head = ring.head.load(std::memory_order_acquire);
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    for (; tail != head; tail++) {
+        const Event& event = ring.events[tail % ring.capacity];
+        ZoneHistory& zone = zones[zoneIndex(event.name)];
+        zone.currentMs += (event.endNs - event.startNs) / 1e6;
+        zone.currentCalls++;
+        if (trace.is_open()) {
+            writeTraceEvent(event, ring.threadId);
+        }
+    }
+    ring.tail.store(tail, std::memory_order_release);
+}
+
+void Profiler::reserve(size_t events) {
+    ThreadRing& own = threadRing();
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        ringCapacity = std::max(ringCapacity, events);
+    }
+    if (own.capacity >= events) return;
+    
+    // Events already recorded count toward the current frame
+    drain(own);
+    own.events.reset(new Event[events]);
+    own.capacity = events;
+    own.head.store(0, std::memory_order_relaxed);
+    own.tail.store(0, std::memory_order_relaxed);
+}
+
+void Profiler::endFrame() {
+    if (!enabled()) return;
+    
+    std::vector<ThreadRing*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const auto& ring : rings) {
+            snapshot.push_back(ring.get());
+        }
+    }
+    
+    for (ThreadRing* ring : snapshot) {
+        drain(*ring);
+    }
+    
+    for (ZoneHistory& zone : zones) {
+        // Indexed per zone: one first recorded after frame 0 has fewer frames
+        zone.frameMs[zone.next] = static_cast<float>(zone.currentMs);
+        zone.next = (zone.next + 1) % STATS_WINDOW;
+        zone.frames = std::min(zone.frames + 1, STATS_WINDOW);
+        zone.lastCalls = zone.currentCalls;
+        zone.currentMs = 0.0;
+        zone.currentCalls = 0;
+    }
+    frame++;
+}
+
+std::vector<Profiler::ZoneStats> Profiler::stats() const {
+    std::vector<ZoneStats> result;
+    std::vector<float> sorted;
+    for (const ZoneHistory& zone : zones) {
+        if (zone.frames == 0) continue;
+        sorted.assign(zone.frameMs.begin(), zone.frameMs.begin() + zone.frames);
+        std::sort(sorted.begin(), sorted.end());
+        
+        ZoneStats stats;
+        stats.name = zone.name;
+        stats.p50Ms = sorted[(sorted.size() - 1) / 2];
+        stats.p99Ms = sorted[(sorted.size() - 1) * 99 / 100];
+        stats.calls = zone.lastCalls;
+        result.push_back(stats);
+    }
+    std::sort(result.begin(), result.end(), [](const ZoneStats& a, const ZoneStats& b) {
+        return a.p99Ms > b.p99Ms;
+    });
+    return result;
+}
+
+void Profiler::printStats(std::ostream& out) const {
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << "Profile (ms per frame over the last " << std::min<uint64_t>(frame, STATS_WINDOW) << " frames):" << std::endl;
+    out << "  " << std::left << std::setw(28) << "zone" << std::right
+        << std::setw(9) << "p50" << std::setw(9) << "p99" << std::setw(8) << "calls" << std::endl;
+    for (const ZoneStats& zone : stats()) {
+        out << "  " << std::left << std::setw(28) << zone.name << std::right << std::fixed
+            << std::setprecision(3) << std::setw(9) << zone.p50Ms << std::setw(9) << zone.p99Ms
+            << std::setw(8) << zone.calls << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+uint64_t Profiler::droppedEvents() const {
+    uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (const auto& ring : rings) {
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+} // namespace pw
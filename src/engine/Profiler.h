@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Scoped timing zones. Build with PW_PROFILER=0 (CMake: -DPW_ENABLE_PROFILER=OFF)
+// and PW_PROFILE_ZONE expands to nothing; otherwise a zone costs one relaxed
+// load while the profiler is stopped.
+#ifndef PW_PROFILER
+#define PW_PROFILER 1
+#endif
+
+namespace pw {
+
+// Collects zone timings from any thread into per-thread single-producer rings.
+// endFrame(), called from a serial phase, drains them into the trace file (Chrome
+// trace / Perfetto JSON) and into rolling per-zone frame totals for stats().
+// Events recorded while a ring is full are dropped and counted; reserve() sizes
+// the rings for the events a frame is expected to produce.
+class Profiler {
+public:
+    struct ZoneStats {
+        std::string name;
+        double p50Ms = 0.0;  // Over the last STATS_WINDOW frames, per-frame totals
+        double p99Ms = 0.0;
+        uint32_t calls = 0;  // In the last frame
+    };
+    
+    static constexpr size_t MIN_RING_CAPACITY = 1 << 14;  // Events per thread between drains
+    static constexpr size_t STATS_WINDOW = 240;
+    
+    static Profiler& instance();
+    
+    // Starts recording; tracePath "" keeps statistics only. Call from the main
+    // thread. Returns false if the trace can't be written or zones were compiled out.
+    bool start(const std::string& tracePath);
+    void stop();  // Drains and closes the trace
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+    
+    void record(const char* name, int64_t startNs, int64_t endNs);
+    void endFrame();
+    
+    // Size the calling thread's ring, and those of threads that have not
+    // recorded yet, to hold at least events between drains. Call from the
+    // thread that calls endFrame(), before worker threads record.
+    void reserve(size_t events);
+    
+    std::vector<ZoneStats> stats() const;  // Slowest p99 first
+    void printStats(std::ostream& out) const;
+    uint64_t droppedEvents() const;
+    
+    static int64_t now();
+
+private:
+    struct Event {
+        const char* name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+    
+    // Written by its thread, drained by endFrame()
+    struct ThreadRing {
+        std::unique_ptr<Event[]> events;
+        size_t capacity = 0;
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        int threadId = 0;
+    };
+    
+    struct ZoneHistory {
+        std::string name;
+        std::array<float, STATS_WINDOW> frameMs{};  // Ring of the zone's own frames
+        size_t next = 0;    // Slot the next frame goes in
+        size_t frames = 0;  // Slots filled
+        double currentMs = 0.0;
+        uint32_t currentCalls = 0;
+        uint32_t lastCalls = 0;
+    };
+    
+    Profiler() = default;
+    ThreadRing& threadRing();
+    void drain(ThreadRing& ring);
+    size_t zoneIndex(const char* name);
+    void writeTraceEvent(const Event& event, int threadId);
+    
+    std::atomic<bool> active{false};
+    int64_t originNs = 0;
+    
+    mutable std::mutex ringsMutex;  // Guards registration; rings live as long as the program
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    size_t ringCapacity = MIN_RING_CAPACITY;  // For rings registered from now on; guarded by ringsMutex
+    
+    // Touched only by the serial phase
+    std::ofstream trace;
+    bool firstTraceEvent = true;
+    std::unordered_map<const char*, size_t> zoneByPointer;
+    std::vector<ZoneHistory> zones;
+    uint64_t frame = 0;
+};
+
+// Times its own lifetime; usually created through PW_PROFILE_ZONE
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name)
+        : name(Profiler::instance().enabled() ? name : nullptr),
+          startNs(this->name ? Profiler::now() : 0) {}
+    
+    ~ProfileZone() {
+        if (name) Profiler::instance().record(name, startNs, Profiler::now());
+    }
+    
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    int64_t startNs;
+};
+
+} // namespace pw
+
+#if PW_PROFILER
+#define PW_PROFILE_JOIN_(a, b) a##b
+#define PW_PROFILE_JOIN(a, b) PW_PROFILE_JOIN_(a, b)
+// name must be a string literal (it is kept by pointer)
+#define PW_PROFILE_ZONE(name) ::pw::ProfileZone PW_PROFILE_JOIN(profileZone_, __LINE__)(name)
+#else
+#define PW_PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace pw {
+
+// Counter-based random stream (SplitMix64). Output n is a hash of key + n, so
+// a stream is two integers: it costs nothing to create, saves and restores
+// exactly, and never touches another stream's state. Give each consumer its
+// own key from streamKey(seed, entity, purpose) and parallel updates draw the
+// same numbers for any thread count.
+//
+// Satisfies UniformRandomBitGenerator, but the members below are preferred
+// over <random> distributions, whose output differs between standard libraries.
+class CounterRng {
+public:
+    using result_type = uint32_t;
+    
+    // Mixing purposes, so one entity's streams differ
+    enum Purpose : uint64_t { Brain = 1, Social, Spawn, Weather, Appearance, Logging };
+    
+    explicit CounterRng(uint64_t key = 0, uint64_t counter = 0) : key(key), counter(counter) {}
+    
+    static uint64_t streamKey(uint64_t seed, uint64_t entity, uint64_t purpose) {
+        return mix(mix(mix(seed) ^ entity) ^ (purpose * GAMMA));
+    }
+    
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+    
+    uint64_t next64() { return mix(key + ++counter * GAMMA); }
+    result_type operator()() { return static_cast<result_type>(next64() >> 32); }
+    
+    // Uniform in [0, 1) and [lo, hi)
+    float uniform() { return static_cast<float>(operator()() >> 8) * (1.0f / 16777216.0f); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    
+    // Uniform integer in [0, n) by multiply-shift; the bias is below n / 2^32
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(operator()()) * n) >> 32);
+    }
+    
+    // Normal deviate (Box-Muller, one of the pair)
+    float normal(float mean, float stddev) {
+        const float u = 1.0f - uniform();  // (0, 1], so the log is finite
+        const float v = uniform();
+        return mean + stddev * std::sqrt(-2.0f * std::log(u)) * std::cos(6.2831853f * v);
+    }
+    
+    uint64_t getKey() const { return key; }
+    uint64_t getCounter() const { return counter; }
+
+private:
+    static constexpr uint64_t GAMMA = 0x9e3779b97f4a7c15ull;
+    
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    
+    uint64_t key;
+    uint64_t counter;
+};
+
+// Index i with probability weights[i] / sum of weights, without the heap
+// allocation std::discrete_distribution makes. Negative weights count as zero;
+// if every weight is zero, index 0 is returned.
+template <typename Weights>
+size_t sampleCategorical(const Weights& weights, CounterRng& rng) {
+    float total = 0.0f;
+    for (float weight : weights) {
+        if (weight > 0.0f) total += weight;
+    }
+    if (!(total > 0.0f)) return 0;
+    
+    float remaining = rng.uniform() * total;
+    size_t last = 0;
+    for (size_t i = 0; i < static_cast<size_t>(weights.size()); i++) {
+        if (!(weights[i] > 0.0f)) continue;
+        last = i;
+        remaining -= weights[i];
+        if (remaining < 0.0f) return i;
+    }
+    return last;  // Rounding left a sliver past the end
+}
+
+} // namespace pw
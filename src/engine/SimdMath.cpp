@@ -0,0 +1,483 @@
+#include "SimdMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PW_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PW_SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PW_SIMD_NEON 1
+#endif
+
+namespace pw {
+namespace simd {
+
+namespace {
+
+#if PW_SIMD_AVX2
+float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+#elif PW_SIMD_SSE2
+float horizontalSum(__m128 v) {
+    __m128 sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+float vectorMax(const float* values, size_t n) {
+    float result = values[0];
+    size_t i = 0;
+#if PW_SIMD_AVX2
+    if (n >= 8) {
+        __m256 best = _mm256_loadu_ps(values);
+        for (i = 8; i + 8 <= n; i += 8) {
+            best = _mm256_max_ps(best, _mm256_loadu_ps(values + i));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, best);
+        result = *std::max_element(lanes, lanes + 8);
+    }
+#elif PW_SIMD_SSE2
+    if (n >= 4) {
+        __m128 best = _mm_loadu_ps(values);
+        for (i = 4; i + 4 <= n; i += 4) {
+            best = _mm_max_ps(best, _mm_loadu_ps(values + i));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, best);
+        result = *std::max_element(lanes, lanes + 4);
+    }
+#elif PW_SIMD_NEON
+    if (n >= 4) {
+        float32x4_t best = vld1q_f32(values);
+        for (i = 4; i + 4 <= n; i += 4) {
+            best = vmaxq_f32(best, vld1q_f32(values + i));
+        }
+        result = vmaxvq_f32(best);
+    }
+#endif
+    for (; i < n; i++) {
+        result = std::max(result, values[i]);
+    }
+    return result;
+}
+
+void scale(float* values, size_t n, float factor) {
+    size_t i = 0;
+#if PW_SIMD_AVX2
+    const __m256 f = _mm256_set1_ps(factor);
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(values + i, _mm256_mul_ps(_mm256_loadu_ps(values + i), f));
+    }
+#elif PW_SIMD_SSE2
+    const __m128 f = _mm_set1_ps(factor);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(values + i, _mm_mul_ps(_mm_loadu_ps(values + i), f));
+    }
+#elif PW_SIMD_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(values + i, vmulq_n_f32(vld1q_f32(values + i), factor));
+    }
+#endif
+    for (; i < n; i++) {
+        values[i] *= factor;
+    }
+}
+
+// One register of floats and the operations the tiled kernel needs, so it
+// is written once for every backend
+#if PW_SIMD_AVX2
+using Lanes = __m256;
+constexpr size_t WIDTH = 8;
+inline Lanes zeroLanes() { return _mm256_setzero_ps(); }
+inline Lanes loadLanes(const float* p) { return _mm256_loadu_ps(p); }
+inline Lanes multiplyAdd(Lanes a, Lanes b, Lanes sum) { return _mm256_fmadd_ps(a, b, sum); }
+inline float sumLanes(Lanes v) { return horizontalSum(v); }
+#elif PW_SIMD_SSE2
+using Lanes = __m128;
+constexpr size_t WIDTH = 4;
+inline Lanes zeroLanes() { return _mm_setzero_ps(); }
+inline Lanes loadLanes(const float* p) { return _mm_loadu_ps(p); }
+inline Lanes multiplyAdd(Lanes a, Lanes b, Lanes sum) { return _mm_add_ps(sum, _mm_mul_ps(a, b)); }
+inline float sumLanes(Lanes v) { return horizontalSum(v); }
+#elif PW_SIMD_NEON
+using Lanes = float32x4_t;
+constexpr size_t WIDTH = 4;
+inline Lanes zeroLanes() { return vdupq_n_f32(0.0f); }
+inline Lanes loadLanes(const float* p) { return vld1q_f32(p); }
+inline Lanes multiplyAdd(Lanes a, Lanes b, Lanes sum) { return vfmaq_f32(sum, a, b); }
+inline float sumLanes(Lanes v) { return vaddvq_f32(v); }
+#else
+using Lanes = float;
+constexpr size_t WIDTH = 1;
+inline Lanes zeroLanes() { return 0.0f; }
+inline Lanes loadLanes(const float* p) { return *p; }
+inline Lanes multiplyAdd(Lanes a, Lanes b, Lanes sum) { return sum + a * b; }
+inline float sumLanes(Lanes v) { return v; }
+#endif
+
+struct FloatOps {
+    using A = float;
+    using B = float;
+    using Result = float;
+    using Row = Lanes;
+    using Column = Lanes;
+    using Sums = Lanes;
+    static constexpr size_t width = WIDTH;
+    static Sums zero() { return zeroLanes(); }
+    static Row loadRow(const float* p) { return loadLanes(p); }
+    static Column loadColumn(const float* p) { return loadLanes(p); }
+    static Sums multiplyAdd(Row a, Column b, Sums sum) { return simd::multiplyAdd(a, b, sum); }
+    static Result total(Sums v) { return sumLanes(v); }
+};
+
+// int16 activations against int8 weights: the weights are sign-extended as
+// they are loaded and pairs of products are summed into int32 lanes
+#if PW_SIMD_AVX2
+struct Int8Ops {
+    using A = int16_t;
+    using B = int8_t;
+    using Result = int32_t;
+    using Row = __m256i;
+    using Column = __m256i;
+    using Sums = __m256i;
+    static constexpr size_t width = 16;
+    static Sums zero() { return _mm256_setzero_si256(); }
+    static Row loadRow(const int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static Column loadColumn(const int8_t* p) {
+        return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    static Sums multiplyAdd(Row a, Column b, Sums sum) { return _mm256_add_epi32(sum, _mm256_madd_epi16(a, b)); }
+    static Result total(Sums v) {
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+    }
+};
+#elif PW_SIMD_SSE2
+struct Int8Ops {
+    using A = int16_t;
+    using B = int8_t;
+    using Result = int32_t;
+    using Row = __m128i;
+    using Column = __m128i;
+    using Sums = __m128i;
+    static constexpr size_t width = 8;
+    static Sums zero() { return _mm_setzero_si128(); }
+    static Row loadRow(const int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static Column loadColumn(const int8_t* p) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+    }
+    static Sums multiplyAdd(Row a, Column b, Sums sum) { return _mm_add_epi32(sum, _mm_madd_epi16(a, b)); }
+    static Result total(Sums v) {
+        __m128i sum = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+    }
+};
+#elif PW_SIMD_NEON
+struct Int8Ops {
+    using A = int16_t;
+    using B = int8_t;
+    using Result = int32_t;
+    using Row = int16x8_t;
+    using Column = int16x8_t;
+    using Sums = int32x4_t;
+    static constexpr size_t width = 8;
+    static Sums zero() { return vdupq_n_s32(0); }
+    static Row loadRow(const int16_t* p) { return vld1q_s16(p); }
+    static Column loadColumn(const int8_t* p) { return vmovl_s8(vld1_s8(p)); }
+    static Sums multiplyAdd(Row a, Column b, Sums sum) {
+        return vmlal_high_s16(vmlal_s16(sum, vget_low_s16(a), vget_low_s16(b)), a, b);
+    }
+    static Result total(Sums v) { return vaddvq_s32(v); }
+};
+#else
+struct Int8Ops {
+    using A = int16_t;
+    using B = int8_t;
+    using Result = int32_t;
+    using Row = int32_t;
+    using Column = int32_t;
+    using Sums = int32_t;
+    static constexpr size_t width = 1;
+    static Sums zero() { return 0; }
+    static Row loadRow(const int16_t* p) { return *p; }
+    static Column loadColumn(const int8_t* p) { return *p; }
+    static Sums multiplyAdd(Row a, Column b, Sums sum) { return sum + a * b; }
+    static Result total(Sums v) { return v; }
+};
+#endif
+
+// R x C block of A * B^T. Every A and B register load feeds C and R
+// multiply-adds; the R * C accumulators stay in registers.
+template <typename Ops, size_t R, size_t C>
+void multiplyTile(const typename Ops::A* a, size_t lda, const typename Ops::B* b, size_t ldb, size_t n,
+                  typename Ops::Result* out, size_t ldo) {
+    typename Ops::Sums sums[R][C];
+    for (size_t r = 0; r < R; r++) {
+        for (size_t c = 0; c < C; c++) sums[r][c] = Ops::zero();
+    }
+    
+    size_t k = 0;
+    for (; k + Ops::width <= n; k += Ops::width) {
+        typename Ops::Column columns[C];
+        for (size_t c = 0; c < C; c++) columns[c] = Ops::loadColumn(b + c * ldb + k);
+        for (size_t r = 0; r < R; r++) {
+            const typename Ops::Row row = Ops::loadRow(a + r * lda + k);
+            for (size_t c = 0; c < C; c++) sums[r][c] = Ops::multiplyAdd(row, columns[c], sums[r][c]);
+        }
+    }
+    
+    for (size_t r = 0; r < R; r++) {
+        for (size_t c = 0; c < C; c++) {
+            typename Ops::Result result = Ops::total(sums[r][c]);
+            for (size_t t = k; t < n; t++) {
+                result += a[r * lda + t] * b[c * ldb + t];
+            }
+            out[r * ldo + c] = result;
+        }
+    }
+}
+
+// Rows of one A block against columns [first, last) of B
+template <typename Ops, size_t R>
+void multiplyRows(const typename Ops::A* a, size_t lda, const typename Ops::B* b, size_t ldb, size_t n,
+                  size_t first, size_t last, typename Ops::Result* out, size_t ldo) {
+    size_t c = first;
+    for (; c + 2 <= last; c += 2) {
+        multiplyTile<Ops, R, 2>(a, lda, b + c * ldb, ldb, n, out + c, ldo);
+    }
+    if (c < last) {
+        multiplyTile<Ops, R, 1>(a, lda, b + c * ldb, ldb, n, out + c, ldo);
+    }
+}
+
+// A block of rows (up to 32 KB of fp32 at n = 128) sits in L2 while each B
+// panel (up to 16 KB) is reused from L1 for every row in it
+template <typename Ops>
+void multiplyBlocked(const typename Ops::A* a, size_t rows, size_t lda,
+                     const typename Ops::B* b, size_t cols, size_t ldb,
+                     size_t n, typename Ops::Result* out, size_t ldo) {
+    constexpr size_t ROW_BLOCK = 64;
+    constexpr size_t PANEL_BYTES = 16384;
+    const size_t panel = std::max<size_t>(2, PANEL_BYTES / (sizeof(typename Ops::B) * std::max<size_t>(n, 1)));
+    
+    for (size_t r0 = 0; r0 < rows; r0 += ROW_BLOCK) {
+        const size_t r1 = std::min(rows, r0 + ROW_BLOCK);
+        for (size_t c0 = 0; c0 < cols; c0 += panel) {
+            const size_t c1 = std::min(cols, c0 + panel);
+            size_t r = r0;
+            for (; r + 4 <= r1; r += 4) {
+                multiplyRows<Ops, 4>(a + r * lda, lda, b, ldb, n, c0, c1, out + r * ldo, ldo);
+            }
+            for (; r < r1; r++) {
+                multiplyRows<Ops, 1>(a + r * lda, lda, b, ldb, n, c0, c1, out + r * ldo, ldo);
+            }
+        }
+    }
+}
+
+} // namespace
+
+const char* backendName() {
+#if PW_SIMD_AVX2
+    return "avx2";
+#elif PW_SIMD_SSE2
+    return "sse2";
+#elif PW_SIMD_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+float dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float result = 0.0f;
+#if PW_SIMD_AVX2
+    __m256 sum = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        sum = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum);
+    }
+    result = horizontalSum(sum);
+#elif PW_SIMD_SSE2
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    result = horizontalSum(sum);
+#elif PW_SIMD_NEON
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        sum = vfmaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    result = vaddvq_f32(sum);
+#endif
+    for (; i < n; i++) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+void dotBatch(const float* rows, size_t rowCount, size_t stride,
+              const float* query, size_t n, float* out) {
+    for (size_t r = 0; r < rowCount; r++) {
+        out[r] = dot(rows + r * stride, query, n);
+    }
+}
+
+float cosine(const float* a, const float* b, size_t n) {
+    float normA = std::sqrt(dot(a, a, n));
+    float normB = std::sqrt(dot(b, b, n));
+    if (normA < 1e-6f || normB < 1e-6f) return 0.0f;
+    return dot(a, b, n) / (normA * normB);
+}
+
+void normalize(float* row, size_t n) {
+    float norm = std::sqrt(dot(row, row, n));
+    if (norm < 1e-6f) {
+        std::fill(row, row + n, 0.0f);
+        return;
+    }
+    scale(row, n, 1.0f / norm);
+}
+
+void gram(const float* rows, size_t count, size_t stride, size_t n, float* out) {
+    // Symmetric: compute the upper triangle and mirror it
+    for (size_t i = 0; i < count; i++) {
+        const float* rowI = rows + i * stride;
+        out[i * count + i] = dot(rowI, rowI, n);
+        for (size_t j = i + 1; j < count; j++) {
+            float value = dot(rowI, rows + j * stride, n);
+            out[i * count + j] = value;
+            out[j * count + i] = value;
+        }
+    }
+}
+
+void multiplyTransposed(const float* a, size_t rows, size_t lda,
+                        const float* b, size_t cols, size_t ldb,
+                        size_t n, float* out, size_t ldo) {
+    multiplyBlocked<FloatOps>(a, rows, lda, b, cols, ldb, n, out, ldo);
+}
+
+void multiplyTransposed(const int16_t* a, size_t rows, size_t lda,
+                        const int8_t* b, size_t cols, size_t ldb,
+                        size_t n, int32_t* out, size_t ldo) {
+    multiplyBlocked<Int8Ops>(a, rows, lda, b, cols, ldb, n, out, ldo);
+}
+
+void halvesToFloats(const uint16_t* halves, size_t n, float* out) {
+    size_t i = 0;
+#if PW_SIMD_AVX2 && defined(__F16C__)
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(halves + i))));
+    }
+#elif PW_SIMD_AVX2 || PW_SIMD_SSE2
+    // Shifting the exponent and mantissa into float position and scaling by
+    // 2^112 rebiases normals and normalizes subnormals exactly; exponent 31
+    // (Inf/NaN) then needs the float exponent forced to 255
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i magnitudeMask = _mm_set1_epi32(0x7FFF);
+    const __m128i signMask = _mm_set1_epi32(0x8000);
+    const __m128i largestFinite = _mm_set1_epi32(0x0F7FFFFF);
+    const __m128i infinity = _mm_set1_epi32(0x7F800000);
+    const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32(0x77800000));  // 2^112
+    for (; i + 4 <= n; i += 4) {
+        const __m128i bits = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(halves + i)), zero);
+        const __m128i magnitude = _mm_slli_epi32(_mm_and_si128(bits, magnitudeMask), 13);
+        const __m128i special = _mm_and_si128(_mm_cmpgt_epi32(magnitude, largestFinite), infinity);
+        const __m128i sign = _mm_slli_epi32(_mm_and_si128(bits, signMask), 16);
+        const __m128 value = _mm_mul_ps(_mm_castsi128_ps(magnitude), rebias);
+        _mm_storeu_ps(out + i, _mm_or_ps(value, _mm_castsi128_ps(_mm_or_si128(special, sign))));
+    }
+#elif PW_SIMD_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(halves + i))));
+    }
+#endif
+    for (; i < n; i++) {
+        const uint32_t sign = static_cast<uint32_t>(halves[i] & 0x8000u) << 16;
+        const uint32_t magnitude = static_cast<uint32_t>(halves[i] & 0x7FFFu) << 13;
+        float value;
+        std::memcpy(&value, &magnitude, sizeof(value));
+        value *= 0x1p112f;
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits |= sign | (magnitude > 0x0F7FFFFFu ? 0x7F800000u : 0u);
+        std::memcpy(&out[i], &bits, sizeof(bits));
+    }
+}
+
+float quantize(const float* values, size_t n, int16_t* out) {
+    float largest = 0.0f;
+    size_t i = 0;
+#if PW_SIMD_AVX2
+    const __m256 magnitudeMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 best = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) best = _mm256_max_ps(best, _mm256_and_ps(_mm256_loadu_ps(values + i), magnitudeMask));
+    largest = vectorMax(reinterpret_cast<const float*>(&best), 8);
+#elif PW_SIMD_SSE2
+    const __m128 magnitudeMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 best = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) best = _mm_max_ps(best, _mm_and_ps(_mm_loadu_ps(values + i), magnitudeMask));
+    largest = vectorMax(reinterpret_cast<const float*>(&best), 4);
+#elif PW_SIMD_NEON
+    float32x4_t best = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) best = vmaxq_f32(best, vabsq_f32(vld1q_f32(values + i)));
+    largest = vmaxvq_f32(best);
+#endif
+    for (; i < n; i++) largest = std::max(largest, std::fabs(values[i]));
+    
+    const float scale = largest > 0.0f ? largest / 127.0f : 1.0f;
+    const float inverse = 1.0f / scale;
+    i = 0;
+    // Conversions round to nearest even, as std::lrint does by default
+#if PW_SIMD_AVX2 || PW_SIMD_SSE2
+    const __m128 factor = _mm_set1_ps(inverse);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i low = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(values + i), factor));
+        const __m128i high = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(values + i + 4), factor));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+    }
+#elif PW_SIMD_NEON
+    for (; i + 8 <= n; i += 8) {
+        const int32x4_t low = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(values + i), inverse));
+        const int32x4_t high = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(values + i + 4), inverse));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for (; i < n; i++) out[i] = static_cast<int16_t>(std::lrint(values[i] * inverse));
+    return scale;
+}
+
+void softmax(float* values, size_t n) {
+    if (n == 0) return;
+    
+    // exp() stays scalar; max and normalization are vectorized
+    const float maxValue = vectorMax(values, n);
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        values[i] = std::exp(values[i] - maxValue);
+        sum += values[i];
+    }
+    if (sum > 0.0f) {
+        scale(values, n, 1.0f / sum);
+    }
+}
+
+} // namespace simd
+} // namespace pw
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace pw {
+
+// Small vectorized kernels for embedding math. The instruction set is picked
+// at compile time: AVX2 (+FMA) when the compiler targets it (configure with
+// -DPW_ENABLE_AVX2=ON), otherwise SSE2 on x86-64, NEON on ARM64, or scalar.
+// All loads are unaligned-safe; aligned rows just make them cheaper.
+namespace simd {
+
+constexpr size_t ALIGNMENT = 32;  // One AVX register
+constexpr size_t LANES = 8;       // Floats per row padding step
+
+// Rounds a row length up to a whole number of vector registers
+constexpr size_t paddedSize(size_t n) { return (n + LANES - 1) / LANES * LANES; }
+
+// Name of the compiled-in backend ("avx2", "sse2", "neon" or "scalar")
+const char* backendName();
+
+float dot(const float* a, const float* b, size_t n);
+
+// out[r] = dot(rows + r * stride, query, n) for r < rowCount
+void dotBatch(const float* rows, size_t rowCount, size_t stride,
+              const float* query, size_t n, float* out);
+
+// 0 if either vector is (near) zero
+float cosine(const float* a, const float* b, size_t n);
+
+// Scales a row to unit length (or zeroes it if its norm is below 1e-6)
+void normalize(float* row, size_t n);
+
+// out[i * count + j] = dot(row i, row j): one pass of A * A^T
+void gram(const float* rows, size_t count, size_t stride, size_t n, float* out);
+
+// In-place numerically stable softmax
+void softmax(float* values, size_t n);
+
+// out[r * ldo + c] = dot(a + r * lda, b + c * ldb, n) for r < rows, c < cols:
+// A * B^T, i.e. a dense layer with B in PyTorch's [outputs, inputs] layout.
+// Cache-blocked over panels of B rows, with a register-tiled kernel; each
+// element is summed in the same order as dot(), whatever its tile.
+void multiplyTransposed(const float* a, size_t rows, size_t lda,
+                        const float* b, size_t cols, size_t ldb,
+                        size_t n, float* out, size_t ldo);
+
+// Integer A * B^T with the same blocking: int16 activations against int8
+// weights, summed exactly in int32 (no overflow while |a| <= 127 and
+// n <= 2^17). The caller applies the row and column scales.
+void multiplyTransposed(const int16_t* a, size_t rows, size_t lda,
+                        const int8_t* b, size_t cols, size_t ldb,
+                        size_t n, int32_t* out, size_t ldo);
+
+// Symmetric int8-range quantization: out[i] = round(values[i] / scale), with
+// the scale (returned) mapping the largest magnitude to 127, or 1 for a zero row
+float quantize(const float* values, size_t n, int16_t* out);
+
+// IEEE half bit patterns to floats, exactly (subnormals and Inf included;
+// F16C may return a signalling NaN quieted)
+void halvesToFloats(const uint16_t* halves, size_t n, float* out);
+
+// Allocator for ALIGNMENT-aligned buffers
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+    
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(ALIGNMENT));
+    }
+    
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float>>;
+
+} // namespace simd
+} // namespace pw
@@ -0,0 +1,821 @@
+#include "Simulation.h"
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+#include "ai/behavior/BehaviorTreeBrain.h"
+#include "ai/neural/NeuralBrain.h"
+#include "ai/social/SocialIntelligence.h"
+#include "serialization/BrainStateFile.h"
+#include "serialization/Snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace pw {
+
+Simulation::Simulation()
+    : seed(std::random_device{}()), rng(CounterRng::streamKey(seed, 0, CounterRng::Spawn)) {}
+
+Simulation::~Simulation() = default;
+
+void Simulation::setSeed(uint32_t newSeed) {
+    seed = newSeed;
+    rng = CounterRng(CounterRng::streamKey(seed, 0, CounterRng::Spawn));
+}
+
+void Simulation::setAILevelOfDetail(bool enabled) {
+    DecisionScheduler::Settings settings = decisionScheduler.getSettings();
+    settings.enabled = enabled;
+    decisionScheduler.setSettings(settings);
+}
+
+void Simulation::setViewAnchor(Vec2 position) {
+    viewAnchor = position;
+    hasViewAnchor = true;
+    decisionScheduler.setViewAnchor(position);
+}
+
+void Simulation::init() {
+    if (!profilePath.empty()) {
+        Profiler::instance().start(profilePath);
+    }
+    
+    jobs = std::make_unique<JobSystem>(threadCount);
+    ModelRegistry::instance().configure(inferenceSettings);
+    inferencePipeline.start(inferenceLatency);
+    workerCommands.assign(jobs->getThreadCount(), WorldCommandBuffer{});
+    frameArenas.clear();
+    for (int i = 0; i < jobs->getThreadCount(); i++) {
+        frameArenas.push_back(std::make_unique<FrameArena>());
+    }
+    
+    // A snapshot decides the world's seed and size, so read its header first.
+    // Its settings replace the configured ones only if the rest reads back too.
+    SnapshotReader snapshot;
+    SnapshotHeader header;
+    bool restoring = !loadSnapshotPath.empty() && readSnapshotHeader(snapshot, header);
+    if (restoring) {
+        createWorld(header.worldSeed, header.width, header.height);
+        if (restoreSnapshot(snapshot, header.seed)) {
+            seed = header.seed;
+            rng = header.rng;
+            currentTick = header.tick;
+            worldSeed = header.worldSeed;
+            worldWidth = header.width;
+            worldHeight = header.height;
+        } else {
+            std::cerr << "Warning: Snapshot " << loadSnapshotPath
+                      << " is damaged, starting a new simulation" << std::endl;
+            restoring = false;
+            npcs.clear();
+        }
+    }
+    if (!restoring) {
+        createWorld(worldSeed, worldWidth, worldHeight);
+    }
+    world->indexResources();
+    world->indexNavigation();
+    
+    if (!restoring) {
+        spawnNPCs();
+    }
+    groupByBrain();
+    rebuildEntityIndex();
+    if (Profiler::instance().enabled()) {
+        Profiler::instance().reserve(npcs.size() * PROFILE_EVENTS_PER_NPC + PROFILE_EVENTS_PER_TICK);
+    }
+    
+    // Initialize data logger
+    dataLogger = std::make_unique<DataLogger>(logDirectory, logFormat, logQueue, logFilter);
+    if (!observationPath.empty()) {
+        observations.open(observationPath, observationCapacity);
+    }
+    
+    if (verbose) {
+        reportSetup(restoring);
+    }
+    if (!restoring && persistBrainStates) {
+        // Load any previously saved NPC states
+        loadNPCStates();
+    }
+}
+
+void Simulation::reportSetup(bool restoring) const {
+    const size_t neuralCount = brainOrder.size() - neuralBegin;
+    std::cout << "Game initialized with " << npcs.size() << " NPCs:" << std::endl;
+    std::cout << "  - " << neuralCount << " Neural Brains" << std::endl;
+    std::cout << "  - " << npcs.size() - neuralCount << " Behavior Tree Brains" << std::endl;
+    std::cout << "  - " << jobs->getThreadCount() << " update threads, seed " << seed << std::endl;
+    std::cout << "  - " << simd::backendName() << " embedding kernels" << std::endl;
+    std::cout << "  - " << world->getWidth() << "x" << world->getHeight() << " world in "
+              << world->totalChunks() << " chunks (";
+    if (terrainCacheDirectory.empty()) {
+        std::cout << "generated on demand, " << world->residentChunks() << " so far)" << std::endl;
+    } else {
+        std::cout << (terrainCached ? "loaded" : "generated") << " in " << static_cast<int>(terrainMs)
+                  << " ms)" << std::endl;
+    }
+    
+    if (observations.isOpen()) {
+        std::cout << "  - observation stream " << observationPath << " (" << observationCapacity
+                  << " records)" << std::endl;
+    }
+    if (restoring) {
+        std::cout << "  - resumed at tick " << currentTick << " from " << loadSnapshotPath << std::endl;
+    }
+}
+
+void Simulation::createWorld(uint32_t terrainSeed, int width, int height) {
+    // Chunks are generated as NPCs reach them. Only a terrain cache wants the
+    // whole map: loaded, or generated in parallel and saved for later runs.
+    world = std::make_unique<World>(terrainSeed, width, height);
+    world->setPageDirectory(chunkPageDirectory);
+    const auto terrainStart = std::chrono::steady_clock::now();
+    terrainCached = false;
+    if (!terrainCacheDirectory.empty()) {
+        const std::string cachePath = terrainCacheDirectory + "/" + world->terrainCacheName();
+        terrainCached = world->loadTerrain(cachePath);
+        if (!terrainCached) {
+            world->generateChunks(*jobs);
+            world->saveTerrain(cachePath);
+        }
+    }
+    terrainMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - terrainStart).count();
+}
+
+std::vector<uint32_t> Simulation::spawnCells() const {
+    // Walkable tiles away from the map edge and within the spawn radius of
+    // the centre, found a row per job and joined in row order
+    const int width = world->getWidth();
+    const int height = world->getHeight();
+    const int margin = static_cast<int>(std::min(10.0f, std::min(width, height) / 4.0f));
+    const int radius = std::max(SPAWN_RADIUS, static_cast<int>(std::ceil(
+        std::sqrt(static_cast<double>(SPAWN_TILES_PER_NPC) * std::max(0, npcCount)) / 2.0)));
+    const int minX = std::max(margin, width / 2 - radius);
+    const int maxX = std::min(width - margin, width / 2 + radius);
+    const int minY = std::max(margin, height / 2 - radius);
+    const int maxY = std::min(height - margin, height / 2 + radius);
+    const int rows = std::max(0, maxY - minY);
+    
+    std::vector<std::vector<uint32_t>> rowCells(rows);
+    const World& sharedWorld = *world;
+    jobs->parallelFor(rows, jobs->grainFor(rows, 4), [&](size_t begin, size_t end, int) {
+        for (size_t row = begin; row < end; row++) {
+            const int y = minY + static_cast<int>(row);
+            for (int x = minX; x < maxX; x++) {
+                if (sharedWorld.isWalkable(x, y)) {
+                    rowCells[row].push_back(static_cast<uint32_t>(y) * width + x);
+                }
+            }
+        }
+    });
+    
+    std::vector<uint32_t> cells;
+    size_t total = 0;
+    for (const auto& row : rowCells) total += row.size();
+    cells.reserve(total);
+    for (const auto& row : rowCells) {
+        cells.insert(cells.end(), row.begin(), row.end());
+    }
+    return cells;
+}
+
+void Simulation::spawnNPCs() {
+    const std::vector<uint32_t> cells = spawnCells();
+    const Vec2 center(world->getWidth() / 2.0f, world->getHeight() / 2.0f);
+    if (cells.empty() && npcCount > 0) {
+        std::cerr << "Warning: No walkable tile to spawn on, placing NPCs at the map centre" << std::endl;
+    }
+    
+    // Positions come from the simulation RNG in id order, so they depend only on the seed
+    const size_t first = npcs.size();
+    npcs.reserve(first + std::max(0, npcCount));
+    for (int i = 0; i < npcCount; i++) {
+        Vec2 pos = center;
+        if (!cells.empty()) {
+            const uint32_t cell = cells[rng.below(static_cast<uint32_t>(cells.size()))];
+            pos.x = static_cast<float>(cell % world->getWidth()) + rng.uniform();
+            pos.y = static_cast<float>(cell / world->getWidth()) + rng.uniform();
+        }
+        npcs.add(i, pos);
+    }
+    
+    // Brains are seeded by id and share models through the registry, so they
+    // can be built in parallel. Neural brains go to the ids where the running
+    // count ceil(id * neuralFraction) steps up: 0.5 gives the even ids.
+    const size_t spawned = npcs.size() - first;
+    jobs->parallelFor(spawned, jobs->grainFor(spawned), [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            NPC npc = npcs[first + i];
+            const EntityId id = npc.getId();
+            if (std::ceil((i + 1) * static_cast<double>(neuralFraction)) >
+                std::ceil(i * static_cast<double>(neuralFraction))) {
+                npc.setBrain(std::make_unique<NeuralBrain>(id, modelPath, seed, &relationships));
+            } else {
+                npc.setBrain(std::make_unique<BehaviorTreeBrain>(id, seed));
+            }
+        }
+    });
+}
+
+void Simulation::step(float dt) {
+    update(dt);
+    currentTick++;
+    Profiler::instance().endFrame();
+}
+
+void Simulation::finish() {
+    dataLogger->flush();
+    if (inferencePipeline.enabled()) {
+        inferencePipeline.drain();
+    }
+    if (verbose) {
+        reportLogQueue();
+        reportDecisions();
+        reportLogFilter();
+        reportObservations();
+        reportPipeline();
+        reportAllocations();
+    }
+    observations.close();
+    reportProfile();
+    if (persistBrainStates) {
+        saveNPCStates();
+    }
+    if (!saveSnapshotPath.empty()) {
+        saveSnapshot(saveSnapshotPath);
+    }
+}
+
+void Simulation::runHeadless(int ticks) {
+    init();
+    
+    for (int i = 0; i < ticks; i++) {
+        step(FIXED_TIMESTEP);
+        
+        if (i % 1000 == 0) {
+            std::cout << "Tick: " << currentTick << std::endl;
+        }
+    }
+    
+    finish();
+    std::cout << "Headless simulation completed: " << currentTick << " ticks" << std::endl;
+    std::cout << "World: " << world->residentChunks() << "/" << world->totalChunks()
+              << " chunks resident" << std::endl;
+}
+
+void Simulation::reportProfile() const {
+    Profiler& profiler = Profiler::instance();
+    if (!profiler.enabled()) return;
+    
+    profiler.printStats(std::cout);
+    if (uint64_t dropped = profiler.droppedEvents()) {
+        std::cerr << "Warning: Profiler dropped " << dropped
+                  << " events (thread rings full); zone times and the trace are incomplete" << std::endl;
+    }
+    profiler.stop();
+    std::cout << "Profile trace written to " << profilePath << std::endl;
+}
+
+void Simulation::reportDecisions() const {
+    if (!decisionScheduler.getSettings().enabled || npcTicks == 0) return;
+    
+    std::cout << "AI level of detail: " << decisionsMade << " decisions in " << npcTicks
+              << " NPC ticks (" << static_cast<int>(100.0 * decisionsMade / npcTicks) << "%)" << std::endl;
+}
+
+void Simulation::reportLogFilter() const {
+    if (!logFilter.filtersDecisions() && logFilter.meetingCooldown == 0) return;
+    
+    std::cout << "Log filter: kept " << decisionsLogged << "/" << decisionsOffered << " decisions, "
+              << meetingsLogged << "/" << meetingsOffered << " meetings" << std::endl;
+}
+
+void Simulation::reportObservations() const {
+    if (observationPath.empty() || observations.published() == 0) return;
+    
+    std::cout << "Observation stream: " << observations.published() << " records published to "
+              << observationPath << std::endl;
+}
+
+void Simulation::reportPipeline() const {
+    if (!inferencePipeline.enabled()) return;
+    
+    InferencePipelineStats stats = inferencePipeline.stats();
+    std::cout << "Inference pipeline: latency " << inferencePipeline.latency() << " ticks, "
+              << stats.batches << " batches in " << static_cast<int>(stats.inferenceMs)
+              << " ms on the inference thread, simulation stalled " << stats.stalls << " times ("
+              << static_cast<int>(stats.stallMs) << " ms)" << std::endl;
+}
+
+void Simulation::reportAllocations() const {
+    if (!AllocationCounter::enabled()) return;
+    
+    std::cout << "Heap allocations: " << tickAllocations << " in " << allocatingTicks << "/" << countedTicks
+              << " ticks";
+    if (allocatingTicks > 0) {
+        std::cout << " (last on tick " << lastAllocatingTick << ")";
+    }
+    size_t arenaBytes = 0;
+    for (const auto& arena : frameArenas) {
+        arenaBytes += arena->bytesReserved();
+    }
+    std::cout << ", frame arenas " << arenaBytes / 1024 << " KB" << std::endl;
+}
+
+void Simulation::reportLogQueue() const {
+    if (!dataLogger->isAsync()) return;
+    
+    LogQueueStats stats = dataLogger->queueStats();
+    std::cout << "Log queue: " << stats.written << " records written, peak depth "
+              << stats.maxDepth << "/" << stats.capacity;
+    if (stats.dropped > 0 || stats.sampledOut > 0) {
+        std::cout << ", " << stats.dropped << " dropped, " << stats.sampledOut << " sampled out";
+    }
+    std::cout << std::endl;
+}
+
+void Simulation::update(float dt) {
+    PW_PROFILE_ZONE("tick");
+    const uint64_t allocationsBefore = AllocationCounter::allocations();
+    
+    // Swap in a retrained model before this tick's decisions
+    if (modelReloadInterval > 0 && currentTick > 0 && currentTick % modelReloadInterval == 0) {
+        ModelRegistry::instance().reloadChanged();
+    }
+    
+    // Update world
+    world->update(dt);
+    
+    // Per-tick buffers, indexed by NPC so the parallel phases never share a slot
+    const size_t npcCount = npcs.size();
+    tickPerceptions.resize(npcCount);
+    tickActions.resize(npcCount);
+    tickOldNeeds.resize(npcCount);
+    tickOldActions.resize(npcCount);
+    tickAte.assign(npcCount, 0);
+    tickRecords.resize(npcCount);
+    tickLogged.resize(npcCount);
+    tickBatched.assign(npcCount, 0);
+    tickDecided.resize(npcCount);
+    for (auto& commands : workerCommands) {
+        commands.clear();
+    }
+    
+    const World& sharedWorld = *world;
+    const size_t grain = jobs->grainFor(npcCount);
+    
+    // Perceive and decide; pipelined inference acts on results from earlier ticks
+    if (inferencePipeline.enabled()) {
+        decidePipelined(sharedWorld, grain);
+    } else {
+        decide(sharedWorld, grain);
+    }
+    
+    // Act on the decisions. NPCs only change themselves; world changes are queued
+    jobs->parallelFor(npcCount, grain, [&](size_t begin, size_t end, int worker) {
+        for (size_t i = begin; i < end; i++) {
+            if (tickBatched[i]) {
+                tickActions[i] = npcs.brain(i)->applyOutput(tickPerceptions[i], inferenceScheduler);
+            }
+            
+            // Store old needs for delta calculation
+            tickOldNeeds[i] = npcs.needs(i);
+            tickOldActions[i] = npcs.currentAction(i).type;
+        }
+        npcs.update(begin, end, dt, sharedWorld, tickActions.data(), workerCommands[worker]);
+    });
+    
+    applyWorldCommands();
+    
+    // Positions are final for this tick; used for meetings now and perception next tick
+    rebuildEntityIndex();
+    
+    // Report outcomes of this tick's decisions; log records are built in
+    // parallel, in the worker's arena, and written in NPC order
+    const bool logDecisions = currentTick % decisionLogInterval == 0;
+    jobs->parallelFor(npcCount, grain, [&](size_t begin, size_t end, int worker) {
+        for (size_t k = begin; k < end; k++) {
+            const uint32_t i = brainOrder[k];
+            if (!tickDecided[i]) continue;
+            const Needs& oldNeeds = tickOldNeeds[i];
+            const Action& action = tickActions[i];
+            
+            const Outcome outcome = Outcome::of(action, oldNeeds, npcs.needs(i), tickAte[i] != 0);
+            
+            tickLogged[i] = logDecisions &&
+                dataLogger->wantsDecision(currentTick, npcs.id(i), tickOldActions[i], action, outcome);
+            if (tickLogged[i]) {
+                FrameArena& arena = *frameArenas[worker];
+                std::pmr::string* record = arena.create<std::pmr::string>(&arena);
+                dataLogger->formatDecision(currentTick, npcs.id(i), tickPerceptions[i], action,
+                                           outcome, *record);
+                tickRecords[i] = record;
+            }
+            
+            // Notify brain of outcome
+            npcs.brain(i)->onOutcome(outcome);
+        }
+    });
+    
+    for (size_t i = 0; i < npcCount; i++) {
+        if (!tickDecided[i]) continue;
+        decisionsMade++;
+        if (logDecisions) {
+            decisionsOffered++;
+        }
+        if (tickLogged[i]) {
+            decisionsLogged++;
+            dataLogger->writeDecision(*tickRecords[i]);
+        }
+        if (observations.isOpen() && npcs.brain(i)->kind() == BrainKind::Neural) {
+            publishObservation(i);
+        }
+    }
+    npcTicks += npcCount;
+    
+    // Engine events (NPCs meeting) go to the brains involved and the event log
+    collectMeetings();
+    dispatchEvents();
+    
+    // Social relationship decay: O(1) per NPC, relationships decay when next read
+    if (currentTick % SocialIntelligence::DECAY_INTERVAL == 0) {
+        for (size_t k = neuralBegin; k < brainOrder.size(); k++) {
+            npcs.brain(brainOrder[k])->social()->decayRelationships(currentTick);
+        }
+    }
+    
+    if (currentTick % CHUNK_EVICT_INTERVAL == 0) {
+        streamChunks();
+    }
+    
+    for (auto& arena : frameArenas) {
+        arena->reset();
+    }
+    
+    if (AllocationCounter::enabled()) {
+        const uint64_t made = AllocationCounter::allocations() - allocationsBefore;
+        countedTicks++;
+        if (made > 0) {
+            tickAllocations += made;
+            allocatingTicks++;
+            lastAllocatingTick = currentTick;
+        }
+    }
+}
+
+void Simulation::decide(const World& sharedWorld, size_t grain) {
+    inferenceScheduler.beginTick();
+    
+    // Perceive and decide one brain kind after another; brains that batch their
+    // inference only queue inputs here. NPCs the scheduler skips keep their action.
+    jobs->parallelFor(npcs.size(), grain, [&](size_t begin, size_t end, int) {
+        for (size_t k = begin; k < end; k++) {
+            const uint32_t i = brainOrder[k];
+            tickDecided[i] = decisionScheduler.shouldDecide(currentTick, npcs, i, sharedWorld);
+            if (!tickDecided[i]) {
+                tickActions[i] = npcs.currentAction(i);
+                continue;
+            }
+            tickPerceptions[i] = npcs[i].gatherPerception(sharedWorld, currentTick);
+            IBrain* brain = npcs.brain(i);
+            if (brain->prepareInput(tickPerceptions[i], sharedWorld, inferenceScheduler)) {
+                tickBatched[i] = 1;
+            } else {
+                tickActions[i] = brain->decide(tickPerceptions[i], sharedWorld);
+            }
+        }
+    });
+    
+    // One batched call per model for every queued NPC; native models spread it over the workers
+    inferenceScheduler.run(jobs.get());
+}
+
+void Simulation::decidePipelined(const World& sharedWorld, size_t grain) {
+    const size_t npcCount = npcs.size();
+    pipelineSubmitted.resize(npcCount, NOT_SUBMITTED);
+    pipelinePerceptions.resize(npcCount);
+    
+    // Requests from latency ticks ago are due now; they have normally finished
+    const Tick latency = inferencePipeline.latency();
+    if (currentTick >= latency) {
+        inferencePipeline.wait(currentTick - latency);
+    }
+    InferenceScheduler& submitting = inferencePipeline.slot(currentTick);
+    submitting.beginTick();
+    
+    jobs->parallelFor(npcCount, grain, [&](size_t begin, size_t end, int) {
+        for (size_t k = begin; k < end; k++) {
+            const uint32_t i = brainOrder[k];
+            IBrain* brain = npcs.brain(i);
+            bool decided = false;
+            
+            // Act on the request in flight once its latency has passed
+            if (pipelineSubmitted[i] != NOT_SUBMITTED && currentTick - pipelineSubmitted[i] >= latency) {
+                tickPerceptions[i] = std::move(pipelinePerceptions[i]);
+                tickActions[i] = brain->applyOutput(tickPerceptions[i],
+                                                    inferencePipeline.slot(pipelineSubmitted[i]));
+                pipelineSubmitted[i] = NOT_SUBMITTED;
+                decided = true;
+            }
+            
+            // Start the next decision, one in flight per NPC; brains with
+            // nothing to batch decide at once
+            if (decisionScheduler.shouldDecide(currentTick, npcs, i, sharedWorld) &&
+                pipelineSubmitted[i] == NOT_SUBMITTED) {
+                Perception perception = npcs[i].gatherPerception(sharedWorld, currentTick);
+                if (brain->prepareInput(perception, sharedWorld, submitting)) {
+                    pipelinePerceptions[i] = std::move(perception);
+                    pipelineSubmitted[i] = currentTick;
+                } else if (!decided) {
+                    tickPerceptions[i] = std::move(perception);
+                    tickActions[i] = brain->decide(tickPerceptions[i], sharedWorld);
+                    decided = true;
+                }
+            }
+            
+            if (!decided) {
+                tickActions[i] = npcs.currentAction(i);
+            }
+            tickDecided[i] = decided;
+        }
+    });
+    
+    // Runs while this tick and the next latency - 1 carry on
+    inferencePipeline.launch(currentTick);
+}
+
+void Simulation::publishObservation(uint32_t npc) {
+    const NeuralBrain* brain = static_cast<const NeuralBrain*>(npcs.brain(npc));
+    if (brain->getLastActionIndex() < 0) return;
+    
+    ObservationRecord record;
+    record.tick = currentTick;
+    record.npcId = npcs.id(npc);
+    record.actionIndex = static_cast<uint32_t>(brain->getLastActionIndex());
+    record.reward = brain->getLastReward();
+    record.modelVersion = brain->getModelVersion();
+    
+    const std::vector<float>& perception = brain->getLastPerceptionVector();
+    std::copy_n(perception.begin(), std::min(perception.size(), InferenceScheduler::PERCEPTION_DIM),
+                record.perception);
+    const std::vector<float>& probs = brain->getLastActionProbs();
+    std::copy_n(probs.begin(), std::min(probs.size(), InferenceScheduler::ACTION_DIM), record.actionProbs);
+    
+    observations.publish(record);
+}
+
+void Simulation::streamChunks() {
+    PW_PROFILE_ZONE("chunks/stream");
+    chunkAnchors.clear();
+    for (size_t i = 0; i < npcs.size(); i++) {
+        chunkAnchors.push_back(npcs.position(i));
+    }
+    if (hasViewAnchor) {
+        chunkAnchors.push_back(viewAnchor);
+    }
+    world->evictChunks(chunkAnchors, CHUNK_KEEP_RADIUS);
+}
+
+void Simulation::applyWorldCommands() {
+    tickCommands.clear();
+    for (const auto& commands : workerCommands) {
+        tickCommands.insert(tickCommands.end(), commands.begin(), commands.end());
+    }
+    
+    // Workers pick up chunks in any order; applying in NPC order makes contested
+    // tiles resolve the same way for every thread count
+    std::stable_sort(tickCommands.begin(), tickCommands.end(),
+                     [](const WorldCommand& a, const WorldCommand& b) {
+                         return a.npc < b.npc;
+                     });
+    
+    for (const auto& command : tickCommands) {
+        switch (command.type) {
+            case WorldCommand::Type::ConsumeFood:
+                if (world->consumeFood(command.x, command.y)) {
+                    npcs.onFoodConsumed(command.npc);
+                    tickAte[command.npc] = 1;
+                }
+                break;
+        }
+    }
+}
+
+void Simulation::rebuildEntityIndex() {
+    EntityIndex& index = world->getEntityIndex();
+    index.clear();
+    for (size_t i = 0; i < npcs.size(); i++) {
+        index.add(npcs.id(i), npcs.position(i));
+    }
+    index.build();
+}
+
+void Simulation::collectMeetings() {
+    static constexpr float MEETING_DISTANCE = 2.0f;
+    
+    // Index slots match positions in npcs (see rebuildEntityIndex)
+    const EntityIndex& index = world->getEntityIndex();
+    for (size_t i = 0; i < npcs.size(); i++) {
+        neighbourScratch.clear();
+        index.queryRadius(npcs.position(i), MEETING_DISTANCE, neighbourScratch);
+        
+        for (uint32_t j : neighbourScratch) {
+            // Each pair once, in the same order as a full pairwise scan
+            if (j <= i) continue;
+            
+            EngineEvent event;
+            event.type = EngineEvent::Type::NpcMet;
+            event.tick = currentTick;
+            event.npc = npcs.id(i);
+            event.other = npcs.id(j);
+            event.npcIndex = static_cast<uint32_t>(i);
+            event.otherIndex = j;
+            event.value = npcs.position(i).distance(npcs.position(j));
+            tickEvents.push_back(event);
+        }
+    }
+}
+
+void Simulation::dispatchEvents() {
+    for (const EngineEvent& event : tickEvents) {
+        bool logged = true;
+        if (event.type == EngineEvent::Type::NpcMet) {
+            meetingsOffered++;
+            logged = dataLogger->wantsMeeting(currentTick, event.npc, event.other);
+            if (logged) {
+                meetingsLogged++;
+            }
+        }
+        if (logged) {
+            dataLogger->logEvent(event);  // Serialized here, and only if kept
+        }
+        
+        npcs.brain(event.npcIndex)->onEvent(event);
+        npcs.brain(event.otherIndex)->onEvent(event);
+    }
+    tickEvents.clear();
+}
+
+void Simulation::groupByBrain() {
+    // Stable, so each group keeps id order
+    brainOrder.resize(npcs.size());
+    for (size_t i = 0; i < npcs.size(); i++) {
+        brainOrder[i] = static_cast<uint32_t>(i);
+    }
+    auto neural = std::stable_partition(brainOrder.begin(), brainOrder.end(), [&](uint32_t i) {
+        return npcs.brainKind(i) != BrainKind::Neural;
+    });
+    neuralBegin = static_cast<size_t>(neural - brainOrder.begin());
+}
+
+std::vector<BrainStateFile::Entry> Simulation::neuralBrains() {
+    std::vector<BrainStateFile::Entry> brains;
+    brains.reserve(brainOrder.size() - neuralBegin);
+    for (size_t k = neuralBegin; k < brainOrder.size(); k++) {
+        const uint32_t i = brainOrder[k];
+        brains.push_back({npcs.id(i), static_cast<NeuralBrain*>(npcs.brain(i))});
+    }
+    return brains;
+}
+
+void Simulation::saveNPCStates() {
+    // Create directory
+    #ifdef _WIN32
+        _mkdir("npc_states");
+    #else
+        mkdir("npc_states", 0755);
+    #endif
+    
+    std::vector<BrainStateFile::Entry> brains = neuralBrains();
+    BrainStateFile::save(BRAIN_STATE_PATH, brains, *jobs);
+    
+    // Human-readable copies for debugging only; never read back automatically
+    if (!brainJsonDirectory.empty()) {
+        #ifdef _WIN32
+            _mkdir(brainJsonDirectory.c_str());
+        #else
+            mkdir(brainJsonDirectory.c_str(), 0755);
+        #endif
+        for (const auto& entry : brains) {
+            entry.brain->saveState(brainJsonDirectory + "/npc_" + std::to_string(entry.id) + "_state.json");
+        }
+    }
+}
+
+void Simulation::loadNPCStates() {
+    std::vector<BrainStateFile::Entry> brains = neuralBrains();
+    
+    struct stat info;
+    if (stat(BRAIN_STATE_PATH, &info) == 0) {
+        BrainStateFile::load(BRAIN_STATE_PATH, brains, *jobs);
+        return;
+    }
+    
+    // Per-NPC JSON files written before the packed format
+    for (const auto& entry : brains) {
+        entry.brain->loadState("npc_states/npc_" + std::to_string(entry.id) + "_state.json");
+    }
+}
+
+namespace {
+
+enum class SnapshotBrain : uint8_t { BehaviorTree, Neural };
+
+} // namespace
+
+bool Simulation::saveSnapshot(const std::string& path) const {
+    const auto start = std::chrono::steady_clock::now();
+    
+    SnapshotWriter out;
+    out.section(snapshot::ENGINE);
+    out.write(seed);
+    out.writeRng(rng);
+    out.write(currentTick);
+    out.write(world->getSeed());
+    out.write(static_cast<int32_t>(world->getWidth()));
+    out.write(static_cast<int32_t>(world->getHeight()));
+    
+    world->writeSnapshot(out);
+    
+    out.write(static_cast<uint32_t>(npcs.size()));
+    for (size_t i = 0; i < npcs.size(); i++) {
+        const NPC npc = npcs[i];
+        SnapshotBrain kind = npc.isNeuralBrain() ? SnapshotBrain::Neural : SnapshotBrain::BehaviorTree;
+        out.write(kind);
+        out.write(npc.getId());
+        npc.writeSnapshot(out);
+    }
+    
+    if (!out.save(path)) {
+        return false;
+    }
+    const double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Snapshot: tick " << currentTick << ", " << out.size() << " bytes to " << path
+              << " in " << elapsedMs << " ms" << std::endl;
+    return true;
+}
+
+bool Simulation::readSnapshotHeader(SnapshotReader& in, SnapshotHeader& header) {
+    // Far beyond any map that fits in memory; a larger size means a corrupt file
+    static constexpr int32_t MAX_WORLD_SIDE = 1 << 15;
+    
+    if (!in.open(loadSnapshotPath)) {
+        return false;
+    }
+    
+    in.section(snapshot::ENGINE);
+    in.read(header.seed);
+    in.readRng(header.rng);
+    in.read(header.tick);
+    in.read(header.worldSeed);
+    in.read(header.width);
+    in.read(header.height);
+    if (!in.ok() || header.width <= 0 || header.height <= 0 || header.width > MAX_WORLD_SIDE
+        || header.height > MAX_WORLD_SIDE) {
+        std::cerr << "Warning: Could not read snapshot " << loadSnapshotPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Simulation::restoreSnapshot(SnapshotReader& in, uint32_t brainSeed) {
+    static constexpr uint32_t MAX_NPCS = 1u << 20;
+    
+    if (!world->readSnapshot(in)) {
+        return false;
+    }
+    
+    uint32_t npcCount = 0;
+    if (!in.read(npcCount) || npcCount > MAX_NPCS) {
+        return false;
+    }
+    npcs.reserve(npcCount);
+    for (uint32_t i = 0; i < npcCount; i++) {
+        SnapshotBrain kind = SnapshotBrain::BehaviorTree;
+        EntityId id = 0;
+        if (!in.read(kind) || !in.read(id)) {
+            return false;
+        }
+        
+        // Brains are rebuilt as the spawner makes them, then overwritten
+        NPC npc = npcs[npcs.add(id, Vec2())];
+        if (kind == SnapshotBrain::Neural) {
+            npc.setBrain(std::make_unique<NeuralBrain>(id, modelPath, brainSeed, &relationships));
+        } else {
+            npc.setBrain(std::make_unique<BehaviorTreeBrain>(id, brainSeed));
+        }
+        if (!npc.readSnapshot(in)) {
+            return false;
+        }
+    }
+    return in.ok();
+}
+
+} // namespace pw
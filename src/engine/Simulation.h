@@ -0,0 +1,291 @@
+#pragma once
+
+#include "Types.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "SimdMath.h"
+#include "DecisionScheduler.h"
+#include "FrameArena.h"
+#include "Random.h"
+#include "world/World.h"
+#include "entities/NPC.h"
+#include "entities/WorldCommand.h"
+#include "data/DataLogger.h"
+#include "data/ObservationStream.h"
+#include "ai/neural/InferencePipeline.h"
+#include "ai/neural/InferenceScheduler.h"
+#include "ai/neural/ModelRegistry.h"
+#include "ai/social/RelationshipStore.h"
+#include "serialization/BrainStateFile.h"
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <string>
+
+namespace pw {
+
+class SnapshotReader;
+
+// The world, its NPCs and everything that advances them, with no rendering or
+// platform code; GameEngine draws it, pw_bench drives it directly. Configure,
+// then init(), step() as often as needed and finish() to flush logs and save
+// state.
+class Simulation {
+public:
+    Simulation();
+    ~Simulation();
+    
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+    
+    // Worker threads for the NPC update (including the main thread); < 1 uses every core
+    void setThreadCount(int threads) { threadCount = threads; }
+    
+    // Seeds NPC spawning and brain RNGs; with a fixed seed the output does not
+    // depend on the thread count
+    void setSeed(uint32_t newSeed);
+    uint32_t getSeed() const { return seed; }
+    
+    // Seed of the terrain, independent of the NPC seed above
+    void setWorldSeed(uint32_t newSeed) { worldSeed = newSeed; }
+    uint32_t getWorldSeed() const { return worldSeed; }
+    
+    // NPCs to spawn when not resuming from a snapshot, the share of them given a
+    // neural brain (spread evenly over ids; the rest use behavior trees) and the
+    // model those brains load
+    void setNPCCount(int count) { npcCount = count; }
+    void setNeuralFraction(float fraction) { neuralFraction = std::clamp(fraction, 0.0f, 1.0f); }
+    void setModelPath(const std::string& path) { modelPath = path; }
+    
+    // Engine and weight storage for the models brains load, applied to the
+    // process-wide ModelRegistry by init()
+    void setInferenceSettings(const InferenceSettings& settings) { inferenceSettings = settings; }
+    const InferenceSettings& getInferenceSettings() const { return inferenceSettings; }
+    
+    // Pipelined inference: batched neural inference runs on its own thread
+    // while the tick carries on, and inputs gathered on tick t decide the
+    // NPC's action on tick t + ticks; until then it keeps its last action.
+    // 0 (the default) runs inference inside the tick. Requests in flight are
+    // not part of snapshots.
+    void setInferenceLatency(int ticks) { inferenceLatency = std::max(0, ticks); }
+    
+    void setLogFormat(LogFormat format) { logFormat = format; }
+    void setLogQueue(const LogQueueSettings& settings) { logQueue = settings; }
+    void setLogDirectory(const std::string& directory) { logDirectory = directory; }
+    const std::string& getLogDirectory() const { return logDirectory; }
+    
+    // Log decisions only on every ticks-th tick (1 logs every tick); events are always logged
+    void setDecisionLogInterval(int ticks) { decisionLogInterval = std::max(1, ticks); }
+    
+    // Which of the remaining decisions and meetings are logged (see LogFilterSettings)
+    void setLogFilter(const LogFilterSettings& settings) { logFilter = settings; }
+    const LogFilterSettings& getLogFilter() const { return logFilter; }
+    
+    // Map size in tiles, and where edited chunks go when evicted ("" keeps them in memory)
+    void setWorldSize(int width, int height) { worldWidth = width; worldHeight = height; }
+    void setChunkPageDirectory(const std::string& directory) { chunkPageDirectory = directory; }
+    const std::string& getChunkPageDirectory() const { return chunkPageDirectory; }
+    
+    // Reuse generated terrain across runs with the same seed and size ("" disables)
+    void setTerrainCacheDirectory(const std::string& directory) { terrainCacheDirectory = directory; }
+    
+    // Resume from a binary snapshot instead of spawning, and/or write one when
+    // the run ends. Snapshots hold the whole simulation state (see Snapshot.h).
+    void setLoadSnapshot(const std::string& path) { loadSnapshotPath = path; }
+    void setSaveSnapshot(const std::string& path) { saveSnapshotPath = path; }
+    bool saveSnapshot(const std::string& path) const;
+    
+    // Load neural brain states in init() and save them in finish() (on by default)
+    void setPersistBrainStates(bool persist) { persistBrainStates = persist; }
+    
+    // Also write each neural brain's state as JSON into directory (debugging aid)
+    void setBrainJsonDirectory(const std::string& directory) { brainJsonDirectory = directory; }
+    
+    // AI level of detail: NPCs re-decide every few ticks, less often far from
+    // the view anchor, and keep their last action in between (see DecisionScheduler)
+    void setAILevelOfDetail(bool enabled);
+    
+    // Publish every neural decision to a shared-memory ring of capacity
+    // records for an online trainer (see ObservationStream.h; "" disables),
+    // and check every ticks ticks for a retrained model file to hot-reload
+    // (0 disables)
+    void setObservationStream(const std::string& path) { observationPath = path; }
+    void setObservationCapacity(size_t records) { observationCapacity = records; }
+    void setModelReloadInterval(Tick ticks) { modelReloadInterval = ticks; }
+    
+    // Time engine subsystems (see Profiler.h) and write a Chrome trace to path;
+    // every step() is a profiler frame, and per-zone p50/p99 over them are
+    // printed by finish()
+    void setProfilePath(const std::string& path) { profilePath = path; }
+    
+    void init();
+    void step(float dt);  // One fixed-timestep tick
+    void finish();
+    
+    // init(), ticks steps with progress output, finish()
+    void runHeadless(int ticks);
+    
+    // Setup, progress and end-of-run reports on stdout (on by default); warnings always print
+    void setVerbose(bool enabled) { verbose = enabled; }
+    
+    // Extra point, in tiles, that keeps chunks resident and NPCs at full
+    // decision rate, e.g. the camera
+    void setViewAnchor(Vec2 position);
+    
+    const World& getWorld() const { return *world; }
+    const NPCStore& getNPCs() const { return npcs; }
+    Tick getTick() const { return currentTick; }
+    const JobSystem& getJobs() const { return *jobs; }
+
+private:
+    // Engine section of a snapshot; applied only once the whole file has read back
+    struct SnapshotHeader {
+        uint32_t seed = 0;
+        CounterRng rng;
+        Tick tick = 0;
+        uint32_t worldSeed = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+    };
+    
+    void createWorld(uint32_t terrainSeed, int width, int height);
+    void spawnNPCs();
+    std::vector<uint32_t> spawnCells() const;
+    bool readSnapshotHeader(SnapshotReader& in, SnapshotHeader& header);
+    bool restoreSnapshot(SnapshotReader& in, uint32_t brainSeed);
+    void update(float dt);
+    void decide(const World& sharedWorld, size_t grain);
+    void decidePipelined(const World& sharedWorld, size_t grain);
+    void applyWorldCommands();
+    void rebuildEntityIndex();
+    void groupByBrain();
+    void collectMeetings();
+    void dispatchEvents();
+    void streamChunks();
+    void reportSetup(bool restoring) const;
+    void reportLogQueue() const;
+    void reportDecisions() const;
+    void reportLogFilter() const;
+    void reportObservations() const;
+    void reportPipeline() const;
+    void reportAllocations() const;
+    void publishObservation(uint32_t npc);
+    void reportProfile() const;
+    
+    // NPC state persistence: every neural brain in one packed file (see BrainStateFile)
+    static constexpr const char* BRAIN_STATE_PATH = "npc_states/brains.bin";
+    std::vector<BrainStateFile::Entry> neuralBrains();
+    void saveNPCStates();
+    void loadNPCStates();
+    
+    // Chunks with no NPC (or the view anchor) within CHUNK_KEEP_RADIUS tiles
+    // are released every CHUNK_EVICT_INTERVAL ticks
+    static constexpr Tick CHUNK_EVICT_INTERVAL = 300;
+    static constexpr float CHUNK_KEEP_RADIUS = 64.0f;
+    
+    // Profiler ring size: zones an NPC can close in a tick (perception,
+    // decision, pathfinding, logging) with headroom, plus the tick's own
+    static constexpr size_t PROFILE_EVENTS_PER_NPC = 8;
+    static constexpr size_t PROFILE_EVENTS_PER_TICK = 1024;
+    
+    // NPCs spawn within SPAWN_RADIUS tiles of the map centre, so a large map
+    // only generates the chunks there at startup. Covers the default map.
+    // Larger populations spread out so each NPC still has about
+    // SPAWN_TILES_PER_NPC tiles of the spawn square (1000 NPCs fill 256x256).
+    static constexpr int SPAWN_RADIUS = 128;
+    static constexpr int SPAWN_TILES_PER_NPC = 64;
+    
+    std::unique_ptr<World> world;
+    RelationshipStore relationships;  // Every neural brain's, so declared before npcs
+    NPCStore npcs;
+    std::unique_ptr<DataLogger> dataLogger;
+    int npcCount = 15;
+    float neuralFraction = 0.5f;
+    std::string modelPath = "models/npc_brain.onnx";
+    InferenceSettings inferenceSettings;
+    int inferenceLatency = 0;
+    int decisionLogInterval = 1;
+    LogFormat logFormat = LogFormat::Jsonl;
+    LogQueueSettings logQueue;
+    LogFilterSettings logFilter;
+    std::string logDirectory = "data_logs";
+    uint32_t worldSeed = 42;
+    int worldWidth = WORLD_WIDTH;
+    int worldHeight = WORLD_HEIGHT;
+    std::string chunkPageDirectory;
+    std::string terrainCacheDirectory;
+    bool terrainCached = false;
+    double terrainMs = 0.0;
+    std::string loadSnapshotPath;
+    std::string saveSnapshotPath;
+    bool persistBrainStates = true;
+    bool verbose = true;
+    std::string brainJsonDirectory;
+    std::string profilePath;
+    std::string observationPath;
+    size_t observationCapacity = 1 << 16;
+    ObservationStream observations;
+    Tick modelReloadInterval = 0;
+    std::vector<Vec2> chunkAnchors;
+    Vec2 viewAnchor;
+    bool hasViewAnchor = false;
+    
+    // NPC indices grouped by brain kind, behavior trees first and id order
+    // within a group, so the decision phases run one kind at a time
+    std::vector<uint32_t> brainOrder;
+    size_t neuralBegin = 0;
+    
+    // Per-tick decision state, reused across ticks
+    InferenceScheduler inferenceScheduler;
+    std::vector<Perception> tickPerceptions;
+    std::vector<Action> tickActions;
+    std::vector<uint8_t> tickBatched;
+    std::vector<uint8_t> tickDecided;
+    
+    // Pipelined inference: per NPC, the tick its request in flight was
+    // submitted on (NOT_SUBMITTED if none) and the perception it describes
+    static constexpr Tick NOT_SUBMITTED = ~Tick{0};
+    InferencePipeline inferencePipeline;
+    std::vector<Tick> pipelineSubmitted;
+    std::vector<Perception> pipelinePerceptions;
+    DecisionScheduler decisionScheduler;
+    uint64_t decisionsMade = 0;
+    uint64_t npcTicks = 0;
+    std::vector<Needs> tickOldNeeds;
+    std::vector<ActionType> tickOldActions;
+    std::vector<uint8_t> tickAte;     // A ConsumeFood command went through
+    std::vector<const std::pmr::string*> tickRecords;  // Formatted into frameArenas
+    std::vector<uint8_t> tickLogged;  // Passed the log filter
+    EngineEventQueue tickEvents;      // Collected after the update, dispatched in order
+    
+    // Heap allocations made inside update(), with PW_COUNT_ALLOCATIONS builds.
+    // The counter is process-wide, so other threads' allocations (log I/O,
+    // other worlds) land here too.
+    uint64_t tickAllocations = 0;
+    uint64_t allocatingTicks = 0;
+    uint64_t countedTicks = 0;
+    Tick lastAllocatingTick = 0;
+    
+    // Log filter totals: records offered to it and kept
+    uint64_t decisionsOffered = 0;
+    uint64_t decisionsLogged = 0;
+    uint64_t meetingsOffered = 0;
+    uint64_t meetingsLogged = 0;
+    
+    // Parallel NPC update
+    std::unique_ptr<JobSystem> jobs;
+    int threadCount = 1;
+    std::vector<WorldCommandBuffer> workerCommands;  // One per worker thread
+    
+    // Per worker too: memory for what a tick builds and drops, reset when it ends
+    std::vector<std::unique_ptr<FrameArena>> frameArenas;
+    WorldCommandBuffer tickCommands;
+    std::vector<uint32_t> neighbourScratch;
+    
+    Tick currentTick = 0;
+    
+    uint32_t seed;
+    CounterRng rng;  // Spawning
+};
+
+} // namespace pw
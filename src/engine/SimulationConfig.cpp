@@ -0,0 +1,171 @@
+#include "SimulationConfig.h"
+#include "Simulation.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace pw {
+
+namespace {
+
+// Every key loadSimulationConfig() reads
+const char* const KEYS[] = {
+    "npcs", "neural_fraction", "model_path", "inference_backend", "weight_precision",
+    "intra_op_threads", "inter_op_threads", "graph_optimization", "inference_latency",
+    "seed", "world_seed", "world_width", "world_height", "threads", "log_format",
+    "log_directory", "decision_log_interval", "ai_lod", "log_sampling", "log_action_changes",
+    "log_min_need_delta", "meeting_log_cooldown", "observation_stream", "observation_capacity",
+    "model_reload_interval"
+};
+
+bool invalid(const std::string& path, const char* key, const char* expected) {
+    std::cerr << "Warning: Config " << path << ": \"" << key << "\" must be " << expected << std::endl;
+    return false;
+}
+
+} // namespace
+
+bool loadSimulationConfig(const std::string& path, Simulation& simulation) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Warning: Could not open config " << path << std::endl;
+        return false;
+    }
+    
+    nlohmann::json config;
+    try {
+        file >> config;
+    } catch (const nlohmann::json::parse_error& e) {
+        std::cerr << "Warning: Could not parse config " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (!config.is_object()) {
+        std::cerr << "Warning: Config " << path << " must hold a JSON object" << std::endl;
+        return false;
+    }
+    
+    // Checked before anything is applied: a misspelled key would otherwise
+    // leave its setting at the default without a word
+    for (const auto& item : config.items()) {
+        if (std::find(std::begin(KEYS), std::end(KEYS), item.key()) == std::end(KEYS)) {
+            std::cerr << "Warning: Config " << path << ": unknown key \"" << item.key() << "\"" << std::endl;
+            return false;
+        }
+    }
+    
+    try {
+        if (config.contains("npcs")) {
+            int npcs = config["npcs"].get<int>();
+            if (npcs < 0) return invalid(path, "npcs", "0 or more");
+            simulation.setNPCCount(npcs);
+        }
+        if (config.contains("neural_fraction")) {
+            float fraction = config["neural_fraction"].get<float>();
+            if (fraction < 0.0f || fraction > 1.0f) return invalid(path, "neural_fraction", "between 0 and 1");
+            simulation.setNeuralFraction(fraction);
+        }
+        if (config.contains("model_path")) {
+            simulation.setModelPath(config["model_path"].get<std::string>());
+        }
+        if (config.contains("inference_backend") || config.contains("weight_precision")
+            || config.contains("intra_op_threads") || config.contains("inter_op_threads")
+            || config.contains("graph_optimization")) {
+            InferenceSettings settings = simulation.getInferenceSettings();
+            if (config.contains("inference_backend")
+                && !parseInferenceBackend(config["inference_backend"].get<std::string>(), settings.backend)) {
+                return invalid(path, "inference_backend", "\"auto\", \"onnx\" or \"native\"");
+            }
+            if (config.contains("weight_precision")
+                && !parseWeightPrecision(config["weight_precision"].get<std::string>(), settings.weightPrecision)) {
+                return invalid(path, "weight_precision", "\"fp32\", \"fp16\" or \"int8\"");
+            }
+            if (config.contains("intra_op_threads")) {
+                settings.intraOpThreads = config["intra_op_threads"].get<int>();
+                if (settings.intraOpThreads < 0) return invalid(path, "intra_op_threads", "0 or more");
+            }
+            if (config.contains("inter_op_threads")) {
+                settings.interOpThreads = config["inter_op_threads"].get<int>();
+                if (settings.interOpThreads < 0) return invalid(path, "inter_op_threads", "0 or more");
+            }
+            if (config.contains("graph_optimization")
+                && !parseGraphOptimization(config["graph_optimization"].get<std::string>(),
+                                           settings.graphOptimization)) {
+                return invalid(path, "graph_optimization", "\"disabled\", \"basic\", \"extended\" or \"all\"");
+            }
+            simulation.setInferenceSettings(settings);
+        }
+        if (config.contains("inference_latency")) {
+            int latency = config["inference_latency"].get<int>();
+            if (latency < 0) return invalid(path, "inference_latency", "0 or more");
+            simulation.setInferenceLatency(latency);
+        }
+        if (config.contains("seed")) {
+            simulation.setSeed(config["seed"].get<uint32_t>());
+        }
+        if (config.contains("world_seed")) {
+            simulation.setWorldSeed(config["world_seed"].get<uint32_t>());
+        }
+        if (config.contains("world_width") || config.contains("world_height")) {
+            int width = config.value("world_width", WORLD_WIDTH);
+            int height = config.value("world_height", WORLD_HEIGHT);
+            if (width <= 0 || height <= 0) return invalid(path, "world_width/world_height", "positive");
+            simulation.setWorldSize(width, height);
+        }
+        if (config.contains("threads")) {
+            simulation.setThreadCount(config["threads"].get<int>());
+        }
+        if (config.contains("log_directory")) {
+            simulation.setLogDirectory(config["log_directory"].get<std::string>());
+        }
+        if (config.contains("observation_stream")) {
+            simulation.setObservationStream(config["observation_stream"].get<std::string>());
+        }
+        if (config.contains("observation_capacity")) {
+            size_t capacity = config["observation_capacity"].get<size_t>();
+            if (capacity == 0) return invalid(path, "observation_capacity", "positive");
+            simulation.setObservationCapacity(capacity);
+        }
+        if (config.contains("model_reload_interval")) {
+            simulation.setModelReloadInterval(config["model_reload_interval"].get<Tick>());
+        }
+        if (config.contains("log_format")) {
+            LogFormat format;
+            if (!DataLogger::parseLogFormat(config["log_format"].get<std::string>(), format)) {
+                return invalid(path, "log_format", "\"jsonl\" or \"binary\"");
+            }
+            simulation.setLogFormat(format);
+        }
+        if (config.contains("ai_lod")) {
+            simulation.setAILevelOfDetail(config["ai_lod"].get<bool>());
+        }
+        if (config.contains("decision_log_interval")) {
+            int interval = config["decision_log_interval"].get<int>();
+            if (interval < 1) return invalid(path, "decision_log_interval", "1 or more");
+            simulation.setDecisionLogInterval(interval);
+        }
+        
+        LogFilterSettings filter = simulation.getLogFilter();
+        if (config.contains("log_sampling")) {
+            filter.decisionSampling = config["log_sampling"].get<int>();
+            if (filter.decisionSampling < 1) return invalid(path, "log_sampling", "1 or more");
+        }
+        if (config.contains("log_action_changes")) {
+            filter.actionChanges = config["log_action_changes"].get<bool>();
+        }
+        if (config.contains("log_min_need_delta")) {
+            filter.minNeedDelta = config["log_min_need_delta"].get<float>();
+        }
+        if (config.contains("meeting_log_cooldown")) {
+            filter.meetingCooldown = config["meeting_log_cooldown"].get<Tick>();
+        }
+        simulation.setLogFilter(filter);
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Warning: Config " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace pw
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+namespace pw {
+
+class Simulation;
+
+// Reads simulation settings from a JSON file and applies them to simulation,
+// so experiments can change them without a rebuild. Keys that are absent keep
+// their current values:
+//
+//   {
+//     "npcs": 1000,              "neural_fraction": 0.5,
+//     "model_path": "models/npc_brain.onnx",
+//     "inference_backend": "native", "weight_precision": "int8",
+//     "intra_op_threads": 4,     "inter_op_threads": 1,
+//     "graph_optimization": "all", "inference_latency": 1,
+//     "seed": 7,                 "world_seed": 42,
+//     "world_width": 1024,       "world_height": 1024,
+//     "threads": 0,              "log_format": "binary",
+//     "log_directory": "data_logs",
+//     "decision_log_interval": 10, "ai_lod": true,
+//     "log_sampling": 4,         "log_action_changes": true,
+//     "log_min_need_delta": 0.05, "meeting_log_cooldown": 600,
+//     "observation_stream": "/dev/shm/pw_observations",
+//     "observation_capacity": 65536, "model_reload_interval": 600
+//   }
+//
+// Returns false, with a warning, if the file can't be parsed, holds a key
+// not listed above (nothing is applied then), or a value is invalid (the
+// settings read before the bad one are kept).
+bool loadSimulationConfig(const std::string& path, Simulation& simulation);
+
+} // namespace pw
@@ -14,7 +14,7 @@ constexpr int VIRTUAL_HEIGHT = 270;
 constexpr float FIXED_TIMESTEP = 1.0f / 60.0f; // 60 Hz simulation
 constexpr int MAX_FRAME_SKIP = 5;
 
-// World constants
+// World constants (default map size; World takes its size at runtime)
 constexpr int WORLD_WIDTH = 200;
 constexpr int WORLD_HEIGHT = 150;
 constexpr int TILE_SIZE = 8;
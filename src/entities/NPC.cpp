@@ -1,188 +1,360 @@
 #include "NPC.h"
 #include "world/World.h"
 #include "ai/behavior/BehaviorTreeBrain.h"
-#include "ai/neural/NeuralBrain.h"
-#include <random>
+#include "engine/Profiler.h"
+#include "serialization/Snapshot.h"
 #include <algorithm>
+#include <cmath>
 
 namespace pw {
 
-NPC::NPC(EntityId id, Vec2 position) : id(id), position(position) {
+uint32_t NPCStore::add(EntityId id, Vec2 position) {
+    const uint32_t index = static_cast<uint32_t>(ids.size());
+    const Needs needs;
+    ids.push_back(id);
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    hunger.push_back(needs.hunger);
+    energy.push_back(needs.energy);
+    social.push_back(needs.social);
+    curiosity.push_back(needs.curiosity);
+    safety.push_back(needs.safety);
+    moods.push_back(Mood::Neutral);
+    actions.emplace_back();
+    speeds.push_back(10.0f);
+    brainMemories.push_back(nullptr);
+    velocityX.push_back(0.0f);
+    velocityY.push_back(0.0f);
+    moveTargets.emplace_back();
+    
     // Random color for visual distinction
-    std::mt19937 rng(id);
-    std::uniform_int_distribution<int> colorDist(100, 255);
-    color = Color(colorDist(rng), colorDist(rng), colorDist(rng));
+    CounterRng rng(CounterRng::streamKey(0, id, CounterRng::Appearance));
+    const uint8_t r = static_cast<uint8_t>(100 + rng.below(156));
+    const uint8_t g = static_cast<uint8_t>(100 + rng.below(156));
+    const uint8_t b = static_cast<uint8_t>(100 + rng.below(156));
+    colors.push_back(Color(r, g, b));
+    
+    brainKinds.push_back(BrainKind::BehaviorTree);
+    decisionIntervals.push_back(1);
+    decisionTriggers.push_back(0);
+    perceivedTiles.emplace_back();
+    brains.emplace_back();
     
     // Initialize with behavior tree brain
-    brain = std::make_unique<BehaviorTreeBrain>(id);
+    (*this)[index].setBrain(std::make_unique<BehaviorTreeBrain>(id));
+    return index;
 }
 
-void NPC::setBrain(std::unique_ptr<IBrain> newBrain) {
-    brain = std::move(newBrain);
+void NPCStore::reserve(size_t count) {
+    ids.reserve(count);
+    positionX.reserve(count);
+    positionY.reserve(count);
+    hunger.reserve(count);
+    energy.reserve(count);
+    social.reserve(count);
+    curiosity.reserve(count);
+    safety.reserve(count);
+    moods.reserve(count);
+    actions.reserve(count);
+    speeds.reserve(count);
+    brainMemories.reserve(count);
+    velocityX.reserve(count);
+    velocityY.reserve(count);
+    moveTargets.reserve(count);
+    colors.reserve(count);
+    brainKinds.reserve(count);
+    decisionIntervals.reserve(count);
+    decisionTriggers.reserve(count);
+    perceivedTiles.reserve(count);
+    brains.reserve(count);
 }
 
-void NPC::update(float dt, World& world, Tick currentTick) {
-    updateNeeds(dt);
-    updateMood();
-    
-    // Make decision
-    if (brain) {
-        Perception perception = gatherPerception(world, {});
-        currentAction = brain->decide(perception, world);
-    }
-    
-    executeAction(dt, world);
+void NPCStore::clear() {
+    ids.clear();
+    positionX.clear();
+    positionY.clear();
+    hunger.clear();
+    energy.clear();
+    social.clear();
+    curiosity.clear();
+    safety.clear();
+    moods.clear();
+    actions.clear();
+    speeds.clear();
+    brainMemories.clear();
+    velocityX.clear();
+    velocityY.clear();
+    moveTargets.clear();
+    colors.clear();
+    brainKinds.clear();
+    decisionIntervals.clear();
+    decisionTriggers.clear();
+    perceivedTiles.clear();
+    brains.clear();
 }
 
-void NPC::updateNeeds(float dt) {
-    needs.update(dt);
+Needs NPCStore::needs(size_t index) const {
+    Needs result;
+    result.hunger = hunger[index];
+    result.energy = energy[index];
+    result.social = social[index];
+    result.curiosity = curiosity[index];
+    result.safety = safety[index];
+    return result;
 }
 
-void NPC::updateMood() {
-    // Determine mood based on needs
-    float avgNeed = (needs.hunger + needs.energy + needs.social) / 3.0f;
-    
-    if (avgNeed < 0.3f) {
-        mood = Mood::Happy;
-    } else if (avgNeed < 0.5f) {
-        mood = Mood::Neutral;
-    } else if (avgNeed < 0.7f) {
-        mood = Mood::Anxious;
-    } else {
-        mood = Mood::Sad;
-    }
-    
-    if (needs.curiosity > 0.7f) {
-        mood = Mood::Excited;
+void NPCStore::update(size_t begin, size_t end, float dt, const World& world,
+                      const Action* chosen, WorldCommandBuffer& commands) {
+    updateNeeds(begin, end, dt);
+    updateMoods(begin, end);
+    applyActions(begin, end, dt, world, chosen, commands);
+    move(begin, end, dt, world);
+}
+
+void NPCStore::onFoodConsumed(size_t index) {
+    hunger[index] = std::max(0.0f, hunger[index] - 0.3f);
+}
+
+void NPCStore::updateNeeds(size_t begin, size_t end, float dt) {
+    // Same arithmetic as Needs::update, one array at a time
+    float* h = hunger.data();
+    float* e = energy.data();
+    float* so = social.data();
+    float* c = curiosity.data();
+    float* sa = safety.data();
+    for (size_t i = begin; i < end; i++) h[i] = std::min(1.0f, h[i] + dt * Needs::HUNGER_RATE);
+    for (size_t i = begin; i < end; i++) e[i] = std::min(1.0f, e[i] + dt * Needs::ENERGY_RATE);
+    for (size_t i = begin; i < end; i++) so[i] = std::min(1.0f, so[i] + dt * Needs::SOCIAL_RATE);
+    for (size_t i = begin; i < end; i++) c[i] = std::min(1.0f, c[i] + dt * Needs::CURIOSITY_RATE);
+    for (size_t i = begin; i < end; i++) sa[i] = std::max(0.0f, sa[i] + dt * Needs::SAFETY_RATE);
+}
+
+void NPCStore::updateMoods(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        // Determine mood based on needs
+        float avgNeed = (hunger[i] + energy[i] + social[i]) / 3.0f;
+        
+        Mood mood;
+        if (avgNeed < 0.3f) {
+            mood = Mood::Happy;
+        } else if (avgNeed < 0.5f) {
+            mood = Mood::Neutral;
+        } else if (avgNeed < 0.7f) {
+            mood = Mood::Anxious;
+        } else {
+            mood = Mood::Sad;
+        }
+        
+        if (curiosity[i] > 0.7f) {
+            mood = Mood::Excited;
+        }
+        moods[i] = mood;
     }
 }
 
-void NPC::executeAction(float dt, World& world) {
-    switch (currentAction.type) {
-        case ActionType::Move:
-        case ActionType::Explore:
-        case ActionType::SeekShelter:
-            moveTowards(currentAction.targetPosition, dt);
-            break;
-            
-        case ActionType::Eat: {
-            int x = static_cast<int>(position.x);
-            int y = static_cast<int>(position.y);
-            Tile& tile = world.getTile(x, y);
-            if (tile.hasFood && tile.foodAmount > 0) {
-                tile.foodAmount--;
-                needs.hunger = std::max(0.0f, needs.hunger - 0.3f);
-                if (tile.foodAmount <= 0) {
-                    tile.hasFood = false;
+void NPCStore::applyActions(size_t begin, size_t end, float dt, const World& world,
+                            const Action* chosen, WorldCommandBuffer& commands) {
+    // Everything but movement, which move() does for the whole range afterwards
+    for (size_t i = begin; i < end; i++) {
+        actions[i] = chosen[i];
+        switch (actions[i].type) {
+            case ActionType::Eat: {
+                int x = static_cast<int>(positionX[i]);
+                int y = static_cast<int>(positionY[i]);
+                Tile tile = world.getTile(x, y);
+                if (tile.hasFood && tile.foodAmount > 0) {
+                    // Resolved by the engine; another NPC may take the last berry first
+                    commands.push_back({WorldCommand::Type::ConsumeFood, static_cast<uint32_t>(i), x, y});
                 }
+                break;
             }
-            break;
-        }
-        
-        case ActionType::Rest:
-            needs.energy = std::max(0.0f, needs.energy - dt * 0.2f);
-            break;
             
-        case ActionType::Socialize:
-            needs.social = std::max(0.0f, needs.social - dt * 0.1f);
-            break;
+            case ActionType::Rest:
+                energy[i] = std::max(0.0f, energy[i] - dt * 0.2f);
+                break;
+            
+            case ActionType::Socialize:
+                social[i] = std::max(0.0f, social[i] - dt * 0.1f);
+                break;
             
-        case ActionType::Idle:
-        default:
-            break;
+            default:
+                break;
+        }
     }
 }
 
-void NPC::moveTowards(Vec2 target, float dt) {
-    Vec2 direction = (target - position).normalized();
-    float distance = position.distance(target);
+void NPCStore::move(size_t begin, size_t end, float dt, const World& world) {
+    const float maxX = static_cast<float>(world.getWidth() - 1);
+    const float maxY = static_cast<float>(world.getHeight() - 1);
     
-    // Adjust speed based on mood
-    float currentSpeed = speed;
-    switch (mood) {
-        case Mood::Happy:
-        case Mood::Excited:
-            currentSpeed = speed * 1.2f;
-            break;
-        case Mood::Sad:
-        case Mood::Anxious:
-            currentSpeed = speed * 0.8f;
-            break;
-        default:
-            break;
+    for (size_t i = begin; i < end; i++) {
+        const ActionType type = actions[i].type;
+        if (type != ActionType::Move && type != ActionType::Explore && type != ActionType::SeekShelter) {
+            continue;
+        }
+        
+        const float x = positionX[i];
+        const float y = positionY[i];
+        const float dx = actions[i].targetPosition.x - x;
+        const float dy = actions[i].targetPosition.y - y;
+        const float distance = std::sqrt(dx * dx + dy * dy);
+        
+        // Adjust speed based on mood
+        float moodScale = 1.0f;
+        if (moods[i] == Mood::Happy || moods[i] == Mood::Excited) {
+            moodScale = 1.2f;
+        } else if (moods[i] == Mood::Sad || moods[i] == Mood::Anxious) {
+            moodScale = 0.8f;
+        }
+        const float moveAmount = speeds[i] * moodScale * dt;
+        
+        float newX = actions[i].targetPosition.x;
+        float newY = actions[i].targetPosition.y;
+        if (distance > moveAmount) {
+            newX = x + (dx / distance) * moveAmount;
+            newY = y + (dy / distance) * moveAmount;
+        }
+        
+        // Clamp to world bounds
+        positionX[i] = std::max(0.0f, std::min(maxX, newX));
+        positionY[i] = std::max(0.0f, std::min(maxY, newY));
     }
-    
-    float moveAmount = currentSpeed * dt;
-    if (distance <= moveAmount) {
-        position = target;
-    } else {
-        position = position + direction * moveAmount;
+}
+
+void NPC::setBrain(std::unique_ptr<IBrain> newBrain) {
+    IBrain* brain = newBrain.get();
+    store->brains[index] = std::move(newBrain);
+    store->brainKinds[index] = brain ? brain->kind() : BrainKind::BehaviorTree;
+    store->brainMemories[index] = brain ? brain->memory() : nullptr;
+    store->decisionIntervals[index] = brain ? std::max(1, brain->decisionInterval()) : 1;
+}
+
+void NPC::writeSnapshot(SnapshotWriter& out) const {
+    out.section(snapshot::NPC);
+    out.write(getId());
+    out.write(getPosition());
+    out.write(Vec2(store->velocityX[index], store->velocityY[index]));
+    out.write(getNeeds());
+    out.write(store->moods[index]);
+    out.write(store->speeds[index]);
+    out.write(store->actions[index]);
+    out.write(store->moveTargets[index]);
+    out.write(store->decisionTriggers[index]);
+    store->brains[index]->writeSnapshot(out);
+}
+
+bool NPC::readSnapshot(SnapshotReader& in) {
+    EntityId storedId = 0;
+    if (!in.section(snapshot::NPC) || !in.read(storedId) || storedId != getId()) {
+        return false;
     }
-    
-    // Clamp to world bounds
-    position.x = std::max(0.0f, std::min(static_cast<float>(WORLD_WIDTH - 1), position.x));
-    position.y = std::max(0.0f, std::min(static_cast<float>(WORLD_HEIGHT - 1), position.y));
+    Vec2 position;
+    Vec2 velocity;
+    Needs needs;
+    in.read(position);
+    in.read(velocity);
+    in.read(needs);
+    in.read(store->moods[index]);
+    in.read(store->speeds[index]);
+    in.read(store->actions[index]);
+    in.read(store->moveTargets[index]);
+    in.read(store->decisionTriggers[index]);
+    store->positionX[index] = position.x;
+    store->positionY[index] = position.y;
+    store->velocityX[index] = velocity.x;
+    store->velocityY[index] = velocity.y;
+    store->hunger[index] = needs.hunger;
+    store->energy[index] = needs.energy;
+    store->social[index] = needs.social;
+    store->curiosity[index] = needs.curiosity;
+    store->safety[index] = needs.safety;
+    return in.ok() && store->brains[index]->readSnapshot(in);
 }
 
-Perception NPC::gatherPerception(const World& world, const std::vector<NPC>& allNPCs) const {
+Perception NPC::gatherPerception(const World& world, Tick tick) const {
+    PW_PROFILE_ZONE("perception");
+    const Vec2 position = getPosition();
+    const EntityId id = getId();
+    const NPCMemory* brainMemory = store->brainMemories[index];
     Perception p;
     p.position = position;
-    p.internalNeeds = needs;
+    p.worldSize = Vec2(static_cast<float>(world.getWidth()), static_cast<float>(world.getHeight()));
+    p.internalNeeds = getNeeds();
     p.timeOfDay = world.getTimeOfDay();
+    p.tick = tick;
     
-    // Weather
-    switch (world.getWeather()) {
-        case Weather::Rain:
-            p.weather = "rain";
-            break;
-        case Weather::Storm:
-            p.weather = "storm";
-            break;
-        default:
-            p.weather = "clear";
-            break;
-    }
+    p.weather = world.getWeather();
     
-    // Nearby tiles
+    // Nearby tiles. The view is smaller than a chunk, so the chunks under its
+    // (clamped) corners are all the chunks it overlaps.
+    static_assert(Perception::VIEW_SIZE <= TileChunk::CHUNK_SIZE, "view spans more than two chunks");
     int centerX = static_cast<int>(position.x);
     int centerY = static_cast<int>(position.y);
-    for (int dy = -5; dy <= 5; dy++) {
-        for (int dx = -5; dx <= 5; dx++) {
-            int x = centerX + dx;
-            int y = centerY + dy;
-            if (x >= 0 && x < world.getWidth() && y >= 0 && y < world.getHeight()) {
-                const Tile& tile = world.getTile(x, y);
-                std::string tileType = "grass"; // Simplified
-                if (tile.type == TileType::BerryBush) tileType = "food";
-                if (tile.type == TileType::Cave) tileType = "shelter";
-                p.nearbyTiles.push_back({Vec2(static_cast<float>(x), static_cast<float>(y)), tileType});
+    p.viewOriginX = centerX - Perception::VIEW_RADIUS;
+    p.viewOriginY = centerY - Perception::VIEW_RADIUS;
+    
+    const int minX = std::max(0, p.viewOriginX);
+    const int minY = std::max(0, p.viewOriginY);
+    const int maxX = std::min(world.getWidth() - 1, centerX + Perception::VIEW_RADIUS);
+    const int maxY = std::min(world.getHeight() - 1, centerY + Perception::VIEW_RADIUS);
+    const std::array<uint32_t, 4> revisions = {
+        world.chunkRevisionAt(minX, minY), world.chunkRevisionAt(maxX, minY),
+        world.chunkRevisionAt(minX, maxY), world.chunkRevisionAt(maxX, maxY)};
+    
+    PerceivedTiles& cached = store->perceivedTiles[index];
+    if (cached.world != &world || cached.centerX != centerX || cached.centerY != centerY ||
+        cached.revisions != revisions) {
+        cached.world = &world;
+        cached.centerX = centerX;
+        cached.centerY = centerY;
+        cached.revisions = revisions;
+        cached.tiles.fill(TileType{});
+        cached.inWorld.reset();
+        size_t cell = 0;
+        for (int dy = -Perception::VIEW_RADIUS; dy <= Perception::VIEW_RADIUS; dy++) {
+            for (int dx = -Perception::VIEW_RADIUS; dx <= Perception::VIEW_RADIUS; dx++, cell++) {
+                int x = centerX + dx;
+                int y = centerY + dy;
+                if (x >= 0 && x < world.getWidth() && y >= 0 && y < world.getHeight()) {
+                    cached.tiles[cell] = world.getTile(x, y).type;
+                    cached.inWorld.set(cell);
+                }
             }
         }
     }
+    p.nearbyTiles = cached.tiles;
+    p.tileInWorld = cached.inWorld;
     
-    // Nearby NPCs
-    for (const auto& npc : allNPCs) {
-        if (npc.getId() != id) {
-            float dist = position.distance(npc.getPosition());
-            if (dist < 20.0f) {
-                p.nearbyNPCs.push_back({npc.getId(), npc.getPosition()});
-            }
+    // Nearby NPCs, nearest first; the closest ones are kept if there are more
+    // than fit. Bounded top-k: best[] stays sorted by (squared distance, slot),
+    // so the result doesn't depend on the order the index visits them in.
+    std::array<std::pair<float, uint32_t>, Perception::MAX_NEARBY_NPCS> best;
+    size_t found = 0;
+    const EntityIndex& entities = world.getEntityIndex();
+    entities.forEachInRadius(position, 20.0f, [&](uint32_t slot, const EntityIndex::Entry& other) {
+        if (other.id == id) return;
+        
+        const Vec2 offset = other.position - position;
+        const std::pair<float, uint32_t> candidate(offset.x * offset.x + offset.y * offset.y, slot);
+        if (found == best.size() && !(candidate < best[found - 1])) return;
+        
+        size_t i = found < best.size() ? found++ : found - 1;
+        while (i > 0 && candidate < best[i - 1]) {
+            best[i] = best[i - 1];
+            --i;
         }
+        best[i] = candidate;
+    });
+    for (size_t i = 0; i < found; i++) {
+        const EntityIndex::Entry& other = entities.entry(best[i].second);
+        p.nearbyNPCs.push_back(PerceivedNPC{other.id, other.position});
     }
     
-    // Memory recalls (from behavior tree or neural brain)
-    if (auto* btBrain = dynamic_cast<BehaviorTreeBrain*>(brain.get())) {
-        auto memories = btBrain->getMemory().getAllMemories();
-        for (const auto& mem : memories) {
-            if (mem.significance > 0.5f) {
-                p.memoryRecalls.push_back(mem.type);
-            }
-        }
-    } else if (auto* neuralBrain = dynamic_cast<NeuralBrain*>(brain.get())) {
-        auto memories = neuralBrain->getMemory().getAllMemories();
-        for (const auto& mem : memories) {
-            if (mem.significance > 0.5f) {
-                p.memoryRecalls.push_back(mem.type);
+    // Memory recalls, for brains that keep a memory
+    if (brainMemory) {
+        for (const auto& mem : brainMemory->getAllMemories()) {
+            if (brainMemory->currentSignificance(mem) > 0.5f && !p.memoryRecalls.push_back(mem.type)) {
+                break;
             }
         }
     }
@@ -190,8 +362,4 @@ Perception NPC::gatherPerception(const World& world, const std::vector<NPC>& all
     return p;
 }
 
-bool NPC::isNeuralBrain() const {
-    return brain && (dynamic_cast<const NeuralBrain*>(brain.get()) != nullptr);
-}
-
 } // namespace pw
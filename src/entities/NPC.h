@@ -3,12 +3,29 @@
 #include "engine/Types.h"
 #include "engine/Math.h"
 #include "ai/interface/IBrain.h"
+#include "entities/WorldCommand.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace pw {
 
 class World;
+class SnapshotReader;
+class SnapshotWriter;
+class NPC;
+
+// Terrain part of an NPC's last perception. Reused while the NPC stays on
+// the same tile of the same world and every chunk under its view keeps its
+// revision (World::chunkRevisionAt), since then none of those tiles changed.
+struct PerceivedTiles {
+    const World* world = nullptr;  // Null until the first perception
+    int centerX = 0;
+    int centerY = 0;
+    std::array<uint32_t, 4> revisions{};  // Chunks under the view's corners
+    std::array<TileType, Perception::VIEW_TILES> tiles{};
+    std::bitset<Perception::VIEW_TILES> inWorld;
+};
 
 enum class Mood {
     Happy,
@@ -18,47 +35,126 @@ enum class Mood {
     Excited
 };
 
-class NPC {
+// Every NPC's state as parallel component arrays: element i of each array
+// belongs to NPC i. Systems stream only the arrays they read (needs decay
+// the five need arrays, movement positions and moods, rendering positions
+// and colors) instead of pulling whole NPCs through the cache. NPC is a
+// handle onto one index for code that works on a single NPC, such as brains.
+class NPCStore {
 public:
-    NPC(EntityId id, Vec2 position);
+    // Adds an NPC with a default behavior tree brain and returns its index.
+    // Indices, and so handles, stay valid until clear().
+    uint32_t add(EntityId id, Vec2 position);
+    void reserve(size_t count);
+    void clear();
     
-    void update(float dt, World& world, Tick currentTick);
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
     
-    EntityId getId() const { return id; }
-    Vec2 getPosition() const { return position; }
-    Needs& getNeeds() { return needs; }
-    const Needs& getNeeds() const { return needs; }
-    Mood getMood() const { return mood; }
-    Color getColor() const { return color; }
-    const Action& getCurrentAction() const { return currentAction; }
+    NPC operator[](size_t index);
+    const NPC operator[](size_t index) const;
     
-    void setBrain(std::unique_ptr<IBrain> newBrain);
-    IBrain* getBrain() { return brain.get(); }
-    const IBrain* getBrain() const { return brain.get(); }
+    EntityId id(size_t index) const { return ids[index]; }
+    Vec2 position(size_t index) const { return Vec2(positionX[index], positionY[index]); }
+    Needs needs(size_t index) const;
+    Mood mood(size_t index) const { return moods[index]; }
+    Color color(size_t index) const { return colors[index]; }
+    const Action& currentAction(size_t index) const { return actions[index]; }
+    IBrain* brain(size_t index) { return brains[index].get(); }
+    const IBrain* brain(size_t index) const { return brains[index].get(); }
+    BrainKind brainKind(size_t index) const { return brainKinds[index]; }
+    int decisionInterval(size_t index) const { return decisionIntervals[index]; }
+    
+    // DecisionScheduler bookkeeping: its trigger bits when the NPC last decided
+    uint8_t triggersAtDecision(size_t index) const { return decisionTriggers[index]; }
+    void setTriggersAtDecision(size_t index, uint8_t bits) { decisionTriggers[index] = bits; }
     
-    // Brain type identification
-    bool isNeuralBrain() const;
+    // One tick for NPCs [begin, end): needs, then mood, then the action the
+    // brain chose (chosen[i] for NPC i). Only touches those NPCs, so disjoint
+    // ranges can run in parallel; world changes are queued on commands.
+    void update(size_t begin, size_t end, float dt, const World& world,
+                const Action* chosen, WorldCommandBuffer& commands);
     
-    // For data logging
-    Perception gatherPerception(const World& world, const std::vector<NPC>& allNPCs) const;
+    // Result of a ConsumeFood command that found food
+    void onFoodConsumed(size_t index);
 
 private:
-    EntityId id;
-    Vec2 position;
-    Vec2 velocity;
-    Needs needs;
-    Mood mood = Mood::Neutral;
-    Color color;
-    float speed = 10.0f; // tiles per second
+    friend class NPC;
+    
+    void updateNeeds(size_t begin, size_t end, float dt);
+    void updateMoods(size_t begin, size_t end);
+    void applyActions(size_t begin, size_t end, float dt, const World& world,
+                      const Action* chosen, WorldCommandBuffer& commands);
+    void move(size_t begin, size_t end, float dt, const World& world);
+    
+    // Hot: read or written every tick
+    std::vector<EntityId> ids;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> hunger;
+    std::vector<float> energy;
+    std::vector<float> social;
+    std::vector<float> curiosity;
+    std::vector<float> safety;
+    std::vector<Mood> moods;
+    std::vector<Action> actions;
+    std::vector<float> speeds;  // tiles per second
+    std::vector<const NPCMemory*> brainMemories;  // brains[i]->memory(), read every perception
+    
+    // Cold: rendering, snapshots and brain dispatch
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<Vec2> moveTargets;
+    std::vector<Color> colors;
+    std::vector<BrainKind> brainKinds;
+    std::vector<int> decisionIntervals;  // brains[i]->decisionInterval()
+    std::vector<uint8_t> decisionTriggers;
+    std::vector<PerceivedTiles> perceivedTiles;  // Written by gatherPerception()
+    std::vector<std::unique_ptr<IBrain>> brains;
+};
+
+// One NPC in an NPCStore. Cheap to copy; a const handle only reads.
+class NPC {
+public:
+    NPC(NPCStore* store, uint32_t index) : store(store), index(index) {}
+    
+    uint32_t getIndex() const { return index; }
+    EntityId getId() const { return store->ids[index]; }
+    Vec2 getPosition() const { return store->position(index); }
+    Needs getNeeds() const { return store->needs(index); }
+    Mood getMood() const { return store->moods[index]; }
+    Color getColor() const { return store->colors[index]; }
+    const Action& getCurrentAction() const { return store->actions[index]; }
+    
+    void setBrain(std::unique_ptr<IBrain> newBrain);
+    IBrain* getBrain() { return store->brains[index].get(); }
+    const IBrain* getBrain() const { return store->brains[index].get(); }
     
-    std::unique_ptr<IBrain> brain;
-    Action currentAction;
-    Vec2 moveTarget;
+    // Brain type identification, cached by setBrain() so hot loops skip the virtual call
+    BrainKind getBrainKind() const { return store->brainKinds[index]; }
+    bool isNeuralBrain() const { return getBrainKind() == BrainKind::Neural; }
     
-    void updateNeeds(float dt);
-    void updateMood();
-    void executeAction(float dt, World& world);
-    void moveTowards(Vec2 target, float dt);
+    // Nearby NPCs come from the world's entity index (see EntityIndex). The
+    // tile window is cached per NPC (see PerceivedTiles); everything else is
+    // read fresh. Refreshing the cache is the only write, so different NPCs
+    // can perceive in parallel.
+    Perception gatherPerception(const World& world, Tick tick) const;
+    
+    // NPC and brain state. Reading needs a brain of the kind that was written.
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
+
+private:
+    NPCStore* store;
+    uint32_t index;
 };
 
+inline NPC NPCStore::operator[](size_t index) {
+    return NPC(this, static_cast<uint32_t>(index));
+}
+
+inline const NPC NPCStore::operator[](size_t index) const {
+    return NPC(const_cast<NPCStore*>(this), static_cast<uint32_t>(index));
+}
+
 } // namespace pw
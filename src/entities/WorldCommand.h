@@ -0,0 +1,24 @@
+#pragma once
+
+#include "engine/Types.h"
+#include <vector>
+
+namespace pw {
+
+// World mutation requested by an NPC during the parallel update. Commands are
+// collected per worker and applied serially in NPC order, so the result does
+// not depend on how NPCs were split across threads.
+struct WorldCommand {
+    enum class Type : uint8_t {
+        ConsumeFood
+    };
+    
+    Type type = Type::ConsumeFood;
+    uint32_t npc = 0;  // Index in the NPCStore
+    int x = 0;
+    int y = 0;
+};
+
+using WorldCommandBuffer = std::vector<WorldCommand>;
+
+} // namespace pw
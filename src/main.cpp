@@ -1,30 +1,209 @@
 #include "engine/GameEngine.h"
+#include "engine/MultiWorldRunner.h"
+#include "engine/SimulationConfig.h"
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+namespace {
+
+struct RunOptions {
+    bool headless = false;
+    int headlessTicks = 10000;
+    int worlds = 0;            // > 0 runs that many headless worlds in one process
+    int concurrentWorlds = 0;  // 0 = one per core
+};
+
+// Applies --config and then every other flag to simulation. Returns false,
+// after printing why, if a value is invalid.
+bool configure(pw::Simulation& simulation, int argc, char* argv[], RunOptions& options) {
+    pw::LogQueueSettings logQueue;
+    
+    // A config file is applied first, whatever its position, so flags override it
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && !pw::loadSimulationConfig(argv[++i], simulation)) {
+            return false;
+        }
+    }
+    pw::LogFilterSettings logFilter = simulation.getLogFilter();
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            ++i;  // Already applied
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            // An optional tick count follows
+            options.headless = true;
+            if (i + 1 < argc) {
+                char* end = nullptr;
+                const long ticks = std::strtol(argv[i + 1], &end, 10);
+                if (end != argv[i + 1] && *end == '\0') {
+                    options.headlessTicks = static_cast<int>(std::max(0L, ticks));
+                    ++i;
+                }
+            }
+        } else if (strcmp(argv[i], "--worlds") == 0 && i + 1 < argc) {
+            // Independent headless worlds with consecutive seeds, one log shard each
+            options.worlds = std::max(0, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--concurrent-worlds") == 0 && i + 1 < argc) {
+            options.concurrentWorlds = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            // 0 = one thread per core
+            simulation.setThreadCount(std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            simulation.setSeed(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (strcmp(argv[i], "--world-seed") == 0 && i + 1 < argc) {
+            simulation.setWorldSeed(static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (strcmp(argv[i], "--npcs") == 0 && i + 1 < argc) {
+            simulation.setNPCCount(std::max(0, std::atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--neural-fraction") == 0 && i + 1 < argc) {
+            // Share of NPCs with a neural brain; the rest use behavior trees
+            simulation.setNeuralFraction(static_cast<float>(std::atof(argv[++i])));
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            simulation.setModelPath(argv[++i]);
+        } else if (strcmp(argv[i], "--inference") == 0 && i + 1 < argc) {
+            pw::InferenceSettings settings = simulation.getInferenceSettings();
+            if (!pw::parseInferenceBackend(argv[++i], settings.backend)) {
+                std::cerr << "Unknown inference backend '" << argv[i] << "' (expected auto, onnx or native)" << std::endl;
+                return false;
+            }
+            simulation.setInferenceSettings(settings);
+        } else if (strcmp(argv[i], "--weight-precision") == 0 && i + 1 < argc) {
+            // Storage of native model weights
+            pw::InferenceSettings settings = simulation.getInferenceSettings();
+            if (!pw::parseWeightPrecision(argv[++i], settings.weightPrecision)) {
+                std::cerr << "Unknown weight precision '" << argv[i] << "' (expected fp32, fp16 or int8)" << std::endl;
+                return false;
+            }
+            simulation.setInferenceSettings(settings);
+        } else if (strcmp(argv[i], "--intra-op-threads") == 0 && i + 1 < argc) {
+            // ONNX Runtime session threads; 0 lets ONNX Runtime pick
+            pw::InferenceSettings settings = simulation.getInferenceSettings();
+            settings.intraOpThreads = std::max(0, std::atoi(argv[++i]));
+            simulation.setInferenceSettings(settings);
+        } else if (strcmp(argv[i], "--inter-op-threads") == 0 && i + 1 < argc) {
+            pw::InferenceSettings settings = simulation.getInferenceSettings();
+            settings.interOpThreads = std::max(0, std::atoi(argv[++i]));
+            simulation.setInferenceSettings(settings);
+        } else if (strcmp(argv[i], "--graph-optimization") == 0 && i + 1 < argc) {
+            pw::InferenceSettings settings = simulation.getInferenceSettings();
+            if (!pw::parseGraphOptimization(argv[++i], settings.graphOptimization)) {
+                std::cerr << "Unknown graph optimization '" << argv[i]
+                          << "' (expected disabled, basic, extended or all)" << std::endl;
+                return false;
+            }
+            simulation.setInferenceSettings(settings);
+        } else if (strcmp(argv[i], "--inference-latency") == 0 && i + 1 < argc) {
+            // Run inference on its own thread; results decide N ticks later
+            simulation.setInferenceLatency(std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--model-reload-interval") == 0 && i + 1 < argc) {
+            // Hot-reload the model file every N ticks if it has changed
+            simulation.setModelReloadInterval(std::strtoull(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--observation-stream") == 0 && i + 1 < argc) {
+            // Shared-memory ring of neural decisions for an online trainer
+            simulation.setObservationStream(argv[++i]);
+        } else if (strcmp(argv[i], "--observation-capacity") == 0 && i + 1 < argc) {
+            simulation.setObservationCapacity(std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10)));
+        } else if (strcmp(argv[i], "--ai-lod") == 0) {
+            // Re-decide every few ticks instead of every tick
+            simulation.setAILevelOfDetail(true);
+        } else if (strcmp(argv[i], "--decision-log-interval") == 0 && i + 1 < argc) {
+            // Log decisions every N ticks
+            simulation.setDecisionLogInterval(std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--log-sampling") == 0 && i + 1 < argc) {
+            // Log about 1 in N of each NPC's decisions
+            logFilter.decisionSampling = std::max(1, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--log-action-changes") == 0) {
+            logFilter.actionChanges = true;
+        } else if (strcmp(argv[i], "--log-min-need-delta") == 0 && i + 1 < argc) {
+            logFilter.minNeedDelta = static_cast<float>(std::atof(argv[++i]));
+        } else if (strcmp(argv[i], "--meeting-log-cooldown") == 0 && i + 1 < argc) {
+            // Ticks before the same pair's meeting is logged again
+            logFilter.meetingCooldown = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--log-dir") == 0 && i + 1 < argc) {
+            simulation.setLogDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--log-format") == 0 && i + 1 < argc) {
+            pw::LogFormat format;
+            if (pw::DataLogger::parseLogFormat(argv[++i], format)) {
+                simulation.setLogFormat(format);
+            } else {
+                std::cerr << "Unknown log format '" << argv[i] << "' (expected jsonl or binary)" << std::endl;
+                return false;
+            }
+        } else if (strcmp(argv[i], "--world-size") == 0 && i + 1 < argc) {
+            int width = 0;
+            int height = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "Invalid world size '" << argv[i] << "' (expected WIDTHxHEIGHT)" << std::endl;
+                return false;
+            }
+            simulation.setWorldSize(width, height);
+        } else if (strcmp(argv[i], "--chunk-pages") == 0 && i + 1 < argc) {
+            // Edited chunks evicted far from every NPC are written here
+            simulation.setChunkPageDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--terrain-cache") == 0 && i + 1 < argc) {
+            simulation.setTerrainCacheDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--load-snapshot") == 0 && i + 1 < argc) {
+            simulation.setLoadSnapshot(argv[++i]);
+        } else if (strcmp(argv[i], "--save-snapshot") == 0 && i + 1 < argc) {
+            simulation.setSaveSnapshot(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            // Chrome trace / Perfetto JSON of per-subsystem timing zones
+            simulation.setProfilePath(argv[++i]);
+        } else if (strcmp(argv[i], "--export-brain-json") == 0 && i + 1 < argc) {
+            simulation.setBrainJsonDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--log-queue") == 0 && i + 1 < argc) {
+            // Records buffered for the log I/O thread; 0 writes synchronously
+            logQueue.capacity = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--log-policy") == 0 && i + 1 < argc) {
+            if (!pw::AsyncLogWriter::parsePolicy(argv[++i], logQueue.policy)) {
+                std::cerr << "Unknown log policy '" << argv[i] << "' (expected block, drop or sample)" << std::endl;
+                return false;
+            }
+        } else {
+            // Also reached by a known option missing its value
+            std::cerr << "Unknown option '" << argv[i] << "'" << (i + 1 == argc ? " or missing value" : "")
+                      << std::endl;
+            return false;
+        }
+    }
+    
+    simulation.setLogQueue(logQueue);
+    simulation.setLogFilter(logFilter);
+    return true;
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
     std::cout << "=== Pixel World Simulator - Milestone 2 ===" << std::endl;
     std::cout << "The Awakening" << std::endl;
     std::cout << std::endl;
     
     pw::GameEngine engine;
+    pw::Simulation& simulation = engine.getSimulation();
     
-    // Check for headless mode
-    bool headless = false;
-    int headlessTicks = 10000;
+    RunOptions options;
+    if (!configure(simulation, argc, argv, options)) {
+        return 1;
+    }
     
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--headless") == 0) {
-            headless = true;
-            if (i + 1 < argc) {
-                headlessTicks = std::atoi(argv[i + 1]);
-            }
-        }
+    if (options.worlds > 0) {
+        // Every world reads the same flags; the runner then gives it its seeds and shard
+        pw::MultiWorldRunner runner(options.worlds, options.concurrentWorlds);
+        bool ok = runner.run(options.headlessTicks, [&](pw::Simulation& world, int) {
+            RunOptions ignored;
+            return configure(world, argc, argv, ignored);
+        });
+        std::cout << "Simulation complete. Check " << simulation.getLogDirectory()
+                  << "/world_*/ for training data." << std::endl;
+        return ok ? 0 : 1;
     }
     
-    if (headless) {
-        std::cout << "Running in headless mode for " << headlessTicks << " ticks..." << std::endl;
-        engine.runHeadless(headlessTicks);
+    if (options.headless) {
+        std::cout << "Running in headless mode for " << options.headlessTicks << " ticks..." << std::endl;
+        engine.runHeadless(options.headlessTicks);
     } else {
         std::cout << "Starting visual simulation..." << std::endl;
         std::cout << "Controls:" << std::endl;
@@ -35,7 +214,7 @@ int main(int argc, char* argv[]) {
         engine.run();
     }
     
-    std::cout << "Simulation complete. Check data_logs/ for training data." << std::endl;
+    std::cout << "Simulation complete. Check " << simulation.getLogDirectory() << "/ for training data." << std::endl;
     
     return 0;
 }
@@ -12,7 +12,7 @@ DebugOverlay::DebugOverlay(Renderer& renderer) : renderer(renderer) {
 
 void DebugOverlay::renderNPCDebug(const NPC& npc, int screenX, int screenY) {
     // Panel background
-    renderer.drawRect(Rect{screenX, screenY, 400, 600}, Color{0, 0, 0, 200}, true);
+    renderer.queueRect(Rect{screenX, screenY, 400, 600}, Color{0, 0, 0, 200});
     
     int yOffset = screenY + 10;
     const int lineHeight = 15;
@@ -35,7 +35,7 @@ void DebugOverlay::renderNPCDebug(const NPC& npc, int screenX, int screenY) {
     yOffset += lineHeight;
     
     // Needs
-    const Needs& needs = npc.getNeeds();
+    const Needs needs = npc.getNeeds();
     drawText("=== NEEDS ===", panelX, yOffset, {150, 255, 150});
     yOffset += lineHeight;
     
@@ -55,7 +55,7 @@ void DebugOverlay::renderNPCDebug(const NPC& npc, int screenX, int screenY) {
     
     // Neural brain specific
     if (npc.isNeuralBrain()) {
-        auto* neuralBrain = dynamic_cast<const NeuralBrain*>(npc.getBrain());
+        auto* neuralBrain = static_cast<const NeuralBrain*>(npc.getBrain());
         if (neuralBrain) {
             // Emotional state
             drawText("=== EMOTION ===", panelX, yOffset, {255, 150, 255});
@@ -84,7 +84,8 @@ void DebugOverlay::renderNPCDebug(const NPC& npc, int screenX, int screenY) {
             }
             
             // Social relationships
-            const auto& relationships = neuralBrain->getSocialIntelligence().getAllRelationships();
+            const std::vector<RelationshipEmbedding> relationships =
+                neuralBrain->getSocialIntelligence().getAllRelationships();
             if (!relationships.empty()) {
                 drawText("=== SOCIAL ===", panelX, yOffset, {150, 255, 200});
                 yOffset += lineHeight;
@@ -106,38 +107,39 @@ void DebugOverlay::renderPerceptionVector(const std::vector<float>& perception,
         int barHeight = static_cast<int>(perception[i] * height);
         
         Color barColor = {100, 150, 255};
-        renderer.drawRect(Rect{barX, y + height - barHeight, barWidth - 1, barHeight},
-                         barColor, true);
+        renderer.queueRect(Rect{barX, y + height - barHeight, barWidth - 1, barHeight},
+                           barColor);
     }
 }
 
-void DebugOverlay::renderMemoryActivations(const std::vector<EpisodicMemory>& memories,
+void DebugOverlay::renderMemoryActivations(const EpisodicBuffer& memories,
                                           int x, int y, int width, int height, int maxShow) {
     // Sort by attention weight
-    std::vector<const EpisodicMemory*> sorted;
-    for (const auto& mem : memories) {
-        sorted.push_back(&mem);
+    std::vector<size_t> sorted(memories.size());
+    for (size_t slot = 0; slot < sorted.size(); ++slot) {
+        sorted[slot] = slot;
     }
     std::sort(sorted.begin(), sorted.end(),
-              [](const EpisodicMemory* a, const EpisodicMemory* b) {
-                  return a->attentionWeight > b->attentionWeight;
+              [&](size_t a, size_t b) {
+                  return memories.attention(a) > memories.attention(b);
               });
     
     // Show top memories
     int lineHeight = height / std::max(1, maxShow);
     for (int i = 0; i < std::min(maxShow, static_cast<int>(sorted.size())); ++i) {
-        const auto* mem = sorted[i];
+        size_t slot = sorted[i];
+        float attention = memories.attention(slot);
         int yPos = y + i * lineHeight;
         
         // Draw attention weight bar
-        int barWidth = static_cast<int>(mem->attentionWeight * width);
+        int barWidth = static_cast<int>(attention * width);
         Color memColor = {150, 100, 255};
-        renderer.drawRect(Rect{x, yPos, barWidth, lineHeight - 2}, memColor, true);
+        renderer.queueRect(Rect{x, yPos, barWidth, lineHeight - 2}, memColor);
         
         // Draw memory type
         std::stringstream ss;
-        ss << mem->memory.type << " " << std::fixed << std::setprecision(2) 
-           << mem->attentionWeight;
+        ss << memoryTypeName(memories.type(slot)) << " " << std::fixed << std::setprecision(2) 
+           << attention;
         drawText(ss.str(), x + 5, yPos + 2, {255, 255, 255});
     }
 }
@@ -183,7 +185,7 @@ void DebugOverlay::renderActionProbabilities(const std::vector<float>& probs,
             barColor = {255, 200, 100};
         }
         
-        renderer.drawRect(Rect{x, yPos, barWidth, barHeight - 2}, barColor, true);
+        renderer.queueRect(Rect{x, yPos, barWidth, barHeight - 2}, barColor);
         
         // Draw action name and percentage
         std::stringstream ss;
@@ -194,13 +196,13 @@ void DebugOverlay::renderActionProbabilities(const std::vector<float>& probs,
 }
 
 void DebugOverlay::renderSocialEmbeddings(
-    const std::map<EntityId, RelationshipEmbedding>& relationships,
+    const std::vector<RelationshipEmbedding>& relationships,
     int x, int y, int width, int height, int maxShow) {
     
     // Sort by affinity
     std::vector<std::pair<EntityId, const RelationshipEmbedding*>> sorted;
-    for (const auto& [id, rel] : relationships) {
-        sorted.push_back({id, &rel});
+    for (const RelationshipEmbedding& rel : relationships) {
+        sorted.push_back({rel.npcId, &rel});
     }
     std::sort(sorted.begin(), sorted.end(),
               [](const auto& a, const auto& b) {
@@ -217,7 +219,7 @@ void DebugOverlay::renderSocialEmbeddings(
         Color relColor = rel->affinity > 0 ? Color{100, 255, 100} : Color{255, 100, 100};
         
         int barWidth = static_cast<int>(affinityNorm * width);
-        renderer.drawRect(Rect{x, yPos, barWidth, lineHeight - 2}, relColor, true);
+        renderer.queueRect(Rect{x, yPos, barWidth, lineHeight - 2}, relColor);
         
         // Draw NPC ID and metrics
         std::stringstream ss;
@@ -227,6 +229,28 @@ void DebugOverlay::renderSocialEmbeddings(
     }
 }
 
+void DebugOverlay::renderProfile(const std::vector<Profiler::ZoneStats>& zones,
+                                 int x, int y, int width, int maxShow) {
+    static constexpr float FRAME_BUDGET_MS = 1000.0f / 60.0f;
+    static constexpr int ROW_HEIGHT = 12;  // Fits a text line
+    
+    int rows = std::min(static_cast<int>(zones.size()), maxShow);
+    renderer.queueRect(Rect{x - 2, y - 2, width + 4, rows * ROW_HEIGHT + 3}, Color{0, 0, 0, 180});
+    
+    for (int i = 0; i < rows; i++) {
+        const Profiler::ZoneStats& zone = zones[i];
+        int yPos = y + i * ROW_HEIGHT;
+        float p50 = std::min(1.0f, static_cast<float>(zone.p50Ms) / FRAME_BUDGET_MS);
+        float p99 = std::min(1.0f, static_cast<float>(zone.p99Ms) / FRAME_BUDGET_MS);
+        
+        // Green while the zone fits in a tenth of the frame, red once it takes half
+        Color barColor = p99 > 0.5f ? Color{220, 60, 60} : (p99 > 0.1f ? Color{220, 200, 60} : Color{80, 200, 80});
+        drawBar(x, yPos + 3, width, 5, p50, barColor);
+        renderer.queueRect(Rect{x + static_cast<int>(p99 * (width - 1)), yPos + 1, 1, 9}, Color{255, 255, 255});
+        drawText(zone.name, x + width + 4, yPos + 1, {200, 200, 200});
+    }
+}
+
 void DebugOverlay::drawText(const std::string& text, int x, int y, const Color& color) {
     // TODO: Actual text rendering requires SDL_ttf or bitmap font system
     // This is a placeholder showing where text would be rendered
@@ -242,11 +266,11 @@ void DebugOverlay::drawText(const std::string& text, int x, int y, const Color&
 void DebugOverlay::drawBar(int x, int y, int width, int height, float value,
                           const Color& color, const Color& bgColor) {
     // Background
-    renderer.drawRect(Rect{x, y, width, height}, bgColor, true);
+    renderer.queueRect(Rect{x, y, width, height}, bgColor);
     
     // Foreground (value bar)
     int filledWidth = static_cast<int>(value * width);
-    renderer.drawRect(Rect{x, y, filledWidth, height}, color, true);
+    renderer.queueRect(Rect{x, y, filledWidth, height}, color);
     
     // Border
     renderer.drawRect(Rect{x, y, width, height}, {200, 200, 200}, false);
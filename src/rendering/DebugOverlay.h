@@ -4,9 +4,9 @@
 #include "entities/NPC.h"
 #include "ai/neural/NeuralBrain.h"
 #include "ai/social/SocialIntelligence.h"
+#include "engine/Profiler.h"
 #include <vector>
 #include <string>
-#include <map>
 
 namespace pw {
 
@@ -21,7 +21,7 @@ public:
     void renderPerceptionVector(const std::vector<float>& perception, 
                                 int x, int y, int width, int height);
     
-    void renderMemoryActivations(const std::vector<EpisodicMemory>& memories,
+    void renderMemoryActivations(const EpisodicBuffer& memories,
                                  int x, int y, int width, int height, int maxShow = 5);
     
     void renderEmotionalState(const EmotionalState& emotion,
@@ -30,9 +30,14 @@ public:
     void renderActionProbabilities(const std::vector<float>& probs,
                                    int x, int y, int width, int height);
     
-    void renderSocialEmbeddings(const std::map<EntityId, RelationshipEmbedding>& relationships,
+    void renderSocialEmbeddings(const std::vector<RelationshipEmbedding>& relationships,
                                int x, int y, int width, int height, int maxShow = 5);
     
+    // Profiler zones, worst p99 first: bar length is p50, the tick marks p99;
+    // full width is one 60 FPS frame
+    void renderProfile(const std::vector<Profiler::ZoneStats>& zones,
+                       int x, int y, int width, int maxShow = 8);
+    
     // Text rendering helper
     void drawText(const std::string& text, int x, int y, const Color& color = {255, 255, 255});
     
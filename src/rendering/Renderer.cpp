@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include <array>
 #include <cmath>
 
 namespace pw {
@@ -10,6 +11,7 @@ void Renderer::setDrawColor(const Color& color) {
 }
 
 void Renderer::drawRect(const Rect& rect, const Color& color, bool filled) {
+    flush();
     SDL_Rect sdlRect = {rect.x, rect.y, rect.w, rect.h};
     setDrawColor(color);
     
@@ -21,44 +23,123 @@ void Renderer::drawRect(const Rect& rect, const Color& color, bool filled) {
 }
 
 void Renderer::drawCircle(int centerX, int centerY, int radius, const Color& color, bool filled) {
-    setDrawColor(color);
-    
     if (filled) {
-        for (int y = -radius; y <= radius; y++) {
-            for (int x = -radius; x <= radius; x++) {
-                if (x * x + y * y <= radius * radius) {
-                    SDL_RenderDrawPoint(renderer, centerX + x, centerY + y);
-                }
-            }
-        }
-    } else {
-        int x = radius;
-        int y = 0;
-        int err = 0;
+        // Same footprint as the x^2 + y^2 <= r^2 pixel disk around the center pixel
+        queueCircle(centerX + 0.5f, centerY + 0.5f, radius + 0.5f, color);
+        flush();
+        return;
+    }
+    
+    flush();
+    points.clear();
+    int x = radius;
+    int y = 0;
+    int err = 0;
+    
+    while (x >= y) {
+        points.push_back({centerX + x, centerY + y});
+        points.push_back({centerX + y, centerY + x});
+        points.push_back({centerX - y, centerY + x});
+        points.push_back({centerX - x, centerY + y});
+        points.push_back({centerX - x, centerY - y});
+        points.push_back({centerX - y, centerY - x});
+        points.push_back({centerX + y, centerY - x});
+        points.push_back({centerX + x, centerY - y});
         
-        while (x >= y) {
-            SDL_RenderDrawPoint(renderer, centerX + x, centerY + y);
-            SDL_RenderDrawPoint(renderer, centerX + y, centerY + x);
-            SDL_RenderDrawPoint(renderer, centerX - y, centerY + x);
-            SDL_RenderDrawPoint(renderer, centerX - x, centerY + y);
-            SDL_RenderDrawPoint(renderer, centerX - x, centerY - y);
-            SDL_RenderDrawPoint(renderer, centerX - y, centerY - x);
-            SDL_RenderDrawPoint(renderer, centerX + y, centerY - x);
-            SDL_RenderDrawPoint(renderer, centerX + x, centerY - y);
-            
-            y++;
-            err += 1 + 2 * y;
-            if (2 * (err - x) + 1 > 0) {
-                x--;
-                err += 1 - 2 * x;
-            }
+        y++;
+        err += 1 + 2 * y;
+        if (2 * (err - x) + 1 > 0) {
+            x--;
+            err += 1 - 2 * x;
         }
     }
+    
+    setDrawColor(color);
+    SDL_RenderDrawPoints(renderer, points.data(), static_cast<int>(points.size()));
 }
 
 void Renderer::drawLine(int x1, int y1, int x2, int y2, const Color& color) {
+    flush();
     setDrawColor(color);
     SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
 }
 
+int Renderer::addVertex(float x, float y, const Color& color) {
+    SDL_Vertex vertex;
+    vertex.position = {x, y};
+    vertex.color = {color.r, color.g, color.b, color.a};
+    vertex.tex_coord = {0.0f, 0.0f};
+    vertices.push_back(vertex);
+    return static_cast<int>(vertices.size()) - 1;
+}
+
+void Renderer::queueRect(const Rect& rect, const Color& color) {
+    const float left = static_cast<float>(rect.x);
+    const float top = static_cast<float>(rect.y);
+    const float right = static_cast<float>(rect.x + rect.w);
+    const float bottom = static_cast<float>(rect.y + rect.h);
+    
+    int a = addVertex(left, top, color);
+    int b = addVertex(right, top, color);
+    int c = addVertex(right, bottom, color);
+    int d = addVertex(left, bottom, color);
+    indices.insert(indices.end(), {a, b, c, a, c, d});
+}
+
+void Renderer::queueCircle(float centerX, float centerY, float radius, const Color& color) {
+    // Unit circle, computed once
+    static const auto directions = [] {
+        std::array<Vec2, CIRCLE_SEGMENTS> table;
+        for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+            float angle = 2.0f * 3.14159265f * i / CIRCLE_SEGMENTS;
+            table[i] = Vec2(std::cos(angle), std::sin(angle));
+        }
+        return table;
+    }();
+    
+    int center = addVertex(centerX, centerY, color);
+    for (const Vec2& direction : directions) {
+        addVertex(centerX + direction.x * radius, centerY + direction.y * radius, color);
+    }
+    for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+        indices.insert(indices.end(), {center, center + 1 + i, center + 1 + (i + 1) % CIRCLE_SEGMENTS});
+    }
+}
+
+void Renderer::queueLine(float x1, float y1, float x2, float y2, const Color& color) {
+    // A one pixel wide quad through the pixel centers, covering both end pixels
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length < 1e-3f) {
+        dx = 1.0f;
+        dy = 0.0f;
+    } else {
+        dx /= length;
+        dy /= length;
+    }
+    const float alongX = dx * 0.5f;
+    const float alongY = dy * 0.5f;
+    const float acrossX = -dy * 0.5f;
+    const float acrossY = dx * 0.5f;
+    const float startX = x1 + 0.5f - alongX;
+    const float startY = y1 + 0.5f - alongY;
+    const float endX = x2 + 0.5f + alongX;
+    const float endY = y2 + 0.5f + alongY;
+    
+    int a = addVertex(startX + acrossX, startY + acrossY, color);
+    int b = addVertex(endX + acrossX, endY + acrossY, color);
+    int c = addVertex(endX - acrossX, endY - acrossY, color);
+    int d = addVertex(startX - acrossX, startY - acrossY, color);
+    indices.insert(indices.end(), {a, b, c, a, c, d});
+}
+
+void Renderer::flush() {
+    if (indices.empty()) return;
+    SDL_RenderGeometry(renderer, nullptr, vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+    vertices.clear();
+    indices.clear();
+}
+
 } // namespace pw
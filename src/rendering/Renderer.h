@@ -2,6 +2,7 @@
 
 #include "engine/Math.h"
 #include <SDL2/SDL.h>
+#include <vector>
 
 namespace pw {
 
@@ -13,11 +14,28 @@ public:
     void drawCircle(int centerX, int centerY, int radius, const Color& color, bool filled = true);
     void drawLine(int x1, int y1, int x2, int y2, const Color& color);
     
+    // Batched primitives. Queued shapes are turned into colored triangles and
+    // submitted with a single SDL_RenderGeometry call on flush(), in the order
+    // they were queued, so a frame of sprites is one draw call. A circle is
+    // always CIRCLE_SEGMENTS triangles whatever its radius. The immediate
+    // draw calls above flush first, so mixing the two keeps painter's order.
+    void queueRect(const Rect& rect, const Color& color);
+    void queueCircle(float centerX, float centerY, float radius, const Color& color);
+    void queueLine(float x1, float y1, float x2, float y2, const Color& color);
+    void flush();
+    
     void setDrawColor(const Color& color);
     SDL_Renderer* getSDLRenderer() { return renderer; }
 
 private:
+    static constexpr int CIRCLE_SEGMENTS = 16;
+    
+    int addVertex(float x, float y, const Color& color);
+    
     SDL_Renderer* renderer;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    std::vector<SDL_Point> points;  // Outline circle scratch
 };
 
 } // namespace pw
@@ -0,0 +1,125 @@
+#include "TileMapRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace pw {
+
+TileMapRenderer::TileMapRenderer(Renderer& renderer)
+    : renderer(renderer), pixels(TileChunk::TILE_COUNT) {}
+
+TileMapRenderer::~TileMapRenderer() {
+    for (ChunkTexture& entry : chunks) {
+        release(entry);
+    }
+}
+
+void TileMapRenderer::render(const World& world, const Camera& camera) {
+    // A different world invalidates every texture
+    if (chunks.size() != world.totalChunks() || chunkColumns != world.chunkColumns()) {
+        for (ChunkTexture& entry : chunks) {
+            release(entry);
+        }
+        chunks.assign(world.totalChunks(), ChunkTexture{});
+        chunkColumns = world.chunkColumns();
+    }
+    frame++;
+    
+    // The camera position is in pixels (see Camera::worldToScreen); cull in tiles
+    Vec2 camTile(camera.getPosition().x / TILE_SIZE, camera.getPosition().y / TILE_SIZE);
+    float zoom = camera.getZoom();
+    
+    int startX = std::max(0, static_cast<int>(std::floor(camTile.x - VIRTUAL_WIDTH / (2.0f * zoom * TILE_SIZE))));
+    int endX = std::min(world.getWidth(), static_cast<int>(camTile.x + VIRTUAL_WIDTH / (2.0f * zoom * TILE_SIZE)) + 1);
+    int startY = std::max(0, static_cast<int>(std::floor(camTile.y - VIRTUAL_HEIGHT / (2.0f * zoom * TILE_SIZE))));
+    int endY = std::min(world.getHeight(), static_cast<int>(camTile.y + VIRTUAL_HEIGHT / (2.0f * zoom * TILE_SIZE)) + 1);
+    if (startX >= endX || startY >= endY) {
+        releaseIdle();
+        return;
+    }
+    
+    // Textures hold untinted colors; the tint is a multiply at copy time
+    Color mod = Color(255, 255, 255).withTint(world.getDayNightTint(), TINT_STRENGTH);
+    SDL_Renderer* sdlRenderer = renderer.getSDLRenderer();
+    renderer.flush();  // Anything queued belongs underneath
+    
+    for (int cy = startY >> TileChunk::SHIFT; cy <= (endY - 1) >> TileChunk::SHIFT; cy++) {
+        for (int cx = startX >> TileChunk::SHIFT; cx <= (endX - 1) >> TileChunk::SHIFT; cx++) {
+            const int chunkIndex = cy * chunkColumns + cx;
+            ChunkTexture& entry = chunks[chunkIndex];
+            if (!entry.texture || entry.revision != world.chunkRevision(chunkIndex)) {
+                if (!bake(world, chunkIndex, entry)) continue;
+            }
+            entry.lastDrawn = frame;
+            
+            // Edge chunks only cover the part of the map that exists
+            const int originX = cx << TileChunk::SHIFT;
+            const int originY = cy << TileChunk::SHIFT;
+            const int tilesW = std::min(TileChunk::CHUNK_SIZE, world.getWidth() - originX);
+            const int tilesH = std::min(TileChunk::CHUNK_SIZE, world.getHeight() - originY);
+            
+            // Both corners are projected so neighbouring chunks meet without seams
+            Vec2 topLeft = camera.worldToScreen(Vec2(originX * TILE_SIZE, originY * TILE_SIZE));
+            Vec2 bottomRight = camera.worldToScreen(
+                Vec2((originX + tilesW) * TILE_SIZE, (originY + tilesH) * TILE_SIZE));
+            SDL_Rect source = {0, 0, tilesW, tilesH};
+            SDL_Rect dest = {
+                static_cast<int>(topLeft.x),
+                static_cast<int>(topLeft.y),
+                static_cast<int>(bottomRight.x) - static_cast<int>(topLeft.x),
+                static_cast<int>(bottomRight.y) - static_cast<int>(topLeft.y)
+            };
+            
+            SDL_SetTextureColorMod(entry.texture, mod.r, mod.g, mod.b);
+            SDL_RenderCopy(sdlRenderer, entry.texture, &source, &dest);
+        }
+    }
+    
+    releaseIdle();
+}
+
+bool TileMapRenderer::bake(const World& world, int chunkIndex, ChunkTexture& entry) {
+    if (!entry.texture) {
+        entry.texture = SDL_CreateTexture(renderer.getSDLRenderer(), SDL_PIXELFORMAT_RGBA8888,
+                                          SDL_TEXTUREACCESS_STATIC,
+                                          TileChunk::CHUNK_SIZE, TileChunk::CHUNK_SIZE);
+        if (!entry.texture) {
+            std::cerr << "Warning: Could not create chunk texture: " << SDL_GetError() << std::endl;
+            return false;
+        }
+    }
+    
+    // Cells past the map edge read as out-of-bounds grass and are never copied
+    const int originX = (chunkIndex % chunkColumns) << TileChunk::SHIFT;
+    const int originY = (chunkIndex / chunkColumns) << TileChunk::SHIFT;
+    for (int y = 0; y < TileChunk::CHUNK_SIZE; y++) {
+        for (int x = 0; x < TileChunk::CHUNK_SIZE; x++) {
+            Color color = world.getTile(originX + x, originY + y).getColor();
+            pixels[y * TileChunk::CHUNK_SIZE + x] = (static_cast<uint32_t>(color.r) << 24) |
+                                                    (static_cast<uint32_t>(color.g) << 16) |
+                                                    (static_cast<uint32_t>(color.b) << 8) |
+                                                    color.a;
+        }
+    }
+    
+    SDL_UpdateTexture(entry.texture, nullptr, pixels.data(),
+                      TileChunk::CHUNK_SIZE * static_cast<int>(sizeof(uint32_t)));
+    entry.revision = world.chunkRevision(chunkIndex);
+    return true;
+}
+
+void TileMapRenderer::release(ChunkTexture& entry) {
+    if (!entry.texture) return;
+    SDL_DestroyTexture(entry.texture);
+    entry.texture = nullptr;
+}
+
+void TileMapRenderer::releaseIdle() {
+    for (ChunkTexture& entry : chunks) {
+        if (entry.texture && frame - entry.lastDrawn > IDLE_FRAMES) {
+            release(entry);
+        }
+    }
+}
+
+} // namespace pw
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "rendering/Renderer.h"
+#include "rendering/Camera.h"
+#include "world/World.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+namespace pw {
+
+// Draws the tile map one chunk at a time. Each visible chunk is baked into a
+// small texture (one texel per tile) that is stretched to screen size, so a
+// frame costs one copy per chunk instead of one fill per tile. A chunk is
+// re-baked only when its World::chunkRevision() moves on, and the day/night
+// tint is applied as a texture color mod. Textures not drawn for
+// IDLE_FRAMES frames are released.
+class TileMapRenderer {
+public:
+    explicit TileMapRenderer(Renderer& renderer);
+    ~TileMapRenderer();
+    
+    TileMapRenderer(const TileMapRenderer&) = delete;
+    TileMapRenderer& operator=(const TileMapRenderer&) = delete;
+    
+    void render(const World& world, const Camera& camera);
+
+private:
+    static constexpr uint32_t IDLE_FRAMES = 600;
+    static constexpr float TINT_STRENGTH = 0.3f;
+    
+    struct ChunkTexture {
+        SDL_Texture* texture = nullptr;
+        uint32_t revision = 0;
+        uint32_t lastDrawn = 0;
+    };
+    
+    bool bake(const World& world, int chunkIndex, ChunkTexture& entry);
+    void release(ChunkTexture& entry);
+    void releaseIdle();
+    
+    Renderer& renderer;
+    std::vector<ChunkTexture> chunks;  // One per world chunk
+    std::vector<uint32_t> pixels;      // Bake scratch
+    int chunkColumns = 0;
+    uint32_t frame = 0;
+};
+
+} // namespace pw
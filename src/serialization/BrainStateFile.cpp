@@ -0,0 +1,108 @@
+#include "BrainStateFile.h"
+#include "Snapshot.h"
+#include "ai/neural/NeuralBrain.h"
+#include <atomic>
+#include <iostream>
+#include <unordered_map>
+
+namespace pw {
+
+namespace {
+
+struct FileHeader {
+    uint32_t magic = BrainStateFile::MAGIC;
+    uint32_t version = BrainStateFile::VERSION;
+    uint64_t count = 0;
+};
+
+struct IndexEntry {
+    EntityId id = 0;
+    uint32_t reserved = 0;
+    uint64_t offset = 0;  // From the start of the file
+    uint64_t size = 0;
+};
+
+static_assert(sizeof(FileHeader) == 16 && sizeof(IndexEntry) == 24, "brain state layout is fixed");
+
+constexpr uint64_t MAX_RECORDS = 1u << 24;
+
+} // namespace
+
+bool BrainStateFile::save(const std::string& path, const std::vector<Entry>& brains, JobSystem& jobs) {
+    std::vector<SnapshotWriter> records(brains.size(), SnapshotWriter(false));
+    jobs.parallelFor(brains.size(), jobs.grainFor(brains.size(), 4), [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            brains[i].brain->writeState(records[i]);
+        }
+    });
+    
+    FileHeader header;
+    header.count = brains.size();
+    uint64_t offset = sizeof(FileHeader) + brains.size() * sizeof(IndexEntry);
+    
+    SnapshotWriter out(false);
+    out.write(header);
+    for (size_t i = 0; i < brains.size(); i++) {
+        IndexEntry entry;
+        entry.id = brains[i].id;
+        entry.offset = offset;
+        entry.size = records[i].size();
+        out.write(entry);
+        offset += entry.size;
+    }
+    for (const auto& record : records) {
+        out.writeBytes(record.data(), record.size());
+    }
+    return out.save(path);
+}
+
+int BrainStateFile::load(const std::string& path, const std::vector<Entry>& brains, JobSystem& jobs) {
+    SnapshotReader file;
+    if (!file.map(path)) {
+        return -1;
+    }
+    
+    FileHeader header;
+    if (!file.read(header) || header.magic != MAGIC || header.version != VERSION ||
+        header.count > MAX_RECORDS || header.count * sizeof(IndexEntry) > file.remaining()) {
+        std::cerr << "Warning: " << path << " is not a version " << VERSION << " brain state file" << std::endl;
+        return -1;
+    }
+    
+    std::vector<IndexEntry> index(static_cast<size_t>(header.count));
+    file.readBytes(index.data(), index.size() * sizeof(IndexEntry));
+    
+    std::unordered_map<EntityId, NeuralBrain*> byId;
+    for (const auto& entry : brains) {
+        byId[entry.id] = entry.brain;
+    }
+    
+    std::atomic<int> restored{0};
+    std::atomic<int> damaged{0};
+    jobs.parallelFor(index.size(), jobs.grainFor(index.size(), 4), [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            const IndexEntry& entry = index[i];
+            auto it = byId.find(entry.id);
+            if (it == byId.end()) continue;
+            
+            if (entry.offset > file.length() || entry.size > file.length() - entry.offset) {
+                damaged.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            SnapshotReader record;
+            record.view(file.bytes() + entry.offset, static_cast<size_t>(entry.size));
+            if (it->second->readState(record)) {
+                restored.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                damaged.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    
+    if (damaged > 0) {
+        std::cerr << "Warning: " << damaged << " damaged brain records in " << path << std::endl;
+    }
+    return restored;
+}
+
+} // namespace pw
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "engine/JobSystem.h"
+#include "engine/Types.h"
+#include <string>
+#include <vector>
+
+namespace pw {
+
+class NeuralBrain;
+
+// Persistent state of every neural brain in one packed file:
+//   header  {magic, version, count}
+//   index   count x {EntityId, offset, size}
+//   records NeuralBrain::writeState() payloads
+// Records are encoded and decoded independently, so both directions run on
+// the job system; the file itself is written and read through mmap.
+class BrainStateFile {
+public:
+    static constexpr uint32_t MAGIC = 0x53425750;  // "PWBS"
+    static constexpr uint32_t VERSION = 1;
+    
+    struct Entry {
+        EntityId id;
+        NeuralBrain* brain;
+    };
+    
+    static bool save(const std::string& path, const std::vector<Entry>& brains, JobSystem& jobs);
+    
+    // Restores every brain that has a record; returns how many did, or -1 if
+    // the file is missing or unreadable
+    static int load(const std::string& path, const std::vector<Entry>& brains, JobSystem& jobs);
+};
+
+} // namespace pw
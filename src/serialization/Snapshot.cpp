@@ -0,0 +1,183 @@
+#include "Snapshot.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pw {
+
+SnapshotWriter::SnapshotWriter(bool withHeader) {
+    if (!withHeader) return;
+    
+    buffer.reserve(1 << 16);
+    write(snapshot::MAGIC);
+    write(snapshot::VERSION);
+}
+
+void SnapshotWriter::writeBytes(const void* data, size_t size) {
+    if (size == 0) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void SnapshotWriter::writeString(const std::string& value) {
+    write(static_cast<uint64_t>(value.size()));
+    writeBytes(value.data(), value.size());
+}
+
+bool SnapshotWriter::save(const std::string& path) const {
+    const std::string temporary = path + ".tmp";
+    
+#ifndef _WIN32
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not create snapshot " << temporary << std::endl;
+        return false;
+    }
+    
+    bool written = ::ftruncate(fd, static_cast<off_t>(buffer.size())) == 0;
+    if (written) {
+        void* target = ::mmap(nullptr, buffer.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (target == MAP_FAILED) {
+            written = false;
+        } else {
+            std::memcpy(target, buffer.data(), buffer.size());
+            written = ::msync(target, buffer.size(), MS_ASYNC) == 0;
+            ::munmap(target, buffer.size());
+        }
+    }
+    ::close(fd);
+#else
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    bool written = static_cast<bool>(file);
+    file.close();
+    std::remove(path.c_str());
+#endif
+    
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Warning: Could not write snapshot " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+void SnapshotReader::close() {
+#ifndef _WIN32
+    if (mapping) {
+        ::munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    fallback.clear();
+    data = nullptr;
+    size = 0;
+    offset = 0;
+    failed = false;
+}
+
+bool SnapshotReader::open(const std::string& path) {
+    if (!map(path)) {
+        return false;
+    }
+    
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!read(magic) || !read(version) || magic != snapshot::MAGIC || version != snapshot::VERSION) {
+        std::cerr << "Warning: " << path << " is not a version " << snapshot::VERSION
+                  << " snapshot" << std::endl;
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+void SnapshotReader::view(const uint8_t* bytes, size_t length) {
+    close();
+    data = bytes;
+    size = length;
+}
+
+bool SnapshotReader::map(const std::string& path) {
+    close();
+    
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Warning: Could not open " << path << std::endl;
+        failed = true;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            mapping = mapped;
+            mappingSize = static_cast<size_t>(info.st_size);
+            data = static_cast<const uint8_t*>(mapped);
+            size = mappingSize;
+        }
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = fallback.data();
+    size = fallback.size();
+#endif
+    return true;
+}
+
+bool SnapshotReader::readBytes(void* out, size_t count) {
+    if (failed || count > remaining()) {
+        failed = true;
+        return false;
+    }
+    if (count > 0) {
+        std::memcpy(out, data + offset, count);
+        offset += count;
+    }
+    return true;
+}
+
+bool SnapshotReader::readString(std::string& value, size_t maxLength) {
+    uint64_t length = 0;
+    if (!read(length) || length > maxLength || length > remaining()) {
+        failed = true;
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data + offset), static_cast<size_t>(length));
+    offset += static_cast<size_t>(length);
+    return true;
+}
+
+bool SnapshotReader::readRng(CounterRng& rng) {
+    uint64_t key = 0;
+    uint64_t counter = 0;
+    if (!read(key) || !read(counter)) return false;
+    rng = CounterRng(key, counter);
+    return true;
+}
+
+bool SnapshotReader::section(uint32_t tag) {
+    uint32_t found = 0;
+    if (!read(found) || found != tag) {
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+} // namespace pw
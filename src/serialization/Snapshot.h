@@ -0,0 +1,121 @@
+#pragma once
+
+#include "engine/Random.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace pw {
+
+// Simulation snapshots: a flat binary stream of trivially copyable values in
+// host byte order, grouped into tagged sections. Writers build the stream in
+// memory and map it to disk in one copy; readers map the file and copy values
+// straight out of the mapping. Files from another VERSION are rejected.
+namespace snapshot {
+
+constexpr uint32_t MAGIC = 0x4E535750;  // "PWSN"
+constexpr uint32_t VERSION = 5;
+
+// Section tags, checked on read to catch a stream that went out of step
+constexpr uint32_t ENGINE = 0x474E4545;  // "EENG"
+constexpr uint32_t WORLD = 0x444C5257;   // "WRLD"
+constexpr uint32_t NPC = 0x2043504E;     // "NPC "
+
+} // namespace snapshot
+
+class SnapshotWriter {
+public:
+    // withHeader = false starts an empty stream, for records embedded in other files
+    explicit SnapshotWriter(bool withHeader = true);
+    
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        writeBytes(&value, sizeof(T));
+    }
+    
+    template <typename T>
+    void writeVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        write(static_cast<uint64_t>(values.size()));
+        writeBytes(values.data(), values.size() * sizeof(T));
+    }
+    
+    void writeBytes(const void* data, size_t size);
+    void writeString(const std::string& value);
+    void writeRng(const CounterRng& rng) { write(rng.getKey()); write(rng.getCounter()); }
+    void section(uint32_t tag) { write(tag); }
+    
+    size_t size() const { return buffer.size(); }
+    const uint8_t* data() const { return buffer.data(); }
+    
+    // Writes path atomically (through a temporary file); false on I/O errors
+    bool save(const std::string& path) const;
+
+private:
+    std::vector<uint8_t> buffer;
+};
+
+// Reads are bounds-checked: past the end or after a bad section, every read
+// fails and ok() turns false, so callers can read a block and check once.
+class SnapshotReader {
+public:
+    SnapshotReader() = default;
+    ~SnapshotReader();
+    
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+    
+    // Maps path and checks the header
+    bool open(const std::string& path);
+    // Maps path without reading anything
+    bool map(const std::string& path);
+    // Reads from memory owned by someone else (e.g. a slice of another reader)
+    void view(const uint8_t* bytes, size_t length);
+    
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        return readBytes(&value, sizeof(T));
+    }
+    
+    // Fails on vectors longer than maxCount, so a corrupt length cannot
+    // trigger a huge allocation
+    template <typename T>
+    bool readVector(std::vector<T>& values, size_t maxCount) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+        uint64_t count = 0;
+        if (!read(count) || count > maxCount || count * sizeof(T) > remaining()) {
+            failed = true;
+            return false;
+        }
+        values.resize(static_cast<size_t>(count));
+        return readBytes(values.data(), values.size() * sizeof(T));
+    }
+    
+    bool readBytes(void* out, size_t size);
+    bool readString(std::string& value, size_t maxLength = 1 << 20);
+    bool readRng(CounterRng& rng);
+    bool section(uint32_t tag);
+    
+    bool ok() const { return !failed; }
+    size_t remaining() const { return size - offset; }
+    size_t length() const { return size; }
+    const uint8_t* bytes() const { return data; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+    bool failed = false;
+    
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    std::vector<uint8_t> fallback;  // Used where mmap is unavailable
+    
+    void close();
+};
+
+} // namespace pw
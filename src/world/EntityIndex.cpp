@@ -0,0 +1,58 @@
+#include "EntityIndex.h"
+
+namespace pw {
+
+EntityIndex::EntityIndex(int worldWidth, int worldHeight)
+    : cellsX(std::max(1, (worldWidth + CELL_SIZE - 1) / CELL_SIZE))
+    , cellsY(std::max(1, (worldHeight + CELL_SIZE - 1) / CELL_SIZE)) {
+    cellStart.assign(static_cast<size_t>(cellsX) * cellsY + 1, 0);
+}
+
+void EntityIndex::clear() {
+    entries.clear();
+    entryCell.clear();
+    cellEntries.clear();
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+}
+
+void EntityIndex::add(EntityId id, Vec2 position) {
+    entries.push_back({id, position});
+}
+
+void EntityIndex::build() {
+    // Counting sort by cell; slots stay in add() order within a cell
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    entryCell.resize(entries.size());
+    
+    for (size_t slot = 0; slot < entries.size(); slot++) {
+        int cx = cellCoord(entries[slot].position.x, cellsX);
+        int cy = cellCoord(entries[slot].position.y, cellsY);
+        entryCell[slot] = static_cast<uint32_t>(cy * cellsX + cx);
+        cellStart[entryCell[slot] + 1]++;
+    }
+    
+    for (size_t cell = 1; cell < cellStart.size(); cell++) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+    
+    cellEntries.resize(entries.size());
+    cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (size_t slot = 0; slot < entries.size(); slot++) {
+        cellEntries[cellCursor[entryCell[slot]]++] = static_cast<uint32_t>(slot);
+    }
+}
+
+void EntityIndex::queryRadius(Vec2 center, float radius, std::vector<uint32_t>& slots) const {
+    size_t first = slots.size();
+    forEachInRadius(center, radius, [&](uint32_t slot, const Entry&) {
+        slots.push_back(slot);
+    });
+    std::sort(slots.begin() + first, slots.end());
+}
+
+int EntityIndex::cellCoord(float value, int cellCount) const {
+    int cell = static_cast<int>(std::floor(value / CELL_SIZE));
+    return std::max(0, std::min(cellCount - 1, cell));
+}
+
+} // namespace pw
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "engine/Types.h"
+#include "engine/Math.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace pw {
+
+// Uniform grid over entity positions, aligned to the tile grid. Entities are
+// added once per tick and build() buckets them by cell; radius queries then
+// only look at the cells the circle overlaps.
+class EntityIndex {
+public:
+    static constexpr int CELL_SIZE = 8;  // Tiles per cell side
+    
+    struct Entry {
+        EntityId id = 0;
+        Vec2 position;
+    };
+    
+    EntityIndex(int worldWidth, int worldHeight);
+    
+    // Rebuild: clear(), add() every entity, then build()
+    void clear();
+    void add(EntityId id, Vec2 position);
+    void build();
+    
+    // Slots are in add() order, so a slot is the entity's index in the caller's list
+    size_t size() const { return entries.size(); }
+    const Entry& entry(uint32_t slot) const { return entries[slot]; }
+    
+    // Append the slots of entities with distance(center) < radius, in slot order
+    void queryRadius(Vec2 center, float radius, std::vector<uint32_t>& slots) const;
+    
+    // Call fn(slot, entry) for every entity with distance(center) < radius, in cell order
+    template <typename Fn>
+    void forEachInRadius(Vec2 center, float radius, Fn&& fn) const;
+
+private:
+    int cellsX = 0;
+    int cellsY = 0;
+    
+    std::vector<Entry> entries;
+    std::vector<uint32_t> entryCell;
+    std::vector<uint32_t> cellStart;    // Cell c owns cellEntries[cellStart[c], cellStart[c + 1])
+    std::vector<uint32_t> cellEntries;  // Slots grouped by cell
+    std::vector<uint32_t> cellCursor;   // Scratch for build()
+    
+    int cellCoord(float value, int cellCount) const;
+};
+
+template <typename Fn>
+void EntityIndex::forEachInRadius(Vec2 center, float radius, Fn&& fn) const {
+    if (entries.empty()) return;
+    
+    int minX = cellCoord(center.x - radius, cellsX);
+    int maxX = cellCoord(center.x + radius, cellsX);
+    int minY = cellCoord(center.y - radius, cellsY);
+    int maxY = cellCoord(center.y + radius, cellsY);
+    
+    for (int cy = minY; cy <= maxY; cy++) {
+        for (int cx = minX; cx <= maxX; cx++) {
+            uint32_t cell = static_cast<uint32_t>(cy * cellsX + cx);
+            for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                uint32_t slot = cellEntries[i];
+                const Entry& e = entries[slot];
+                if (center.distance(e.position) < radius) {
+                    fn(slot, e);
+                }
+            }
+        }
+    }
+}
+
+} // namespace pw
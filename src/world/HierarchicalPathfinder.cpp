@@ -0,0 +1,556 @@
+#include "HierarchicalPathfinder.h"
+#include "World.h"
+#include "engine/FixedVector.h"
+#include "engine/Profiler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace pw {
+
+namespace {
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+// Runs at least this long get a portal at each end instead of one in the middle
+constexpr int LONG_RUN = 6;
+
+constexpr int DX[] = {0, 1, 0, -1, 1, 1, -1, -1};
+constexpr int DY[] = {-1, 0, 1, 0, -1, 1, 1, -1};
+
+} // namespace
+
+HierarchicalPathfinder::HierarchicalPathfinder(const World& world)
+    : world(world)
+    , worldWidth(world.getWidth())
+    , worldHeight(world.getHeight())
+    , clustersX((worldWidth + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+    , clustersY((worldHeight + CLUSTER_SIZE - 1) / CLUSTER_SIZE)
+    , clusters(new std::atomic<Cluster*>[static_cast<size_t>(clustersX) * clustersY]()) {
+}
+
+HierarchicalPathfinder::~HierarchicalPathfinder() {
+    for (size_t i = 0; i < static_cast<size_t>(clustersX) * clustersY; i++) {
+        delete clusters[i].load(std::memory_order_relaxed);
+    }
+}
+
+int HierarchicalPathfinder::GoalTree::windowIndex(int cluster, int clustersX) const {
+    int cx = cluster % clustersX - x0;
+    int cy = cluster / clustersX - y0;
+    if (cx < 0 || cx >= columns || cy < 0 || cy >= rows) return -1;
+    return cy * columns + cx;
+}
+
+int HierarchicalPathfinder::clusterOf(int32_t tile) const {
+    int x = tile % worldWidth;
+    int y = tile / worldWidth;
+    return (y / CLUSTER_SIZE) * clustersX + (x / CLUSTER_SIZE);
+}
+
+const HierarchicalPathfinder::Cluster& HierarchicalPathfinder::cluster(int index) const {
+    Cluster* result = clusters[index].load(std::memory_order_acquire);
+    if (result) {
+        return *result;
+    }
+    
+    std::lock_guard<std::mutex> lock(buildMutex);
+    // Another query may have built it while we waited
+    result = clusters[index].load(std::memory_order_relaxed);
+    if (!result) {
+        result = buildCluster(index);
+        clusters[index].store(result, std::memory_order_release);
+        built.fetch_add(1, std::memory_order_relaxed);
+    }
+    return *result;
+}
+
+void HierarchicalPathfinder::onWalkabilityChanged(int x, int y) {
+    // A cluster's portals also depend on the tiles just across its edges and corners
+    const int cx = x / CLUSTER_SIZE;
+    const int cy = y / CLUSTER_SIZE;
+    auto drop = [this](int nx, int ny) {
+        if (nx < 0 || nx >= clustersX || ny < 0 || ny >= clustersY) return;
+        Cluster* stale = clusters[ny * clustersX + nx].exchange(nullptr, std::memory_order_relaxed);
+        if (stale) {
+            delete stale;
+            built.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+    for (int ny = cy - 1; ny <= cy + 1; ny++) {
+        for (int nx = cx - 1; nx <= cx + 1; nx++) drop(nx, ny);
+    }
+    
+    // Cached trees refer to the old graph
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheOrder.clear();
+    cacheLookup.clear();
+}
+
+void HierarchicalPathfinder::addPortals(Cluster& cluster, int x, int y, int stepX, int stepY,
+                                        int length, int outsideX, int outsideY) const {
+    // Partner across the edge, offset along it by shift for a diagonal step
+    auto addPortal = [&](int i, int shift) {
+        int px = x + stepX * i;
+        int py = y + stepY * i;
+        int32_t tile = py * worldWidth + px;
+        int32_t partner = (py + outsideY + stepY * shift) * worldWidth + (px + outsideX + stepX * shift);
+        
+        auto it = std::find(cluster.nodes.begin(), cluster.nodes.end(), tile);
+        if (it == cluster.nodes.end()) {
+            cluster.nodes.push_back(tile);
+            cluster.partners.push_back({partner});
+        } else {
+            cluster.partners[it - cluster.nodes.begin()].push_back(partner);
+        }
+    };
+    
+    // The cluster across the edge scans the same runs, so both sides agree on the portals
+    int runStart = -1;
+    for (int i = 0; i <= length; i++) {
+        bool open = i < length &&
+                    world.isWalkable(x + stepX * i, y + stepY * i) &&
+                    world.isWalkable(x + stepX * i + outsideX, y + stepY * i + outsideY);
+        if (open && runStart < 0) {
+            runStart = i;
+        } else if (!open && runStart >= 0) {
+            int runEnd = i - 1;
+            if (runEnd - runStart + 1 >= LONG_RUN) {
+                addPortal(runStart, 0);
+                addPortal(runEnd, 0);
+            } else {
+                addPortal((runStart + runEnd) / 2, 0);
+            }
+            runStart = -1;
+        }
+    }
+    
+    // Moves may cut corners, so a diagonal step can cross where no straight
+    // one does. It only needs a portal when neither tile it joins has a
+    // straight crossing, which would reach the other within one cluster.
+    // Steps off the ends of the edge reach the diagonal clusters; only the
+    // horizontal edges add those, so each corner is linked once.
+    auto walkable = [&](int i, int outside) {
+        return world.isWalkable(x + stepX * i + outsideX * outside, y + stepY * i + outsideY * outside);
+    };
+    auto straight = [&](int i) { return walkable(i, 0) && walkable(i, 1); };
+    for (int i = 0; i < length; i++) {
+        if (!walkable(i, 0)) continue;
+        for (int shift = -1; shift <= 1; shift += 2) {
+            const int j = i + shift;
+            const bool corner = j < 0 || j >= length;
+            if (corner ? stepX == 0 : straight(i) || straight(j)) continue;
+            if (walkable(j, 1)) addPortal(i, shift);
+        }
+    }
+}
+
+HierarchicalPathfinder::Cluster* HierarchicalPathfinder::buildCluster(int index) const {
+    PW_PROFILE_ZONE("pathfinding/build-cluster");
+    auto cluster = std::make_unique<Cluster>();
+    cluster->x0 = (index % clustersX) * CLUSTER_SIZE;
+    cluster->y0 = (index / clustersX) * CLUSTER_SIZE;
+    cluster->width = std::min(CLUSTER_SIZE, worldWidth - cluster->x0);
+    cluster->height = std::min(CLUSTER_SIZE, worldHeight - cluster->y0);
+    
+    cluster->walkable.resize(static_cast<size_t>(cluster->width) * cluster->height);
+    for (int y = 0; y < cluster->height; y++) {
+        for (int x = 0; x < cluster->width; x++) {
+            cluster->walkable[y * cluster->width + x] = world.isWalkable(cluster->x0 + x, cluster->y0 + y);
+        }
+    }
+    
+    const int left = cluster->x0;
+    const int top = cluster->y0;
+    const int right = cluster->x0 + cluster->width - 1;
+    const int bottom = cluster->y0 + cluster->height - 1;
+    
+    // isWalkable() is false outside the world, so map edges get no portals
+    addPortals(*cluster, left, top, 0, 1, cluster->height, -1, 0);
+    addPortals(*cluster, right, top, 0, 1, cluster->height, 1, 0);
+    addPortals(*cluster, left, top, 1, 0, cluster->width, 0, -1);
+    addPortals(*cluster, left, bottom, 1, 0, cluster->width, 0, 1);
+    
+    const size_t n = cluster->nodes.size();
+    cluster->costs.assign(n * n, INF);
+    
+    std::vector<float> distance;
+    for (size_t i = 0; i < n; i++) {
+        clusterDistances(*cluster, cluster->nodes[i], distance);
+        for (size_t j = 0; j < n; j++) {
+            int lx = cluster->nodes[j] % worldWidth - cluster->x0;
+            int ly = cluster->nodes[j] / worldWidth - cluster->y0;
+            cluster->costs[i * n + j] = distance[ly * cluster->width + lx];
+        }
+    }
+    return cluster.release();
+}
+
+void HierarchicalPathfinder::clusterDistances(const Cluster& cluster, int32_t source,
+                                              std::vector<float>& distance,
+                                              std::vector<int32_t>* parent, int32_t target) const {
+    static thread_local std::vector<QueueEntry> open;
+    
+    const int w = cluster.width;
+    const int h = cluster.height;
+    distance.assign(static_cast<size_t>(w) * h, INF);
+    if (parent) {
+        parent->assign(distance.size(), -1);
+    }
+    open.clear();
+    
+    int sx = source % worldWidth - cluster.x0;
+    int sy = source / worldWidth - cluster.y0;
+    distance[sy * w + sx] = 0.0f;
+    open.push_back({0.0f, sy * w + sx});
+    
+    const int32_t targetId = target < 0 ? -1 :
+        (target / worldWidth - cluster.y0) * w + (target % worldWidth - cluster.x0);
+    
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<QueueEntry>());
+        QueueEntry current = open.back();
+        open.pop_back();
+        if (current.cost > distance[current.id]) continue;
+        if (current.id == targetId) break;
+        
+        int cx = current.id % w;
+        int cy = current.id / w;
+        for (int i = 0; i < 8; i++) {
+            int nx = cx + DX[i];
+            int ny = cy + DY[i];
+            if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
+            if (!cluster.walkable[ny * w + nx]) continue;
+            
+            // Same step costs as Pathfinder
+            float cost = current.cost + ((i < 4) ? 1.0f : 1.414f);
+            if (cost < distance[ny * w + nx]) {
+                distance[ny * w + nx] = cost;
+                if (parent) {
+                    (*parent)[ny * w + nx] = current.id;
+                }
+                open.push_back({cost, ny * w + nx});
+                std::push_heap(open.begin(), open.end(), std::greater<QueueEntry>());
+            }
+        }
+    }
+}
+
+std::shared_ptr<HierarchicalPathfinder::GoalTree>
+HierarchicalPathfinder::goalTree(int32_t goalTile, int radius) const {
+    const int64_t key = static_cast<int64_t>(goalTile) << 32 | radius;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cacheLookup.find(key);
+    if (it != cacheLookup.end()) {
+        cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->second;
+    }
+    
+    // Starting a tree is one cluster search; queries grow it under its own lock
+    misses.fetch_add(1, std::memory_order_relaxed);
+    auto tree = startGoalTree(goalTile, radius);
+    cacheOrder.emplace_front(key, tree);
+    cacheLookup[key] = cacheOrder.begin();
+    if (cacheOrder.size() > GOAL_CACHE_SIZE) {
+        cacheLookup.erase(cacheOrder.back().first);
+        cacheOrder.pop_back();
+    }
+    return tree;
+}
+
+std::shared_ptr<HierarchicalPathfinder::GoalTree>
+HierarchicalPathfinder::startGoalTree(int32_t goalTile, int radius) const {
+    PW_PROFILE_ZONE("pathfinding/goal-tree");
+    auto tree = std::make_shared<GoalTree>();
+    
+    const int goalCluster = clusterOf(goalTile);
+    const int gx = goalCluster % clustersX;
+    const int gy = goalCluster / clustersX;
+    tree->x0 = std::max(0, gx - radius);
+    tree->y0 = std::max(0, gy - radius);
+    tree->columns = std::min(clustersX, gx + radius + 1) - tree->x0;
+    tree->rows = std::min(clustersY, gy + radius + 1) - tree->y0;
+    tree->base.assign(static_cast<size_t>(tree->columns) * tree->rows, -1);
+    tree->window.assign(tree->base.size(), nullptr);
+    
+    // Seed with the portals of the goal's cluster
+    const int32_t goalBase = numberCluster(*tree, goalCluster);
+    const Cluster& gc = *tree->window[tree->windowIndex(goalCluster, clustersX)];
+    std::vector<float> local;
+    clusterDistances(gc, goalTile, local);
+    for (size_t j = 0; j < gc.nodes.size(); j++) {
+        int lx = gc.nodes[j] % worldWidth - gc.x0;
+        int ly = gc.nodes[j] / worldWidth - gc.y0;
+        float d = local[ly * gc.width + lx];
+        if (d < INF) {
+            int32_t id = goalBase + static_cast<int32_t>(j);
+            tree->distance[id] = d;
+            tree->next[id] = TO_GOAL;
+            tree->open.push_back({d, id});
+        }
+    }
+    std::make_heap(tree->open.begin(), tree->open.end(), std::greater<QueueEntry>());
+    return tree;
+}
+
+int32_t HierarchicalPathfinder::numberCluster(GoalTree& tree, int index) const {
+    const int w = tree.windowIndex(index, clustersX);
+    if (w < 0) return -1;
+    if (tree.base[w] >= 0) return tree.base[w];
+    
+    const Cluster& c = cluster(index);
+    const int32_t base = static_cast<int32_t>(tree.distance.size());
+    const size_t total = tree.distance.size() + c.nodes.size();
+    tree.base[w] = base;
+    tree.window[w] = &c;
+    tree.nodeCluster.resize(total, index);
+    tree.distance.resize(total, INF);
+    tree.next.resize(total, -1);
+    tree.settled.resize(total, 0);
+    return base;
+}
+
+int32_t HierarchicalPathfinder::growTree(GoalTree& tree) const {
+    std::pop_heap(tree.open.begin(), tree.open.end(), std::greater<QueueEntry>());
+    const QueueEntry current = tree.open.back();
+    tree.open.pop_back();
+    if (current.cost > tree.distance[current.id]) return -1;
+    tree.settled[current.id] = 1;
+    
+    // Moves are symmetric, so next[] points toward the goal
+    auto relax = [&](int32_t to, float cost) {
+        float d = current.cost + cost;
+        if (d < tree.distance[to]) {
+            tree.distance[to] = d;
+            tree.next[to] = current.id;
+            tree.open.push_back({d, to});
+            std::push_heap(tree.open.begin(), tree.open.end(), std::greater<QueueEntry>());
+        }
+    };
+    
+    const int c = tree.nodeCluster[current.id];
+    const int32_t base = tree.base[tree.windowIndex(c, clustersX)];
+    const Cluster& here = *tree.window[tree.windowIndex(c, clustersX)];
+    const size_t n = here.nodes.size();
+    const size_t i = static_cast<size_t>(current.id - base);
+    
+    for (size_t j = 0; j < n; j++) {
+        float cost = here.costs[i * n + j];
+        if (j != i && cost < INF) {
+            relax(base + static_cast<int32_t>(j), cost);
+        }
+    }
+    
+    // Portals across the window's edge lead nowhere this tree covers
+    const int32_t tile = here.nodes[i];
+    for (int32_t partner : here.partners[i]) {
+        const int pc = clusterOf(partner);
+        const int32_t partnerBase = numberCluster(tree, pc);
+        if (partnerBase < 0) continue;
+        const auto& nodes = tree.window[tree.windowIndex(pc, clustersX)]->nodes;
+        auto it = std::find(nodes.begin(), nodes.end(), partner);
+        if (it != nodes.end()) {
+            const bool diagonal = partner % worldWidth != tile % worldWidth && partner / worldWidth != tile / worldWidth;
+            relax(partnerBase + static_cast<int32_t>(it - nodes.begin()), diagonal ? 1.414f : 1.0f);
+        }
+    }
+    return current.id;
+}
+
+bool HierarchicalPathfinder::findWaypoints(Vec2 start, Vec2 goal, std::vector<Vec2>& waypoints) const {
+    waypoints.clear();
+    
+    int startX = static_cast<int>(start.x);
+    int startY = static_cast<int>(start.y);
+    int goalX = static_cast<int>(goal.x);
+    int goalY = static_cast<int>(goal.y);
+    
+    if (!world.isWalkable(goalX, goalY)) return false;
+    if (startX < 0 || startX >= worldWidth || startY < 0 || startY >= worldHeight) return false;
+    
+    const int32_t goalTile = goalY * worldWidth + goalX;
+    const int goalCluster = clusterOf(goalTile);
+    
+    // NPCs can stand on unwalkable tiles (movement ignores walkability); route
+    // from their walkable neighbours then, which may lie in another cluster
+    struct Entry {
+        int x, y;
+        float cost;
+        int cluster;
+        int32_t base;  // -1 outside the tree's window
+        const Cluster* home;
+    };
+    FixedVector<Entry, 8> entries;
+    auto addEntry = [&](int x, int y, float cost) {
+        const int c = clusterOf(y * worldWidth + x);
+        entries.push_back({x, y, cost, c, -1, &cluster(c)});
+    };
+    if (world.isWalkable(startX, startY)) {
+        addEntry(startX, startY, 0.0f);
+    } else {
+        for (int i = 0; i < 8; i++) {
+            if (world.isWalkable(startX + DX[i], startY + DY[i])) {
+                addEntry(startX + DX[i], startY + DY[i], (i < 4) ? 1.0f : 1.414f);
+            }
+        }
+    }
+    
+    static thread_local std::array<std::vector<float>, 8> local;
+    for (size_t e = 0; e < entries.size(); e++) {
+        clusterDistances(*entries[e].home, entries[e].y * worldWidth + entries[e].x, local[e]);
+    }
+    
+    // A route that leaves the window is looked for again in one twice as wide,
+    // up to the whole map. The first window with a route answers, so the
+    // result doesn't depend on which trees earlier queries built.
+    const int wholeMap = std::max(clustersX, clustersY) - 1;
+    for (int radius = SEARCH_RADIUS;; radius = std::min(radius * 2, wholeMap)) {
+        auto tree = goalTree(goalTile, radius);
+        std::lock_guard<std::mutex> treeLock(tree->mutex);
+        
+        bool inWindow = false;
+        for (size_t e = 0; e < entries.size(); e++) {
+            entries[e].base = numberCluster(*tree, entries[e].cluster);
+            inWindow = inWindow || entries[e].base >= 0;
+        }
+        
+        // Route cost from entry e through its cluster's portal j, if that portal is settled
+        auto routeCost = [&](size_t e, size_t j) {
+            const Entry& entry = entries[e];
+            const int32_t id = entry.base + static_cast<int32_t>(j);
+            if (!tree->settled[id]) return INF;
+            int lx = entry.home->nodes[j] % worldWidth - entry.home->x0;
+            int ly = entry.home->nodes[j] / worldWidth - entry.home->y0;
+            return entry.cost + local[e][ly * entry.home->width + lx] + tree->distance[id];
+        };
+        auto directCost = [&](size_t e) {
+            const Entry& entry = entries[e];
+            if (entry.cluster != goalCluster) return INF;
+            return entry.cost + local[e][(goalY - entry.home->y0) * entry.home->width + (goalX - entry.home->x0)];
+        };
+        
+        float best = INF;
+        if (inWindow) {
+            for (size_t e = 0; e < entries.size(); e++) {
+                best = std::min(best, directCost(e));
+                if (entries[e].base < 0) continue;  // Too far from the goal
+                for (size_t j = 0; j < entries[e].home->nodes.size(); j++) {
+                    best = std::min(best, routeCost(e, j));
+                }
+            }
+            
+            // Grow the tree until every portal that could match best is settled, so
+            // the answer doesn't depend on how far earlier queries grew it
+            while (!tree->open.empty() && tree->open.front().cost <= best) {
+                const int32_t id = growTree(*tree);
+                if (id < 0) continue;
+                for (size_t e = 0; e < entries.size(); e++) {
+                    if (entries[e].base >= 0 && tree->nodeCluster[id] == entries[e].cluster) {
+                        best = std::min(best, routeCost(e, static_cast<size_t>(id - entries[e].base)));
+                    }
+                }
+            }
+        }
+        if (best == INF) {
+            if (radius >= wholeMap) return false;
+            continue;
+        }
+        
+        best = INF;
+        int32_t bestNode = -1;
+        size_t bestEntry = 0;
+        for (size_t e = 0; e < entries.size(); e++) {
+            float d = directCost(e);
+            if (d < best) {
+                best = d;
+                bestNode = -1;
+                bestEntry = e;
+            }
+            if (entries[e].base < 0) continue;
+            for (size_t j = 0; j < entries[e].home->nodes.size(); j++) {
+                d = routeCost(e, j);
+                if (d < best) {
+                    best = d;
+                    bestNode = entries[e].base + static_cast<int32_t>(j);
+                    bestEntry = e;
+                }
+            }
+        }
+        
+        waypoints.push_back(Vec2(static_cast<float>(startX), static_cast<float>(startY)));
+        const Entry& entry = entries[bestEntry];
+        if (entry.x != startX || entry.y != startY) {
+            waypoints.push_back(Vec2(static_cast<float>(entry.x), static_cast<float>(entry.y)));
+        }
+        for (int32_t id = bestNode; id >= 0; id = tree->next[id]) {
+            const int w = tree->windowIndex(tree->nodeCluster[id], clustersX);
+            int32_t tile = tree->window[w]->nodes[id - tree->base[w]];
+            waypoints.push_back(Vec2(static_cast<float>(tile % worldWidth),
+                                     static_cast<float>(tile / worldWidth)));
+        }
+        waypoints.push_back(Vec2(static_cast<float>(goalX), static_cast<float>(goalY)));
+        return true;
+    }
+}
+
+std::vector<Vec2> HierarchicalPathfinder::refineSegment(Vec2 from, Vec2 to) const {
+    const int fromX = static_cast<int>(from.x);
+    const int fromY = static_cast<int>(from.y);
+    const int toX = static_cast<int>(to.x);
+    const int toY = static_cast<int>(to.y);
+    
+    // Crossing a border, or stepping off an unwalkable start
+    if (std::abs(fromX - toX) <= 1 && std::abs(fromY - toY) <= 1) {
+        std::vector<Vec2> path{Vec2(static_cast<float>(fromX), static_cast<float>(fromY))};
+        if (fromX != toX || fromY != toY) {
+            path.push_back(Vec2(static_cast<float>(toX), static_cast<float>(toY)));
+        }
+        return path;
+    }
+    
+    // Every other leg stays inside one cluster
+    const int32_t fromTile = fromY * worldWidth + fromX;
+    const int32_t toTile = toY * worldWidth + toX;
+    const int c = clusterOf(fromTile);
+    if (c != clusterOf(toTile)) {
+        return {};
+    }
+    
+    static thread_local std::vector<float> distance;
+    static thread_local std::vector<int32_t> parent;
+    const Cluster& here = cluster(c);
+    clusterDistances(here, fromTile, distance, &parent, toTile);
+    
+    int32_t target = (toY - here.y0) * here.width + (toX - here.x0);
+    if (distance[target] == INF) {
+        return {};
+    }
+    std::vector<Vec2> path;
+    for (int32_t id = target; id != -1; id = parent[id]) {
+        path.push_back(Vec2(static_cast<float>(here.x0 + id % here.width),
+                            static_cast<float>(here.y0 + id / here.width)));
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<Vec2> HierarchicalPathfinder::findPath(Vec2 start, Vec2 goal) const {
+    PW_PROFILE_ZONE("pathfinding/hierarchical");
+    std::vector<Vec2> waypoints;
+    if (!findWaypoints(start, goal, waypoints)) {
+        return {};
+    }
+    
+    std::vector<Vec2> path;
+    for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+        auto segment = refineSegment(waypoints[i], waypoints[i + 1]);
+        if (segment.empty()) return {};
+        path.insert(path.end(), segment.begin() + (path.empty() ? 0 : 1), segment.end());
+    }
+    return path;
+}
+
+} // namespace pw
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "engine/Math.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pw {
+
+class World;
+
+// HPA* over the tile grid. The map is cut into CLUSTER_SIZE square clusters;
+// every run of walkable tiles across a cluster border gets a portal, as does
+// a diagonal step across a border or corner that no run covers, and
+// portal-to-portal costs inside each cluster are precomputed. Queries search
+// this small graph and refine the result one leg at a time, each leg inside
+// a single cluster.
+//
+// Clusters are built the first time a query reaches them, so, like terrain,
+// cost grows with the area NPCs travel rather than the map. A search first
+// covers the clusters within SEARCH_RADIUS of the goal's; if no route stays
+// inside, it retries in windows twice as wide, up to the whole map, so only
+// unreachable goals fail. A route is the best one inside the first window
+// that has one.
+//
+// Searches toward the same goal and window share a reverse shortest-path tree
+// over the portal graph, kept in an LRU cache (NPCs keep walking to the same
+// bushes and caves) and grown only as far as queries need. A walkability
+// change rebuilds the clusters around it and drops the cache.
+//
+// Queries are safe from several threads; onWalkabilityChanged() is called by
+// World::setTile(), in serial phases.
+class HierarchicalPathfinder {
+public:
+    static constexpr int CLUSTER_SIZE = 16;
+    static constexpr int SEARCH_RADIUS = 8;  // Clusters around the goal's, in the first window
+    static constexpr size_t GOAL_CACHE_SIZE = 64;
+    
+    // Reads world's tiles as clusters are built; world must outlive the pathfinder
+    explicit HierarchicalPathfinder(const World& world);
+    ~HierarchicalPathfinder();
+    
+    HierarchicalPathfinder(const HierarchicalPathfinder&) = delete;
+    HierarchicalPathfinder& operator=(const HierarchicalPathfinder&) = delete;
+    
+    // Tile path from start to goal, both included; empty if there is none
+    std::vector<Vec2> findPath(Vec2 start, Vec2 goal) const;
+    
+    // Coarse route: start, the portal tiles to pass through, then goal.
+    // Walk it leg by leg with refineSegment() to only pay for what is used.
+    bool findWaypoints(Vec2 start, Vec2 goal, std::vector<Vec2>& waypoints) const;
+    std::vector<Vec2> refineSegment(Vec2 from, Vec2 to) const;
+    
+    void onWalkabilityChanged(int x, int y);
+    
+    size_t builtClusters() const { return built.load(std::memory_order_relaxed); }
+    size_t cacheHits() const { return hits.load(std::memory_order_relaxed); }
+    size_t cacheMisses() const { return misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Cluster {
+        int x0 = 0;
+        int y0 = 0;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> walkable;               // Per tile, row-major, cluster-local
+        std::vector<int32_t> nodes;                  // Portal tiles inside this cluster
+        std::vector<std::vector<int32_t>> partners;  // Tiles across the border, per node
+        std::vector<float> costs;                    // nodes x nodes, INF if not connected
+    };
+    
+    struct QueueEntry {
+        float cost;
+        int32_t id;
+        
+        bool operator>(const QueueEntry& other) const { return cost > other.cost; }
+    };
+    
+    // Reverse shortest-path tree toward one goal tile: a Dijkstra search out
+    // from the goal that each query resumes only until its own answer is
+    // settled, so the tree spans about as far as the NPCs using it stand.
+    // Portals are numbered a cluster at a time as the search or a query first
+    // reaches them, within a window of some radius around the goal's cluster.
+    struct GoalTree {
+        std::mutex mutex;  // Held by the query growing or reading the tree
+        int x0 = 0;        // Window, in clusters
+        int y0 = 0;
+        int columns = 0;
+        int rows = 0;
+        std::vector<int32_t> base;               // First node id per window cluster, -1 until numbered
+        std::vector<const Cluster*> window;      // Per window cluster, once numbered
+        std::vector<int32_t> nodeCluster;        // Cluster index of each node
+        std::vector<float> distance;
+        std::vector<int32_t> next;               // Node id of the next portal, or TO_GOAL
+        std::vector<uint8_t> settled;            // distance and next are final
+        std::vector<QueueEntry> open;            // Min-heap of the paused search
+        
+        // Index into base/window, or -1 outside the window
+        int windowIndex(int cluster, int clustersX) const;
+    };
+    
+    static constexpr int32_t TO_GOAL = -2;
+    
+    const World& world;
+    int worldWidth = 0;
+    int worldHeight = 0;
+    int clustersX = 0;
+    int clustersY = 0;
+    
+    // One slot per cluster; null until first query. Filled under buildMutex, read lock-free.
+    std::unique_ptr<std::atomic<Cluster*>[]> clusters;
+    mutable std::mutex buildMutex;
+    mutable std::atomic<size_t> built{0};
+    
+    // Keyed by goal tile (high 32 bits) and window radius
+    using CacheList = std::list<std::pair<int64_t, std::shared_ptr<GoalTree>>>;
+    mutable std::mutex cacheMutex;
+    mutable CacheList cacheOrder;  // Most recent first
+    mutable std::unordered_map<int64_t, CacheList::iterator> cacheLookup;
+    mutable std::atomic<size_t> hits{0};
+    mutable std::atomic<size_t> misses{0};
+    
+    int clusterOf(int32_t tile) const;
+    const Cluster& cluster(int index) const;
+    Cluster* buildCluster(int index) const;
+    void addPortals(Cluster& cluster, int x, int y, int stepX, int stepY, int length,
+                    int outsideX, int outsideY) const;
+    
+    // Costs from source to every tile of the cluster (row-major, cluster-local),
+    // and each tile's predecessor on the way if parent is given. With a target
+    // tile, stops once its cost is final.
+    void clusterDistances(const Cluster& cluster, int32_t source, std::vector<float>& distance,
+                          std::vector<int32_t>* parent = nullptr, int32_t target = -1) const;
+    
+    std::shared_ptr<GoalTree> goalTree(int32_t goalTile, int radius) const;
+    std::shared_ptr<GoalTree> startGoalTree(int32_t goalTile, int radius) const;
+    // First node id of cluster in tree, numbering its portals if needed; -1 outside the window
+    int32_t numberCluster(GoalTree& tree, int cluster) const;
+    // Settles the next node of the paused search; -1 if the entry popped was stale
+    int32_t growTree(GoalTree& tree) const;
+};
+
+} // namespace pw
@@ -0,0 +1,246 @@
+#include "ResourceField.h"
+#include "World.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace pw {
+
+static_assert(ResourceField::BLOCK_SIZE % ResourceField::CELL_SIZE == 0, "cells must tile blocks");
+
+bool ResourceField::tracks(TileType type) {
+    return layerOf(type) >= 0;
+}
+
+int ResourceField::layerOf(TileType type) {
+    switch (type) {
+        case TileType::BerryBush: return 0;
+        case TileType::Tree: return 1;
+        case TileType::Cave: return 2;
+        case TileType::Shelter: return 3;
+        default: return -1;
+    }
+}
+
+bool ResourceField::available(const Tile& tile) {
+    return tile.type != TileType::BerryBush || (tile.hasFood && tile.foodAmount > 0);
+}
+
+int ResourceField::layerOf(const Tile& tile) {
+    return available(tile) ? layerOf(tile.type) : -1;
+}
+
+ResourceField::ResourceField(const World& world)
+    : world(world)
+    , width(world.getWidth())
+    , height(world.getHeight())
+    , cellsX((width + CELL_SIZE - 1) / CELL_SIZE)
+    , cellsY((height + CELL_SIZE - 1) / CELL_SIZE)
+    , blocksX((width + BLOCK_SIZE - 1) / BLOCK_SIZE)
+    , blocksY((height + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+    blocks.reset(new std::atomic<Block*>[static_cast<size_t>(blocksX) * blocksY]());
+}
+
+ResourceField::~ResourceField() {
+    const size_t blockCount = static_cast<size_t>(blocksX) * blocksY;
+    for (size_t i = 0; i < blockCount; i++) {
+        delete blocks[i].load(std::memory_order_relaxed);
+    }
+}
+
+ResourceField::Block::~Block() {
+    for (auto& field : fields) {
+        delete field.load(std::memory_order_relaxed);
+    }
+}
+
+ResourceField::Block& ResourceField::blockAt(int x, int y) const {
+    std::atomic<Block*>& slot = blocks[(y / BLOCK_SIZE) * blocksX + x / BLOCK_SIZE];
+    Block* block = slot.load(std::memory_order_acquire);
+    if (!block) {
+        std::lock_guard<std::mutex> lock(blockMutex);
+        block = slot.load(std::memory_order_relaxed);
+        if (!block) {
+            block = new Block();
+            slot.store(block, std::memory_order_release);
+        }
+    }
+    return *block;
+}
+
+ResourceField::Block* ResourceField::findBlock(int x, int y) const {
+    return blocks[(y / BLOCK_SIZE) * blocksX + x / BLOCK_SIZE].load(std::memory_order_acquire);
+}
+
+int ResourceField::cellSlot(int x, int y) {
+    return (y % BLOCK_SIZE / CELL_SIZE) * BLOCK_CELLS + x % BLOCK_SIZE / CELL_SIZE;
+}
+
+bool ResourceField::nearest(int x, int y, TileType type, float maxDist, int& foundX, int& foundY) const {
+    const int layer = layerOf(type);
+    if (layer < 0) return false;
+    
+    // Whole-tile radii up to FIELD_RADIUS are answered from the field: the
+    // nearest tile within FIELD_RADIUS is also the nearest within maxDist,
+    // if it is that close at all
+    const bool cached = maxDist <= static_cast<float>(FIELD_RADIUS) && maxDist == std::floor(maxDist) &&
+                        x >= 0 && x < width && y >= 0 && y < height;
+    if (!cached) {
+        const int32_t tile = search(layer, x, y, maxDist);
+        if (tile < 0) return false;
+        foundX = tile % width;
+        foundY = tile / width;
+        return true;
+    }
+    
+    std::atomic<uint16_t>& slot = entry(layer, x, y);
+    uint16_t value = slot.load(std::memory_order_relaxed);
+    if (value == UNKNOWN) {
+        // Racing threads compute the same value, so a relaxed store is enough
+        const int32_t tile = search(layer, x, y, static_cast<float>(FIELD_RADIUS));
+        value = NONE;
+        if (tile >= 0) {
+            const int dx = tile % width - x;
+            const int dy = tile / width - y;
+            value = static_cast<uint16_t>(((dx + OFFSET_BIAS) << 8) | (dy + OFFSET_BIAS));
+        }
+        slot.store(value, std::memory_order_relaxed);
+    }
+    if (value == NONE) return false;
+    
+    const int dx = (value >> 8) - OFFSET_BIAS;
+    const int dy = (value & 0xFF) - OFFSET_BIAS;
+    if (static_cast<float>(dx * dx + dy * dy) >= maxDist * maxDist) return false;
+    
+    foundX = x + dx;
+    foundY = y + dy;
+    return true;
+}
+
+int32_t ResourceField::search(int layer, int x, int y, float maxDist) const {
+    const int radius = static_cast<int>(maxDist);
+    float best = maxDist * maxDist;
+    int32_t found = -1;
+    
+    const int minCellX = std::max(0, (x - radius) / CELL_SIZE);
+    const int maxCellX = std::min(cellsX - 1, (x + radius) / CELL_SIZE);
+    const int minCellY = std::max(0, (y - radius) / CELL_SIZE);
+    const int maxCellY = std::min(cellsY - 1, (y + radius) / CELL_SIZE);
+    for (int cy = minCellY; cy <= maxCellY; cy++) {
+        for (int cx = minCellX; cx <= maxCellX; cx++) {
+            indexCell(cx, cy);
+            const int cellX = cx * CELL_SIZE;
+            const int cellY = cy * CELL_SIZE;
+            for (int32_t tile : blockAt(cellX, cellY).cells[layer][cellSlot(cellX, cellY)]) {
+                const int dx = tile % width - x;
+                const int dy = tile / width - y;
+                if (std::abs(dx) > radius || std::abs(dy) > radius) continue;
+                
+                // Same float comparison as a tile scan; equal distances go to the lower tile index
+                const float distSq = static_cast<float>(dx * dx + dy * dy);
+                if (distSq < best || (distSq == best && found >= 0 && tile < found)) {
+                    best = distSq;
+                    found = tile;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+void ResourceField::indexCell(int cx, int cy) const {
+    const int minX = cx * CELL_SIZE;
+    const int minY = cy * CELL_SIZE;
+    Block& block = blockAt(minX, minY);
+    const int cell = cellSlot(minX, minY);
+    std::atomic<uint8_t>& indexed = block.indexed[cell];
+    if (indexed.load(std::memory_order_acquire)) return;
+    
+    std::lock_guard<std::mutex> lock(cellMutex);
+    if (indexed.load(std::memory_order_relaxed)) return;
+    
+    // Row by row, so the cell's lists come out in row-major order
+    const int maxX = std::min(width, minX + CELL_SIZE);
+    const int maxY = std::min(height, minY + CELL_SIZE);
+    for (int y = minY; y < maxY; y++) {
+        for (int x = minX; x < maxX; x++) {
+            const int layer = layerOf(world.getTile(x, y));
+            if (layer < 0) continue;
+            
+            block.cells[layer][cell].push_back(y * width + x);
+            counts[layer]++;
+        }
+    }
+    indexed.store(1, std::memory_order_release);
+}
+
+std::atomic<uint16_t>& ResourceField::entry(int layer, int x, int y) const {
+    std::atomic<Field*>& slot = blockAt(x, y).fields[layer];
+    Field* field = slot.load(std::memory_order_acquire);
+    if (!field) {
+        std::lock_guard<std::mutex> lock(blockMutex);
+        field = slot.load(std::memory_order_relaxed);
+        if (!field) {
+            field = new Field();
+            slot.store(field, std::memory_order_release);
+        }
+    }
+    return (*field)[(y % BLOCK_SIZE) * BLOCK_SIZE + x % BLOCK_SIZE];
+}
+
+void ResourceField::onTileChanged(int x, int y, const Tile& before, const Tile& after) {
+    const int removed = layerOf(before);
+    const int added = layerOf(after);
+    if (removed == added) return;
+    
+    const int32_t tile = y * width + x;
+    
+    // A cell not indexed yet will read the new type when it is
+    Block* block = findBlock(x, y);
+    const int cell = cellSlot(x, y);
+    const bool indexed = block && block->indexed[cell].load(std::memory_order_relaxed);
+    if (removed >= 0) {
+        if (indexed) {
+            std::vector<int32_t>& tiles = block->cells[removed][cell];
+            auto it = std::lower_bound(tiles.begin(), tiles.end(), tile);
+            if (it != tiles.end() && *it == tile) {
+                tiles.erase(it);
+                counts[removed]--;
+            }
+        }
+        clearField(removed, x, y);
+    }
+    
+    if (added >= 0) {
+        if (indexed) {
+            std::vector<int32_t>& tiles = block->cells[added][cell];
+            tiles.insert(std::lower_bound(tiles.begin(), tiles.end(), tile), tile);
+            counts[added]++;
+        }
+        clearField(added, x, y);
+    }
+}
+
+void ResourceField::clearField(int layer, int x, int y) {
+    // Only tiles within FIELD_RADIUS can have cached this one
+    const int minX = std::max(0, x - FIELD_RADIUS);
+    const int maxX = std::min(width - 1, x + FIELD_RADIUS);
+    const int minY = std::max(0, y - FIELD_RADIUS);
+    const int maxY = std::min(height - 1, y + FIELD_RADIUS);
+    for (int ty = minY; ty <= maxY; ty++) {
+        for (int tx = minX; tx <= maxX; tx++) {
+            const Block* block = findBlock(tx, ty);
+            Field* field = block ? block->fields[layer].load(std::memory_order_relaxed) : nullptr;
+            if (field) {
+                (*field)[(ty % BLOCK_SIZE) * BLOCK_SIZE + tx % BLOCK_SIZE].store(UNKNOWN, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+size_t ResourceField::tileCount(TileType type) const {
+    const int layer = layerOf(type);
+    return layer < 0 ? 0 : counts[layer];
+}
+
+} // namespace pw
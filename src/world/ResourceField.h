@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Tile.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pw {
+
+class World;
+
+// Where the resource tiles NPCs search for are (berry bushes, trees, caves
+// and shelters), so "nearest cave" needs no tile scan. Each type's tiles are
+// bucketed by CELL_SIZE cells, indexed the first time a query reaches a cell,
+// and a nearest-tile field caches the answer of every FIELD_RADIUS query per
+// tile, filled in the first time NPCs ask there and cleared around a tile
+// that joins or leaves a type. Berry bushes eaten bare leave the berry layer
+// until they have food again.
+//
+// Both live in BLOCK_SIZE blocks allocated the first time a query reaches
+// them; up front there is one pointer per block. So memory, and the chunks
+// generated to index cells, grow with the area NPCs visit.
+//
+// Queries are safe from several threads; the field is only changed through
+// World::setTile(), in serial phases.
+class ResourceField {
+public:
+    static constexpr int CELL_SIZE = 16;
+    static constexpr int BLOCK_SIZE = 32;   // Field tiles allocated together
+    static constexpr int FIELD_RADIUS = 50;  // Largest query the field caches
+    static constexpr int LAYERS = 4;         // Tracked types
+    
+    static bool tracks(TileType type);
+    
+    // Whether tile counts as one of its type: false for a bush with no food left
+    static bool available(const Tile& tile);
+    
+    // Reads world's tiles as cells are indexed; world must outlive the field
+    explicit ResourceField(const World& world);
+    ~ResourceField();
+    
+    ResourceField(const ResourceField&) = delete;
+    ResourceField& operator=(const ResourceField&) = delete;
+    
+    // Nearest tile of type to (x, y) with dx^2 + dy^2 < maxDist^2 and |dx|,
+    // |dy| <= int(maxDist); ties go to the lowest row, then column, as a
+    // row-major scan of that square would find. False if there is none.
+    bool nearest(int x, int y, TileType type, float maxDist, int& foundX, int& foundY) const;
+    
+    void onTileChanged(int x, int y, const Tile& before, const Tile& after);
+    
+    // Tiles of type in the cells indexed so far
+    size_t tileCount(TileType type) const;
+
+private:
+    // Field entries: offset to the nearest tile within FIELD_RADIUS, biased
+    // into a byte each, or one of these
+    static constexpr uint16_t UNKNOWN = 0;
+    static constexpr uint16_t NONE = 1;
+    static constexpr int OFFSET_BIAS = 64;
+    
+    static constexpr int BLOCK_CELLS = BLOCK_SIZE / CELL_SIZE;  // Cells per block side
+    
+    using Field = std::array<std::atomic<uint16_t>, BLOCK_SIZE * BLOCK_SIZE>;
+    
+    struct Block {
+        // Tile indices per layer and cell, in row-major order, once the cell is indexed
+        std::array<std::array<std::vector<int32_t>, BLOCK_CELLS * BLOCK_CELLS>, LAYERS> cells;
+        std::array<std::atomic<uint8_t>, BLOCK_CELLS * BLOCK_CELLS> indexed{};  // For every layer at once
+        std::array<std::atomic<Field*>, LAYERS> fields{};  // Null until first query
+        
+        ~Block();
+    };
+    
+    const World& world;
+    int width = 0;
+    int height = 0;
+    int cellsX = 0;
+    int cellsY = 0;
+    int blocksX = 0;
+    int blocksY = 0;
+    
+    // One slot per block; null until first query. Filled under blockMutex, read lock-free.
+    std::unique_ptr<std::atomic<Block*>[]> blocks;
+    mutable std::array<size_t, LAYERS> counts{};  // Cells are indexed by const queries
+    mutable std::mutex blockMutex;
+    mutable std::mutex cellMutex;
+    
+    static int layerOf(TileType type);
+    static int layerOf(const Tile& tile);  // -1 unless available
+    Block& blockAt(int x, int y) const;    // Allocates it if needed
+    Block* findBlock(int x, int y) const;  // Null if never reached
+    static int cellSlot(int x, int y);     // Index of (x, y)'s cell in its block
+    void indexCell(int cx, int cy) const;  // Reads the cell's tiles, once
+    std::atomic<uint16_t>& entry(int layer, int x, int y) const;
+    int32_t search(int layer, int x, int y, float maxDist) const;
+    void clearField(int layer, int x, int y);
+};
+
+} // namespace pw
@@ -13,6 +13,14 @@ public:
     
     float noise(float x, float y) const;
     float octaveNoise(float x, float y, int octaves, float persistence) const;
+    
+    // Fills out[row * width + col] with octaveNoise(sx, sy, octaves, persistence)
+    // for the tile grid starting at (x0, y0), where sx = x * scale + offset (and
+    // likewise sy). Evaluates several samples per instruction on SSE2; results
+    // are identical to calling octaveNoise() per tile when the compiler does
+    // not fuse the scalar path's multiply-adds (no -mfma).
+    void fillOctaveNoise(float* out, int x0, int y0, int width, int height,
+                         float scale, float offset, int octaves, float persistence) const;
 
 private:
     std::array<uint8_t, 512> perm;
@@ -17,11 +17,12 @@ enum class TileType : uint8_t {
     Shelter // Player-built
 };
 
+// Unpacked view of a tile; World stores tiles packed (see TileChunk)
 struct Tile {
     TileType type = TileType::Grass;
     bool walkable = true;
     bool hasFood = false;
-    int foodAmount = 0;
+    uint8_t foodAmount = 0;
     
     Color getColor() const;
     bool isResource() const;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Tile.h"
+#include <array>
+#include <cstdint>
+
+namespace pw {
+
+// CHUNK_SIZE x CHUNK_SIZE block of tiles, each packed into 16 bits:
+//   bits 0-3  TileType
+//   bit  4    walkable
+//   bit  5    hasFood
+//   bits 8-15 foodAmount
+struct TileChunk {
+    static constexpr int CHUNK_SIZE = 32;
+    static constexpr int SHIFT = 5;  // log2(CHUNK_SIZE)
+    static constexpr int TILE_COUNT = CHUNK_SIZE * CHUNK_SIZE;
+    
+    static constexpr uint16_t TYPE_MASK = 0x000F;
+    static constexpr uint16_t WALKABLE_BIT = 0x0010;
+    static constexpr uint16_t FOOD_BIT = 0x0020;
+    static constexpr int FOOD_SHIFT = 8;
+    
+    std::array<uint16_t, TILE_COUNT> cells{};
+    bool modified = false;  // Differs from what generation would produce
+    
+    static int localIndex(int x, int y) {
+        return ((y & (CHUNK_SIZE - 1)) << SHIFT) | (x & (CHUNK_SIZE - 1));
+    }
+    
+    static uint16_t pack(const Tile& tile) {
+        uint16_t bits = static_cast<uint16_t>(tile.type) & TYPE_MASK;
+        if (tile.walkable) bits |= WALKABLE_BIT;
+        if (tile.hasFood) bits |= FOOD_BIT;
+        bits |= static_cast<uint16_t>(tile.foodAmount) << FOOD_SHIFT;
+        return bits;
+    }
+    
+    static Tile unpack(uint16_t bits) {
+        Tile tile;
+        tile.type = static_cast<TileType>(bits & TYPE_MASK);
+        tile.walkable = (bits & WALKABLE_BIT) != 0;
+        tile.hasFood = (bits & FOOD_BIT) != 0;
+        tile.foodAmount = static_cast<uint8_t>(bits >> FOOD_SHIFT);
+        return tile;
+    }
+};
+
+static_assert(static_cast<int>(TileType::Shelter) <= TileChunk::TYPE_MASK, "TileType must fit in 4 bits");
+
+} // namespace pw
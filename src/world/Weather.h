@@ -0,0 +1,11 @@
+#pragma once
+
+namespace pw {
+
+enum class Weather {
+    Clear,
+    Rain,
+    Storm
+};
+
+} // namespace pw
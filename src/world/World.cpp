@@ -1,84 +1,487 @@
 #include "World.h"
-#include <random>
+#include "ResourceField.h"
+#include "HierarchicalPathfinder.h"
+#include "engine/Profiler.h"
+#include "serialization/Snapshot.h"
 #include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
 
 namespace pw {
 
-World::World(uint32_t seed) : noise(seed) {
-    tiles.resize(WORLD_WIDTH * WORLD_HEIGHT);
-    generateTerrain();
+World::World(uint32_t seed, int width, int height)
+    : seed(seed), width(std::max(1, width)), height(std::max(1, height)),
+      chunksX((this->width + TileChunk::CHUNK_SIZE - 1) >> TileChunk::SHIFT),
+      chunksY((this->height + TileChunk::CHUNK_SIZE - 1) >> TileChunk::SHIFT),
+      chunkSlots(static_cast<size_t>(chunksX) * chunksY),
+      chunkStates(chunkSlots.size(), ChunkState::Absent),
+      chunkRevisions(chunkSlots.size(), 0),
+      noise(seed), entityIndex(this->width, this->height), weatherRng(CounterRng::streamKey(seed, 0, CounterRng::Weather)) {
+    for (auto& slot : chunkSlots) {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
     
     // Initialize weather
-    std::mt19937 rng(seed);
-    std::uniform_real_distribution<float> dist(10.0f, 30.0f);
-    weatherDuration = dist(rng);
+    weatherDuration = weatherRng.uniform(10.0f, 30.0f);
 }
 
-void World::generateTerrain() {
-    for (int y = 0; y < WORLD_HEIGHT; y++) {
-        for (int x = 0; x < WORLD_WIDTH; x++) {
-            float elevation = noise.octaveNoise(x * 0.05f, y * 0.05f, 4, 0.5f);
-            float moisture = noise.octaveNoise(x * 0.03f + 100, y * 0.03f + 100, 3, 0.5f);
-            float detail = noise.octaveNoise(x * 0.2f, y * 0.2f, 2, 0.4f);
-            
-            Tile& tile = getTile(x, y);
-            
-            // Determine tile type based on noise
-            if (elevation < -0.3f) {
-                tile.type = TileType::Water;
-                tile.walkable = false;
-            } else if (elevation < -0.15f) {
-                tile.type = TileType::Sand;
-            } else if (elevation > 0.5f) {
-                if (moisture < -0.2f) {
-                    tile.type = TileType::Stone;
-                } else if (detail > 0.3f && moisture > 0.0f) {
-                    tile.type = TileType::Cave;
-                } else {
-                    tile.type = TileType::Stone;
-                }
-            } else {
-                // Mid elevation - grass, dirt, vegetation
-                if (moisture > 0.3f && detail > 0.4f) {
-                    tile.type = TileType::Tree;
-                    tile.walkable = false;
-                } else if (moisture > 0.0f && detail > 0.5f) {
-                    tile.type = TileType::BerryBush;
-                    tile.hasFood = true;
-                    tile.foodAmount = 5;
-                } else if (moisture < -0.2f) {
-                    tile.type = TileType::Dirt;
-                } else {
-                    tile.type = TileType::Grass;
-                }
+World::~World() {
+    for (auto& slot : chunkSlots) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+namespace {
+
+constexpr uint32_t TERRAIN_MAGIC = 0x52545750;  // "PWTR"
+constexpr uint32_t TERRAIN_VERSION = 1;         // Bump when generation rules change
+
+struct TerrainHeader {
+    uint32_t magic = TERRAIN_MAGIC;
+    uint32_t version = TERRAIN_VERSION;
+    uint32_t seed = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    uint32_t chunkSize = TileChunk::CHUNK_SIZE;
+};
+
+} // namespace
+
+Tile World::classifyTile(float elevation, float moisture, float detail) {
+    Tile tile;
+    
+    // Determine tile type based on noise
+    if (elevation < -0.3f) {
+        tile.type = TileType::Water;
+        tile.walkable = false;
+    } else if (elevation < -0.15f) {
+        tile.type = TileType::Sand;
+    } else if (elevation > 0.5f) {
+        if (moisture < -0.2f) {
+            tile.type = TileType::Stone;
+        } else if (detail > 0.3f && moisture > 0.0f) {
+            tile.type = TileType::Cave;
+        } else {
+            tile.type = TileType::Stone;
+        }
+    } else {
+        // Mid elevation - grass, dirt, vegetation
+        if (moisture > 0.3f && detail > 0.4f) {
+            tile.type = TileType::Tree;
+            tile.walkable = false;
+        } else if (moisture > 0.0f && detail > 0.5f) {
+            tile.type = TileType::BerryBush;
+            tile.hasFood = true;
+            tile.foodAmount = 5;
+        } else if (moisture < -0.2f) {
+            tile.type = TileType::Dirt;
+        } else {
+            tile.type = TileType::Grass;
+        }
+    }
+    return tile;
+}
+
+void World::generateChunk(TileChunk& chunk, int chunkIndex) const {
+    const int originX = (chunkIndex % chunksX) << TileChunk::SHIFT;
+    const int originY = (chunkIndex / chunksX) << TileChunk::SHIFT;
+    constexpr int SIZE = TileChunk::CHUNK_SIZE;
+    
+    // Edge chunks are filled out to full size; cells past the map are never read
+    std::array<float, TileChunk::TILE_COUNT> elevation;
+    std::array<float, TileChunk::TILE_COUNT> moisture;
+    std::array<float, TileChunk::TILE_COUNT> detail;
+    noise.fillOctaveNoise(elevation.data(), originX, originY, SIZE, SIZE, 0.05f, 0.0f, 4, 0.5f);
+    noise.fillOctaveNoise(moisture.data(), originX, originY, SIZE, SIZE, 0.03f, 100.0f, 3, 0.5f);
+    noise.fillOctaveNoise(detail.data(), originX, originY, SIZE, SIZE, 0.2f, 0.0f, 2, 0.4f);
+    
+    for (int i = 0; i < TileChunk::TILE_COUNT; i++) {
+        chunk.cells[i] = TileChunk::pack(classifyTile(elevation[i], moisture[i], detail[i]));
+    }
+    chunk.modified = false;
+}
+
+TileChunk& World::chunkAt(int x, int y) const {
+    const int chunkIndex = chunkIndexOf(x, y);
+    TileChunk* chunk = chunkSlots[chunkIndex].load(std::memory_order_acquire);
+    if (chunk) {
+        return *chunk;
+    }
+    return loadChunk(chunkIndex);
+}
+
+TileChunk& World::loadChunk(int chunkIndex) const {
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    
+    // Another reader may have filled it while we waited
+    TileChunk* chunk = chunkSlots[chunkIndex].load(std::memory_order_relaxed);
+    if (chunk) {
+        return *chunk;
+    }
+    
+    chunk = createChunk(chunkIndex);
+    chunkSlots[chunkIndex].store(chunk, std::memory_order_release);
+    return *chunk;
+}
+
+TileChunk* World::createChunk(int chunkIndex) const {
+    auto chunk = std::make_unique<TileChunk>();
+    if (chunkStates[chunkIndex] != ChunkState::Paged) {
+        generateChunk(*chunk, chunkIndex);
+    } else if (!pageIn(chunkIndex, *chunk)) {
+        generateChunk(*chunk, chunkIndex);
+        chunkRevisions[chunkIndex]++;  // The edits are gone
+    }
+    chunkStates[chunkIndex] = ChunkState::Resident;
+    resident.fetch_add(1, std::memory_order_relaxed);
+    return chunk.release();
+}
+
+void World::generateChunks(JobSystem& jobs) {
+    // Each chunk is a pure function of its index, and each job owns its slots
+    jobs.parallelFor(chunkSlots.size(), 1, [this](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            if (!chunkSlots[i].load(std::memory_order_relaxed)) {
+                chunkSlots[i].store(createChunk(static_cast<int>(i)), std::memory_order_release);
             }
         }
+    });
+}
+
+std::string World::terrainCacheName() const {
+    return "terrain_" + std::to_string(seed) + "_" + std::to_string(width) + "x" +
+           std::to_string(height) + ".bin";
+}
+
+bool World::loadTerrain(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
     }
+    
+    TerrainHeader expected;
+    expected.seed = seed;
+    expected.width = width;
+    expected.height = height;
+    TerrainHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(&header, &expected, sizeof(header)) != 0) {
+        std::cerr << "Warning: Ignoring stale terrain cache " << path << std::endl;
+        return false;
+    }
+    
+    std::vector<std::unique_ptr<TileChunk>> loaded(chunkSlots.size());
+    for (auto& chunk : loaded) {
+        chunk = std::make_unique<TileChunk>();
+        file.read(reinterpret_cast<char*>(chunk->cells.data()), sizeof(chunk->cells));
+    }
+    if (!file) {
+        std::cerr << "Warning: Truncated terrain cache " << path << std::endl;
+        return false;
+    }
+    
+    // Only fill chunks nobody has touched yet
+    for (size_t i = 0; i < loaded.size(); i++) {
+        if (chunkSlots[i].load(std::memory_order_relaxed) || chunkStates[i] == ChunkState::Paged) continue;
+        chunkStates[i] = ChunkState::Resident;
+        resident.fetch_add(1, std::memory_order_relaxed);
+        chunkSlots[i].store(loaded[i].release(), std::memory_order_release);
+    }
+    return true;
 }
 
-Tile& World::getTile(int x, int y) {
-    if (x < 0 || x >= WORLD_WIDTH || y < 0 || y >= WORLD_HEIGHT) {
-        static Tile invalid;
-        invalid.walkable = false;
-        return invalid;
+bool World::saveTerrain(const std::string& path) const {
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, error);
+    }
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Warning: Could not write terrain cache " << path << std::endl;
+        return false;
+    }
+    
+    TerrainHeader header;
+    header.seed = seed;
+    header.width = width;
+    header.height = height;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    TileChunk generated;
+    for (size_t i = 0; i < chunkSlots.size(); i++) {
+        TileChunk* chunk = chunkSlots[i].load(std::memory_order_acquire);
+        if (!chunk || chunk->modified) {
+            generateChunk(generated, static_cast<int>(i));
+            chunk = &generated;
+        }
+        file.write(reinterpret_cast<const char*>(chunk->cells.data()), sizeof(chunk->cells));
+    }
+    
+    if (!file) {
+        std::cerr << "Warning: Could not write terrain cache " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void World::evictChunks(const std::vector<Vec2>& anchors, float keepRadius) {
+    const float keepSq = keepRadius * keepRadius;
+    
+    for (int chunkIndex = 0; chunkIndex < static_cast<int>(chunkSlots.size()); chunkIndex++) {
+        TileChunk* chunk = chunkSlots[chunkIndex].load(std::memory_order_relaxed);
+        if (!chunk) continue;
+        
+        // Distance from each anchor to the nearest point of the chunk
+        const float minX = static_cast<float>((chunkIndex % chunksX) << TileChunk::SHIFT);
+        const float minY = static_cast<float>((chunkIndex / chunksX) << TileChunk::SHIFT);
+        const float maxX = minX + TileChunk::CHUNK_SIZE;
+        const float maxY = minY + TileChunk::CHUNK_SIZE;
+        bool needed = false;
+        for (const Vec2& anchor : anchors) {
+            float dx = std::max({minX - anchor.x, 0.0f, anchor.x - maxX});
+            float dy = std::max({minY - anchor.y, 0.0f, anchor.y - maxY});
+            if (dx * dx + dy * dy <= keepSq) {
+                needed = true;
+                break;
+            }
+        }
+        if (needed) continue;
+        
+        // Edited chunks can't be regenerated; keep them unless they page out
+        ChunkState state = ChunkState::Absent;
+        if (chunk->modified) {
+            if (pageDirectory.empty() || !pageOut(chunkIndex, *chunk)) continue;
+            state = ChunkState::Paged;
+        }
+        
+        chunkStates[chunkIndex] = state;
+        chunkSlots[chunkIndex].store(nullptr, std::memory_order_relaxed);
+        resident.fetch_sub(1, std::memory_order_relaxed);
+        delete chunk;
     }
-    return tiles[y * WORLD_WIDTH + x];
 }
 
-const Tile& World::getTile(int x, int y) const {
-    if (x < 0 || x >= WORLD_WIDTH || y < 0 || y >= WORLD_HEIGHT) {
-        static Tile invalid;
+void World::setPageDirectory(const std::string& directory) {
+    pageDirectory = directory;
+    if (pageDirectory.empty()) return;
+    
+    std::error_code error;
+    std::filesystem::create_directories(pageDirectory, error);
+    if (error) {
+        std::cerr << "Warning: Could not create chunk page directory " << pageDirectory
+                  << ": " << error.message() << std::endl;
+        pageDirectory.clear();
+    }
+}
+
+std::string World::pagePath(int chunkIndex) const {
+    return pageDirectory + "/chunk_" + std::to_string(chunkIndex % chunksX) + "_" +
+           std::to_string(chunkIndex / chunksX) + ".bin";
+}
+
+bool World::pageOut(int chunkIndex, const TileChunk& chunk) const {
+    std::ofstream file(pagePath(chunkIndex), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(chunk.cells.data()), sizeof(chunk.cells));
+    if (!file) {
+        std::cerr << "Warning: Could not page out chunk to " << pagePath(chunkIndex) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool World::pageIn(int chunkIndex, TileChunk& chunk) const {
+    std::ifstream file(pagePath(chunkIndex), std::ios::binary);
+    file.read(reinterpret_cast<char*>(chunk.cells.data()), sizeof(chunk.cells));
+    if (!file) {
+        std::cerr << "Warning: Could not page in chunk from " << pagePath(chunkIndex)
+                  << ", regenerating" << std::endl;
+        return false;
+    }
+    chunk.modified = true;
+    return true;
+}
+
+Tile World::getTile(int x, int y) const {
+    if (!inBounds(x, y)) {
+        Tile invalid;
         invalid.walkable = false;
         return invalid;
     }
-    return tiles[y * WORLD_WIDTH + x];
+    return TileChunk::unpack(chunkAt(x, y).cells[TileChunk::localIndex(x, y)]);
 }
 
 bool World::isWalkable(int x, int y) const {
-    return getTile(x, y).walkable;
+    if (!inBounds(x, y)) return false;
+    return (chunkAt(x, y).cells[TileChunk::localIndex(x, y)] & TileChunk::WALKABLE_BIT) != 0;
+}
+
+uint32_t World::chunkRevisionAt(int x, int y) const {
+    chunkAt(x, y);
+    return chunkRevisions[chunkIndexOf(x, y)];
+}
+
+void World::setTile(int x, int y, const Tile& tile) {
+    if (!inBounds(x, y)) {
+        return;
+    }
+    
+    TileChunk& chunk = chunkAt(x, y);
+    uint16_t& cell = chunk.cells[TileChunk::localIndex(x, y)];
+    const Tile previous = TileChunk::unpack(cell);
+    bool walkabilityChanged = ((cell & TileChunk::WALKABLE_BIT) != 0) != tile.walkable;
+    cell = TileChunk::pack(tile);
+    chunk.modified = true;
+    chunkRevisions[chunkIndexOf(x, y)]++;
+    
+    if (resources) {
+        resources->onTileChanged(x, y, previous, tile);
+    }
+    if (navigation && walkabilityChanged) {
+        navigation->onWalkabilityChanged(x, y);
+    }
+}
+
+Vec2 World::nearestTile(int x, int y, TileType type, float maxDist) const {
+    if (resources && ResourceField::tracks(type)) {
+        int foundX = 0;
+        int foundY = 0;
+        if (!resources->nearest(x, y, type, maxDist, foundX, foundY)) {
+            return Vec2(-1, -1);
+        }
+        return Vec2(static_cast<float>(foundX), static_cast<float>(foundY));
+    }
+    
+    const int searchRadius = static_cast<int>(maxDist);
+    float minDist = maxDist * maxDist;
+    Vec2 nearest(-1, -1);
+    
+    for (int dy = -searchRadius; dy <= searchRadius; dy++) {
+        for (int dx = -searchRadius; dx <= searchRadius; dx++) {
+            const int tx = x + dx;
+            const int ty = y + dy;
+            if (!inBounds(tx, ty)) {
+                continue;
+            }
+            
+            const Tile tile = getTile(tx, ty);
+            if (tile.type == type && ResourceField::available(tile)) {
+                float distSq = static_cast<float>(dx * dx + dy * dy);
+                if (distSq < minDist) {
+                    minDist = distSq;
+                    nearest = Vec2(static_cast<float>(tx), static_cast<float>(ty));
+                }
+            }
+        }
+    }
+    
+    return nearest;
+}
+
+void World::indexResources() {
+    PW_PROFILE_ZONE("World::indexResources");
+    resources.reset();  // setTile() must not reach a half-built field
+    resources = std::make_unique<ResourceField>(*this);
+}
+
+void World::indexNavigation() {
+    navigation.reset();
+    navigation = std::make_unique<HierarchicalPathfinder>(*this);
+}
+
+bool World::consumeFood(int x, int y) {
+    if (!inBounds(x, y)) {
+        return false;
+    }
+    
+    Tile tile = getTile(x, y);
+    if (!tile.hasFood || tile.foodAmount == 0) {
+        return false;
+    }
+    
+    tile.foodAmount--;
+    if (tile.foodAmount == 0) {
+        tile.hasFood = false;
+    }
+    // Through setTile(), so a bush eaten bare leaves the resource field
+    setTile(x, y, tile);
+    return true;
+}
+
+void World::writeSnapshot(SnapshotWriter& out) const {
+    out.section(snapshot::WORLD);
+    out.write(timeOfDay);
+    out.write(dayNightSpeed);
+    out.write(currentWeather);
+    out.write(weatherTimer);
+    out.write(weatherDuration);
+    out.writeRng(weatherRng);
+    
+    // Unedited chunks regenerate from the seed
+    std::vector<int32_t> edited;
+    for (size_t i = 0; i < chunkSlots.size(); i++) {
+        TileChunk* chunk = chunkSlots[i].load(std::memory_order_acquire);
+        if ((chunk && chunk->modified) || (!chunk && chunkStates[i] == ChunkState::Paged)) {
+            edited.push_back(static_cast<int32_t>(i));
+        }
+    }
+    
+    out.write(static_cast<uint32_t>(edited.size()));
+    TileChunk paged;
+    for (int32_t chunkIndex : edited) {
+        const TileChunk* chunk = chunkSlots[chunkIndex].load(std::memory_order_acquire);
+        if (!chunk) {
+            if (!pageIn(chunkIndex, paged)) {
+                generateChunk(paged, chunkIndex);
+            }
+            chunk = &paged;
+        }
+        out.write(chunkIndex);
+        out.write(chunk->cells);
+    }
+}
+
+bool World::readSnapshot(SnapshotReader& in) {
+    in.section(snapshot::WORLD);
+    in.read(timeOfDay);
+    in.read(dayNightSpeed);
+    in.read(currentWeather);
+    in.read(weatherTimer);
+    in.read(weatherDuration);
+    in.readRng(weatherRng);
+    
+    uint32_t editedCount = 0;
+    if (!in.read(editedCount) || editedCount > chunkSlots.size()) {
+        return false;
+    }
+    for (uint32_t n = 0; n < editedCount; n++) {
+        int32_t chunkIndex = -1;
+        if (!in.read(chunkIndex) || chunkIndex < 0 || chunkIndex >= static_cast<int32_t>(chunkSlots.size())) {
+            return false;
+        }
+        
+        TileChunk* chunk = chunkSlots[chunkIndex].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new TileChunk();
+            chunkStates[chunkIndex] = ChunkState::Resident;
+            resident.fetch_add(1, std::memory_order_relaxed);
+            chunkSlots[chunkIndex].store(chunk, std::memory_order_release);
+        }
+        if (!in.read(chunk->cells)) {
+            return false;
+        }
+        chunk->modified = true;
+        chunkRevisions[chunkIndex]++;
+    }
+    return in.ok();
 }
 
 void World::update(float dt) {
+    PW_PROFILE_ZONE("World::update");
     updateDayNight(dt);
     updateWeather(dt);
 }
@@ -97,12 +500,7 @@ void World::updateWeather(float dt) {
         weatherTimer = 0.0f;
         
         // Change weather
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<float> chanceDist(0.0f, 1.0f);
-        std::uniform_real_distribution<float> durationDist(10.0f, 30.0f);
-        
-        float chance = chanceDist(gen);
+        float chance = weatherRng.uniform();
         if (currentWeather == Weather::Clear) {
             if (chance < 0.3f) {
                 currentWeather = Weather::Rain;
@@ -115,7 +513,7 @@ void World::updateWeather(float dt) {
             }
         }
         
-        weatherDuration = durationDist(gen);
+        weatherDuration = weatherRng.uniform(10.0f, 30.0f);
     }
 }
 
@@ -1,43 +1,157 @@
 #pragma once
 
 #include "Tile.h"
+#include "TileChunk.h"
+#include "Weather.h"
+#include "EntityIndex.h"
 #include "SimplexNoise.h"
+#include "engine/JobSystem.h"
 #include "engine/Types.h"
-#include <vector>
+#include "engine/Random.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace pw {
 
-enum class Weather {
-    Clear,
-    Rain,
-    Storm
-};
+class HierarchicalPathfinder;
+class ResourceField;
+class SnapshotReader;
+class SnapshotWriter;
 
+// Tile map stored as TileChunk::CHUNK_SIZE square chunks. A chunk is generated
+// the first time any of its tiles is read, so startup cost and memory scale
+// with the area NPCs actually visit. evictChunks() drops chunks far from every
+// anchor; modified chunks are paged to disk if a page directory is set, and
+// otherwise stay resident.
+//
+// Reads (including the lazy generation behind them) are safe from several
+// threads. Writes and eviction must happen in serial phases.
 class World {
 public:
-    World(uint32_t seed = 42);
+    World(uint32_t seed = 42, int width = WORLD_WIDTH, int height = WORLD_HEIGHT);
+    ~World();
+    
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
     
     void update(float dt);
     
-    Tile& getTile(int x, int y);
-    const Tile& getTile(int x, int y) const;
+    // Out-of-bounds tiles read as unwalkable grass
+    Tile getTile(int x, int y) const;
     bool isWalkable(int x, int y) const;
     
+    // Replace a tile (e.g. building a Shelter); the resource field and
+    // navigation layer are kept up to date
+    void setTile(int x, int y, const Tile& tile);
+    
+    // Take one unit of food from the tile, as a setTile(); returns false if it had none
+    bool consumeFood(int x, int y);
+    
+    // Nearest tile of type to (x, y) closer than maxDist, searching the square
+    // of side 2 * int(maxDist) + 1 around it; ties go to the lowest row, then
+    // column. (-1, -1) if there is none; bushes with no food left don't
+    // count. Berry bushes, trees, caves and shelters come from the resource
+    // field once indexResources() has set it up; other types, or a world
+    // without one, are scanned tile by tile.
+    Vec2 nearestTile(int x, int y, TileType type, float maxDist) const;
+    
+    // Set up the resource field, which indexes tiles as queries reach them;
+    // setTile() keeps it up to date afterwards. Call from a serial phase.
+    void indexResources();
+    const ResourceField* getResourceField() const { return resources.get(); }
+    
+    // Set up the navigation layer for long path queries, which builds its
+    // clusters as queries reach them; setTile() keeps it up to date
+    // afterwards. Call from a serial phase.
+    void indexNavigation();
+    const HierarchicalPathfinder* getNavigation() const { return navigation.get(); }
+    
     float getTimeOfDay() const { return timeOfDay; }
     Weather getWeather() const { return currentWeather; }
     Color getDayNightTint() const;
     
-    int getWidth() const { return WORLD_WIDTH; }
-    int getHeight() const { return WORLD_HEIGHT; }
+    // NPC positions, rebuilt by the engine once per tick after NPCs move
+    EntityIndex& getEntityIndex() { return entityIndex; }
+    const EntityIndex& getEntityIndex() const { return entityIndex; }
+    
+    uint32_t getSeed() const { return seed; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    
+    // Chunk streaming. Chunks with no anchor within keepRadius tiles are
+    // released; call from a serial phase only.
+    void evictChunks(const std::vector<Vec2>& anchors, float keepRadius);
+    void setPageDirectory(const std::string& directory);
+    size_t residentChunks() const { return resident.load(std::memory_order_relaxed); }
+    size_t totalChunks() const { return chunkSlots.size(); }
+    
+    // Chunk grid (index = cy * chunkColumns() + cx). A chunk's revision is
+    // bumped whenever one of its tiles changes and survives eviction, so
+    // per-chunk caches (see TileMapRenderer) know when to rebuild.
+    int chunkColumns() const { return chunksX; }
+    int chunkRows() const { return chunksY; }
+    uint32_t chunkRevision(int chunkIndex) const { return chunkRevisions[chunkIndex]; }
+    
+    // Revision of the chunk holding tile (x, y), which must be in bounds. Loads
+    // the chunk first, so the value can't change until the next serial phase.
+    uint32_t chunkRevisionAt(int x, int y) const;
+    
+    // Generates every chunk not yet resident, spread over the job system.
+    // Output does not depend on the thread count. Call from a serial phase.
+    void generateChunks(JobSystem& jobs);
+    
+    // Generated terrain cached on disk, keyed by seed and size (see
+    // terrainCacheName()). Edits are not cached: modified chunks are saved as
+    // generated. loadTerrain() returns false if the file is missing or stale.
+    std::string terrainCacheName() const;
+    bool loadTerrain(const std::string& path);
+    bool saveTerrain(const std::string& path) const;
+    
+    // Time, weather and every edited chunk. Seed and size are constructor
+    // arguments, so the caller records those; read into a World built with
+    // them, before indexResources() and indexNavigation().
+    void writeSnapshot(SnapshotWriter& out) const;
+    bool readSnapshot(SnapshotReader& in);
 
 private:
-    void generateTerrain();
+    enum class ChunkState : uint8_t { Absent, Resident, Paged };
+    
     void updateDayNight(float dt);
     void updateWeather(float dt);
     
-    std::vector<Tile> tiles;
+    static Tile classifyTile(float elevation, float moisture, float detail);
+    TileChunk& chunkAt(int x, int y) const;
+    TileChunk& loadChunk(int chunkIndex) const;
+    TileChunk* createChunk(int chunkIndex) const;
+    void generateChunk(TileChunk& chunk, int chunkIndex) const;
+    std::string pagePath(int chunkIndex) const;
+    bool pageOut(int chunkIndex, const TileChunk& chunk) const;
+    bool pageIn(int chunkIndex, TileChunk& chunk) const;
+    bool inBounds(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    int chunkIndexOf(int x, int y) const { return (y >> TileChunk::SHIFT) * chunksX + (x >> TileChunk::SHIFT); }
+    
+    uint32_t seed;
+    int width;
+    int height;
+    int chunksX;
+    int chunksY;
+    
+    // One slot per chunk; null until first access. Filled under chunkMutex,
+    // read lock-free.
+    mutable std::vector<std::atomic<TileChunk*>> chunkSlots;
+    mutable std::vector<ChunkState> chunkStates;  // Guarded by chunkMutex
+    mutable std::vector<uint32_t> chunkRevisions;  // Written in serial phases or under chunkMutex
+    mutable std::mutex chunkMutex;
+    mutable std::atomic<size_t> resident{0};
+    std::string pageDirectory;
+    
     SimplexNoise noise;
+    EntityIndex entityIndex;
+    std::unique_ptr<ResourceField> resources;
+    std::unique_ptr<HierarchicalPathfinder> navigation;
     
     float timeOfDay = 0.0f; // 0.0 = midnight, 0.5 = noon, 1.0 = midnight
     float dayNightSpeed = 0.02f; // Full day cycle takes ~50 seconds
@@ -45,6 +159,7 @@ private:
     Weather currentWeather = Weather::Clear;
     float weatherTimer = 0.0f;
     float weatherDuration = 0.0f;
+    CounterRng weatherRng;  // Derived from the world seed so runs are reproducible
 };
 
 } // namespace pw
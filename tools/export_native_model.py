@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""
+Export a trained NPC brain to the simulator's native weights format (.pwnn),
+which it runs with its built-in inference engine - no ONNX Runtime needed.
+Must match NativeModel::load() in src/ai/neural/NativeModel.cpp.
+"""
+
+import argparse
+import os
+import struct
+
+import torch
+
+from model_architecture import create_model
+
+
+NATIVE_MODEL_MAGIC = 0x4D4E5750  # "PWNM"
+NATIVE_MODEL_VERSION = 1
+
+
+def native_tensor_names(n_layers):
+    """State dict entries in the order the loader reads them"""
+    names = [
+        'perception_encoder.0.weight', 'perception_encoder.0.bias',
+        'perception_encoder.3.weight', 'perception_encoder.3.bias',
+        'memory_encoder.0.weight', 'memory_encoder.0.bias',
+        'pos_encoding.pe',
+    ]
+    for layer in range(n_layers):
+        prefix = f'attention_blocks.{layer}.'
+        names += [prefix + name for name in (
+            'attention.in_proj_weight', 'attention.in_proj_bias',
+            'attention.out_proj.weight', 'attention.out_proj.bias',
+            'norm1.weight', 'norm1.bias',
+            'ffn.0.weight', 'ffn.0.bias',
+            'ffn.3.weight', 'ffn.3.bias',
+            'norm2.weight', 'norm2.bias',
+        )]
+    names += [
+        'action_head.0.weight', 'action_head.0.bias',
+        'action_head.3.weight', 'action_head.3.bias',
+        'emotion_head.0.weight', 'emotion_head.0.bias',
+        'emotion_head.3.weight', 'emotion_head.3.bias',
+    ]
+    return names
+
+
+def export_native(model, output_path):
+    """Write model's weights as a .pwnn file (through a temporary file, so a
+    simulator hot-reloading it never reads a partial one)"""
+    n_layers = len(model.attention_blocks)
+    n_heads = model.attention_blocks[0].attention.num_heads
+    state = model.state_dict()
+
+    temporary_path = output_path + '.tmp'
+    with open(temporary_path, 'wb') as f:
+        f.write(struct.pack('<8I', NATIVE_MODEL_MAGIC, NATIVE_MODEL_VERSION,
+                            model.perception_dim, model.memory_seq_len, model.memory_dim,
+                            model.d_model, n_heads, n_layers))
+        for name in native_tensor_names(n_layers):
+            values = state[name].detach().cpu().float().contiguous().flatten().tolist()
+            f.write(struct.pack('<Q', len(values)))
+            f.write(struct.pack(f'<{len(values)}f', *values))
+    os.replace(temporary_path, output_path)
+
+    print(f"Native model exported to {output_path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Export an NPC brain checkpoint for native inference')
+    parser.add_argument('--checkpoint', type=str, default='models/npc_brain_best.pth',
+                        help='PyTorch state dict saved by train_npc_brain.py')
+    parser.add_argument('--output', type=str, default='models/npc_brain.pwnn',
+                        help='Output weights file')
+    args = parser.parse_args()
+
+    model = create_model()
+    model.load_state_dict(torch.load(args.checkpoint, map_location='cpu'))
+    model.eval()
+    export_native(model, args.output)
+
+
+if __name__ == '__main__':
+    main()
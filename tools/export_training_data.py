@@ -1,7 +1,7 @@
 #!/usr/bin/env python3
 """
 Data export tool for Pixel World Simulator
-Converts JSON logs to PyTorch-ready tensor datasets
+Converts JSON or binary logs to PyTorch-ready tensor datasets
 """
 
 import json
@@ -11,18 +11,84 @@ from pathlib import Path
 from typing import List, Dict, Any
 
 
+# Binary decision log (decisions.bin), written with --log-format binary.
+# Must match DecisionRecord in src/data/DecisionRecord.h.
+BINARY_LOG_MAGIC = 0x4C445750  # "PWDL"
+BINARY_SCHEMA_VERSION = 1
+BINARY_HEADER_SIZE = 16
+
+RECORD_DTYPE = np.dtype([
+    ('tick', '<u8'),
+    ('npc_id', '<u4'),
+    ('position', '<f4', (2,)),
+    ('needs', '<f4', (5,)),            # hunger, energy, social, curiosity, safety
+    ('time_of_day', '<f4'),
+    ('view_origin', '<i4', (2,)),
+    ('target_position', '<f4', (2,)),
+    ('target_entity', '<u4'),
+    ('needs_delta', '<f4', (5,)),
+    ('weather', 'u1'),                 # 0 clear, 1 rain, 2 storm
+    ('action_type', 'u1'),             # Index into CLASS_NAMES
+    ('nearby_npc_count', 'u1'),
+    ('memory_recall_count', 'u1'),
+    ('tiles', 'u1', (121,)),           # TileType, 255 = outside the world
+    ('memory_recalls', 'u1', (16,)),
+    ('reserved', 'u1', (7,)),
+    ('nearby_npc_ids', '<u4', (16,)),
+    ('nearby_npc_positions', '<f4', (16, 2)),
+])
+assert RECORD_DTYPE.itemsize == 424
+
+# TileType values counted as food/shelter (same categories as the JSONL schema)
+TILE_BERRY_BUSH = 6
+TILE_CAVE = 7
+
+CLASS_NAMES = [
+    'idle', 'move', 'forage', 'eat', 'rest', 'explore',
+    'socialize', 'build_shelter', 'seek_shelter'
+]
+
+
+def open_binary_log(path: Path) -> np.ndarray:
+    """Memory-map a decisions.bin file as a structured array (no parsing)"""
+    header = np.fromfile(path, dtype='<u4', count=4)
+    if len(header) < 4 or header[0] != BINARY_LOG_MAGIC:
+        raise ValueError(f"{path} is not a binary decision log")
+    if header[1] != BINARY_SCHEMA_VERSION or header[2] != RECORD_DTYPE.itemsize:
+        raise ValueError(f"{path} has schema version {header[1]} with {header[2]}-byte records; "
+                         f"expected version {BINARY_SCHEMA_VERSION} with {RECORD_DTYPE.itemsize}-byte records")
+    
+    payload = path.stat().st_size - BINARY_HEADER_SIZE
+    count = payload // RECORD_DTYPE.itemsize
+    if count == 0:
+        return np.zeros(0, dtype=RECORD_DTYPE)
+    return np.memmap(path, dtype=RECORD_DTYPE, mode='r', offset=BINARY_HEADER_SIZE, shape=(count,))
+
+
 class DataProcessor:
     def __init__(self, log_dir: str = "data_logs"):
         self.log_dir = Path(log_dir)
         self.decisions = []
+        self.records = None  # Structured array when reading decisions.bin
         self.events = []
         
-    def load_logs(self):
+    def load_logs(self, log_format: str = 'auto'):
         """Load all decision and event logs"""
         decisions_file = self.log_dir / "decisions.jsonl"
+        binary_file = self.log_dir / "decisions.bin"
         events_file = self.log_dir / "events.jsonl"
         
-        if decisionsfile.exists():
+        if log_format == 'auto':
+            # Prefer whichever file the latest run wrote
+            log_format = 'jsonl'
+            if binary_file.exists() and (not decisions_file.exists() or
+                                         binary_file.stat().st_mtime >= decisions_file.stat().st_mtime):
+                log_format = 'binary'
+        
+        if log_format == 'binary':
+            if binary_file.exists():
+                self.records = open_binary_log(binary_file)
+        elif decisions_file.exists():
             with open(decisions_file, 'r') as f:
                 for line in f:
                     try:
@@ -42,7 +108,34 @@ class DataProcessor:
                     except json.JSONDecodeError:
                         continue
         
-        print(f"Loaded {len(self.decisions)} decisions and {len(self.events)} events")
+        print(f"Loaded {self.num_decisions()} decisions and {len(self.events)} events")
+    
+    def num_decisions(self) -> int:
+        return len(self.records) if self.records is not None else len(self.decisions)
+    
+    def extract_features_binary(self, records: np.ndarray) -> np.ndarray:
+        """Vectorized extract_features() for binary records"""
+        n = len(records)
+        features = np.zeros((n, 13), dtype=np.float32)
+        
+        features[:, 0:5] = records['needs']
+        features[:, 5] = records['time_of_day']
+        
+        weather = records['weather']
+        features[:, 6] = weather == 0
+        features[:, 7] = weather == 1
+        features[:, 8] = weather == 2
+        
+        tiles = records['tiles']
+        food_count = (tiles == TILE_BERRY_BUSH).sum(axis=1)
+        shelter_count = (tiles == TILE_CAVE).sum(axis=1)
+        features[:, 9] = np.minimum(food_count / 10.0, 1.0)
+        features[:, 10] = np.minimum(shelter_count / 10.0, 1.0)
+        
+        features[:, 11] = np.minimum(records['nearby_npc_count'] / 10.0, 1.0)
+        features[:, 12] = np.minimum(records['memory_recall_count'] / 5.0, 1.0)
+        
+        return features
     
     def extract_features(self, perception: Dict[str, Any]) -> np.ndarray:
         """Extract numerical features from perception data"""
@@ -107,19 +200,23 @@ class DataProcessor:
         output_path = Path(output_dir)
         output_path.mkdir(exist_ok=True)
         
-        features_list = []
-        labels_list = []
-        
-        for decision in self.decisions:
-            features = self.extract_features(decision['perception'])
-            label = self.encode_action(decision['decision'])
+        if self.records is not None:
+            X = self.extract_features_binary(self.records)
+            y = self.records['action_type'].astype(np.int64)
+        else:
+            features_list = []
+            labels_list = []
             
-            features_list.append(features)
-            labels_list.append(label)
-        
-        # Convert to numpy arrays
-        X = np.array(features_list, dtype=np.float32)
-        y = np.array(labels_list, dtype=np.int64)
+            for decision in self.decisions:
+                features = self.extract_features(decision['perception'])
+                label = self.encode_action(decision['decision'])
+                
+                features_list.append(features)
+                labels_list.append(label)
+            
+            # Convert to numpy arrays
+            X = np.array(features_list, dtype=np.float32).reshape(-1, 13)
+            y = np.array(labels_list, dtype=np.int64)
         
         # Save as numpy files
         np.save(output_path / 'features.npy', X)
@@ -136,10 +233,7 @@ class DataProcessor:
                 'weather_clear', 'weather_rain', 'weather_storm',
                 'nearby_food', 'nearby_shelter', 'nearby_npcs', 'memory_count'
             ],
-            'class_names': [
-                'idle', 'move', 'forage', 'eat', 'rest', 'explore',
-                'socialize', 'build_shelter', 'seek_shelter'
-            ]
+            'class_names': CLASS_NAMES
         }
         
         with open(output_path / 'metadata.json', 'w') as f:
@@ -154,10 +248,14 @@ class DataProcessor:
     
     def print_statistics(self):
         """Print dataset statistics"""
-        if not self.decisions:
+        if self.num_decisions() == 0:
             print("No decisions to analyze")
             return
         
+        if self.records is not None:
+            self.print_statistics_binary()
+            return
+        
         action_counts = {}
         for decision in self.decisions:
             action = decision['decision']['type']
@@ -179,16 +277,39 @@ class DataProcessor:
         print(f"  Social: {avg_social:.3f}")
 
 
+    def print_statistics_binary(self):
+        """print_statistics() for binary records"""
+        total = len(self.records)
+        counts = np.bincount(self.records['action_type'], minlength=len(CLASS_NAMES))
+        
+        print("\nAction distribution:")
+        for index in np.argsort(-counts, kind='stable'):
+            if counts[index] == 0:
+                continue
+            name = CLASS_NAMES[index] if index < len(CLASS_NAMES) else 'unknown'
+            percentage = (counts[index] / total) * 100
+            print(f"  {name}: {counts[index]} ({percentage:.1f}%)")
+        
+        avg_needs = self.records['needs'].mean(axis=0)
+        
+        print(f"\nAverage needs:")
+        print(f"  Hunger: {avg_needs[0]:.3f}")
+        print(f"  Energy: {avg_needs[1]:.3f}")
+        print(f"  Social: {avg_needs[2]:.3f}")
+
+
 def main():
     parser = argparse.ArgumentParser(description='Process Pixel World Simulator logs')
     parser.add_argument('--log-dir', default='data_logs', help='Directory containing log files')
     parser.add_argument('--output-dir', default='training_data', help='Output directory for processed data')
     parser.add_argument('--stats', action='store_true', help='Print statistics only')
+    parser.add_argument('--format', choices=['auto', 'jsonl', 'binary'], default='auto',
+                        help='Decision log to read (auto picks the most recently written one)')
     
     args = parser.parse_args()
     
     processor = DataProcessor(args.log_dir)
-    processor.load_logs()
+    processor.load_logs(args.format)
     processor.print_statistics()
     
     if not args.stats:
@@ -15,6 +15,7 @@ import sys
 sys.path.append(os.path.dirname(os.path.abspath(__file__)))
 from model_architecture import create_model
 from train_npc_brain import NPCDataset, train_epoch, validate, export_to_onnx
+from export_native_model import export_native
 
 
 class PersonalizedNPCDataset(NPCDataset):
@@ -73,6 +74,7 @@ def fine_tune(base_model_path, npc_id, data_dir, output_dir, epochs=20, lr=0.000
     # Export to ONNX
     onnx_path = os.path.join(output_dir, f'npc_brain_{npc_id}.onnx')
     export_to_onnx(model, onnx_path)
+    export_native(model, os.path.join(output_dir, f'npc_brain_{npc_id}.pwnn'))
     
     print(f"\nFine-tuning complete for NPC {npc_id}!")
     print(f"Personalized model saved to {output_dir}/")
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+Reader for the simulator's shared-memory observation stream
+(--observation-stream), for training while the simulation runs.
+
+The stream is a ring of fixed-size records; numpy maps it directly, so there
+is nothing to parse. Each record is one neural decision: the perception vector
+the model saw, the action it sampled, the action distribution and the reward
+the outcome earned.
+
+    stream = ObservationStream('/dev/shm/pw_observations')
+    while training:
+        batch = stream.poll()          # Structured array of new records
+        train_on(batch['perception'], batch['action'], batch['reward'])
+"""
+
+import argparse
+import time
+from pathlib import Path
+
+import numpy as np
+
+
+# Must match ObservationStreamHeader and ObservationRecord in
+# src/data/ObservationStream.h.
+OBSERVATION_STREAM_MAGIC = 0x534F5750  # "PWOS"
+OBSERVATION_SCHEMA_VERSION = 1
+HEADER_SIZE = 128
+WRITE_INDEX_OFFSET = 64
+
+PERCEPTION_DIM = 20
+ACTION_DIM = 9
+
+OBSERVATION_DTYPE = np.dtype([
+    ('tick', '<u8'),
+    ('npc_id', '<u4'),
+    ('action', '<u4'),                 # Index into CLASS_NAMES
+    ('reward', '<f4'),
+    ('model_version', '<u4'),          # 0 = fallback heuristics chose the action
+    ('perception', '<f4', (PERCEPTION_DIM,)),
+    ('action_probs', '<f4', (ACTION_DIM,)),
+    ('reserved', '<u4'),
+])
+assert OBSERVATION_DTYPE.itemsize == 144
+
+
+class ObservationStream:
+    """Reads records published since the last poll()"""
+
+    def __init__(self, path, start='oldest'):
+        self.path = Path(path)
+        header = np.fromfile(self.path, dtype='<u4', count=5)
+        if len(header) < 5 or header[0] != OBSERVATION_STREAM_MAGIC:
+            raise ValueError(f"{path} is not an observation stream (or the simulator is still creating it)")
+        if header[1] != OBSERVATION_SCHEMA_VERSION or header[2] != OBSERVATION_DTYPE.itemsize:
+            raise ValueError(f"{path} has schema version {header[1]} with {header[2]}-byte records; "
+                             f"expected version {OBSERVATION_SCHEMA_VERSION} with "
+                             f"{OBSERVATION_DTYPE.itemsize}-byte records")
+        if header[4] != PERCEPTION_DIM:
+            raise ValueError(f"{path} has {header[4]} perception features, expected {PERCEPTION_DIM}")
+
+        self.capacity = int(header[3])
+        self._index = np.memmap(self.path, dtype='<u8', mode='r', offset=WRITE_INDEX_OFFSET, shape=(1,))
+        self.records = np.memmap(self.path, dtype=OBSERVATION_DTYPE, mode='r',
+                                 offset=HEADER_SIZE, shape=(self.capacity,))
+        self.dropped = 0  # Records overwritten before this reader got to them
+
+        written = self.write_index()
+        self.next = max(0, written - self.capacity + 1) if start == 'oldest' else written
+
+    def write_index(self):
+        """Records the simulator has published so far"""
+        return int(self._index[0])
+
+    def poll(self, max_records=None):
+        """Copy out every intact record not yet returned (possibly none)"""
+        written = self.write_index()
+        oldest = max(0, written - self.capacity + 1)  # Slot of `written` may be mid-write
+        if self.next < oldest:
+            self.dropped += oldest - self.next
+            self.next = oldest
+        end = written if max_records is None else min(written, self.next + max_records)
+        if end <= self.next:
+            return np.zeros(0, dtype=OBSERVATION_DTYPE)
+
+        slots = np.arange(self.next, end) % self.capacity
+        batch = self.records[slots]  # Fancy indexing copies
+
+        # The simulator may have lapped us during the copy; keep what is still intact
+        intact = max(0, self.write_index() - self.capacity + 1)
+        if intact > self.next:
+            lost = min(intact, end) - self.next
+            self.dropped += lost
+            batch = batch[lost:]
+        self.next = end
+        return batch
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Follow an observation stream and print throughput')
+    parser.add_argument('path', help='Path given to --observation-stream')
+    parser.add_argument('--interval', type=float, default=1.0, help='Seconds between polls')
+    args = parser.parse_args()
+
+    stream = ObservationStream(args.path, start='latest')
+    print(f"Following {args.path}: {stream.capacity} record ring")
+    while True:
+        time.sleep(args.interval)
+        batch = stream.poll()
+        if len(batch) == 0:
+            continue
+        versions = sorted(set(batch['model_version'].tolist()))
+        print(f"{len(batch)} records, ticks {batch['tick'].min()}-{batch['tick'].max()}, "
+              f"mean reward {batch['reward'].mean():.3f}, model versions {versions}, "
+              f"{stream.dropped} dropped")
+
+
+if __name__ == '__main__':
+    main()
@@ -16,6 +16,7 @@ import sys
 # Add tools directory to path
 sys.path.append(os.path.dirname(os.path.abspath(__file__)))
 from model_architecture import create_model
+from export_native_model import export_native
 
 
 class NPCDataset(Dataset):
@@ -26,9 +27,9 @@ class NPCDataset(Dataset):
         self.memory_seq_len = memory_seq_len
         self.memory_dim = memory_dim
         
-        # Load JSONL decision logs
+        # Load JSONL decision logs, including the world_*/ shards of a --worlds run
         self.samples = []
-        decision_files = list(Path(data_dir).glob("decisions_*.jsonl"))
+        decision_files = sorted(Path(data_dir).rglob("decisions*.jsonl"))
         
         print(f"Loading data from {len(decision_files)} files...")
         for filepath in decision_files:
@@ -36,7 +37,8 @@ class NPCDataset(Dataset):
                 for line in f:
                     try:
                         entry = json.loads(line.strip())
-                        self.samples.append(entry)
+                        if 'perception' in entry:  # Skip the schema header line
+                            self.samples.append(entry)
                     except json.JSONDecodeError:
                         continue
         
@@ -263,11 +265,13 @@ def export_to_onnx(model, output_path, perception_dim=20, memory_seq_len=50, mem
     dummy_perception = torch.randn(1, perception_dim)
     dummy_memory = torch.randn(1, memory_seq_len, memory_dim)
     
-    # Export
+    # Export to a temporary file and rename it into place, so a simulator
+    # hot-reloading the model (--model-reload-interval) never reads a partial file
+    temporary_path = output_path + '.tmp'
     torch.onnx.export(
         model,
         (dummy_perception, dummy_memory),
-        output_path,
+        temporary_path,
         input_names=['perception', 'memory'],
         output_names=['output'],
         dynamic_axes={
@@ -277,6 +281,7 @@ def export_to_onnx(model, output_path, perception_dim=20, memory_seq_len=50, mem
         },
         opset_version=12
     )
+    os.replace(temporary_path, output_path)
     
     print(f"Model exported to {output_path}")
 
@@ -373,6 +378,7 @@ def main():
     print("\nExporting to ONNX...")
     onnx_path = os.path.join(args.output_dir, 'npc_brain.onnx')
     export_to_onnx(model, onnx_path)
+    export_native(model, os.path.join(args.output_dir, 'npc_brain.pwnn'))
     
     print("\nTraining complete!")
     print(f"Best validation loss: {best_val_loss:.4f}")